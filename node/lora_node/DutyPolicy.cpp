@@ -0,0 +1,76 @@
+#include "DutyPolicy.h"
+
+DutyMode DutyPolicy::mode = DUTY_NORMAL;
+uint8_t DutyPolicy::relayPercent = 100;
+uint16_t DutyPolicy::beaconPercent = 100;
+
+bool DutyPolicy::update(int batteryPercent)
+{
+    DutyMode next = DUTY_NORMAL;
+#if DUTY_POLICY_ENABLED
+    if (batteryPercent < 0)
+    {
+        next = DUTY_NORMAL;
+    }
+    else if (batteryPercent < DUTY_CRITICAL_LEVEL ||
+             (mode == DUTY_LEAF && batteryPercent < DUTY_CRITICAL_LEVEL + DUTY_HYSTERESIS))
+    {
+        next = DUTY_LEAF;
+    }
+    else if (batteryPercent < DUTY_LOW_LEVEL ||
+             (mode != DUTY_NORMAL && batteryPercent < DUTY_LOW_LEVEL + DUTY_HYSTERESIS))
+    {
+        next = DUTY_LOW_POWER;
+    }
+#endif
+
+    switch (next)
+    {
+    case DUTY_NORMAL:
+        relayPercent = 100;
+        beaconPercent = 100;
+        break;
+    case DUTY_LOW_POWER:
+    {
+        // How far into the low band, 0 at DUTY_LOW_LEVEL (or above, while
+        // the hysteresis holds) up to span at DUTY_CRITICAL_LEVEL
+        const int span = DUTY_LOW_LEVEL - DUTY_CRITICAL_LEVEL;
+        int depth = DUTY_LOW_LEVEL - batteryPercent;
+        depth = depth < 0 ? 0 : (depth > span ? span : depth);
+        relayPercent = (uint8_t)(100 - (100 - DUTY_RELAY_MIN_PERCENT) * depth / span);
+        beaconPercent = (uint16_t)(100 + (DUTY_BEACON_MAX_PERCENT - 100) * depth / span);
+        break;
+    }
+    case DUTY_LEAF:
+        relayPercent = 0;
+        beaconPercent = DUTY_BEACON_MAX_PERCENT;
+        break;
+    }
+
+    const bool changed = next != mode;
+    mode = next;
+    return changed;
+}
+
+const char *DutyPolicy::getModeName(DutyMode value)
+{
+    switch (value)
+    {
+    case DUTY_LOW_POWER:
+        return "low-power";
+    case DUTY_LEAF:
+        return "leaf";
+    default:
+        return "normal";
+    }
+}
+
+uint32_t DutyPolicy::beaconInterval(uint32_t baseMs)
+{
+    return (uint32_t)((uint64_t)baseMs * beaconPercent / 100);
+}
+
+bool DutyPolicy::shouldRelay(uint32_t random)
+{
+    return random % 100 < relayPercent;
+}
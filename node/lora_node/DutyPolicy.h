@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include "NodeConfig.h"
+
+// =======================
+// Battery duty policy
+// =======================
+// Decides how much of the mesh's work this node takes on. Above
+// DUTY_LOW_LEVEL percent battery it beacons and relays like any other node.
+// Below it the node is in low power: the beacon interval stretches and a
+// growing share of relays is dropped, both scaling linearly down to
+// DUTY_CRITICAL_LEVEL, and beacons carry a low-power flag so neighbours
+// can tell. Below DUTY_CRITICAL_LEVEL the node is a leaf: it still sends
+// its own traffic and beacons, but relays nothing. A mode is only left
+// again DUTY_HYSTERESIS points above the level that entered it.
+//
+// Arduino-free; the loop task feeds it the battery level and asks it.
+enum DutyMode : uint8_t
+{
+    DUTY_NORMAL,
+    DUTY_LOW_POWER,
+    DUTY_LEAF
+};
+
+class DutyPolicy
+{
+public:
+    // batteryPercent < 0 means no battery to spare (none fitted, or not
+    // measured yet), which runs as DUTY_NORMAL. Returns true when the mode
+    // changed.
+    static bool update(int batteryPercent);
+
+    static DutyMode getMode() { return mode; }
+    static const char *getModeName(DutyMode value);
+    static bool isLowPower() { return mode != DUTY_NORMAL; }
+    static uint8_t getRelayPercent() { return relayPercent; }
+
+    // Beacon interval to use instead of baseMs
+    static uint32_t beaconInterval(uint32_t baseMs);
+    // Draws whether to relay one frame; random is any uniform 32-bit value
+    static bool shouldRelay(uint32_t random);
+
+private:
+    static DutyMode mode;
+    static uint8_t relayPercent;
+    // Beacon interval in percent of the normal one
+    static uint16_t beaconPercent;
+};
@@ -0,0 +1,145 @@
+#include "JsonWriter.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char hexDigits[] = "0123456789abcdef";
+
+JsonWriter::JsonWriter(char *out, size_t capacity)
+    : buf(out), cap(capacity), used(0), overflow(false)
+{
+}
+
+bool JsonWriter::reserve(size_t count)
+{
+    if (overflow || cap - used < count)
+    {
+        overflow = true;
+        return false;
+    }
+    return true;
+}
+
+void JsonWriter::rollback(size_t position)
+{
+    if (position <= used)
+    {
+        used = position;
+        overflow = false;
+    }
+}
+
+void JsonWriter::raw(const char *text)
+{
+    raw(text, strlen(text));
+}
+
+void JsonWriter::raw(const char *text, size_t length)
+{
+    if (reserve(length))
+    {
+        memcpy(buf + used, text, length);
+        used += length;
+    }
+}
+
+void JsonWriter::string(const char *text)
+{
+    string(text, strlen(text));
+}
+
+void JsonWriter::string(const char *text, size_t length)
+{
+    const size_t escaped = escapedLength(text, length);
+    if (reserve(escaped))
+    {
+        escape(text, length, buf + used);
+        used += escaped;
+    }
+}
+
+void JsonWriter::key(const char *name)
+{
+    const size_t length = strlen(name);
+    if (reserve(length + 3))
+    {
+        buf[used++] = '"';
+        memcpy(buf + used, name, length);
+        used += length;
+        buf[used++] = '"';
+        buf[used++] = ':';
+    }
+}
+
+void JsonWriter::number(long value)
+{
+    char text[24];
+    int length = snprintf(text, sizeof(text), "%ld", value);
+    raw(text, (size_t)length);
+}
+
+void JsonWriter::number(unsigned long value)
+{
+    char text[24];
+    int length = snprintf(text, sizeof(text), "%lu", value);
+    raw(text, (size_t)length);
+}
+
+void JsonWriter::boolean(bool value)
+{
+    raw(value ? "true" : "false");
+}
+
+// =======================
+// Escaping
+// =======================
+// Quotes and backslashes get a backslash, other control characters \u00XX.
+// Bytes from 0x80 up pass through, so UTF-8 stays UTF-8.
+size_t JsonWriter::escapedLength(const char *text, size_t length)
+{
+    size_t escaped = 2;
+    for (size_t i = 0; i < length; i++)
+    {
+        const uint8_t c = (uint8_t)text[i];
+        if (c == '"' || c == '\\')
+        {
+            escaped += 2;
+        }
+        else if (c < 0x20)
+        {
+            escaped += 6;
+        }
+        else
+        {
+            escaped++;
+        }
+    }
+    return escaped;
+}
+
+void JsonWriter::escape(const char *text, size_t length, char *out)
+{
+    *out++ = '"';
+    for (size_t i = 0; i < length; i++)
+    {
+        const uint8_t c = (uint8_t)text[i];
+        if (c == '"' || c == '\\')
+        {
+            *out++ = '\\';
+            *out++ = (char)c;
+        }
+        else if (c < 0x20)
+        {
+            *out++ = '\\';
+            *out++ = 'u';
+            *out++ = '0';
+            *out++ = '0';
+            *out++ = hexDigits[c >> 4];
+            *out++ = hexDigits[c & 0x0F];
+        }
+        else
+        {
+            *out++ = (char)c;
+        }
+    }
+    *out = '"';
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// =======================
+// Streaming JSON writer
+// =======================
+// Writes JSON text straight into a caller's buffer, e.g. the one a chunked
+// web response hands out. Once something does not fit the writer stops and
+// reports overflow; rollback() to an earlier mark() drops a half-written
+// item so every chunk ends on an item boundary. Commas are left to the
+// caller. Nothing in here depends on Arduino, so it can also be built on the
+// host.
+class JsonWriter
+{
+public:
+    JsonWriter(char *out, size_t capacity);
+
+    void raw(const char *text);
+    void raw(const char *text, size_t length);
+    // Quoted and escaped
+    void string(const char *text);
+    void string(const char *text, size_t length);
+    // "name": ; name must not need escaping
+    void key(const char *name);
+    void number(long value);
+    void number(unsigned long value);
+    void boolean(bool value);
+
+    size_t length() const { return used; }
+    bool overflowed() const { return overflow; }
+    size_t mark() const { return used; }
+    void rollback(size_t position);
+
+    // Length of text once escaped, quotes included
+    static size_t escapedLength(const char *text, size_t length);
+    // Writes the quoted, escaped text into out (escapedLength() bytes, no NUL)
+    static void escape(const char *text, size_t length, char *out);
+
+private:
+    bool reserve(size_t count);
+
+    char *buf;
+    size_t cap;
+    size_t used;
+    bool overflow;
+};
@@ -0,0 +1,416 @@
+#include "LogRecord.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool isFlag(char c)
+{
+    return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0';
+}
+
+static bool isLengthModifier(char c)
+{
+    return c == 'h' || c == 'l' || c == 'L' || c == 'q' || c == 'j' || c == 'z' || c == 't';
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// =======================
+// LogPacker
+// =======================
+LogPacker::LogPacker(LogRecord &record, const char *format)
+    : rec(record), cursor(format), starsPending(0), precisionStar(false), precision(-1)
+{
+    rec.format = format;
+    rec.argCount = 0;
+    rec.textUsed = 0;
+    parseSpec();
+}
+
+void LogPacker::parseSpec()
+{
+    starsPending = 0;
+    precisionStar = false;
+    precision = -1;
+    while (*cursor != '\0')
+    {
+        if (*cursor++ != '%')
+        {
+            continue;
+        }
+        if (*cursor == '%')
+        {
+            cursor++;
+            continue;
+        }
+        while (isFlag(*cursor))
+        {
+            cursor++;
+        }
+        if (*cursor == '*')
+        {
+            starsPending++;
+            cursor++;
+        }
+        while (isDigit(*cursor))
+        {
+            cursor++;
+        }
+        if (*cursor == '.')
+        {
+            cursor++;
+            if (*cursor == '*')
+            {
+                starsPending++;
+                precisionStar = true;
+                cursor++;
+            }
+            else
+            {
+                precision = 0;
+                while (isDigit(*cursor))
+                {
+                    precision = precision * 10 + (*cursor++ - '0');
+                }
+            }
+        }
+        while (isLengthModifier(*cursor))
+        {
+            cursor++;
+        }
+        if (*cursor != '\0')
+        {
+            cursor++;
+        }
+        return;
+    }
+}
+
+bool LogPacker::store(LogArgType type, uint64_t bits)
+{
+    if (rec.argCount >= LOG_RECORD_ARGS)
+    {
+        return false;
+    }
+    rec.types[rec.argCount] = (uint8_t)type;
+    rec.args[rec.argCount].u = bits;
+    rec.argCount++;
+    return true;
+}
+
+bool LogPacker::takeStar(long long value)
+{
+    if (starsPending == 0)
+    {
+        return false;
+    }
+    starsPending--;
+    // The precision star always comes last
+    if (starsPending == 0 && precisionStar)
+    {
+        precision = value < 0 ? -1 : (int)value;
+    }
+    return true;
+}
+
+void LogPacker::addSigned(long long value)
+{
+    const bool star = takeStar(value);
+    store(LOG_ARG_INT, (uint64_t)value);
+    if (!star)
+    {
+        parseSpec();
+    }
+}
+
+void LogPacker::addUnsigned(unsigned long long value)
+{
+    const bool star = takeStar((long long)value);
+    store(LOG_ARG_UINT, value);
+    if (!star)
+    {
+        parseSpec();
+    }
+}
+
+void LogPacker::add(double value)
+{
+    const bool star = takeStar((long long)value);
+    if (rec.argCount < LOG_RECORD_ARGS)
+    {
+        rec.types[rec.argCount] = LOG_ARG_DOUBLE;
+        rec.args[rec.argCount].d = value;
+        rec.argCount++;
+    }
+    if (!star)
+    {
+        parseSpec();
+    }
+}
+
+void LogPacker::add(const void *value)
+{
+    const bool star = takeStar(0);
+    store(LOG_ARG_POINTER, (uint64_t)(uintptr_t)value);
+    if (!star)
+    {
+        parseSpec();
+    }
+}
+
+void LogPacker::add(const char *value)
+{
+    if (takeStar(0))
+    {
+        store(LOG_ARG_POINTER, (uint64_t)(uintptr_t)value);
+        return;
+    }
+    if (value == NULL)
+    {
+        value = "(null)";
+    }
+    // Never read past what will be printed or what fits
+    size_t limit = LOG_RECORD_TEXT - rec.textUsed;
+    if (precision >= 0 && (size_t)precision < limit)
+    {
+        limit = (size_t)precision;
+    }
+    size_t length = 0;
+    while (length < limit && value[length] != '\0')
+    {
+        length++;
+    }
+    if (store(LOG_ARG_TEXT, ((uint64_t)rec.textUsed << 16) | length))
+    {
+        memcpy(rec.text + rec.textUsed, value, length);
+        rec.textUsed = (uint8_t)(rec.textUsed + length);
+    }
+    parseSpec();
+}
+
+// =======================
+// Formatting
+// =======================
+struct FormatOutput
+{
+    char *out;
+    size_t capacity;
+    size_t length;
+
+    void append(const char *text, size_t count)
+    {
+        size_t room = capacity - 1 - length;
+        if (count > room)
+        {
+            count = room;
+        }
+        memcpy(out + length, text, count);
+        length += count;
+        out[length] = '\0';
+    }
+
+    template <typename T>
+    void appendFormatted(const char *spec, T value)
+    {
+        size_t room = capacity - length;
+        int written = snprintf(out + length, room, spec, value);
+        if (written > 0)
+        {
+            length += (size_t)written < room ? (size_t)written : room - 1;
+        }
+        out[length] = '\0';
+    }
+};
+
+static long long argAsSigned(const LogRecord &record, size_t index)
+{
+    switch (record.types[index])
+    {
+    case LOG_ARG_DOUBLE:
+        return (long long)record.args[index].d;
+    case LOG_ARG_TEXT:
+        return 0;
+    default:
+        return record.args[index].i;
+    }
+}
+
+static double argAsDouble(const LogRecord &record, size_t index)
+{
+    switch (record.types[index])
+    {
+    case LOG_ARG_DOUBLE:
+        return record.args[index].d;
+    case LOG_ARG_INT:
+        return (double)record.args[index].i;
+    case LOG_ARG_UINT:
+        return (double)record.args[index].u;
+    default:
+        return 0;
+    }
+}
+
+size_t logFormat(const LogRecord &record, char *out, size_t capacity)
+{
+    if (capacity == 0)
+    {
+        return 0;
+    }
+    FormatOutput output = {out, capacity, 0};
+    out[0] = '\0';
+    size_t argIndex = 0;
+    const char *p = record.format;
+
+    while (*p != '\0' && output.length + 1 < capacity)
+    {
+        const char *literal = p;
+        while (*p != '\0' && *p != '%')
+        {
+            p++;
+        }
+        output.append(literal, (size_t)(p - literal));
+        if (*p == '\0')
+        {
+            break;
+        }
+        p++;
+        if (*p == '%')
+        {
+            output.append("%", 1);
+            p++;
+            continue;
+        }
+
+        // Rebuild the spec with stars resolved and our own length modifier
+        char spec[48];
+        size_t specLen = 0;
+        spec[specLen++] = '%';
+        while (isFlag(*p))
+        {
+            if (specLen < 8)
+            {
+                spec[specLen++] = *p;
+            }
+            p++;
+        }
+        if (*p == '*')
+        {
+            p++;
+            long long width = argIndex < record.argCount ? argAsSigned(record, argIndex++) : 0;
+            specLen += (size_t)snprintf(spec + specLen, sizeof(spec) - specLen, "%d", (int)width);
+        }
+        while (isDigit(*p))
+        {
+            if (specLen < 16)
+            {
+                spec[specLen++] = *p;
+            }
+            p++;
+        }
+        if (*p == '.')
+        {
+            p++;
+            if (*p == '*')
+            {
+                p++;
+                long long prec = argIndex < record.argCount ? argAsSigned(record, argIndex++) : 0;
+                if (prec >= 0)
+                {
+                    specLen += (size_t)snprintf(spec + specLen, sizeof(spec) - specLen, ".%d", (int)prec);
+                }
+            }
+            else
+            {
+                spec[specLen++] = '.';
+                while (isDigit(*p))
+                {
+                    if (specLen < 24)
+                    {
+                        spec[specLen++] = *p;
+                    }
+                    p++;
+                }
+            }
+        }
+        while (isLengthModifier(*p))
+        {
+            p++;
+        }
+        const char conversion = *p;
+        if (conversion == '\0')
+        {
+            break;
+        }
+        p++;
+
+        if (argIndex >= record.argCount)
+        {
+            output.append("?", 1);
+            continue;
+        }
+        const size_t index = argIndex++;
+
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+            spec[specLen++] = 'l';
+            spec[specLen++] = 'l';
+            spec[specLen++] = conversion;
+            spec[specLen] = '\0';
+            output.appendFormatted(spec, argAsSigned(record, index));
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            spec[specLen++] = 'l';
+            spec[specLen++] = 'l';
+            spec[specLen++] = conversion;
+            spec[specLen] = '\0';
+            output.appendFormatted(spec, (unsigned long long)argAsSigned(record, index));
+            break;
+        case 'c':
+            spec[specLen++] = 'c';
+            spec[specLen] = '\0';
+            output.appendFormatted(spec, (int)argAsSigned(record, index));
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec[specLen++] = conversion;
+            spec[specLen] = '\0';
+            output.appendFormatted(spec, argAsDouble(record, index));
+            break;
+        case 's':
+        {
+            char text[LOG_RECORD_TEXT + 1];
+            size_t length = 0;
+            if (record.types[index] == LOG_ARG_TEXT)
+            {
+                const uint32_t ref = (uint32_t)record.args[index].u;
+                length = ref & 0xFFFF;
+                memcpy(text, record.text + (ref >> 16), length);
+            }
+            text[length] = '\0';
+            spec[specLen++] = 's';
+            spec[specLen] = '\0';
+            output.appendFormatted(spec, (const char *)text);
+            break;
+        }
+        case 'p':
+            output.appendFormatted("%p", (void *)(uintptr_t)record.args[index].u);
+            break;
+        default:
+            break;
+        }
+    }
+    return output.length;
+}
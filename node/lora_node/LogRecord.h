@@ -0,0 +1,94 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// =======================
+// Binary log records
+// =======================
+// A record keeps the printf format pointer (the format string lives in flash,
+// so the pointer doubles as its ID) and the raw argument values. Formatting
+// into text happens later on the log drain task. String arguments are copied
+// into the record because the caller's buffer may be gone by then.
+// Nothing in here depends on Arduino, so it can also be built on the host.
+#ifndef LOG_RECORD_ARGS
+#define LOG_RECORD_ARGS 6
+#endif
+#ifndef LOG_RECORD_TEXT
+#define LOG_RECORD_TEXT 64
+#endif
+
+enum LogArgType
+{
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_TEXT, // value = offset << 16 | length into LogRecord::text
+    LOG_ARG_POINTER
+};
+
+struct LogRecord
+{
+    const char *format;
+    uint8_t level;
+    uint8_t topic;
+    uint8_t argCount;
+    uint8_t textUsed;
+    uint8_t types[LOG_RECORD_ARGS];
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+    } args[LOG_RECORD_ARGS];
+    char text[LOG_RECORD_TEXT];
+};
+
+// Fills a record argument by argument. It walks the format string alongside
+// the arguments so that "%.*s" and "%.20s" only copy the bytes that will be
+// printed. Arguments past LOG_RECORD_ARGS are dropped.
+class LogPacker
+{
+public:
+    LogPacker(LogRecord &record, const char *format);
+
+    void add(int value) { addSigned(value); }
+    void add(long value) { addSigned(value); }
+    void add(long long value) { addSigned(value); }
+    void add(unsigned value) { addUnsigned(value); }
+    void add(unsigned long value) { addUnsigned(value); }
+    void add(unsigned long long value) { addUnsigned(value); }
+    void add(double value);
+    void add(const char *value);
+    void add(const void *value);
+
+private:
+    void addSigned(long long value);
+    void addUnsigned(unsigned long long value);
+    // True when the argument is a '*' width/precision of the current spec
+    bool takeStar(long long value);
+    // False once the record is full
+    bool store(LogArgType type, uint64_t bits);
+    // Moves the cursor past the next conversion spec
+    void parseSpec();
+
+    LogRecord &rec;
+    const char *cursor;
+    uint8_t starsPending;
+    bool precisionStar;
+    int precision;
+};
+
+inline void logPack(LogPacker &)
+{
+}
+
+template <typename T, typename... Rest>
+inline void logPack(LogPacker &packer, T first, Rest... rest)
+{
+    packer.add(first);
+    logPack(packer, rest...);
+}
+
+// Formats a record like printf would have. Returns the length written to out
+// (always NUL-terminated, truncated to capacity - 1).
+size_t logFormat(const LogRecord &record, char *out, size_t capacity);
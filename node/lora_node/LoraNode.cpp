@@ -1,7 +1,14 @@
 #include "LoraNode.h"
 #include "NodeWebServer.h"
-#include <map>
-#include <sstream>
+#include "NodeState.h"
+#include "RingBuffer.h"
+#include "Metrics.h"
+#include "Profiler.h"
+#include "PacketCapture.h"
+#include "MessageStore.h"
+#include "NodeLog.h"
+#include "SerialLink.h"
+#include "DutyPolicy.h"
 
 // =======================
 // Static vars
@@ -9,8 +16,6 @@
 Module LoraNode::loraModule(LORA_CS, LORA_DIO1, LORA_RST, LORA_BUSY);
 SX1262 LoraNode::radio(&loraModule);
 
-NodeMessage LoraNode::messages[MAX_MSGS];
-int LoraNode::msgWriteIndex = 0;
 
 OnlineNode LoraNode::onlineNodes[MAX_ONLINE];
 int LoraNode::onlineCount = 0;
@@ -21,9 +26,10 @@ int LoraNode::beaconInterval = 30000; // 30s
 bool LoraNode::usersSynced = false;
 bool LoraNode::pagesSynced = false;
 unsigned long LoraNode::lastSyncAttempt = 0;
-String LoraNode::seenMsgIds[MAX_MSGS];
+uint64_t LoraNode::seenMsgIds[DEDUP_CACHE_SIZE];
 int LoraNode::seenMsgIndex = 0;
 Preferences LoraNode::syncPrefs;
+#if FEATURE_ENABLE_WEBSERVER
 static unsigned long pagesSyncRequestMs = 0;
 
 static const int MAX_USER_SYNC_PARTS = 60;
@@ -50,7 +56,75 @@ static unsigned long pageEntryLastPartMs[MAX_PAGE_TEAMS];
 
 static bool hasActivePageEntries();
 static void resetPageEntrySlot(int slot);
+#endif
 
+// =======================
+// Radio task plumbing
+// =======================
+// The radio task owns the SX1262. It hands received frames and TX results to
+// the app loop and takes transmissions from whichever task queues them.
+struct RxFrame
+{
+    uint16_t length;
+    float rssi;
+    float snr;
+    char data[RX_BUFFER_SIZE + 1]; // NUL-terminated
+};
+
+struct TxJob
+{
+    uint16_t length;
+    uint8_t origin;
+    char data[RX_BUFFER_SIZE];
+};
+
+enum RadioEventType
+{
+    RADIO_EVT_TX_DONE,
+    RADIO_EVT_TX_FAILED,
+    RADIO_EVT_RX_ERROR,
+    RADIO_EVT_RX_DROPPED
+};
+
+struct RadioEvent
+{
+    RadioEventType type;
+    int16_t code;
+    uint16_t length;
+};
+
+static SpscRing<RxFrame, RX_QUEUE_DEPTH> rxQueue;                 // radio task -> app loop
+static MpscRing<TxJob, TX_QUEUE_DEPTH> txQueue;                   // app loop, web handlers -> radio task
+static SpscRing<RadioEvent, RADIO_EVENT_QUEUE_DEPTH> radioEvents; // radio task -> app loop
+static TaskHandle_t radioTaskHandle = NULL;
+static volatile bool rxPending = false;
+// Set by the radio task while it waits in receive with nothing left to do
+static volatile bool radioListening = false;
+
+// Gateway frames the radio finished (including failed ones) and how many of
+// those failed; written only by the radio task
+static volatile uint32_t gatewayTxDone = 0;
+static volatile uint32_t gatewayTxFailed = 0;
+// Gateway frames refused because the TX queue was full (app side)
+static uint32_t gatewayTxRejected = 0;
+static uint32_t gatewayTxReported = 0;
+
+// Classifies and dispatches one packet; returns its type
+static PacketType routePacket(const char *packet, size_t length);
+
+// Signal of the frame being handled by the app loop
+static float lastRxRssi = 0;
+static float lastRxSnr = 0;
+
+// Reports a radio frame to the gateway as "<prefix><frame>" on the protocol channel
+static void reportFrame(const char *prefix, const char *data, size_t length)
+{
+    char line[RX_BUFFER_SIZE + 16];
+    int len = snprintf(line, sizeof(line), "%s%.*s", prefix, (int)length, data);
+    SerialLink::sendProto(line, min(len, (int)sizeof(line) - 1));
+}
+
+#if FEATURE_ENABLE_WEBSERVER
 // =======================
 // Persistent Sync Status
 // =======================
@@ -60,7 +134,7 @@ void LoraNode::loadSyncStatus()
     usersSynced = syncPrefs.getBool("usersSynced", false);
     pagesSynced = syncPrefs.getBool("pagesSynced", false);
     syncPrefs.end();
-    Serial.printf("[SYNC] Loaded from NVS: usersSynced=%d, pagesSynced=%d\n", usersSynced, pagesSynced);
+    LOG_I(LOG_TOPIC_SYNC, "[SYNC] Loaded from NVS: usersSynced=%d, pagesSynced=%d", usersSynced, pagesSynced);
 }
 
 void LoraNode::saveSyncStatus()
@@ -69,20 +143,26 @@ void LoraNode::saveSyncStatus()
     syncPrefs.putBool("usersSynced", usersSynced);
     syncPrefs.putBool("pagesSynced", pagesSynced);
     syncPrefs.end();
-    Serial.printf("[SYNC] Saved to NVS: usersSynced=%d, pagesSynced=%d\n", usersSynced, pagesSynced);
+    LOG_I(LOG_TOPIC_SYNC, "[SYNC] Saved to NVS: usersSynced=%d, pagesSynced=%d", usersSynced, pagesSynced);
 }
+#endif
 
 // =======================
 // Setup
 // =======================
 void LoraNode::setup()
 {
-    Serial.println("[LoRa] Initializing SX1262...");
-    int state = radio.begin(868.0, 125.0, 9, 7, 0x12);
+    LOG_I(LOG_TOPIC_RADIO, "[LoRa] Initializing SX1262...");
+    int state = radio.begin(LORA_FREQUENCY_MHZ, LORA_BANDWIDTH_KHZ, LORA_SPREADING_FACTOR,
+                            LORA_CODING_RATE, LORA_SYNC_WORD);
+    if (state == RADIOLIB_ERR_NONE)
+    {
+        state = radio.setPreambleLength(LORA_PREAMBLE_LENGTH);
+    }
 
     if (state != RADIOLIB_ERR_NONE)
     {
-        Serial.printf("[LoRa] init failed, code: %d\n", state);
+        LOG_E(LOG_TOPIC_RADIO, "[LoRa] init failed, code: %d", state);
         while (true)
             ;
     }
@@ -92,9 +172,19 @@ void LoraNode::setup()
     mac.replace(":", "");
     nodeName = "LoRA_" + mac + "_" + FIRMWARE_VERSION;
 
-    Serial.println("[LoRa] Init OK, node = " + nodeName);
+    LOG_I(LOG_TOPIC_RADIO, "[LoRa] Init OK, node = %s", nodeName.c_str());
     addOnlineNode(nodeName, 0, 0);
 
+    PacketCapture::begin();
+#if FEATURE_ENABLE_MESSAGE_STORE
+    MessageStore::begin();
+#endif
+
+    // From here on only the radio task touches the SX1262
+    xTaskCreatePinnedToCore(radioTask, "radio", RADIO_TASK_STACK, NULL,
+                            RADIO_TASK_PRIORITY, &radioTaskHandle, RADIO_TASK_CORE);
+
+#if FEATURE_ENABLE_WEBSERVER
     // Load persistent sync status from NVS
     loadSyncStatus();
     
@@ -105,16 +195,18 @@ void LoraNode::setup()
     }
     else
     {
-        Serial.println("[SYNC] Users already synced (from NVS), skipping initial request");
+        LOG_I(LOG_TOPIC_SYNC, "[SYNC] Users already synced (from NVS), skipping initial request");
     }
+#endif
 }
 
+#if FEATURE_ENABLE_WEBSERVER
 void LoraNode::requestUsers()
 {
     usersSynced = false;
     String request = "REQ;USERS;" + nodeName;
-    Serial.println("[SYNC] Requesting users: " + request);
-    Serial.println(request);
+    LOG_I(LOG_TOPIC_SYNC, "[SYNC] Requesting users: %s", request.c_str());
+    SerialLink::sendProto(request);
     LoraNode::transmitRaw(request);
 }
 
@@ -123,14 +215,11 @@ void LoraNode::requestPages()
     pagesSynced = false;
     pagesSyncRequestMs = millis();
     String request = "REQ;PAGES;" + nodeName;
-    Serial.println("[SYNC] Requesting pages: " + request);
-    Serial.println(request);
+    LOG_I(LOG_TOPIC_SYNC, "[SYNC] Requesting pages: %s", request.c_str());
+    SerialLink::sendProto(request);
     LoraNode::transmitRaw(request);
 }
 
-bool LoraNode::isUsersSynced() { return usersSynced; }
-bool LoraNode::isPagesSynced() { return pagesSynced; }
-
 void LoraNode::setUsersSynced(bool synced)
 {
     usersSynced = synced;
@@ -144,18 +233,253 @@ void LoraNode::setPagesSynced(bool synced)
 }
 
 bool LoraNode::isUsersSyncInProgress() { return usersSyncExpectedParts > 0; }
+#endif
 
-void LoraNode::transmitRaw(const String &packet)
+bool LoraNode::isUsersSynced() { return usersSynced; }
+bool LoraNode::isPagesSynced() { return pagesSynced; }
+
+bool LoraNode::transmitRaw(const String &packet)
 {
-    String packetCopy = packet;
-    int state = radio.transmit(packetCopy);
-    if (state == RADIOLIB_ERR_NONE)
+    return transmitRaw(packet.c_str(), packet.length());
+}
+
+bool LoraNode::transmitRaw(const char *packet, size_t length, TxOrigin origin)
+{
+    if (length > RX_BUFFER_SIZE)
     {
-        Serial.println("[LoRa TX RAW] " + packet);
+        LOG_W(LOG_TOPIC_RADIO, "[LoRa TX RAW] packet too long (%u bytes), dropped", (unsigned)length);
+        if (origin == TX_ORIGIN_GATEWAY)
+        {
+            gatewayTxRejected++;
+        }
+        return false;
     }
-    else
+
+    TxJob job;
+    job.length = (uint16_t)length;
+    job.origin = (uint8_t)origin;
+    memcpy(job.data, packet, length);
+
+    if (!txQueue.push(job))
+    {
+        LOG_W(LOG_TOPIC_RADIO, "[LoRa TX RAW] TX queue full, packet dropped");
+        Metrics::inc(CTR_TX_QUEUE_FULL);
+        if (origin == TX_ORIGIN_GATEWAY)
+        {
+            gatewayTxRejected++;
+        }
+        return false;
+    }
+    LOG_D(LOG_TOPIC_RADIO, "[LoRa TX RAW] %.*s", (int)length, packet);
+    reportFrame("LORA_TX;", packet, length);
+    if (radioTaskHandle != NULL)
+    {
+        xTaskNotifyGive(radioTaskHandle);
+    }
+    return true;
+}
+
+// =======================
+// Radio task (core 0)
+// =======================
+static void IRAM_ATTR onRadioIrq()
+{
+    rxPending = true;
+    BaseType_t woken = pdFALSE;
+    if (radioTaskHandle != NULL)
+    {
+        vTaskNotifyGiveFromISR(radioTaskHandle, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+static void postRadioEvent(RadioEventType type, int code, size_t length)
+{
+    RadioEvent event;
+    event.type = type;
+    event.code = (int16_t)code;
+    event.length = (uint16_t)length;
+    // Events are diagnostics; losing one when the app loop lags is fine
+    radioEvents.push(event);
+}
+
+void LoraNode::receiveFrame()
+{
+    // Read straight into the ring slot; when the app loop is behind, the
+    // packet still has to be read out of the radio to clear it
+    static RxFrame overflow;
+    RxFrame *frame = rxQueue.claim();
+    const bool dropped = (frame == NULL);
+    if (dropped)
+    {
+        frame = &overflow;
+    }
+
+    size_t length = radio.getPacketLength();
+    if (length > RX_BUFFER_SIZE)
+    {
+        length = RX_BUFFER_SIZE;
+    }
+    int state = radio.readData((uint8_t *)frame->data, length);
+    if (state != RADIOLIB_ERR_NONE)
+    {
+        Metrics::inc(CTR_RX_ERRORS);
+        postRadioEvent(RADIO_EVT_RX_ERROR, state, length);
+        return;
+    }
+    if (length == 0)
+    {
+        return;
+    }
+    const float rssi = radio.getRSSI();
+    const float snr = radio.getSNR();
+    PacketCapture::record(CAPTURE_RX, (const uint8_t *)frame->data, length, rssi, snr,
+                          radio.getTimeOnAir(length));
+    if (dropped)
+    {
+        Metrics::inc(CTR_RX_DROPPED);
+        postRadioEvent(RADIO_EVT_RX_DROPPED, 0, length);
+        return;
+    }
+    frame->length = (uint16_t)length;
+    frame->data[length] = '\0';
+    frame->rssi = rssi;
+    frame->snr = snr;
+    rxQueue.publish();
+}
+
+// In POWER_SAVE builds the SX1262 sleeps between preamble checks (RX duty
+// cycle). RadioLib falls back to plain receive when LORA_PREAMBLE_LENGTH is
+// too short for that.
+void LoraNode::startListening()
+{
+#if POWER_SAVE
+    radio.startReceiveDutyCycleAuto(LORA_PREAMBLE_LENGTH);
+#else
+    radio.startReceive();
+#endif
+}
+
+void LoraNode::radioTask(void * /*param*/)
+{
+    radio.setDio1Action(onRadioIrq);
+    startListening();
+
+    TxJob job;
+    for (;;)
+    {
+        radioListening = true;
+        // Woken by DIO1, by transmitRaw() or by the idle timeout
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RADIO_IDLE_WAIT_MS));
+        radioListening = false;
+
+        if (rxPending)
+        {
+            PROFILE_SCOPE(PROF_RADIO_RX);
+            rxPending = false;
+            receiveFrame();
+            startListening();
+        }
+
+        bool transmitted = false;
+        while (txQueue.pop(job))
+        {
+            const uint32_t startUs = micros();
+            int state = radio.transmit((uint8_t *)job.data, job.length);
+            const uint32_t airtimeUs = micros() - startUs;
+            Metrics::inc(CTR_AIRTIME_MS, (airtimeUs + 500) / 1000);
+            PROFILE_RECORD(PROF_RADIO_TX, airtimeUs);
+            PacketCapture::record(CAPTURE_TX, (const uint8_t *)job.data, job.length, 0, 0, airtimeUs);
+            if (state == RADIOLIB_ERR_NONE)
+            {
+                StrView frame;
+                Metrics::countTx(PacketParser::classify(StrView(job.data, job.length), frame));
+            }
+            else
+            {
+                Metrics::inc(CTR_TX_FAILED);
+            }
+            postRadioEvent(state == RADIOLIB_ERR_NONE ? RADIO_EVT_TX_DONE : RADIO_EVT_TX_FAILED, state, job.length);
+            if (job.origin == TX_ORIGIN_GATEWAY)
+            {
+                // Failed first, so a reader never sees a failure it has no done for
+                if (state != RADIOLIB_ERR_NONE)
+                {
+                    gatewayTxFailed++;
+                }
+                gatewayTxDone++;
+            }
+            transmitted = true;
+        }
+        if (transmitted)
+        {
+            // The TX-done interrupt is not a received packet
+            rxPending = false;
+            startListening();
+        }
+    }
+}
+
+bool LoraNode::isRadioIdle()
+{
+    return radioListening && !rxPending && txQueue.empty() && rxQueue.empty() && radioEvents.empty();
+}
+
+void LoraNode::checkRadioIrq()
+{
+    if (digitalRead(LORA_DIO1) == HIGH && !rxPending)
+    {
+        rxPending = true;
+        if (radioTaskHandle != NULL)
+        {
+            xTaskNotifyGive(radioTaskHandle);
+        }
+    }
+}
+
+static void handleRadioEvents()
+{
+    RadioEvent event;
+    while (radioEvents.pop(event))
     {
-        Serial.printf("[LoRa TX RAW] failed, code %d\n", state);
+        switch (event.type)
+        {
+        case RADIO_EVT_TX_DONE:
+            LOG_D(LOG_TOPIC_RADIO, "[LoRa TX] Sent %u bytes", event.length);
+            break;
+        case RADIO_EVT_TX_FAILED:
+            LOG_W(LOG_TOPIC_RADIO, "[LoRa TX] failed, code %d", event.code);
+            break;
+        case RADIO_EVT_RX_ERROR:
+            LOG_W(LOG_TOPIC_RADIO, "[LoRa RX] receive failed, code %d", event.code);
+            break;
+        case RADIO_EVT_RX_DROPPED:
+            LOG_W(LOG_TOPIC_RADIO, "[LoRa RX] RX queue full, dropped %u byte packet", event.length);
+            break;
+        }
+    }
+}
+
+// One "TXDONE;<done>;<failed>;<credits>" line per finished gateway frame.
+// done and failed are running totals since boot (rejected frames count as
+// both), credits is the number of free TX queue slots. Totals instead of
+// deltas mean a lost line costs the gateway nothing.
+static void reportGatewayTx()
+{
+    const uint32_t failed = gatewayTxFailed + gatewayTxRejected;
+    const uint32_t done = gatewayTxDone + gatewayTxRejected;
+    if (done == gatewayTxReported)
+    {
+        return;
+    }
+    const unsigned credits = (unsigned)(TX_QUEUE_DEPTH - txQueue.size());
+    char line[48];
+    while (gatewayTxReported != done)
+    {
+        gatewayTxReported++;
+        int len = snprintf(line, sizeof(line), "TXDONE;%lu;%lu;%u",
+                           (unsigned long)gatewayTxReported, (unsigned long)failed, credits);
+        SerialLink::sendProto(line, (size_t)len);
     }
 }
 
@@ -164,6 +488,12 @@ void LoraNode::transmitRaw(const String &packet)
 // =======================
 void LoraNode::loop()
 {
+    NodeStateLock lock;
+    handleRadioEvents();
+    reportGatewayTx();
+    PacketCapture::streamPending();
+
+#if FEATURE_ENABLE_WEBSERVER
     const unsigned long nowMs = millis();
     const bool usersSyncInProgress = usersSyncExpectedParts > 0;
     const unsigned long usersSyncIntervalMs = 120000; // wait 2 minutes between users sync retries
@@ -186,14 +516,16 @@ void LoraNode::loop()
 
     if (!usersSynced && usersSyncExpectedParts > 0 && (nowMs - usersSyncLastPartMs > 30000) && (nowMs - lastUsersResendMs > 30000))
     {
-        Serial.println("[USER-SYNC] Missing parts detected, re-requesting users...");
+        LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] Missing parts detected, re-requesting users...");
+        Metrics::inc(CTR_SYNC_PARTS_LOST, usersSyncExpectedParts - usersSyncReceivedParts);
         requestUsers();
         lastUsersResendMs = nowMs;
     }
 
     if (!pagesSynced && pagesSyncExpectedParts > 0 && (nowMs - pagesSyncLastPartMs > 45000) && (nowMs - lastPagesResendMs > 45000))
     {
-        Serial.println("[PAGE-SYNC] Missing parts detected, re-requesting pages...");
+        LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] Missing parts detected, re-requesting pages...");
+        Metrics::inc(CTR_SYNC_PARTS_LOST, pagesSyncExpectedParts - pagesSyncReceivedParts);
         requestPages();
         lastPagesResendMs = nowMs;
     }
@@ -208,33 +540,40 @@ void LoraNode::loop()
             }
             if (nowMs - pageEntryLastPartMs[i] > 90000)
             {
-                Serial.printf("[PAGE-SYNC] RESP;PAGE timeout for team: %s (reset slot %d)\n", pageEntryTeams[i].c_str(), i);
+                LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] RESP;PAGE timeout for team: %s (reset slot %d)", pageEntryTeams[i].c_str(), i);
+                Metrics::inc(CTR_SYNC_PARTS_LOST, pageEntryTotals[i] - pageEntryReceived[i]);
                 resetPageEntrySlot(i);
                 resetAny = true;
             }
         }
         if (resetAny)
         {
-            Serial.println("[PAGE-SYNC] RESP;PAGE missing parts, re-requesting pages...");
+            LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] RESP;PAGE missing parts, re-requesting pages...");
             requestPages();
             lastRespPageResendMs = nowMs;
         }
     }
-    // Check for incoming
-    String str;
-    int state = radio.receive(str);
-
-    if (state == RADIOLIB_ERR_NONE && str.length() > 0)
+#endif
+    // Frames received by the radio task, parsed in place in their ring slot
+    while (const RxFrame *frame = rxQueue.front())
     {
-        Serial.println("[LoRa RX] " + str);
-        handlePacket(str);
-        Serial.println("LORA_RX;" + str);
+        lastRxRssi = frame->rssi;
+        lastRxSnr = frame->snr;
+        LOG_D(LOG_TOPIC_RADIO, "[LoRa RX] %s", frame->data);
+        Metrics::countRx(routePacket(frame->data, frame->length));
+        reportFrame("LORA_RX;", frame->data, frame->length);
+        rxQueue.release();
     }
 
     // Send beacon (pause while waiting for pages sync to improve reception)
+#if FEATURE_ENABLE_WEBSERVER
     const bool waitingForPages = (!pagesSynced && pagesSyncRequestMs > 0 && (millis() - pagesSyncRequestMs) < 30000);
     const bool waitingForUsers = (!usersSynced && usersSyncExpectedParts > 0 && (millis() - usersSyncLastPartMs) < 30000);
-    if (!waitingForPages && !waitingForUsers && (millis() - lastBeacon > beaconInterval))
+#else
+    const bool waitingForPages = false;
+    const bool waitingForUsers = false;
+#endif
+    if (!waitingForPages && !waitingForUsers && (millis() - lastBeacon > DutyPolicy::beaconInterval(beaconInterval)))
     {
         sendBeacon();
         lastBeacon = millis();
@@ -244,29 +583,14 @@ void LoraNode::loop()
     cleanOfflineNodes();
 }
 
-int LoraNode::getMsgCount() { return msgWriteIndex; }
-int LoraNode::getMsgWriteIndex() { return msgWriteIndex; }
-NodeMessage LoraNode::getMessage(int index) { return messages[index]; }
-String LoraNode::getMessageRow(int index)
-{
-    NodeMessage msg = getMessage(index);
-    String row = "<td>" + msg.msgId + "</td>";
-    row += "<td>" + msg.user + "</td>";
-    row += "<td>" + msg.object + "</td>";
-    row += "<td>" + msg.function + "</td>";
-    row += "<td>" + msg.parameters + "</td>";
-    row += "<td>" + String(msg.TTL) + "</td>";
-    return row;
-}
-
-String LoraNode::getNodeName()
+const String &LoraNode::getNodeName()
 {
     return nodeName;
 }
 
-static bool hasSeenMsgId(const String &msgId)
+static bool hasSeenMsgId(uint64_t msgId)
 {
-    for (int i = 0; i < MAX_MSGS; i++)
+    for (int i = 0; i < DEDUP_CACHE_SIZE; i++)
     {
         if (LoraNode::seenMsgIds[i] == msgId)
         {
@@ -276,79 +600,109 @@ static bool hasSeenMsgId(const String &msgId)
     return false;
 }
 
-static void rememberMsgId(const String &msgId)
+static void rememberMsgId(uint64_t msgId)
 {
     LoraNode::seenMsgIds[LoraNode::seenMsgIndex] = msgId;
-    LoraNode::seenMsgIndex = (LoraNode::seenMsgIndex + 1) % MAX_MSGS;
+    LoraNode::seenMsgIndex = (LoraNode::seenMsgIndex + 1) % DEDUP_CACHE_SIZE;
 }
 
 // =======================
 // Send message
 // =======================
-void LoraNode::loraSend(NodeMessage nodeMessage)
+// MSG;msgId;user;ttl;timestamp;object;function;parameters
+void LoraNode::loraSend(const NodeMessage &nodeMessage)
 {
-    String packet = String(millis()) + ";" + nodeMessage.object + ";" + nodeMessage.function + ";" + nodeMessage.parameters;
-    loraSendFW(nodeMessage.msgId, nodeMessage.user, 3, packet);
-}
-
-void LoraNode::loraSendFW(String msgID, const String &user, int TTL, const String &packet)
-{
-    String msg = "MSG;" + msgID + ";" + user + ";" + String(TTL) + ";" + packet;
-    int state = radio.transmit(msg);
-
-    if (state == RADIOLIB_ERR_NONE)
-    {
-        Serial.println("[LoRa TX] " + msg);
-    }
-    else
-    {
-        Serial.printf("[LoRa TX] failed, code %d\n", state);
-    }
+    char msgId[24];
+    NodeMessage::formatId(nodeMessage.msgId, msgId, sizeof(msgId));
+    const StrView user = nodeMessage.user();
+    const StrView object = nodeMessage.objectName();
+    const StrView function = nodeMessage.functionName();
+    const StrView parameters = nodeMessage.parameters();
+    char packet[RX_BUFFER_SIZE + 1];
+    int len = snprintf(packet, sizeof(packet), "MSG;%s;%.*s;%u;%lu;%.*s;%.*s;%.*s", msgId,
+                       (int)user.len, user.data, (unsigned)nodeMessage.ttl, (unsigned long)millis(),
+                       (int)object.len, object.data, (int)function.len, function.data,
+                       (int)parameters.len, parameters.data);
+    transmitRaw(packet, min(len, (int)sizeof(packet) - 1));
 }
 
 // =======================
 // Store message locally
 // =======================
-void LoraNode::addMessage(NodeMessage nodeMessage)
+void LoraNode::addMessage(const NodeMessage &received)
 {
+    // USER frames carry the password hash and token. The store is persisted,
+    // served by /api/messages and pushed over /events, so only name and team
+    // are kept.
+    NodeMessage stripped;
+    const NodeMessage &nodeMessage = received.object == MSG_OBJECT_USER ? stripped : received;
+    if (received.object == MSG_OBJECT_USER)
+    {
+        const MessageFields fields(received.parameters());
+        const StrView name = fields.get("name");
+        const StrView team = fields.get("team");
+        char kept[NODE_MESSAGE_TEXT];
+        int len = snprintf(kept, sizeof(kept), "name:%.*s,team:%.*s",
+                           (int)name.len, name.data, (int)team.len, team.data);
+        stripped.set(received.msgId, received.user(), received.ttl, received.timestamp, received.objectName(),
+                     received.functionName(), StrView(kept, min(len, (int)sizeof(kept) - 1)));
+    }
+
     // Log broadcast reception
-    Serial.printf("[BROADCAST RX] User: %s | TTL: %d | Params: %s\n", 
-        nodeMessage.user.c_str(), 
-        nodeMessage.TTL, 
-        nodeMessage.parameters.c_str());
+    const StrView user = nodeMessage.user();
+    const StrView parameters = nodeMessage.parameters();
+    LOG_I(LOG_TOPIC_MESH, "[BROADCAST RX] User: %.*s | TTL: %d | Params: %.*s", 
+        (int)user.len, user.data, 
+        nodeMessage.ttl, 
+        (int)parameters.len, parameters.data);
     
-    messages[msgWriteIndex] = nodeMessage;
-    msgWriteIndex = (msgWriteIndex + 1) % MAX_MSGS;
+#if FEATURE_ENABLE_MESSAGE_STORE
+    const uint32_t seq = MessageStore::append(nodeMessage);
+    NodeWebServer::publishMessage(seq);
     
-    Serial.printf("[BROADCAST STORED] Index: %d | Total: %d\n", 
-        (msgWriteIndex - 1 + MAX_MSGS) % MAX_MSGS, 
-        msgWriteIndex);
+    LOG_I(LOG_TOPIC_MESH, "[BROADCAST STORED] Seq: %lu | Kept: %lu", 
+        (unsigned long)seq, 
+        (unsigned long)(MessageStore::getNextSeq() - MessageStore::getOldestSeq()));
+#endif
 }
 
 // =======================
 // Online nodes
 // =======================
 void LoraNode::addOnlineNode(const String &node, float rssi, float snr)
+{
+    addOnlineNode(node.c_str(), node.length(), rssi, snr);
+}
+
+void LoraNode::addOnlineNode(const char *node, size_t length, float rssi, float snr, bool lowPower)
 {
     for (int i = 0; i < LoraNode::onlineCount; i++)
     {
-        if (LoraNode::onlineNodes[i].name == node)
+        const String &name = LoraNode::onlineNodes[i].name;
+        if (name.length() == length && memcmp(name.c_str(), node, length) == 0)
         {
             LoraNode::onlineNodes[i].rssi = rssi;
             LoraNode::onlineNodes[i].snr = snr;
             LoraNode::onlineNodes[i].lastSeen = millis();
+            if (LoraNode::onlineNodes[i].lowPower != lowPower)
+            {
+                LoraNode::onlineNodes[i].lowPower = lowPower;
+                NodeWebServer::publishOnlineNodesChanged();
+            }
             return;
         }
     }
     if (LoraNode::onlineCount < MAX_ONLINE)
     {
         OnlineNode onlineNode;
-        onlineNode.name = node;
+        onlineNode.name.concat(node, length);
         onlineNode.rssi = rssi;
         onlineNode.snr = snr;
         onlineNode.lastSeen = millis();
+        onlineNode.lowPower = lowPower;
 
         LoraNode::onlineNodes[LoraNode::onlineCount++] = onlineNode;
+        NodeWebServer::publishOnlineNodesChanged();
     }
 }
 
@@ -359,95 +713,60 @@ void LoraNode::cleanOfflineNodes()
     {
         if (now - onlineNodes[i].lastSeen > 60000)
         {
-            Serial.println("[LoRa] Offline: " + onlineNodes[i].name);
+            LOG_I(LOG_TOPIC_MESH, "[LoRa] Offline: %s", onlineNodes[i].name.c_str());
+            SerialLink::sendProto("OFFLINE;" + onlineNodes[i].name);
             for (int j = i; j < onlineCount - 1; j++)
             {
                 onlineNodes[j] = onlineNodes[j + 1];
             }
             onlineCount--;
             i--;
+            NodeWebServer::publishOnlineNodesChanged();
         }
     }
 }
 
-NodeMessage LoraNode::nodeMessageFromString(const String &str)
+#if FEATURE_ENABLE_WEBSERVER
+static String viewToString(StrView view)
 {
-    NodeMessage nodeMessage;
-    int p0 = str.indexOf(';');
-    int p1 = str.indexOf(';', p0 + 1);
-    int p2 = str.indexOf(';', p1 + 1);
-    int p3 = str.indexOf(';', p2 + 1);
-    int p4 = str.indexOf(';', p3 + 1);
-    int p5 = str.indexOf(';', p4 + 1);
-    int p6 = str.indexOf(';', p5 + 1);
-    int p7 = str.indexOf(';', p6 + 1);
-
-    nodeMessage.msgId = str.substring(p1 + 1, p2);
-    nodeMessage.user = str.substring(p2 + 1, p3);
-    nodeMessage.TTL = str.substring(p3 + 1, p4).toInt();
-    if (p5 == -1 || p6 == -1 || p7 == -1)
-    {
-        nodeMessage.timestamp = millis();
-        nodeMessage.object = str.substring(p4 + 1, p5 == -1 ? str.length() : p5);
-        nodeMessage.function = "";
-        nodeMessage.parameters = "";
+    String out;
+    out.concat(view.data, view.len);
+    return out;
+}
+#endif
+
+// MSG;msgId;user;ttl;timestamp;object;function;parameters
+static void nodeMessageFromFields(const StrView *fields, size_t count, NodeMessage &nodeMessage)
+{
+    const uint64_t msgId = count > 1 ? NodeMessage::parseId(fields[1]) : 0;
+    const StrView user = count > 2 ? fields[2] : StrView();
+    const long ttl = count > 3 ? fields[3].toInt() : 0;
+    if (count < 8)
+    {
+        nodeMessage.set(msgId, user, ttl, millis(), count > 4 ? fields[4] : StrView(), StrView(), StrView());
     }
     else
     {
-        nodeMessage.timestamp = str.substring(p4 + 1, p5).toInt();
-        nodeMessage.object = str.substring(p5 + 1, p6);
-        nodeMessage.function = str.substring(p6 + 1, p7);
-        nodeMessage.parameters = str.substring(p7 + 1);
+        nodeMessage.set(msgId, user, ttl, (uint32_t)fields[4].toInt(), fields[5], fields[6], fields[7]);
     }
-
-    return nodeMessage;
 }
 
-std::map<std::string, std::string> parseFields(const std::string& input) {
-    std::map<std::string, std::string> fields;
-    std::stringstream ss(input);
-    std::string item;
-    while (std::getline(ss, item, ',')) {
-        size_t pos = item.find(':');
-        if (pos != std::string::npos) {
-            std::string key = item.substr(0, pos);
-            std::string value = item.substr(pos + 1);
-            // Remove possible spaces
-            key.erase(0, key.find_first_not_of(" \t"));
-            key.erase(key.find_last_not_of(" \t") + 1);
-            value.erase(0, value.find_first_not_of(" \t"));
-            value.erase(value.find_last_not_of(" \t") + 1);
-            fields[key] = value;
-        }
-    }
-    return fields;
+void LoraNode::nodeMessageFromString(const String &str, NodeMessage &nodeMessage)
+{
+    StrView fields[8];
+    size_t count = PacketParser::splitFields(StrView(str.c_str(), str.length()), ';', fields, 8);
+    nodeMessageFromFields(fields, count, nodeMessage);
 }
 
-static String urlDecode(const String &input)
+#if FEATURE_ENABLE_WEBSERVER
+static void appendUrlDecoded(String &out, StrView input)
 {
-    String output;
-    char temp[3] = {0};
-    for (int i = 0; i < input.length(); i++)
+    out.reserve(out.length() + input.len);
+    size_t pos = 0;
+    while (pos < input.len)
     {
-        char c = input[i];
-        if (c == '+')
-        {
-            output += ' ';
-        }
-        else if (c == '%' && i + 2 < input.length())
-        {
-            temp[0] = input[i + 1];
-            temp[1] = input[i + 2];
-            char decoded = (char)strtol(temp, nullptr, 16);
-            output += decoded;
-            i += 2;
-        }
-        else
-        {
-            output += c;
-        }
+        out += PacketParser::urlDecodeNext(input, pos);
     }
-    return output;
 }
 
 static bool hasActivePageEntries()
@@ -474,60 +793,66 @@ static void resetPageEntrySlot(int slot)
         pageEntryChunks[slot][i] = "";
     }
 }
+#endif
 
 static void sendAckForMessage(const NodeMessage &nodeMessage)
 {
-    String ack = "ACK;" + nodeMessage.msgId + ";" + LoraNode::getNodeName() + ";" + nodeMessage.object + ";" + nodeMessage.function + ";" + String(millis());
-    Serial.println("[ACK] Sending: " + ack);
-    LoraNode::transmitRaw(ack);
-    Serial.println(ack);
+    char msgId[24];
+    NodeMessage::formatId(nodeMessage.msgId, msgId, sizeof(msgId));
+    const StrView object = nodeMessage.objectName();
+    const StrView function = nodeMessage.functionName();
+    char ack[RX_BUFFER_SIZE + 1];
+    int len = snprintf(ack, sizeof(ack), "ACK;%s;%s;%.*s;%.*s;%lu", msgId, LoraNode::getNodeName().c_str(),
+                       (int)object.len, object.data, (int)function.len, function.data, (unsigned long)millis());
+    LOG_D(LOG_TOPIC_MESH, "[ACK] Sending: %s", ack);
+    LoraNode::transmitRaw(ack, min(len, (int)sizeof(ack) - 1));
 }
 
-static bool isTargetedForThisNode(const NodeMessage &nodeMessage)
+static bool isTargetedForThisNode(const MessageFields &fields)
 {
-    auto fields = parseFields(std::string(nodeMessage.parameters.c_str()));
-    if (fields.find("node") != fields.end())
+    const char *nodeName = LoraNode::getNodeName().c_str();
+    static const char *const targetKeys[] = {"node", "target", "nodeid"};
+    for (size_t i = 0; i < sizeof(targetKeys) / sizeof(targetKeys[0]); i++)
     {
-        return (String(fields["node"].c_str()) == LoraNode::getNodeName());
-    }
-    if (fields.find("target") != fields.end())
-    {
-        return (String(fields["target"].c_str()) == LoraNode::getNodeName());
-    }
-    if (fields.find("nodeid") != fields.end())
-    {
-        return (String(fields["nodeid"].c_str()) == LoraNode::getNodeName());
+        if (fields.has(targetKeys[i]))
+        {
+            return fields.get(targetKeys[i]).equals(nodeName);
+        }
     }
     return false;
 }
 
-void LoraNode::handleMessage(NodeMessage nodeMessage)
+void LoraNode::handleMessage(const NodeMessage &nodeMessage, const MessageFields &fields)
 {
-    auto fields = parseFields(std::string(nodeMessage.parameters.c_str()));
-    if (nodeMessage.object == "USER")
+#if FEATURE_ENABLE_WEBSERVER
+    if (nodeMessage.object == MSG_OBJECT_USER)
     {
-        if ((nodeMessage.function == "ADD") || (nodeMessage.function == "UPDATE")) {
-            Serial.println("[LoRa] Registering user: " + nodeMessage.parameters);
+        const StrView parameters = nodeMessage.parameters();
+        if ((nodeMessage.function == MSG_FUNCTION_ADD) || (nodeMessage.function == MSG_FUNCTION_UPDATE)) {
+            LOG_I(LOG_TOPIC_MESH, "[LoRa] Registering user: %.*s", (int)parameters.len, parameters.data);
             User::registerUserWithToken(
-                String(fields["name"].c_str()),
-                String(fields["pwdHash"].c_str()),
-                String(fields["team"].c_str()),
-                String(fields["token"].c_str())
+                viewToString(fields.get("name")),
+                viewToString(fields.get("pwdHash")),
+                viewToString(fields.get("team")),
+                viewToString(fields.get("token"))
             );
         }
         // DELETE function removed, as User::removeUser does not exist
     }
+#endif
 
-    if (nodeMessage.object == "SETUP")
+    if (nodeMessage.object == MSG_OBJECT_SETUP)
     {
-        Serial.println("[LoRa] Setting up user: " + nodeMessage.parameters);
+        LOG_D(LOG_TOPIC_MESH, "[LoRa] Setting up user: %.*s",
+              (int)nodeMessage.parameters().len, nodeMessage.parameters().data);
     }
-    if (nodeMessage.object == "MSG")
+    if (nodeMessage.object == MSG_OBJECT_MSG)
     {
-        Serial.println("[LoRa] Sending message: " + nodeMessage.parameters);
+        LOG_D(LOG_TOPIC_MESH, "[LoRa] Sending message: %.*s",
+              (int)nodeMessage.parameters().len, nodeMessage.parameters().data);
     }
 
-    if (isTargetedForThisNode(nodeMessage))
+    if (isTargetedForThisNode(fields))
     {
         sendAckForMessage(nodeMessage);
     }
@@ -536,557 +861,572 @@ void LoraNode::handleMessage(NodeMessage nodeMessage)
 // =======================
 // Handle incoming packets
 // =======================
-void LoraNode::handlePacket(const String &packet)
+// Each handler gets the frame starting at its prefix; all fields are views
+// into the RX buffer, so parsing itself never touches the heap.
+typedef void (*PacketHandler)(StrView frame);
+
+#if FEATURE_ENABLE_WEBSERVER
+static void storePagesPayload(StrView payload)
 {
-    String workingPacket = packet;
-    if (workingPacket.startsWith("LORA_TX;"))
+    bool anyPages = false;
+    int storedCount = 0;
+    LOG_D(LOG_TOPIC_SYNC, "[PAGE-SYNC] Payload length: %u", (unsigned)payload.len);
+    if (payload.len > 0)
     {
-        workingPacket = workingPacket.substring(String("LORA_TX;").length());
+        LOG_D(LOG_TOPIC_SYNC, "[PAGE-SYNC] Payload preview: %.*s", (int)(payload.len > 160 ? 160 : payload.len), payload.data);
     }
-    if (workingPacket.startsWith("REQ;STATS;"))
+
+    FieldTokenizer entries(payload, ';');
+    StrView entry;
+    while (entries.next(entry))
     {
-        String nodeId = workingPacket.substring(String("REQ;STATS;").length());
-        nodeId.trim();
-        if (nodeId.length() == 0 || nodeId == LoraNode::getNodeName())
+        entry = entry.trimmed();
+        if (entry.empty())
         {
-            int usersCount = User::getUserCount();
-            int pagesCount = NodeWebServer::getStoredPagesCount();
-            String resp = "RESP;STATS;" + LoraNode::getNodeName() + ";" + String(usersCount) + ";" + String(pagesCount);
-            Serial.println("[STATS] Responding: " + resp);
-            LoraNode::transmitRaw(resp);
-            Serial.println(resp);
+            continue;
         }
-        return;
+        StrView parts[3];
+        size_t count = PacketParser::splitFields(entry, '|', parts, 3);
+        if (count < 2 || parts[0].empty())
+        {
+            LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] Skipped entry without team separator");
+            continue;
+        }
+        String team = viewToString(parts[0]);
+        String updatedAt = count > 2 ? viewToString(parts[2]) : String();
+        String html;
+        appendUrlDecoded(html, parts[1]);
+        NodeWebServer::storeTeamPage(team, html, updatedAt);
+        anyPages = true;
+        storedCount++;
+        LOG_I(LOG_TOPIC_SYNC, "[PAGE-SYNC] Stored page for team: %s updated=%s", team.c_str(), updatedAt.c_str());
     }
-    int usersPartPos = workingPacket.indexOf("RESP;USERS;PART;");
-    if (usersPartPos > 0)
+
+    LOG_I(LOG_TOPIC_SYNC, "[PAGE-SYNC] Stored pages total: %d", storedCount);
+    LoraNode::setPagesSynced(anyPages);
+    NodeWebServer::setPagesSynced(anyPages);
+}
+
+// Joins multipart payloads, inserting the entry separator where a part boundary lacks one
+static String joinSyncParts(String *parts, int count)
+{
+    size_t total = 0;
+    for (int i = 0; i < count; i++)
     {
-        workingPacket = workingPacket.substring(usersPartPos);
+        total += parts[i].length() + 1;
     }
-    int usersPos = workingPacket.indexOf("RESP;USERS;");
-    if (usersPos > 0)
+    String combined;
+    combined.reserve(total);
+    for (int i = 0; i < count; i++)
     {
-        workingPacket = workingPacket.substring(usersPos);
+        if (parts[i].length() == 0)
+        {
+            continue;
+        }
+        if (combined.length() > 0 && !combined.endsWith(";") && !parts[i].startsWith(";"))
+        {
+            combined += ';';
+        }
+        combined += parts[i];
+        parts[i] = "";
     }
-    int pagesPos = workingPacket.indexOf("RESP;PAGES;");
-    if (pagesPos > 0)
+    return combined;
+}
+
+static void onUsersSynced(bool ok)
+{
+    LoraNode::setUsersSynced(ok);
+    NodeWebServer::setUsersSynced(ok);
+    if (ok && !LoraNode::isPagesSynced())
     {
-        workingPacket = workingPacket.substring(pagesPos);
+        LoraNode::requestPages();
+        LoraNode::lastSyncAttempt = millis();
     }
+}
+#endif
 
-    int multiPagesPartPos = workingPacket.indexOf("RESP;PAGES;PART;", 1);
-    if (workingPacket.startsWith("RESP;PAGES;PART;") && multiPagesPartPos > 0)
+// REQ;STATS;[nodeId]
+static void handleStatsRequest(StrView frame)
+{
+    StrView nodeId = frame.substr(strlen("REQ;STATS;")).trimmed();
+    const String &nodeName = LoraNode::getNodeName();
+    if (!nodeId.empty() && !nodeId.equals(nodeName.c_str()))
     {
-        int start = 0;
-        while (true)
-        {
-            int idx = workingPacket.indexOf("RESP;PAGES;PART;", start);
-            if (idx < 0)
-            {
-                break;
-            }
-            int next = workingPacket.indexOf("RESP;PAGES;PART;", idx + 1);
-            String chunk = (next > 0) ? workingPacket.substring(idx, next) : workingPacket.substring(idx);
-            handlePacket(chunk);
-            if (next < 0)
-            {
-                return;
-            }
-            start = next;
-        }
+        return;
     }
+    char resp[96];
+    int len = snprintf(resp, sizeof(resp), "RESP;STATS;%s;%d;%d",
+                       nodeName.c_str(), User::getUserCount(), NodeWebServer::getStoredPagesCount());
+    LOG_D(LOG_TOPIC_MESH, "[STATS] Responding: %s", resp);
+    LoraNode::transmitRaw(resp, len);
+}
 
-    if (workingPacket.startsWith("RESP;USERS;PART;"))
+// REQ;METRICS;[nodeId]
+static void handleMetricsRequest(StrView frame)
+{
+    StrView nodeId = frame.substr(strlen("REQ;METRICS;")).trimmed();
+    const String &nodeName = LoraNode::getNodeName();
+    if (!nodeId.empty() && !nodeId.equals(nodeName.c_str()))
     {
-        const unsigned long nowMs = millis();
-        if (nowMs - usersSyncLastPartMs > 90000)
-        {
-            for (int i = 0; i < MAX_USER_SYNC_PARTS; i++)
-            {
-                usersSyncParts[i] = "";
-            }
-            usersSyncExpectedParts = 0;
-            usersSyncReceivedParts = 0;
-        }
-        usersSyncLastPartMs = nowMs;
-
-        int s1 = workingPacket.indexOf(';');
-        int s2 = workingPacket.indexOf(';', s1 + 1);
-        int s3 = workingPacket.indexOf(';', s2 + 1);
-        int s4 = workingPacket.indexOf(';', s3 + 1);
-        int s5 = workingPacket.indexOf(';', s4 + 1);
-        if (s1 == -1 || s2 == -1 || s3 == -1 || s4 == -1 || s5 == -1)
+        return;
+    }
+    char resp[RX_BUFFER_SIZE + 1];
+    size_t len = Metrics::buildResponse(nodeName.c_str(), resp, sizeof(resp));
+    LOG_D(LOG_TOPIC_MESH, "[METRICS] Responding with %u bytes", (unsigned)len);
+    LoraNode::transmitRaw(resp, len);
+}
+
+#if FEATURE_ENABLE_WEBSERVER
+// RESP;USERS;PART;index;total;payload
+static void handleUsersPart(StrView frame)
+{
+    const unsigned long nowMs = millis();
+    if (nowMs - usersSyncLastPartMs > 90000)
+    {
+        for (int i = 0; i < MAX_USER_SYNC_PARTS; i++)
         {
-            Serial.println("[USER-SYNC] Invalid PART header");
-            return;
+            usersSyncParts[i] = "";
         }
+        usersSyncExpectedParts = 0;
+        usersSyncReceivedParts = 0;
+    }
+    usersSyncLastPartMs = nowMs;
 
-        int partIndex = workingPacket.substring(s3 + 1, s4).toInt();
-        int partTotal = workingPacket.substring(s4 + 1, s5).toInt();
-        String payload = workingPacket.substring(s5 + 1);
+    StrView fields[6];
+    if (PacketParser::splitFields(frame, ';', fields, 6) < 6)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] Invalid PART header");
+        return;
+    }
 
-        if (partTotal <= 0 || partTotal > MAX_USER_SYNC_PARTS || partIndex <= 0 || partIndex > partTotal)
-        {
-            Serial.println("[USER-SYNC] PART out of range");
-            return;
-        }
+    int partIndex = fields[3].toInt();
+    int partTotal = fields[4].toInt();
+    StrView payload = fields[5];
 
-        if (usersSyncExpectedParts == 0)
-        {
-            usersSyncExpectedParts = partTotal;
-        }
-        else if (usersSyncExpectedParts != partTotal)
-        {
-            Serial.println("[USER-SYNC] PART total changed, resetting cache");
-            for (int i = 0; i < MAX_USER_SYNC_PARTS; i++)
-            {
-                usersSyncParts[i] = "";
-            }
-            usersSyncExpectedParts = partTotal;
-            usersSyncReceivedParts = 0;
-        }
+    if (partTotal <= 0 || partTotal > MAX_USER_SYNC_PARTS || partIndex <= 0 || partIndex > partTotal)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] PART out of range");
+        return;
+    }
 
-        if (usersSyncParts[partIndex - 1].length() == 0)
+    if (usersSyncExpectedParts == 0)
+    {
+        usersSyncExpectedParts = partTotal;
+    }
+    else if (usersSyncExpectedParts != partTotal)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] PART total changed, resetting cache");
+        for (int i = 0; i < MAX_USER_SYNC_PARTS; i++)
         {
-            usersSyncParts[partIndex - 1] = payload;
-            usersSyncReceivedParts++;
+            usersSyncParts[i] = "";
         }
+        usersSyncExpectedParts = partTotal;
+        usersSyncReceivedParts = 0;
+    }
 
-        lastUsersResendMs = nowMs;
+    if (usersSyncParts[partIndex - 1].length() == 0)
+    {
+        usersSyncParts[partIndex - 1].concat(payload.data, payload.len);
+        usersSyncReceivedParts++;
+        Metrics::inc(CTR_SYNC_PARTS_RECEIVED);
+    }
 
-        Serial.printf("[USER-SYNC] PART %d/%d received (len=%d)\n", partIndex, partTotal, payload.length());
+    lastUsersResendMs = nowMs;
 
-        if (usersSyncReceivedParts >= usersSyncExpectedParts)
-        {
-            String combined;
-            for (int i = 0; i < usersSyncExpectedParts; i++)
-            {
-                if (usersSyncParts[i].length() == 0)
-                {
-                    continue;
-                }
-                if (combined.length() > 0 && !combined.endsWith(";") && !usersSyncParts[i].startsWith(";"))
-                {
-                    combined += ';';
-                }
-                combined += usersSyncParts[i];
-                usersSyncParts[i] = "";
-            }
+    LOG_D(LOG_TOPIC_SYNC, "[USER-SYNC] PART %d/%d received (len=%u)", partIndex, partTotal, (unsigned)payload.len);
 
-            usersSyncExpectedParts = 0;
-            usersSyncReceivedParts = 0;
-                    Serial.println("[PAGE-SYNC] Resetting PART cache (timeout)");
+    if (usersSyncReceivedParts >= usersSyncExpectedParts)
+    {
+        String combined = joinSyncParts(usersSyncParts, usersSyncExpectedParts);
+        usersSyncExpectedParts = 0;
+        usersSyncReceivedParts = 0;
 
-            User::setRuntimeCacheOnly(false);
-            bool ok = User::setUsersFromSyncPayload(combined);
-            LoraNode::setUsersSynced(ok);
-            NodeWebServer::setUsersSynced(ok);
-            if (ok && !LoraNode::isPagesSynced())
-            {
-                requestPages();
-                lastSyncAttempt = millis();
-            }
-        }
-        return;
+        User::setRuntimeCacheOnly(false);
+        onUsersSynced(User::setUsersFromSyncPayload(combined));
     }
+}
 
-    if (workingPacket.startsWith("RESP;USERS;"))
+// RESP;USERS;payload
+static void handleUsers(StrView frame)
+{
+    User::setRuntimeCacheOnly(false);
+    onUsersSynced(User::setUsersFromSyncPayload(viewToString(frame.substr(strlen("RESP;USERS;")))));
+}
+
+// RESP;PAGES;PART;index;total;payload (several parts may arrive back to back)
+static void handlePagesPart(StrView frame)
+{
+    static const char PART_PREFIX[] = "RESP;PAGES;PART;";
+    int next = frame.find(PART_PREFIX, 1);
+    if (next > 0)
     {
-        String payload = workingPacket.substring(String("RESP;USERS;").length());
-        User::setRuntimeCacheOnly(false);
-        bool ok = User::setUsersFromSyncPayload(payload);
-        LoraNode::setUsersSynced(ok);
-        NodeWebServer::setUsersSynced(ok);
-        if (ok && !LoraNode::isPagesSynced())
-        {
-            requestPages();
-            lastSyncAttempt = millis();
-        }
+        handlePagesPart(frame.substr(0, next));
+        handlePagesPart(frame.substr(next));
         return;
     }
 
-    if (workingPacket.startsWith("RESP;PAGES;PART;"))
+    LOG_D(LOG_TOPIC_SYNC, "[PAGE-SYNC] Receiving multipart pages payload");
+    const unsigned long nowMs = millis();
+    if (nowMs - pagesSyncLastPartMs > 120000)
     {
-        Serial.println("[PAGE-SYNC] Receiving multipart pages payload");
-        const unsigned long nowMs = millis();
-        if (nowMs - pagesSyncLastPartMs > 120000)
-        {
-            for (int i = 0; i < MAX_PAGE_SYNC_PARTS; i++)
-            {
-                pagesSyncParts[i] = "";
-            }
-            pagesSyncExpectedParts = 0;
-            pagesSyncReceivedParts = 0;
-        }
-        pagesSyncLastPartMs = nowMs;
-
-        int s1 = workingPacket.indexOf(';');
-        int s2 = workingPacket.indexOf(';', s1 + 1);
-        int s3 = workingPacket.indexOf(';', s2 + 1);
-        int s4 = workingPacket.indexOf(';', s3 + 1);
-        int s5 = workingPacket.indexOf(';', s4 + 1);
-        if (s1 == -1 || s2 == -1 || s3 == -1 || s4 == -1 || s5 == -1)
+        for (int i = 0; i < MAX_PAGE_SYNC_PARTS; i++)
         {
-            Serial.println("[PAGE-SYNC] Invalid PART header");
-            return;
+            pagesSyncParts[i] = "";
         }
+        pagesSyncExpectedParts = 0;
+        pagesSyncReceivedParts = 0;
+    }
+    pagesSyncLastPartMs = nowMs;
 
-        int partIndex = workingPacket.substring(s3 + 1, s4).toInt();
-        int partTotal = workingPacket.substring(s4 + 1, s5).toInt();
-        String payload = workingPacket.substring(s5 + 1);
+    StrView fields[6];
+    if (PacketParser::splitFields(frame, ';', fields, 6) < 6)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] Invalid PART header");
+        return;
+    }
 
-        if (partTotal <= 0 || partTotal > MAX_PAGE_SYNC_PARTS || partIndex <= 0 || partIndex > partTotal)
-        {
-            Serial.println("[PAGE-SYNC] PART out of range");
-            return;
-        }
+    int partIndex = fields[3].toInt();
+    int partTotal = fields[4].toInt();
+    StrView payload = fields[5];
 
-        if (pagesSyncExpectedParts == 0)
-        {
-            pagesSyncExpectedParts = partTotal;
-        }
+    if (partTotal <= 0 || partTotal > MAX_PAGE_SYNC_PARTS || partIndex <= 0 || partIndex > partTotal)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] PART out of range");
+        return;
+    }
 
-        if (pagesSyncParts[partIndex - 1].length() == 0)
-        {
-            pagesSyncParts[partIndex - 1] = payload;
-            pagesSyncReceivedParts++;
-        }
+    if (pagesSyncExpectedParts == 0)
+    {
+        pagesSyncExpectedParts = partTotal;
+    }
 
-        Serial.printf("[PAGE-SYNC] PART %d/%d received (len=%d)\n", partIndex, partTotal, payload.length());
-        Serial.printf("[PAGE-SYNC] Parts received: %d/%d\n", pagesSyncReceivedParts, pagesSyncExpectedParts);
+    if (pagesSyncParts[partIndex - 1].length() == 0)
+    {
+        pagesSyncParts[partIndex - 1].concat(payload.data, payload.len);
+        pagesSyncReceivedParts++;
+        Metrics::inc(CTR_SYNC_PARTS_RECEIVED);
+    }
 
-        if (pagesSyncReceivedParts >= pagesSyncExpectedParts)
-        {
-            String combined;
-            for (int i = 0; i < pagesSyncExpectedParts; i++)
-            {
-                if (pagesSyncParts[i].length() == 0)
-                {
-                    continue;
-                }
-                if (combined.length() > 0 && !combined.endsWith(";") && !pagesSyncParts[i].startsWith(";"))
-                {
-                    combined += ';';
-                }
-                combined += pagesSyncParts[i];
-                pagesSyncParts[i] = "";
-            }
+    LOG_D(LOG_TOPIC_SYNC, "[PAGE-SYNC] PART %d/%d received (len=%u)", partIndex, partTotal, (unsigned)payload.len);
+    LOG_D(LOG_TOPIC_SYNC, "[PAGE-SYNC] Parts received: %d/%d", pagesSyncReceivedParts, pagesSyncExpectedParts);
 
-            pagesSyncExpectedParts = 0;
-            pagesSyncReceivedParts = 0;
+    if (pagesSyncReceivedParts >= pagesSyncExpectedParts)
+    {
+        String combined = joinSyncParts(pagesSyncParts, pagesSyncExpectedParts);
+        pagesSyncExpectedParts = 0;
+        pagesSyncReceivedParts = 0;
+        storePagesPayload(StrView(combined.c_str(), combined.length()));
+    }
+}
 
-            Serial.printf("[PAGE-SYNC] Combined payload length: %d\n", combined.length());
-            if (combined.length() > 0)
-            {
-                String preview = combined.substring(0, combined.length() > 160 ? 160 : combined.length());
-                Serial.println("[PAGE-SYNC] Payload preview: " + preview);
-            }
-            bool anyPages = false;
-            int storedCount = 0;
-            int start = 0;
-            while (start < combined.length())
-            {
-                int end = combined.indexOf(';', start);
-                if (end == -1) end = combined.length();
-                String entry = combined.substring(start, end);
-                entry.trim();
-                if (entry.length() > 0)
-                {
-                    int p1 = entry.indexOf('|');
-                    int p2 = (p1 > 0) ? entry.indexOf('|', p1 + 1) : -1;
-                    if (p1 > 0)
-                    {
-                        String team = entry.substring(0, p1);
-                        String encoded = (p2 > p1) ? entry.substring(p1 + 1, p2) : entry.substring(p1 + 1);
-                        String updatedAt = (p2 > p1) ? entry.substring(p2 + 1) : "";
-                        String html = urlDecode(encoded);
-                        NodeWebServer::storeTeamPage(team, html, updatedAt);
-                        anyPages = true;
-                        storedCount++;
-                        Serial.printf("[PAGE-SYNC] Stored page for team: %s updated=%s\n", team.c_str(), updatedAt.c_str());
-                    }
-                    else
-                    {
-                        Serial.println("[PAGE-SYNC] Skipped entry without team separator");
-                    }
-                }
-                start = end + 1;
-            }
+static void startPageEntrySlot(int slot, const char *team, int partTotal, const char *updatedAt)
+{
+    resetPageEntrySlot(slot);
+    pageEntryTeams[slot] = team;
+    pageEntryTotals[slot] = partTotal;
+    pageEntryUpdatedAt[slot] = updatedAt;
+}
 
-            Serial.printf("[PAGE-SYNC] Stored pages total: %d\n", storedCount);
-            LoraNode::setPagesSynced(anyPages);
-            NodeWebServer::setPagesSynced(anyPages);
-        }
+// RESP;PAGE;team;index;total;updatedAt;chunk
+static void handlePage(StrView frame)
+{
+    const unsigned long nowMs = millis();
+    StrView fields[7];
+    if (PacketParser::splitFields(frame, ';', fields, 7) < 7)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] Invalid RESP;PAGE packet");
         return;
     }
 
-    if (workingPacket.startsWith("RESP;PAGE;"))
+    int partIndex = fields[3].toInt();
+    int partTotal = fields[4].toInt();
+    StrView chunk = fields[6];
+
+    if (partTotal <= 0 || partTotal > MAX_PAGE_ENTRY_PARTS || partIndex <= 0 || partIndex > partTotal)
     {
-        const unsigned long nowMs = millis();
-        int s1 = workingPacket.indexOf(';');
-        int s2 = workingPacket.indexOf(';', s1 + 1);
-        int s3 = workingPacket.indexOf(';', s2 + 1);
-        int s4 = workingPacket.indexOf(';', s3 + 1);
-        int s5 = workingPacket.indexOf(';', s4 + 1);
-        int s6 = workingPacket.indexOf(';', s5 + 1);
-        if (s1 == -1 || s2 == -1 || s3 == -1 || s4 == -1 || s5 == -1 || s6 == -1)
-        {
-            Serial.println("[PAGE-SYNC] Invalid RESP;PAGE packet");
-            return;
-        }
+        LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] RESP;PAGE part out of range");
+        return;
+    }
 
-        String teamEncoded = workingPacket.substring(s2 + 1, s3);
-        int partIndex = workingPacket.substring(s3 + 1, s4).toInt();
-        int partTotal = workingPacket.substring(s4 + 1, s5).toInt();
-        String updatedAtEncoded = workingPacket.substring(s5 + 1, s6);
-        String chunk = workingPacket.substring(s6 + 1);
+    char team[64];
+    char updatedAt[48];
+    PacketParser::urlDecode(fields[2], team, sizeof(team));
+    PacketParser::urlDecode(fields[5], updatedAt, sizeof(updatedAt));
 
-        if (partTotal <= 0 || partTotal > MAX_PAGE_ENTRY_PARTS || partIndex <= 0 || partIndex > partTotal)
+    LoraNode::setPagesSynced(false);
+    NodeWebServer::setPagesSynced(false);
+    pagesSyncRequestMs = nowMs;
+
+    int slot = -1;
+    for (int i = 0; i < MAX_PAGE_TEAMS; i++)
+    {
+        if (pageEntryTeams[i] == team || pageEntryTeams[i].length() == 0)
         {
-            Serial.println("[PAGE-SYNC] RESP;PAGE part out of range");
-            return;
+            slot = i;
+            break;
         }
+    }
 
-        String team = urlDecode(teamEncoded);
-        String updatedAt = urlDecode(updatedAtEncoded);
+    if (slot < 0)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] No slot available for page parts");
+        return;
+    }
 
-        LoraNode::setPagesSynced(false);
-        NodeWebServer::setPagesSynced(false);
-        pagesSyncRequestMs = nowMs;
+    if (pageEntryTeams[slot].length() == 0)
+    {
+        startPageEntrySlot(slot, team, partTotal, updatedAt);
+        pageEntryLastPartMs[slot] = nowMs;
+    }
+    else if ((nowMs - pageEntryLastPartMs[slot]) > 120000)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] RESP;PAGE slot timeout, resetting slot %d", slot);
+        startPageEntrySlot(slot, team, partTotal, updatedAt);
+    }
+    else if (pageEntryTotals[slot] != partTotal || pageEntryUpdatedAt[slot] != updatedAt)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[PAGE-SYNC] RESP;PAGE metadata changed, resetting slot %d", slot);
+        startPageEntrySlot(slot, team, partTotal, updatedAt);
+    }
 
-        int slot = -1;
-        for (int i = 0; i < MAX_PAGE_TEAMS; i++)
-        {
-            if (pageEntryTeams[i] == team || pageEntryTeams[i].length() == 0)
-            {
-                slot = i;
-                break;
-            }
-        }
+    if (pageEntryChunks[slot][partIndex - 1].length() == 0)
+    {
+        pageEntryChunks[slot][partIndex - 1].concat(chunk.data, chunk.len);
+        pageEntryReceived[slot]++;
+        Metrics::inc(CTR_SYNC_PARTS_RECEIVED);
+    }
 
-        if (slot < 0)
-        {
-            Serial.println("[PAGE-SYNC] No slot available for page parts");
-            return;
-        }
+    pageEntryLastPartMs[slot] = nowMs;
+
+    LOG_D(LOG_TOPIC_SYNC, "[PAGE-SYNC] RESP;PAGE team=%s part %d/%d (slot=%d)", team, partIndex, partTotal, slot);
 
-        if (pageEntryTeams[slot].length() == 0)
+    if (pageEntryReceived[slot] >= pageEntryTotals[slot])
+    {
+        // Decode only once all chunks are in: an escape may straddle two chunks
+        String encoded;
+        for (int i = 0; i < pageEntryTotals[slot]; i++)
         {
-            pageEntryTeams[slot] = team;
-            pageEntryTotals[slot] = partTotal;
-            pageEntryReceived[slot] = 0;
-            pageEntryUpdatedAt[slot] = updatedAt;
-            for (int i = 0; i < MAX_PAGE_ENTRY_PARTS; i++)
-            {
-                pageEntryChunks[slot][i] = "";
-            }
-            pageEntryLastPartMs[slot] = nowMs;
-        }
-        else
-        {
-            if ((nowMs - pageEntryLastPartMs[slot]) > 120000)
-            {
-                Serial.printf("[PAGE-SYNC] RESP;PAGE slot timeout, resetting slot %d\n", slot);
-                resetPageEntrySlot(slot);
-                pageEntryTeams[slot] = team;
-                pageEntryTotals[slot] = partTotal;
-                pageEntryReceived[slot] = 0;
-                pageEntryUpdatedAt[slot] = updatedAt;
-            }
-            else if (pageEntryTotals[slot] != partTotal || pageEntryUpdatedAt[slot] != updatedAt)
-            {
-                Serial.printf("[PAGE-SYNC] RESP;PAGE metadata changed, resetting slot %d\n", slot);
-                resetPageEntrySlot(slot);
-                pageEntryTeams[slot] = team;
-                pageEntryTotals[slot] = partTotal;
-                pageEntryReceived[slot] = 0;
-                pageEntryUpdatedAt[slot] = updatedAt;
-            }
+            encoded += pageEntryChunks[slot][i];
         }
+        String html;
+        appendUrlDecoded(html, StrView(encoded.c_str(), encoded.length()));
+        NodeWebServer::storeTeamPage(team, html, updatedAt);
+        LOG_I(LOG_TOPIC_SYNC, "[PAGE-SYNC] RESP;PAGE assembled for team: %s (len=%d)", team, html.length());
 
-        if (pageEntryChunks[slot][partIndex - 1].length() == 0)
+        resetPageEntrySlot(slot);
+
+        if (!hasActivePageEntries())
         {
-            pageEntryChunks[slot][partIndex - 1] = chunk;
-            pageEntryReceived[slot]++;
+            LoraNode::setPagesSynced(true);
+            NodeWebServer::setPagesSynced(true);
         }
+    }
+}
 
-        pageEntryLastPartMs[slot] = nowMs;
+// RESP;PAGES;payload
+static void handlePages(StrView frame)
+{
+    LOG_D(LOG_TOPIC_SYNC, "[PAGE-SYNC] Receiving single pages payload");
+    storePagesPayload(frame.substr(strlen("RESP;PAGES;")));
+}
+#endif
 
-        Serial.printf("[PAGE-SYNC] RESP;PAGE team=%s part %d/%d (slot=%d)\n", team.c_str(), partIndex, partTotal, slot);
+static void handlePing(StrView /*frame*/)
+{
+    char pong[96];
+    int len = snprintf(pong, sizeof(pong), "PONG;%s;%lu", LoraNode::getNodeName().c_str(), millis());
+    LOG_D(LOG_TOPIC_MESH, "[PING] Replying: %s", pong);
+    LoraNode::transmitRaw(pong, len);
+}
 
-        if (pageEntryReceived[slot] >= pageEntryTotals[slot])
-        {
-            String encoded;
-            for (int i = 0; i < pageEntryTotals[slot]; i++)
-            {
-                encoded += pageEntryChunks[slot][i];
-            }
-            String html = urlDecode(encoded);
-            NodeWebServer::storeTeamPage(team, html, updatedAt);
-            Serial.printf("[PAGE-SYNC] RESP;PAGE assembled for team: %s (len=%d)\n", team.c_str(), html.length());
+static void handlePong(StrView frame)
+{
+    (void)frame; // only used for logging
+    LOG_D(LOG_TOPIC_MESH, "[PING] Received: %.*s", (int)frame.len, frame.data);
+}
 
-            resetPageEntrySlot(slot);
+static void handleAck(StrView frame)
+{
+    (void)frame; // only used for logging
+    LOG_D(LOG_TOPIC_MESH, "[ACK] Received: %.*s", (int)frame.len, frame.data);
+}
 
-            if (!hasActivePageEntries())
-            {
-                LoraNode::setPagesSynced(true);
-                NodeWebServer::setPagesSynced(true);
-            }
-        }
-        return;
+// Low on battery, the node leaves part or all of the relaying to others
+static bool relayAllowed()
+{
+    if (DutyPolicy::shouldRelay(esp_random()))
+    {
+        return true;
     }
+    Metrics::inc(CTR_RELAY_SKIPPED);
+    return false;
+}
 
-    if (workingPacket.startsWith("RESP;PAGES;"))
+// BCAST;msgId;user;ttl;content or the older BCAST;user;ttl;content
+static void handleBroadcast(StrView frame)
+{
+    StrView fields[5];
+    size_t count = PacketParser::splitFields(frame, ';', fields, 5);
+    if (count < 4)
     {
-        Serial.println("[PAGE-SYNC] Receiving single pages payload");
-        String payload = workingPacket.substring(String("RESP;PAGES;").length());
-        bool anyPages = false;
-        int storedCount = 0;
-        Serial.printf("[PAGE-SYNC] Payload length: %d\n", payload.length());
-        if (payload.length() > 0)
-        {
-            String preview = payload.substring(0, payload.length() > 160 ? 160 : payload.length());
-            Serial.println("[PAGE-SYNC] Payload preview: " + preview);
-        }
-        int start = 0;
-        while (start < payload.length())
-        {
-            int end = payload.indexOf(';', start);
-            if (end == -1) end = payload.length();
-            String entry = payload.substring(start, end);
-            entry.trim();
-            if (entry.length() > 0)
-            {
-                int p1 = entry.indexOf('|');
-                int p2 = (p1 > 0) ? entry.indexOf('|', p1 + 1) : -1;
-                if (p1 > 0)
-                {
-                    String team = entry.substring(0, p1);
-                    String encoded = (p2 > p1) ? entry.substring(p1 + 1, p2) : entry.substring(p1 + 1);
-                    String updatedAt = (p2 > p1) ? entry.substring(p2 + 1) : "";
-                    String html = urlDecode(encoded);
-                    NodeWebServer::storeTeamPage(team, html, updatedAt);
-                    anyPages = true;
-                    storedCount++;
-                    Serial.printf("[PAGE-SYNC] Stored page for team: %s updated=%s\n", team.c_str(), updatedAt.c_str());
-                }
-                else
-                {
-                    Serial.println("[PAGE-SYNC] Skipped entry without team separator");
-                }
-            }
-            start = end + 1;
-        }
-
-        Serial.printf("[PAGE-SYNC] Stored pages total: %d\n", storedCount);
-        LoraNode::setPagesSynced(anyPages);
-        NodeWebServer::setPagesSynced(anyPages);
         return;
     }
 
-    if (workingPacket.startsWith("PING;"))
+    char idText[24];
+    StrView msgId;
+    StrView user;
+    StrView content;
+    int ttl = 0;
+    if (count == 5)
     {
-        String pong = "PONG;" + LoraNode::getNodeName() + ";" + String(millis());
-        Serial.println("[PING] Replying: " + pong);
-        LoraNode::transmitRaw(pong);
-        Serial.println(pong);
-        return;
+        msgId = fields[1];
+        user = fields[2];
+        ttl = fields[3].toInt();
+        content = fields[4];
     }
-
-    if (workingPacket.startsWith("PONG;"))
+    else
     {
-        Serial.println("[PING] Received: " + workingPacket);
-        return;
+        user = fields[1];
+        ttl = fields[2].toInt();
+        content = fields[3];
+        msgId = StrView(idText, NodeMessage::formatId(millis(), idText, sizeof(idText)));
     }
 
-    if (workingPacket.startsWith("ACK;"))
+    NodeMessage msg;
+    msg.set(NodeMessage::parseId(msgId), user, ttl, millis(), MSG_OBJECT_BCAST, MSG_FUNCTION_RX, content);
+    // Relayed copies come back from every neighbour; store the first only
+    if (hasSeenMsgId(msg.msgId))
     {
-        Serial.println("[ACK] Received: " + workingPacket);
+        Metrics::inc(CTR_DEDUP_HITS);
         return;
     }
+    rememberMsgId(msg.msgId);
+    LoraNode::addMessage(msg);
 
-    if (workingPacket.startsWith("BCAST;"))
+    if (ttl > 0)
     {
-        int p1 = workingPacket.indexOf(';');
-        int p2 = workingPacket.indexOf(';', p1 + 1);
-        int p3 = workingPacket.indexOf(';', p2 + 1);
-        int p4 = workingPacket.indexOf(';', p3 + 1);
-        if (p1 > -1 && p2 > -1 && p3 > -1)
+        if (!relayAllowed())
         {
-            String msgId;
-            String user;
-            int ttl = 0;
-            String content;
-
-            if (p4 > -1)
-            {
-                msgId = workingPacket.substring(p1 + 1, p2);
-                user = workingPacket.substring(p2 + 1, p3);
-                ttl = workingPacket.substring(p3 + 1, p4).toInt();
-                content = workingPacket.substring(p4 + 1);
-            }
-            else
-            {
-                msgId = String(millis());
-                user = workingPacket.substring(p1 + 1, p2);
-                ttl = workingPacket.substring(p2 + 1, p3).toInt();
-                content = workingPacket.substring(p3 + 1);
-            }
-
-            NodeMessage msg;
-            msg.msgId = msgId;
-            msg.user = user;
-            msg.TTL = ttl;
-            msg.timestamp = millis();
-            msg.object = "BCAST";
-            msg.function = "RX";
-            msg.parameters = content;
-            addMessage(msg);
-
-            if (ttl > 0 && !hasSeenMsgId(msg.msgId))
-            {
-                rememberMsgId(msg.msgId);
-                String forward = "BCAST;" + msgId + ";" + user + ";" + String(ttl - 1) + ";" + content;
-                LoraNode::transmitRaw(forward);
-            }
+            return;
+        }
+        char forward[RX_BUFFER_SIZE + 16];
+        int len = snprintf(forward, sizeof(forward), "BCAST;%.*s;%.*s;%d;%.*s",
+                           (int)msgId.len, msgId.data, (int)user.len, user.data, ttl - 1, (int)content.len, content.data);
+        if (LoraNode::transmitRaw(forward, min(len, (int)sizeof(forward) - 1)))
+        {
+            Metrics::inc(CTR_RELAYED);
         }
-        return;
     }
+}
 
-    if (workingPacket.startsWith("BEACON;"))
+// BEACON;nodeName[;LP]
+static void handleBeacon(StrView frame)
+{
+    StrView fields[4];
+    size_t count = PacketParser::splitFields(frame, ';', fields, 4);
+    if (count < 2)
     {
-        String sender = workingPacket.substring(7);
-
-        float rssi = radio.getRSSI();
-        float snr = radio.getSNR();
-        addOnlineNode(sender, rssi, snr);
         return;
     }
+    const bool lowPower = count > 2 && fields[2].equals("LP");
+    LoraNode::addOnlineNode(fields[1].data, fields[1].len, lastRxRssi, lastRxSnr, lowPower);
+}
 
-    if (workingPacket.startsWith("MSG;"))
+// MSG;msgId;user;ttl;timestamp;object;function;parameters
+static void handleMsg(StrView frame)
+{
+    StrView fields[8];
+    size_t count = PacketParser::splitFields(frame, ';', fields, 8);
+
+    LOG_D(LOG_TOPIC_MESH, "[LoRa RX] Message received: %.*s", (int)frame.len, frame.data);
+
+    if (count < 4)
+    {
+        return;
+    }
+    const uint64_t msgId = NodeMessage::parseId(fields[1]);
+    if (hasSeenMsgId(msgId))
     {
-        NodeMessage nodeMessage = nodeMessageFromString(workingPacket);
+        LOG_W(LOG_TOPIC_MESH, "[LoRa RX] Duplicate msgId ignored: %.*s", (int)fields[1].len, fields[1].data);
+        Metrics::inc(CTR_DEDUP_HITS);
+        return;
+    }
+
+    NodeMessage nodeMessage;
+    nodeMessageFromFields(fields, count, nodeMessage);
+    rememberMsgId(msgId);
 
-        Serial.printf("[LoRa RX] Message received: %s\n", workingPacket.c_str());
+    // Parsed once over the RX buffer and shared by every consumer below
+    MessageFields params(count >= 8 ? fields[7] : StrView());
+    LoraNode::handleMessage(nodeMessage, params);
+    LoraNode::addMessage(nodeMessage);
 
-        if (hasSeenMsgId(nodeMessage.msgId))
+    bool isTargeted = isTargetedForThisNode(params);
+    if (!isTargeted && nodeMessage.ttl > 0 && count > 4 && relayAllowed())
+    {
+        // Re-send the original tail (timestamp onwards) with the TTL decremented
+        StrView tail(fields[4].data, frame.data + frame.len - fields[4].data);
+        char forward[RX_BUFFER_SIZE + 16];
+        int len = snprintf(forward, sizeof(forward), "MSG;%.*s;%.*s;%d;%.*s",
+                           (int)fields[1].len, fields[1].data, (int)fields[2].len, fields[2].data,
+                           nodeMessage.ttl - 1, (int)tail.len, tail.data);
+        len = min(len, (int)sizeof(forward) - 1);
+        LOG_D(LOG_TOPIC_RADIO, "[LoRa TX] %s", forward);
+        if (LoraNode::transmitRaw(forward, len))
         {
-            Serial.printf("[LoRa RX] Duplicate msgId ignored: %s\n", nodeMessage.msgId.c_str());
-            return;
+            Metrics::inc(CTR_RELAYED);
         }
-        rememberMsgId(nodeMessage.msgId);
-
-        handleMessage(nodeMessage);
-        addMessage(nodeMessage);
+    }
+}
 
-        bool isTargeted = isTargetedForThisNode(nodeMessage);
-        if (!isTargeted && nodeMessage.TTL > 0)
+struct PacketRoute
+{
+    PacketType type;
+    PacketHandler handler;
+};
+
+static const PacketRoute packetRoutes[] = {
+    {PKT_REQ_STATS, handleStatsRequest},
+    {PKT_REQ_METRICS, handleMetricsRequest},
+#if FEATURE_ENABLE_WEBSERVER
+    {PKT_RESP_USERS_PART, handleUsersPart},
+    {PKT_RESP_USERS, handleUsers},
+    {PKT_RESP_PAGES_PART, handlePagesPart},
+    {PKT_RESP_PAGE, handlePage},
+    {PKT_RESP_PAGES, handlePages},
+#endif
+    {PKT_PING, handlePing},
+    {PKT_PONG, handlePong},
+    {PKT_ACK, handleAck},
+    {PKT_BCAST, handleBroadcast},
+    {PKT_BEACON, handleBeacon},
+    {PKT_MSG, handleMsg},
+};
+
+static PacketType routePacket(const char *packet, size_t length)
+{
+    StrView frame;
+    PacketType type = PacketParser::classify(StrView(packet, length), frame);
+    for (size_t i = 0; i < sizeof(packetRoutes) / sizeof(packetRoutes[0]); i++)
+    {
+        if (packetRoutes[i].type == type)
         {
-            String forwardPacket = String(nodeMessage.timestamp) + ";" + nodeMessage.object + ";" + nodeMessage.function + ";" + nodeMessage.parameters;
-            LoraNode::loraSendFW(nodeMessage.msgId, nodeMessage.user, nodeMessage.TTL - 1, forwardPacket);
+            packetRoutes[i].handler(frame);
+            break;
         }
-        return;
     }
+    return type;
+}
+
+void LoraNode::handlePacket(const char *packet, size_t length)
+{
+    NodeStateLock lock;
+    routePacket(packet, length);
+}
+
+void LoraNode::handlePacket(const String &packet)
+{
+    handlePacket(packet.c_str(), packet.length());
 }
 
 // =======================
@@ -1095,12 +1435,12 @@ void LoraNode::handlePacket(const String &packet)
 void LoraNode::sendBeacon()
 {
     String packet = "BEACON;" + nodeName;
-    int state = radio.transmit(packet);
-
-    if (state == RADIOLIB_ERR_NONE)
+    if (DutyPolicy::isLowPower())
     {
-        Serial.println("[LoRa TX] " + packet);
+        // Neighbours see the flag; nodes that predate it ignore the field
+        packet += ";LP";
     }
+    transmitRaw(packet);
 }
 // =======================
 // Relay broadcast to all nodes
@@ -1110,16 +1450,11 @@ void LoraNode::relayBroadcast(const String &username, const String &content, int
     // Format: BCAST;msgId;username;ttl;content
     String packet = "BCAST;" + String(millis()) + ";" + username + ";" + String(ttl) + ";" + content;
     
-    Serial.printf("[BROADCAST RELAY] Sending to all nodes: %s | TTL: %d\n", username.c_str(), ttl);
-    
-    int state = radio.transmit(packet);
+    LOG_I(LOG_TOPIC_MESH, "[BROADCAST RELAY] Sending to all nodes: %s | TTL: %d", username.c_str(), ttl);
     
-    if (state == RADIOLIB_ERR_NONE)
-    {
-        Serial.println("[LoRa TX BCAST] Broadcast relayed successfully");
-    }
-    else
+    if (transmitRaw(packet))
     {
-        Serial.printf("[LoRa TX BCAST] Failed, code: %d\n", state);
+        LOG_D(LOG_TOPIC_RADIO, "[LoRa TX BCAST] Broadcast queued for relay");
+        Metrics::inc(CTR_RELAYED);
     }
 }
\ No newline at end of file
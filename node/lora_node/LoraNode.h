@@ -4,6 +4,9 @@
 #include <RadioLib.h>
 #include <Preferences.h>
 #include "User.h"
+#include "PacketParser.h"
+#include "NodeMessage.h"
+#include "NodeConfig.h"
 #include "version.h"
 
 // =======================
@@ -13,23 +16,27 @@
 #define LORA_RST 12
 #define LORA_BUSY 13
 #define LORA_DIO1 14
+// Radio parameters; every node in the mesh must use the same ones
+#define LORA_FREQUENCY_MHZ 868.0
+#define LORA_BANDWIDTH_KHZ 125.0
+#define LORA_SPREADING_FACTOR 9
+#define LORA_CODING_RATE 7 // 4/7
+#define LORA_SYNC_WORD 0x12
+// Symbols sent ahead of every frame. A POWER_SAVE receiver sleeps between
+// preamble checks only when senders leave it room: 8 (RadioLib's default)
+// keeps it listening continuously, 32 lets it sleep most of the time.
+#define LORA_PREAMBLE_LENGTH 8
 
 // Max limits
-#define MAX_MSGS 50
 #define MAX_ONLINE 20
+// Largest SX1262 payload
+#define RX_BUFFER_SIZE 255
 
-// =======================
-// Message struct
-// =======================
-struct NodeMessage
+// Who queued a frame; the gateway gets TXDONE reports for its own frames
+enum TxOrigin
 {
-  String msgId;
-  String user;
-  int TTL;
-  unsigned long timestamp;
-  String object;
-  String function;
-  String parameters;
+  TX_ORIGIN_NODE,
+  TX_ORIGIN_GATEWAY
 };
 
 // =======================
@@ -41,6 +48,8 @@ struct OnlineNode
   float rssi;
   float snr;
   unsigned long lastSeen;
+  // Its beacon said it is saving battery (see DutyPolicy.h)
+  bool lowPower;
 };
 
 // =======================
@@ -52,23 +61,20 @@ class LoraNode
 public:
   static int getOnlineCount() { return onlineCount; }
   static const OnlineNode *getOnlineNodes() { return onlineNodes; }
-  static const NodeMessage *getMessages() { return messages; }
   static void setup();
   static void loop();
-  static void addMessage(NodeMessage nodeMessage);
-  static void loraSend(NodeMessage nodeMessage);
-  static void loraSendFW(String msgID, const String &user, int TTL, const String &packet);
-  static int getMsgCount();
-  static int getMsgWriteIndex();
-  static NodeMessage getMessage(int index);
-  static String getMessageRow(int index);
-  static String getNodeName();
+  static void addMessage(const NodeMessage &nodeMessage);
+  static void loraSend(const NodeMessage &nodeMessage);
+  static const String &getNodeName();
   // Node management
   static void addOnlineNode(const String &node, float rssi, float snr);
-  static void handleMessage(NodeMessage nodeMessage);
+  static void addOnlineNode(const char *node, size_t length, float rssi, float snr, bool lowPower = false);
+  static void handleMessage(const NodeMessage &nodeMessage, const MessageFields &fields);
   static void handlePacket(const String &packet);
+  // packet does not need to be NUL-terminated; it is parsed in place
+  static void handlePacket(const char *packet, size_t length);
   static void cleanOfflineNodes();
-  static NodeMessage nodeMessageFromString(const String &str);
+  static void nodeMessageFromString(const String &str, NodeMessage &nodeMessage);
   static void requestUsers();
   static void requestPages();
   static bool isUsersSynced();
@@ -76,28 +82,35 @@ public:
   static void setUsersSynced(bool synced);
   static void setPagesSynced(bool synced);
   static bool isUsersSyncInProgress();
-  static void transmitRaw(const String &packet);
+  // Queues a packet for the radio task; false when it could not be queued
+  static bool transmitRaw(const String &packet);
+  static bool transmitRaw(const char *packet, size_t length, TxOrigin origin = TX_ORIGIN_NODE);
+  // True when the radio is listening with nothing queued in either
+  // direction, so the CPU can sleep without missing a frame
+  static bool isRadioIdle();
+  // After a light sleep: hands a DIO1 edge that came in while interrupts
+  // were off to the radio task
+  static void checkRadioIrq();
   static void loadSyncStatus();
   static void saveSyncStatus();
-  static int msgWriteIndex;
   static int onlineCount;
   static bool usersSynced;
   static bool pagesSynced;
   static unsigned long lastSyncAttempt;
-  static String seenMsgIds[MAX_MSGS];
+  static uint64_t seenMsgIds[DEDUP_CACHE_SIZE];
   static int seenMsgIndex;
 
 private:
   static void sendBeacon();
+  static void radioTask(void *param);
+  static void receiveFrame();
+  static void startListening();
   static void relayBroadcast(const String &username, const String &content, int ttl);
 
   // LoRa module
   static Module loraModule;
   static SX1262 radio;
 
-  // Buffers
-  static NodeMessage messages[MAX_MSGS];
-
   static OnlineNode onlineNodes[MAX_ONLINE];
 
   // Identity
@@ -0,0 +1,303 @@
+#include "MessageStore.h"
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+#include "NodeMessage.h"
+#include "NodeLog.h"
+
+static_assert(sizeof(MessageRecord) == MESSAGE_RECORD_SIZE, "MessageRecord must stay one fixed-size slot");
+static_assert(MESSAGE_LOG_CAPACITY % MESSAGE_SEGMENT_RECORDS == 0, "log capacity must be whole segments");
+
+#define MESSAGE_SEGMENTS (MESSAGE_LOG_CAPACITY / MESSAGE_SEGMENT_RECORDS)
+#define MESSAGE_LOG_DIR "/msglog"
+// Longest id/user/object/function kept; the parameters get the rest
+#define MESSAGE_SHORT_FIELD_MAX 48
+
+MessageRecord *MessageStore::cache = NULL;
+uint32_t MessageStore::nextSeq = 0;
+uint32_t MessageStore::cacheStartSeq = 0;
+bool MessageStore::persistent = false;
+
+// Segment currently being appended to
+static File segmentFile;
+static int openSegment = -1;
+
+// Same CRC-16/CCITT as the serial link
+static uint16_t recordCrc(const MessageRecord &record)
+{
+    MessageRecord copy = record;
+    copy.crc = 0;
+    const uint8_t *data = (const uint8_t *)&copy;
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < sizeof(copy); i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static String segmentPath(uint32_t segment)
+{
+    char path[32];
+    snprintf(path, sizeof(path), MESSAGE_LOG_DIR "/%03u.bin", (unsigned)segment);
+    return String(path);
+}
+
+static uint32_t segmentOf(uint32_t seq)
+{
+    return (seq / MESSAGE_SEGMENT_RECORDS) % MESSAGE_SEGMENTS;
+}
+
+// =======================
+// Records
+// =======================
+StrView MessageRecord::field(MessageField which) const
+{
+    size_t offset = 0;
+    for (int i = 0; i < which; i++)
+    {
+        offset += lengths[i];
+    }
+    if (offset + lengths[which] > MESSAGE_RECORD_TEXT)
+    {
+        return StrView();
+    }
+    return StrView(text + offset, lengths[which]);
+}
+
+String MessageRecord::fieldString(MessageField which) const
+{
+    StrView view = field(which);
+    String out;
+    out.concat(view.data, view.len);
+    return out;
+}
+
+void MessageStore::pack(const NodeMessage &message, uint32_t seq, MessageRecord &record)
+{
+    memset(&record, 0, sizeof(record));
+    record.seq = seq;
+    record.timestamp = message.timestamp;
+    record.ttl = message.ttl;
+    if (message.truncated)
+    {
+        record.flags |= MESSAGE_FLAG_TRUNCATED;
+    }
+
+    char msgId[24];
+    const size_t msgIdLength = NodeMessage::formatId(message.msgId, msgId, sizeof(msgId));
+    const StrView fields[MESSAGE_FIELD_COUNT] = {StrView(msgId, msgIdLength), message.user(), message.objectName(),
+                                                 message.functionName(), message.parameters()};
+    size_t used = 0;
+    for (int i = 0; i < MESSAGE_FIELD_COUNT; i++)
+    {
+        size_t room = MESSAGE_RECORD_TEXT - used;
+        if (i != MESSAGE_FIELD_PARAMETERS && room > MESSAGE_SHORT_FIELD_MAX)
+        {
+            room = MESSAGE_SHORT_FIELD_MAX;
+        }
+        size_t length = fields[i].len;
+        if (length > room)
+        {
+            length = room;
+            record.flags |= MESSAGE_FLAG_TRUNCATED;
+        }
+        memcpy(record.text + used, fields[i].data, length);
+        record.lengths[i] = (uint8_t)length;
+        used += length;
+    }
+    record.crc = recordCrc(record);
+}
+
+// =======================
+// Setup
+// =======================
+void MessageStore::begin()
+{
+    if (cache == NULL)
+    {
+        void *ring = heap_caps_calloc(MESSAGE_CACHE_DEPTH, sizeof(MessageRecord), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (ring == NULL)
+        {
+            ring = heap_caps_calloc(MESSAGE_CACHE_DEPTH, sizeof(MessageRecord), MALLOC_CAP_8BIT);
+        }
+        cache = (MessageRecord *)ring;
+    }
+
+    persistent = LittleFS.begin(true);
+    if (!persistent)
+    {
+        LOG_W(LOG_TOPIC_MESH, "[MSGLOG] LittleFS not available, keeping messages in RAM only");
+        return;
+    }
+    if (!LittleFS.exists(MESSAGE_LOG_DIR))
+    {
+        LittleFS.mkdir(MESSAGE_LOG_DIR);
+    }
+    recover();
+    cacheStartSeq = nextSeq;
+    LOG_I(LOG_TOPIC_MESH, "[MSGLOG] %lu messages on flash, next seq %lu",
+          (unsigned long)(nextSeq - getOldestSeq()), (unsigned long)nextSeq);
+}
+
+void MessageStore::end()
+{
+    if (segmentFile)
+    {
+        segmentFile.close();
+    }
+    openSegment = -1;
+}
+
+// Picks up after the segment with the highest first sequence number. A
+// record that did not make it to flash whole ends its segment, so appending
+// continues at the next segment boundary.
+void MessageStore::recover()
+{
+    bool found = false;
+    uint32_t newestBase = 0;
+    uint32_t resumeSeq = 0;
+    MessageRecord record;
+    for (uint32_t segment = 0; segment < MESSAGE_SEGMENTS; segment++)
+    {
+        File file = LittleFS.open(segmentPath(segment), "r");
+        if (!file)
+        {
+            continue;
+        }
+        const size_t size = file.size();
+        const size_t count = size / sizeof(MessageRecord);
+        bool valid = count > 0 && file.read((uint8_t *)&record, sizeof(record)) == sizeof(record) &&
+                     record.crc == recordCrc(record) && record.seq % MESSAGE_SEGMENT_RECORDS == 0 &&
+                     segmentOf(record.seq) == segment;
+        const uint32_t base = record.seq;
+        if (valid && (!found || base > newestBase))
+        {
+            bool clean = size == count * sizeof(MessageRecord) && count <= MESSAGE_SEGMENT_RECORDS;
+            if (clean && count > 1)
+            {
+                file.seek((count - 1) * sizeof(MessageRecord));
+                clean = file.read((uint8_t *)&record, sizeof(record)) == sizeof(record) &&
+                        record.crc == recordCrc(record) && record.seq == base + count - 1;
+            }
+            resumeSeq = clean ? base + count : base + MESSAGE_SEGMENT_RECORDS;
+            newestBase = base;
+            found = true;
+        }
+        file.close();
+    }
+    nextSeq = resumeSeq;
+}
+
+// =======================
+// Append / read
+// =======================
+uint32_t MessageStore::append(const NodeMessage &message)
+{
+    const uint32_t seq = nextSeq;
+    MessageRecord record;
+    pack(message, seq, record);
+    if (cache != NULL)
+    {
+        cache[seq % MESSAGE_CACHE_DEPTH] = record;
+    }
+    if (persistent && !writeToLog(record))
+    {
+        // The segment may end in a partial record now; start the next one
+        nextSeq = (seq / MESSAGE_SEGMENT_RECORDS + 1) * MESSAGE_SEGMENT_RECORDS;
+        return seq;
+    }
+    nextSeq++;
+    return seq;
+}
+
+bool MessageStore::writeToLog(const MessageRecord &record)
+{
+    const int segment = (int)segmentOf(record.seq);
+    const bool startOver = record.seq % MESSAGE_SEGMENT_RECORDS == 0;
+    if (startOver || segment != openSegment || !segmentFile)
+    {
+        end();
+        // "w" drops the records this segment held one lap ago
+        segmentFile = LittleFS.open(segmentPath(segment), startOver ? "w" : "a");
+        if (!segmentFile)
+        {
+            LOG_W(LOG_TOPIC_MESH, "[MSGLOG] Cannot open segment %d", segment);
+            return false;
+        }
+        openSegment = segment;
+    }
+    if (segmentFile.write((const uint8_t *)&record, sizeof(record)) != sizeof(record))
+    {
+        LOG_W(LOG_TOPIC_MESH, "[MSGLOG] Write failed for seq %lu", (unsigned long)record.seq);
+        end();
+        return false;
+    }
+    segmentFile.flush();
+    return true;
+}
+
+uint32_t MessageStore::getCapacity()
+{
+    return persistent ? MESSAGE_LOG_CAPACITY : MESSAGE_CACHE_DEPTH;
+}
+
+uint32_t MessageStore::getOldestSeq()
+{
+    if (!persistent)
+    {
+        return nextSeq > MESSAGE_CACHE_DEPTH ? nextSeq - MESSAGE_CACHE_DEPTH : 0;
+    }
+    // The segment being written no longer holds what it had one lap ago
+    uint32_t end = (nextSeq / MESSAGE_SEGMENT_RECORDS) * MESSAGE_SEGMENT_RECORDS;
+    if (nextSeq % MESSAGE_SEGMENT_RECORDS != 0)
+    {
+        end += MESSAGE_SEGMENT_RECORDS;
+    }
+    return end > MESSAGE_LOG_CAPACITY ? end - MESSAGE_LOG_CAPACITY : 0;
+}
+
+bool MessageStore::read(uint32_t seq, MessageRecord &record)
+{
+    if (seq >= nextSeq || seq < getOldestSeq())
+    {
+        return false;
+    }
+    if (cache != NULL && seq >= cacheStartSeq && nextSeq - seq <= MESSAGE_CACHE_DEPTH)
+    {
+        // Sequence numbers skipped after a failed write have no record
+        record = cache[seq % MESSAGE_CACHE_DEPTH];
+        return record.seq == seq;
+    }
+    return persistent && readFromLog(seq, record);
+}
+
+bool MessageStore::read(uint32_t seq, NodeMessage &message)
+{
+    MessageRecord record;
+    if (!read(seq, record))
+    {
+        return false;
+    }
+    message.set(NodeMessage::parseId(record.field(MESSAGE_FIELD_ID)), record.field(MESSAGE_FIELD_USER), record.ttl,
+                record.timestamp, record.field(MESSAGE_FIELD_OBJECT), record.field(MESSAGE_FIELD_FUNCTION),
+                record.field(MESSAGE_FIELD_PARAMETERS));
+    return true;
+}
+
+bool MessageStore::readFromLog(uint32_t seq, MessageRecord &record)
+{
+    File file = LittleFS.open(segmentPath(segmentOf(seq)), "r");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = file.seek((seq % MESSAGE_SEGMENT_RECORDS) * sizeof(MessageRecord)) &&
+              file.read((uint8_t *)&record, sizeof(record)) == sizeof(record);
+    file.close();
+    // A torn write, or a record from another lap
+    return ok && record.seq == seq && record.crc == recordCrc(record);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <Arduino.h>
+#include "NodeConfig.h"
+#include "PacketParser.h"
+
+struct NodeMessage;
+
+// =======================
+// Message store
+// =======================
+// Every stored message gets the next sequence number and is kept as one
+// fixed-size record, so memory per message is bounded whatever the sender
+// put in it. Records go to a circular log on LittleFS that survives reboots;
+// the newest MESSAGE_CACHE_DEPTH also stay in RAM. A sequence number maps
+// straight to its place in the log (no index to keep), and the log holds
+// the last MESSAGE_LOG_CAPACITY messages.
+//
+// The log is split into segment files of MESSAGE_SEGMENT_RECORDS records
+// that are only ever appended to or started over, which is what LittleFS is
+// fast at. At boot the segment with the highest first sequence number says
+// where the log left off; a record torn by a reset ends that segment.
+//
+// Callers hold the node state lock.
+#define MESSAGE_RECORD_SIZE 256
+#define MESSAGE_RECORD_HEADER 20
+#define MESSAGE_RECORD_TEXT (MESSAGE_RECORD_SIZE - MESSAGE_RECORD_HEADER)
+
+// Set when a field had to be shortened to fit the record
+#define MESSAGE_FLAG_TRUNCATED 0x01
+
+enum MessageField
+{
+    MESSAGE_FIELD_ID,
+    MESSAGE_FIELD_USER,
+    MESSAGE_FIELD_OBJECT,
+    MESSAGE_FIELD_FUNCTION,
+    MESSAGE_FIELD_PARAMETERS,
+    MESSAGE_FIELD_COUNT
+};
+
+// The fields' text is stored back to back in text[]
+struct MessageRecord
+{
+    uint32_t seq;
+    uint32_t timestamp;
+    uint16_t crc; // CRC-16/CCITT of the record with this field zero
+    uint8_t ttl;
+    uint8_t flags;
+    uint8_t lengths[MESSAGE_FIELD_COUNT];
+    uint8_t reserved[3];
+    char text[MESSAGE_RECORD_TEXT];
+
+    StrView field(MessageField which) const;
+    String fieldString(MessageField which) const;
+};
+
+class MessageStore
+{
+public:
+    // Mounts LittleFS and finds where the log left off. Without a usable
+    // file system only the RAM cache is kept.
+    static void begin();
+    // Closes the open segment; begin() picks the log up again
+    static void end();
+    // Returns the message's sequence number
+    static uint32_t append(const NodeMessage &message);
+
+    // Records in [getOldestSeq(), getNextSeq()) can be read, unless one was
+    // lost to a reset while it was being written
+    static uint32_t getNextSeq() { return nextSeq; }
+    static uint32_t getOldestSeq();
+    static bool read(uint32_t seq, MessageRecord &record);
+    static bool read(uint32_t seq, NodeMessage &message);
+
+    static bool isPersistent() { return persistent; }
+    static uint32_t getCapacity();
+
+    // Packs a message into a record, shortening fields that do not fit
+    static void pack(const NodeMessage &message, uint32_t seq, MessageRecord &record);
+
+private:
+    static bool readFromLog(uint32_t seq, MessageRecord &record);
+    static bool writeToLog(const MessageRecord &record);
+    static void recover();
+
+    static MessageRecord *cache;
+    static uint32_t nextSeq;
+    // First sequence number written since begin(); older ones are only in the log
+    static uint32_t cacheStartSeq;
+    static bool persistent;
+};
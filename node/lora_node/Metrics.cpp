@@ -0,0 +1,254 @@
+#include "Metrics.h"
+#include "LoraNode.h"
+#include "NodeLog.h"
+#include "SerialLink.h"
+
+std::atomic<uint32_t> Metrics::counters[CTR_COUNT];
+std::atomic<uint32_t> Metrics::gauges[GAUGE_COUNT];
+std::atomic<uint32_t> Metrics::rxByType[PKT_TYPE_COUNT];
+std::atomic<uint32_t> Metrics::txByType[PKT_TYPE_COUNT];
+std::atomic<uint32_t> Metrics::buckets[HIST_COUNT][METRIC_HIST_BUCKETS + 1];
+std::atomic<uint32_t> Metrics::sums[HIST_COUNT];
+
+// =======================
+// Metric descriptions
+// =======================
+struct MetricInfo
+{
+    const char *name;
+    const char *help;
+};
+
+static const MetricInfo counterInfo[CTR_COUNT] = {
+    {"lora_rx_dropped_total", "Frames lost because the RX ring was full"},
+    {"lora_rx_errors_total", "Failed radio reads"},
+    {"lora_tx_failed_total", "Failed radio transmissions"},
+    {"lora_tx_queue_full_total", "Frames refused because the TX queue was full"},
+    {"lora_airtime_ms_total", "Milliseconds spent transmitting"},
+    {"mesh_dedup_hits_total", "Messages dropped as already seen"},
+    {"mesh_relayed_total", "Frames re-sent on behalf of other nodes"},
+    {"sync_parts_received_total", "Users/pages sync parts received"},
+    {"sync_parts_lost_total", "Sync parts still missing when a sync was re-requested"},
+    {"http_requests_total", "HTTP requests handled"},
+    {"light_sleep_ms_total", "Milliseconds spent in light sleep"},
+    {"display_frames_total", "OLED frames drawn and sent to the panel"},
+    {"mesh_relay_skipped_total", "Relays left out to save battery"},
+};
+
+static const MetricInfo gaugeInfo[GAUGE_COUNT] = {
+    {"heap_free_bytes", "Free heap"},
+    {"heap_min_free_bytes", "Lowest free heap since boot"},
+    {"heap_largest_block_bytes", "Largest allocatable heap block"},
+    {"online_nodes", "Nodes heard recently"},
+    {"uptime_seconds", "Seconds since boot"},
+    {"cpu_frequency_mhz", "Current CPU clock"},
+    {"battery_millivolts", "Filtered battery voltage"},
+    {"duty_mode", "0 normal, 1 low power, 2 leaf"},
+};
+
+static const MetricInfo histogramInfo[HIST_COUNT] = {
+    {"http_request_duration_ms", "Time spent in HTTP handlers"},
+    {"loop_duration_us", "Time for one pass of the main loop"},
+};
+
+static const uint32_t histogramBounds[HIST_COUNT][METRIC_HIST_BUCKETS] = {
+    {1, 2, 5, 10, 20, 50, 100, 250, 500, 1000},
+    {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000},
+};
+
+// Label values for PacketType
+static const char *const packetTypeNames[PKT_TYPE_COUNT] = {
+    "unknown", "req_stats", "resp_users_part", "resp_users", "resp_pages_part",
+    "resp_page", "resp_pages", "ping", "pong", "ack", "bcast", "beacon", "msg",
+    "req_metrics", "resp_metrics",
+};
+
+// =======================
+// Recording
+// =======================
+void Metrics::observe(MetricHistogram histogram, uint32_t value)
+{
+    size_t bucket = 0;
+    while (bucket < METRIC_HIST_BUCKETS && value > histogramBounds[histogram][bucket])
+    {
+        bucket++;
+    }
+    buckets[histogram][bucket].fetch_add(1, std::memory_order_relaxed);
+    sums[histogram].fetch_add(value, std::memory_order_relaxed);
+}
+
+void Metrics::sample()
+{
+    set(GAUGE_HEAP_FREE, ESP.getFreeHeap());
+    set(GAUGE_HEAP_MIN_FREE, ESP.getMinFreeHeap());
+    set(GAUGE_HEAP_LARGEST_BLOCK, ESP.getMaxAllocHeap());
+    set(GAUGE_ONLINE_NODES, (uint32_t)LoraNode::getOnlineCount());
+    set(GAUGE_UPTIME_S, millis() / 1000);
+}
+
+// =======================
+// Prometheus text
+// =======================
+static void writeHeader(Print &out, const char *name, const char *help, const char *type)
+{
+    out.printf("# HELP meshnet_%s %s\n# TYPE meshnet_%s %s\n", name, help, name, type);
+}
+
+static void writeByType(Print &out, const char *name, const char *help, const std::atomic<uint32_t> *values)
+{
+    writeHeader(out, name, help, "counter");
+    for (int t = 0; t < PKT_TYPE_COUNT; t++)
+    {
+        out.printf("meshnet_%s{type=\"%s\"} %u\n", name, packetTypeNames[t],
+                   (unsigned)values[t].load(std::memory_order_relaxed));
+    }
+}
+
+static void writeValue(Print &out, const char *name, const char *help, const char *type, uint32_t value)
+{
+    writeHeader(out, name, help, type);
+    out.printf("meshnet_%s %u\n", name, (unsigned)value);
+}
+
+void Metrics::writePrometheus(Print &out)
+{
+    sample();
+    writeByType(out, "lora_rx_frames_total", "LoRa frames received, by packet type", rxByType);
+    writeByType(out, "lora_tx_frames_total", "LoRa frames transmitted, by packet type", txByType);
+    for (int c = 0; c < CTR_COUNT; c++)
+    {
+        writeValue(out, counterInfo[c].name, counterInfo[c].help, "counter",
+                   counters[c].load(std::memory_order_relaxed));
+    }
+    writeValue(out, "serial_crc_errors_total", "Serial frames with a bad CRC", "counter", SerialLink::getCrcErrors());
+    writeValue(out, "serial_dropped_frames_total", "Serial frames dropped as duplicate or out of order", "counter", SerialLink::getDroppedFrames());
+    writeValue(out, "log_dropped_records_total", "Log records lost because the log ring was full", "counter", NodeLog::getDroppedRecords());
+    for (int g = 0; g < GAUGE_COUNT; g++)
+    {
+        writeValue(out, gaugeInfo[g].name, gaugeInfo[g].help, "gauge",
+                   gauges[g].load(std::memory_order_relaxed));
+    }
+    for (int h = 0; h < HIST_COUNT; h++)
+    {
+        const char *name = histogramInfo[h].name;
+        writeHeader(out, name, histogramInfo[h].help, "histogram");
+        uint32_t cumulative = 0;
+        for (int b = 0; b <= METRIC_HIST_BUCKETS; b++)
+        {
+            cumulative += buckets[h][b].load(std::memory_order_relaxed);
+            if (b < METRIC_HIST_BUCKETS)
+            {
+                out.printf("meshnet_%s_bucket{le=\"%u\"} %u\n", name, (unsigned)histogramBounds[h][b], (unsigned)cumulative);
+            }
+            else
+            {
+                out.printf("meshnet_%s_bucket{le=\"+Inf\"} %u\n", name, (unsigned)cumulative);
+            }
+        }
+        out.printf("meshnet_%s_sum %u\nmeshnet_%s_count %u\n", name,
+                   (unsigned)sums[h].load(std::memory_order_relaxed), name, (unsigned)cumulative);
+    }
+}
+
+// =======================
+// Compact encoding
+// =======================
+struct CompactWriter
+{
+    uint8_t *out;
+    size_t capacity;
+    size_t length;
+
+    // Skips zero values; false once the buffer is full
+    bool put(uint8_t id, uint32_t value)
+    {
+        if (value == 0)
+        {
+            return true;
+        }
+        uint8_t varint[5];
+        size_t n = 0;
+        do
+        {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            varint[n++] = value ? (byte | 0x80) : byte;
+        } while (value);
+        if (length + 1 + n > capacity)
+        {
+            return false;
+        }
+        out[length++] = id;
+        memcpy(out + length, varint, n);
+        length += n;
+        return true;
+    }
+};
+
+size_t Metrics::encodeCompact(uint8_t *out, size_t capacity)
+{
+    if (capacity == 0)
+    {
+        return 0;
+    }
+    sample();
+    CompactWriter writer = {out, capacity, 0};
+    out[writer.length++] = METRICS_COMPACT_VERSION;
+    bool room = true;
+    for (int g = 0; g < GAUGE_COUNT && room; g++)
+    {
+        room = writer.put(METRIC_ID_GAUGE + g, gauges[g].load(std::memory_order_relaxed));
+    }
+    for (int c = 0; c < CTR_COUNT && room; c++)
+    {
+        room = writer.put(c, counters[c].load(std::memory_order_relaxed));
+    }
+    for (int h = 0; h < HIST_COUNT && room; h++)
+    {
+        uint32_t count = 0;
+        for (int b = 0; b <= METRIC_HIST_BUCKETS; b++)
+        {
+            count += buckets[h][b].load(std::memory_order_relaxed);
+        }
+        room = writer.put(METRIC_ID_HIST_COUNT + h, count) &&
+               writer.put(METRIC_ID_HIST_SUM + h, sums[h].load(std::memory_order_relaxed));
+    }
+    for (int t = 0; t < PKT_TYPE_COUNT && room; t++)
+    {
+        room = writer.put(METRIC_ID_RX_TYPE + t, rxByType[t].load(std::memory_order_relaxed)) &&
+               writer.put(METRIC_ID_TX_TYPE + t, txByType[t].load(std::memory_order_relaxed));
+    }
+    return writer.length;
+}
+
+static size_t base64Encode(const uint8_t *in, size_t length, char *out, size_t capacity)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t written = 0;
+    for (size_t i = 0; i < length && written + 4 < capacity; i += 3)
+    {
+        uint32_t block = (uint32_t)in[i] << 16;
+        if (i + 1 < length) block |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < length) block |= in[i + 2];
+        out[written++] = alphabet[(block >> 18) & 0x3F];
+        out[written++] = alphabet[(block >> 12) & 0x3F];
+        out[written++] = i + 1 < length ? alphabet[(block >> 6) & 0x3F] : '=';
+        out[written++] = i + 2 < length ? alphabet[block & 0x3F] : '=';
+    }
+    out[written] = '\0';
+    return written;
+}
+
+size_t Metrics::buildResponse(const char *nodeName, char *out, size_t capacity)
+{
+    int header = snprintf(out, capacity, "RESP;METRICS;%s;", nodeName);
+    if (header < 0 || (size_t)header >= capacity)
+    {
+        return 0;
+    }
+    // Base64 turns 3 bytes into 4; keep the whole frame within capacity
+    uint8_t blob[RX_BUFFER_SIZE];
+    size_t room = (capacity - (size_t)header - 1) / 4 * 3;
+    size_t blobLength = encodeCompact(blob, room < sizeof(blob) ? room : sizeof(blob));
+    return (size_t)header + base64Encode(blob, blobLength, out + header, capacity - (size_t)header);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "PacketParser.h"
+
+// =======================
+// Runtime metrics
+// =======================
+// Counters, gauges and fixed-bucket histograms in static storage. Updates are
+// relaxed atomic adds, so any task (radio, loop, web) can record without a
+// lock. Heap and serial link figures are sampled when the metrics are read.
+// Values are 32-bit and wrap like a counter reset.
+enum MetricCounter
+{
+    CTR_RX_DROPPED,       // RX ring full
+    CTR_RX_ERRORS,        // readData() failed
+    CTR_TX_FAILED,        // transmit() failed
+    CTR_TX_QUEUE_FULL,    // transmitRaw() refused
+    CTR_AIRTIME_MS,       // time spent in transmit()
+    CTR_DEDUP_HITS,       // MSG ids already seen
+    CTR_RELAYED,          // frames re-sent for other nodes
+    CTR_SYNC_PARTS_RECEIVED,
+    CTR_SYNC_PARTS_LOST,  // parts still missing when a sync was re-requested
+    CTR_HTTP_REQUESTS,
+    CTR_SLEEP_MS,         // time spent in light sleep
+    CTR_DISPLAY_FRAMES,   // OLED redraws pushed over I2C
+    CTR_RELAY_SKIPPED,    // relays dropped by the duty policy
+    CTR_COUNT
+};
+
+enum MetricGauge
+{
+    GAUGE_HEAP_FREE,
+    GAUGE_HEAP_MIN_FREE,
+    GAUGE_HEAP_LARGEST_BLOCK,
+    GAUGE_ONLINE_NODES,
+    GAUGE_UPTIME_S,
+    GAUGE_CPU_MHZ,
+    GAUGE_BATTERY_MV,
+    GAUGE_DUTY_MODE,      // DutyMode
+    GAUGE_COUNT
+};
+
+enum MetricHistogram
+{
+    HIST_HTTP_MS,  // synchronous handler time
+    HIST_LOOP_US,  // one pass of loop()
+    HIST_COUNT
+};
+
+#define METRIC_HIST_BUCKETS 10
+
+// Compact encoding ids (RESP;METRICS): counter c = c, gauge g = 64 + g,
+// RX by type t = 128 + t, TX by type t = 160 + t, histogram h count = 200 + h,
+// histogram h sum = 216 + h
+#define METRIC_ID_GAUGE 64
+#define METRIC_ID_RX_TYPE 128
+#define METRIC_ID_TX_TYPE 160
+#define METRIC_ID_HIST_COUNT 200
+#define METRIC_ID_HIST_SUM 216
+#define METRICS_COMPACT_VERSION 1
+
+class Metrics
+{
+public:
+    static void inc(MetricCounter counter, uint32_t amount = 1)
+    {
+        counters[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+    static void set(MetricGauge gauge, uint32_t value)
+    {
+        gauges[gauge].store(value, std::memory_order_relaxed);
+    }
+    static void countRx(PacketType type)
+    {
+        rxByType[type].fetch_add(1, std::memory_order_relaxed);
+    }
+    static void countTx(PacketType type)
+    {
+        txByType[type].fetch_add(1, std::memory_order_relaxed);
+    }
+    static void observe(MetricHistogram histogram, uint32_t value);
+
+    // Prometheus text exposition format
+    static void writePrometheus(Print &out);
+    // Version byte followed by (id, varint value) pairs for non-zero metrics,
+    // as many as fit. Returns the number of bytes written.
+    static size_t encodeCompact(uint8_t *out, size_t capacity);
+    // "RESP;METRICS;<node>;<base64 of encodeCompact>" into out
+    static size_t buildResponse(const char *nodeName, char *out, size_t capacity);
+
+private:
+    static void sample();
+
+    static std::atomic<uint32_t> counters[CTR_COUNT];
+    static std::atomic<uint32_t> gauges[GAUGE_COUNT];
+    static std::atomic<uint32_t> rxByType[PKT_TYPE_COUNT];
+    static std::atomic<uint32_t> txByType[PKT_TYPE_COUNT];
+    // Last bucket is +Inf
+    static std::atomic<uint32_t> buckets[HIST_COUNT][METRIC_HIST_BUCKETS + 1];
+    static std::atomic<uint32_t> sums[HIST_COUNT];
+};
@@ -1,68 +1,95 @@
 #include "NodeButton.h"
 
 NodeButton::NodeButton(uint8_t pin)
-    : _pin(pin), _lastState(false), _pressed(false), _lastDebounceTime(0),
-      _lastPressTime(0), _lastReleaseTime(0), _clickCount(0),
-      _singleClickFlag(false), _doubleClickFlag(false), _longPressFlag(false) {}
+    : _pin(pin), _hasPending(false), _pending(), _pressed(false),
+      _lastPressTime(0), _lastReleaseTime(0), _clickCount(0) {}
 
 void NodeButton::begin() {
     pinMode(_pin, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(_pin), onEdge, this, CHANGE);
+}
+
+// The ring's only producer; a full ring drops the edge, and update() picks
+// the level up again from the pin
+void IRAM_ATTR NodeButton::onEdge(void *arg) {
+    NodeButton *button = static_cast<NodeButton *>(arg);
+    Edge edge;
+    edge.ms = millis();
+    edge.down = digitalRead(button->_pin) == LOW; // active low
+    button->_edges.push(edge);
+}
+
+void NodeButton::injectEdge(bool down, unsigned long ms) {
+    Edge edge;
+    edge.ms = ms;
+    edge.down = down;
+    _edges.push(edge);
 }
 
 void NodeButton::update() {
-    bool currentState = !digitalRead(_pin); // active low
-    unsigned long now = millis();
+    update(millis());
+}
 
-    if (currentState != _lastState) {
-        _lastDebounceTime = now;
+void NodeButton::update(unsigned long nowMs) {
+    // An edge only counts once the level held for the debounce time, judged
+    // by the next edge's timestamp or, for the last one, by the clock
+    Edge edge;
+    while (_edges.pop(edge)) {
+        if (_hasPending && edge.ms - _pending.ms > BUTTON_DEBOUNCE_MS) {
+            settle(_pending.down, _pending.ms);
+        }
+        _pending = edge;
+        _hasPending = true;
+    }
+    if (_hasPending && nowMs - _pending.ms > BUTTON_DEBOUNCE_MS) {
+        settle(_pending.down, _pending.ms);
+        _hasPending = false;
     }
 
-    if ((now - _lastDebounceTime) > 50) { // debounce
-        if (currentState && !_pressed) {
-            _pressed = true;
-            _lastPressTime = now;
-            _clickCount++;
-        } else if (!currentState && _pressed) {
-            _pressed = false;
-            _lastReleaseTime = now;
-            if ((now - _lastPressTime) > 800) {
-                _longPressFlag = true;
-            } else if (_clickCount == 1) {
-                _singleClickFlag = true;
-            } else if (_clickCount == 2) {
-                _doubleClickFlag = true;
-                _clickCount = 0;
-            }
-        }
+    // A release lost to a dropped or masked edge would leave the button
+    // held forever; only while it is held is the pin looked at
+    if (_pressed && !_hasPending && nowMs - _lastPressTime > BUTTON_DEBOUNCE_MS &&
+        digitalRead(_pin) != LOW) {
+        settle(false, nowMs);
     }
-    _lastState = currentState;
-}
 
-bool NodeButton::isPressed() const {
-    return _pressed;
+    if (_clickCount == 1 && !_pressed && nowMs - _lastReleaseTime > BUTTON_DOUBLE_CLICK_MS) {
+        _events.push(BUTTON_EVENT_CLICK);
+        _clickCount = 0;
+    }
 }
 
-bool NodeButton::isSingleClick() {
-    if (_singleClickFlag) {
-        _singleClickFlag = false;
+void NodeButton::settle(bool down, unsigned long ms) {
+    if (down == _pressed) {
+        return;
+    }
+    _pressed = down;
+    if (down) {
+        // A first click whose double-click window ran out before this press
+        // (the consumer may only see both now)
+        if (_clickCount == 1 && ms - _lastReleaseTime > BUTTON_DOUBLE_CLICK_MS) {
+            _events.push(BUTTON_EVENT_CLICK);
+            _clickCount = 0;
+        }
+        _lastPressTime = ms;
+        _events.push(BUTTON_EVENT_PRESS);
+        return;
+    }
+
+    _lastReleaseTime = ms;
+    if (ms - _lastPressTime > BUTTON_LONG_PRESS_MS) {
+        _events.push(BUTTON_EVENT_LONG_PRESS);
+        _clickCount = 0;
+    } else if (++_clickCount == 2) {
+        _events.push(BUTTON_EVENT_DOUBLE_CLICK);
         _clickCount = 0;
-        return true;
     }
-    return false;
 }
 
-bool NodeButton::isDoubleClick() {
-    if (_doubleClickFlag) {
-        _doubleClickFlag = false;
-        return true;
-    }
-    return false;
+bool NodeButton::isPressed() const {
+    return _pressed;
 }
 
-bool NodeButton::isLongPress() {
-    if (_longPressFlag) {
-        _longPressFlag = false;
-        return true;
-    }
-    return false;
+bool NodeButton::nextEvent(ButtonEvent &event) {
+    return _events.pop(event);
 }
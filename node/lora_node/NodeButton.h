@@ -2,28 +2,60 @@
 #define NODE_BUTTON_H
 
 #include <Arduino.h>
+#include "NodeConfig.h"
+#include "RingBuffer.h"
+
+// =======================
+// Button
+// =======================
+// A GPIO interrupt on both edges timestamps every level change into a ring;
+// nothing polls the pin while the button is left alone. update() turns the
+// edges into gestures using their own timestamps, so a task that was busy
+// for a while still decodes clicks and long presses correctly. Gestures
+// wait in a queue until nextEvent() takes them.
+enum ButtonEvent : uint8_t {
+    BUTTON_EVENT_PRESS,        // went down (debounced); comes before the gesture
+    BUTTON_EVENT_CLICK,        // released, and no second click followed
+    BUTTON_EVENT_DOUBLE_CLICK,
+    BUTTON_EVENT_LONG_PRESS    // released after BUTTON_LONG_PRESS_MS
+};
 
 class NodeButton {
 public:
     NodeButton(uint8_t pin);
     void begin();
+    uint8_t getPin() const { return _pin; }
+
+    // Decodes queued edges into events; call from the task that reads them
     void update();
+    void update(unsigned long nowMs);
+    bool nextEvent(ButtonEvent &event);
     bool isPressed() const;
-    bool isSingleClick();
-    bool isDoubleClick();
-    bool isLongPress();
+
+    // For an edge the interrupt could not see (its interrupt was masked,
+    // e.g. around light sleep). Only call while the pin's interrupt is off.
+    void injectEdge(bool down, unsigned long ms);
 
 private:
+    struct Edge {
+        uint32_t ms;
+        bool down;
+    };
+
+    static void IRAM_ATTR onEdge(void *arg);
+    void settle(bool down, unsigned long ms);
+
     uint8_t _pin;
-    bool _lastState;
+    SpscRing<Edge, BUTTON_EDGE_QUEUE_DEPTH> _edges;
+    SpscRing<ButtonEvent, BUTTON_EVENT_QUEUE_DEPTH> _events;
+    // Last raw edge, applied once the level held for BUTTON_DEBOUNCE_MS
+    bool _hasPending;
+    Edge _pending;
     bool _pressed;
-    unsigned long _lastDebounceTime;
     unsigned long _lastPressTime;
     unsigned long _lastReleaseTime;
+    // Short clicks in the current click sequence
     int _clickCount;
-    bool _singleClickFlag;
-    bool _doubleClickFlag;
-    bool _longPressFlag;
 };
 
 #endif // NODE_BUTTON_H
@@ -0,0 +1,236 @@
+#pragma once
+
+// =======================
+// Build profile and features
+// =======================
+// NODE_PROFILE_RELAY=1 builds a headless repeater for masts: WiFi stays
+// off, there is no web server, no users or pages synced from the gateway,
+// no message history or display, and the RAM goes to a larger dedup cache
+// and TX queue instead.
+// The FEATURE_ENABLE_* flags can also be set one by one.
+#ifndef NODE_PROFILE_RELAY
+#define NODE_PROFILE_RELAY 0
+#endif
+// Access point, captive portal, web pages, /events and /api, and the users
+// and team pages they serve (kept in NVS, synced from the gateway)
+#ifndef FEATURE_ENABLE_WEBSERVER
+#define FEATURE_ENABLE_WEBSERVER (!NODE_PROFILE_RELAY)
+#endif
+// OLED status screens
+#ifndef FEATURE_ENABLE_DISPLAY
+#define FEATURE_ENABLE_DISPLAY (!NODE_PROFILE_RELAY)
+#endif
+// Received messages kept on LittleFS; only the web pages and the display
+// read them back
+#ifndef FEATURE_ENABLE_MESSAGE_STORE
+#define FEATURE_ENABLE_MESSAGE_STORE (FEATURE_ENABLE_WEBSERVER || FEATURE_ENABLE_DISPLAY)
+#endif
+
+// =======================
+// Task layout
+// =======================
+// Core 0 runs the radio task (next to the WiFi stack); everything that
+// talks to people (serial, DNS, web, OLED, button) runs on core 1, which is
+// also where the Arduino loop() task and AsyncTCP live.
+#define RADIO_TASK_CORE 0
+#define APP_TASK_CORE 1
+
+#define RADIO_TASK_PRIORITY 5
+#define UI_TASK_PRIORITY 1
+
+#define RADIO_TASK_STACK 4096
+#define UI_TASK_STACK 4096
+
+// How long the radio task sleeps when nothing happens; it is woken early by
+// DIO1 and by queued transmissions
+#define RADIO_IDLE_WAIT_MS 50
+// Upper bound for one UI task iteration when the display has no budget left
+#define UI_TASK_PERIOD_MS 10
+
+// =======================
+// Inter-task queues
+// =======================
+// Capacities must be powers of two. A repeater has nothing else to spend
+// its RAM on, and relays in bursts when several neighbours talk at once.
+#if NODE_PROFILE_RELAY
+#define RX_QUEUE_DEPTH 16
+#define TX_QUEUE_DEPTH 64
+#else
+#define RX_QUEUE_DEPTH 8
+#define TX_QUEUE_DEPTH 16
+#endif
+#define RADIO_EVENT_QUEUE_DEPTH 16
+// Message ids remembered to drop duplicates (8 bytes each)
+#if NODE_PROFILE_RELAY
+#define DEDUP_CACHE_SIZE 512
+#else
+#define DEDUP_CACHE_SIZE 50
+#endif
+
+// =======================
+// Serial link to the Pi gateway
+// =======================
+// 1: SLIP frames with CRC16 and sequence numbers, protocol and log output on
+//    separate channels (see rpi/lora-gateway/serialLink.js).
+// 0: plain text lines, for use with a serial monitor.
+#ifndef SERIAL_LINK_FRAMED
+#define SERIAL_LINK_FRAMED 1
+#endif
+#define SERIAL_LINK_BAUD 921600
+// UART driver buffer; the onReceive callback empties it into a ring of
+// SERIAL_LINK_RX_RING bytes (power of two) that the app loop parses. Together
+// they hold a full send window of escaped frames from the gateway.
+#define SERIAL_LINK_RX_BUFFER 1024
+#define SERIAL_LINK_RX_RING 4096
+// Longest command line in text mode; longer lines are dropped whole
+#define SERIAL_LINE_MAX 512
+// Largest unescaped frame (header + payload + CRC)
+#define SERIAL_LINK_MAX_FRAME 600
+// Frames the gateway may have in flight before it waits for an ack
+#define SERIAL_LINK_WINDOW 4
+// Formatted log lines are truncated to this
+#define LOG_LINE_MAX 240
+
+// =======================
+// Logging (see NodeLog.h)
+// =======================
+// Calls above LOG_LEVEL or outside LOG_TOPICS are compiled out entirely.
+// Override from platformio.ini, e.g. -DLOG_LEVEL=LOG_LEVEL_DEBUG.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#ifndef LOG_TOPICS
+#define LOG_TOPICS LOG_TOPIC_ALL
+#endif
+// Records waiting for the drain task (power of two); overflow is counted
+#define LOG_RING_DEPTH 64
+#define LOG_TASK_PRIORITY 1
+#define LOG_TASK_STACK 4096
+#define LOG_DRAIN_IDLE_MS 20
+
+// =======================
+// Profiler (see Profiler.h)
+// =======================
+// 0 compiles every PROFILE_SCOPE / PROFILE_PERIOD out
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 1
+#endif
+// Histogram buckets per section: four per power of two, so p50/p99 are
+// within 25%. Values past the last bucket still count towards max.
+#define PROFILE_BUCKETS 80
+
+// =======================
+// Packet capture (see PacketCapture.h)
+// =======================
+// Frames kept in the capture ring; it lives in PSRAM when there is some,
+// otherwise a much smaller ring comes out of internal RAM
+#define CAPTURE_DEPTH 256
+#define CAPTURE_DEPTH_INTERNAL 16
+
+// =======================
+// Live page updates (/events)
+// =======================
+// Open server-sent event streams; browsers past this get no live updates
+// and keep working by reloading
+#define SSE_MAX_CLIENTS 4
+// Online-node changes are coalesced into one event per interval
+#define SSE_NODES_INTERVAL_MS 1000
+// Reconnect delay browsers are told to use when the stream drops
+#define SSE_RETRY_MS 5000
+
+// =======================
+// JSON API (/api/...)
+// =======================
+// Messages per /api/messages response unless the page asks for fewer
+#define API_MESSAGES_LIMIT 20
+#define API_MESSAGES_MAX 100
+#define API_USERS_PAGE_SIZE 25
+// Chunks smaller than this wait for the TCP buffer to drain; an item that
+// does not fit even then is left out of the list. Above the largest message
+// or node item.
+#define API_CHUNK_MIN 2048
+
+// =======================
+// Message store (see MessageStore.h)
+// =======================
+// Messages kept on LittleFS, 256 bytes each; a multiple of the segment size
+#define MESSAGE_LOG_CAPACITY 2048
+#define MESSAGE_SEGMENT_RECORDS 32
+// Newest messages also kept in RAM
+#define MESSAGE_CACHE_DEPTH 32
+
+// =======================
+// Button (see NodeButton.h)
+// =======================
+#define BUTTON_DEBOUNCE_MS 50
+// Held longer than this is a long press instead of a click
+#define BUTTON_LONG_PRESS_MS 800
+// Longest gap between the clicks of a double click
+#define BUTTON_DOUBLE_CLICK_MS 400
+// Raw edges between two update() calls, bounces included (power of two)
+#define BUTTON_EDGE_QUEUE_DEPTH 32
+#define BUTTON_EVENT_QUEUE_DEPTH 8
+
+// =======================
+// OLED display (see node_display.cpp)
+// =======================
+// How often the battery, online nodes and newest message are looked at
+#define DISPLAY_SAMPLE_MS 1000
+// The panel switches off after this long without a button press or a new
+// broadcast
+#define DISPLAY_SLEEP_MS 120000
+
+// =======================
+// Battery (see node_battery.cpp)
+// =======================
+#define BATTERY_INTERVAL_MS 30000
+// Divider settle time after VBAT_CTRL switches it on
+#define BATTERY_SETTLE_MS 10
+// Calibrated ADC reads averaged per measurement
+#define BATTERY_SAMPLES 8
+// Weight of a new measurement in the running average
+#define BATTERY_EWMA_ALPHA 0.25f
+// Pack voltage per volt at the ADC pin (Heltec V3: 390k over 100k)
+#ifndef BATTERY_DIVIDER_RATIO
+#define BATTERY_DIVIDER_RATIO 4.9f
+#endif
+// Anything lower means no cell is fitted (the node runs off USB)
+#define BATTERY_PRESENT_MIN_V 2.5f
+
+// =======================
+// Power management (see PowerManager.h)
+// =======================
+// CPU clock while someone is connected to the access point, and otherwise
+#define POWER_CPU_ACTIVE_MHZ 240
+#define POWER_CPU_IDLE_MHZ 80
+#define POWER_CHECK_INTERVAL_MS 1000
+// How long loop() blocks between passes, so the idle task gets the CPU
+#define POWER_LOOP_IDLE_MS 1
+// 1: light sleep between radio events while WiFi is off, and the radio in
+// RX duty-cycle mode (see LORA_PREAMBLE_LENGTH)
+#ifndef POWER_SAVE
+#define POWER_SAVE 0
+#endif
+// Longest light sleep; loop() timers such as the beacon run at this granularity
+#define POWER_SLEEP_MAX_MS 1000
+// Awake time after a button press, so clicks and long presses can be timed
+#define POWER_BUTTON_AWAKE_MS 3000
+// The Pi gateway talks over the UART, which cannot receive in light sleep;
+// a node that heard from it this recently stays awake
+#define POWER_SERIAL_QUIET_MS 10000
+
+// =======================
+// Battery duty policy (see DutyPolicy.h)
+// =======================
+#ifndef DUTY_POLICY_ENABLED
+#define DUTY_POLICY_ENABLED 1
+#endif
+// Battery percent below which the node slows its beacons and thins out
+// relaying, and below which it stops relaying altogether
+#define DUTY_LOW_LEVEL 30
+#define DUTY_CRITICAL_LEVEL 10
+#define DUTY_HYSTERESIS 3
+// Share of frames still relayed just above DUTY_CRITICAL_LEVEL
+#define DUTY_RELAY_MIN_PERCENT 25
+// Beacon interval at DUTY_CRITICAL_LEVEL and below, in percent of normal
+#define DUTY_BEACON_MAX_PERCENT 400
@@ -0,0 +1,72 @@
+#include "NodeLog.h"
+#include <atomic>
+#include "RingBuffer.h"
+#include "SerialLink.h"
+
+static MpscRing<LogRecord, LOG_RING_DEPTH> records; // any task -> drain task
+static TaskHandle_t drainTaskHandle = NULL;
+// Counted by submit() on both cores
+static std::atomic<uint32_t> droppedRecords(0);
+static uint32_t reportedDrops = 0;
+
+void NodeLog::begin()
+{
+    if (drainTaskHandle != NULL)
+    {
+        return;
+    }
+    xTaskCreatePinnedToCore(drainTask, "log", LOG_TASK_STACK, NULL,
+                            LOG_TASK_PRIORITY, &drainTaskHandle, APP_TASK_CORE);
+}
+
+uint32_t NodeLog::getDroppedRecords()
+{
+    return droppedRecords.load(std::memory_order_relaxed);
+}
+
+void NodeLog::submit(const LogRecord &record)
+{
+    if (drainTaskHandle == NULL)
+    {
+        writeRecord(record);
+        return;
+    }
+    if (!records.push(record))
+    {
+        droppedRecords.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void NodeLog::writeRecord(const LogRecord &record)
+{
+    char line[LOG_LINE_MAX];
+    size_t length = logFormat(record, line, sizeof(line));
+    SerialLink::sendLog(line, length);
+}
+
+void NodeLog::drain()
+{
+    LogRecord record;
+    while (records.pop(record))
+    {
+        writeRecord(record);
+    }
+    const uint32_t dropped = droppedRecords.load(std::memory_order_relaxed);
+    if (dropped != reportedDrops)
+    {
+        char line[48];
+        int length = snprintf(line, sizeof(line), "[LOG] %lu records dropped",
+                              (unsigned long)(dropped - reportedDrops));
+        reportedDrops = dropped;
+        SerialLink::sendLog(line, (size_t)length);
+    }
+}
+
+void NodeLog::drainTask(void * /*param*/)
+{
+    for (;;)
+    {
+        drain();
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_IDLE_MS));
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <Arduino.h>
+#include "LogRecord.h"
+#include "NodeConfig.h"
+
+// =======================
+// Levels and topics
+// =======================
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+// Secrets (hashes, tokens, cookies) only ever log at this level
+#define LOG_LEVEL_VERBOSE 5
+
+#define LOG_TOPIC_SYS 0x01    // boot, setup, serial commands
+#define LOG_TOPIC_RADIO 0x02  // LoRa RX/TX
+#define LOG_TOPIC_MESH 0x04   // messages, pings, acks, relays
+#define LOG_TOPIC_SYNC 0x08   // users/pages sync
+#define LOG_TOPIC_USER 0x10   // user table, NVS
+#define LOG_TOPIC_AUTH 0x20   // login and sessions
+#define LOG_TOPIC_WEB 0x40    // webserver
+#define LOG_TOPIC_UI 0x80     // display, button
+#define LOG_TOPIC_ALL 0xFF
+
+// =======================
+// Log macros
+// =======================
+// LOG_x(topic, format, args...) with printf formats and no trailing newline.
+// Disabled levels expand to nothing, so their arguments are not evaluated;
+// a disabled topic is a constant-false branch the compiler drops.
+// Pass C strings (String::c_str()), they are copied into the record.
+#define LOG_AT(level, topic, ...)                 \
+    do                                            \
+    {                                             \
+        if (((topic) & (LOG_TOPICS)) != 0)        \
+        {                                         \
+            NodeLog::log(level, topic, __VA_ARGS__); \
+        }                                         \
+    } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(topic, ...) LOG_AT(LOG_LEVEL_ERROR, topic, __VA_ARGS__)
+#else
+#define LOG_E(topic, ...) do { } while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(topic, ...) LOG_AT(LOG_LEVEL_WARN, topic, __VA_ARGS__)
+#else
+#define LOG_W(topic, ...) do { } while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(topic, ...) LOG_AT(LOG_LEVEL_INFO, topic, __VA_ARGS__)
+#else
+#define LOG_I(topic, ...) do { } while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(topic, ...) LOG_AT(LOG_LEVEL_DEBUG, topic, __VA_ARGS__)
+#else
+#define LOG_D(topic, ...) do { } while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_VERBOSE
+#define LOG_V(topic, ...) LOG_AT(LOG_LEVEL_VERBOSE, topic, __VA_ARGS__)
+#else
+#define LOG_V(topic, ...) do { } while (0)
+#endif
+
+// =======================
+// Deferred log sink
+// =======================
+// Records go into a lock-free ring; a low-priority task formats them and
+// sends them over the serial link's log channel. Before begin() (and when
+// the drain task is not running) records are written out synchronously.
+class NodeLog
+{
+public:
+    static void begin();
+    static uint32_t getDroppedRecords();
+
+    template <typename... Args>
+    static void log(uint8_t level, uint8_t topic, const char *format, Args... args)
+    {
+        LogRecord record;
+        record.level = level;
+        record.topic = topic;
+        LogPacker packer(record, format);
+        logPack(packer, args...);
+        submit(record);
+    }
+
+private:
+    static void submit(const LogRecord &record);
+    static void drainTask(void *param);
+    // Single consumer: only the drain task calls this
+    static void drain();
+    static void writeRecord(const LogRecord &record);
+};
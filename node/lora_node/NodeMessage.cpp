@@ -0,0 +1,159 @@
+#include "NodeMessage.h"
+
+static const char *const objectNames[MSG_OBJECT_COUNT] = {"", "USER", "SETUP", "MSG", "BCAST"};
+static const char *const functionNames[MSG_FUNCTION_COUNT] = {"", "ADD", "UPDATE", "SEND", "RX"};
+
+// =======================
+// Interning
+// =======================
+MessageObject NodeMessage::internObject(StrView name)
+{
+    for (int i = 1; i < MSG_OBJECT_COUNT; i++)
+    {
+        if (name.equals(objectNames[i]))
+        {
+            return (MessageObject)i;
+        }
+    }
+    return MSG_OBJECT_OTHER;
+}
+
+MessageFunction NodeMessage::internFunction(StrView name)
+{
+    for (int i = 1; i < MSG_FUNCTION_COUNT; i++)
+    {
+        if (name.equals(functionNames[i]))
+        {
+            return (MessageFunction)i;
+        }
+    }
+    return MSG_FUNCTION_OTHER;
+}
+
+// =======================
+// Ids
+// =======================
+uint64_t NodeMessage::parseId(StrView text)
+{
+    if (text.empty())
+    {
+        return 0;
+    }
+    uint64_t id = 0;
+    bool numeric = text.len <= 18;
+    for (size_t i = 0; numeric && i < text.len; i++)
+    {
+        numeric = text.data[i] >= '0' && text.data[i] <= '9';
+        id = id * 10 + (uint64_t)(text.data[i] - '0');
+    }
+    if (numeric)
+    {
+        return id;
+    }
+    // FNV-1a with the top bit set, which no 18-digit id reaches
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < text.len; i++)
+    {
+        hash = (hash ^ (uint8_t)text.data[i]) * 1099511628211ull;
+    }
+    return hash | (1ull << 63);
+}
+
+size_t NodeMessage::formatId(uint64_t id, char *out, size_t size)
+{
+    char digits[20];
+    size_t count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + id % 10);
+        id /= 10;
+    } while (id != 0 && count < sizeof(digits));
+
+    size_t length = count < size ? count : size - 1;
+    for (size_t i = 0; i < length; i++)
+    {
+        out[i] = digits[count - 1 - i];
+    }
+    out[length] = '\0';
+    return length;
+}
+
+// =======================
+// Text
+// =======================
+void NodeMessage::set(uint64_t id, StrView user, long hops, uint32_t time, StrView objectName,
+                      StrView functionName, StrView parameters)
+{
+    const MessageObject knownObject = internObject(objectName);
+    const MessageFunction knownFunction = internFunction(functionName);
+    // Interned names need no text
+    setParts(id, hops, time, knownObject, knownFunction, user,
+             knownObject == MSG_OBJECT_OTHER ? objectName : StrView(),
+             knownFunction == MSG_FUNCTION_OTHER ? functionName : StrView(), parameters);
+}
+
+void NodeMessage::set(uint64_t id, StrView user, long hops, uint32_t time, MessageObject knownObject,
+                      MessageFunction knownFunction, StrView parameters)
+{
+    setParts(id, hops, time, knownObject, knownFunction, user, StrView(), StrView(), parameters);
+}
+
+void NodeMessage::setParts(uint64_t id, long hops, uint32_t time, MessageObject knownObject,
+                           MessageFunction knownFunction, StrView user, StrView objectText, StrView functionText,
+                           StrView parameters)
+{
+    msgId = id;
+    timestamp = time;
+    ttl = (uint8_t)(hops < 0 ? 0 : (hops > 255 ? 255 : hops));
+    object = knownObject;
+    function = knownFunction;
+    truncated = false;
+
+    const StrView parts[PART_COUNT] = {user, objectText, functionText, parameters};
+    size_t used = 0;
+    for (int i = 0; i < PART_COUNT; i++)
+    {
+        size_t room = NODE_MESSAGE_TEXT - used;
+        if (i != PART_PARAMETERS && room > NODE_MESSAGE_NAME_MAX)
+        {
+            room = NODE_MESSAGE_NAME_MAX;
+        }
+        size_t length = parts[i].len;
+        if (length > room)
+        {
+            length = room;
+            truncated = true;
+        }
+        memcpy(text + used, parts[i].data, length);
+        lengths[i] = (uint8_t)length;
+        used += length;
+    }
+}
+
+StrView NodeMessage::part(Part which) const
+{
+    size_t offset = 0;
+    for (int i = 0; i < which; i++)
+    {
+        offset += lengths[i];
+    }
+    return StrView(text + offset, lengths[which]);
+}
+
+StrView NodeMessage::objectName() const
+{
+    if (object == MSG_OBJECT_OTHER || object >= MSG_OBJECT_COUNT)
+    {
+        return part(PART_OBJECT);
+    }
+    return StrView(objectNames[object], strlen(objectNames[object]));
+}
+
+StrView NodeMessage::functionName() const
+{
+    if (function == MSG_FUNCTION_OTHER || function >= MSG_FUNCTION_COUNT)
+    {
+        return part(PART_FUNCTION);
+    }
+    return StrView(functionNames[function], strlen(functionNames[function]));
+}
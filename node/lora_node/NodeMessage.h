@@ -0,0 +1,92 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "PacketParser.h"
+
+// =======================
+// Node message
+// =======================
+// A mesh message packed into one fixed-size value: id, TTL and timestamp
+// are integers, the objects and functions the node acts on are enums, and
+// the sender and parameters sit back to back in one inline buffer. Copying
+// or relaying a message is a plain struct copy and never touches the heap.
+//
+// Objects and functions the node does not know come through as
+// MSG_OBJECT_OTHER / MSG_FUNCTION_OTHER with their name kept in the buffer,
+// so nothing read off the air is lost.
+
+// A whole LoRa frame's worth of text
+#define NODE_MESSAGE_TEXT 255
+// Longest sender or object/function name kept; the parameters get the rest
+#define NODE_MESSAGE_NAME_MAX 48
+
+enum MessageObject : uint8_t
+{
+    MSG_OBJECT_OTHER,
+    MSG_OBJECT_USER,
+    MSG_OBJECT_SETUP,
+    MSG_OBJECT_MSG,
+    MSG_OBJECT_BCAST,
+    MSG_OBJECT_COUNT
+};
+
+enum MessageFunction : uint8_t
+{
+    MSG_FUNCTION_OTHER,
+    MSG_FUNCTION_ADD,
+    MSG_FUNCTION_UPDATE,
+    MSG_FUNCTION_SEND,
+    MSG_FUNCTION_RX,
+    MSG_FUNCTION_COUNT
+};
+
+struct NodeMessage
+{
+    uint64_t msgId;
+    uint32_t timestamp;
+    uint8_t ttl;
+    MessageObject object;
+    MessageFunction function;
+    // Set when the text did not fit and was shortened
+    bool truncated;
+
+    NodeMessage() : msgId(0), timestamp(0), ttl(0), object(MSG_OBJECT_OTHER), function(MSG_FUNCTION_OTHER),
+                    truncated(false), lengths() {}
+
+    // Replaces the whole message. hops is clamped to 0..255 and the object
+    // and function names are interned.
+    void set(uint64_t id, StrView user, long hops, uint32_t time, StrView objectName, StrView functionName,
+             StrView parameters);
+    // For messages made on this node, which already know what they are
+    void set(uint64_t id, StrView user, long hops, uint32_t time, MessageObject knownObject,
+             MessageFunction knownFunction, StrView parameters);
+
+    StrView user() const { return part(PART_USER); }
+    StrView objectName() const;
+    StrView functionName() const;
+    StrView parameters() const { return part(PART_PARAMETERS); }
+
+    // Ids on the air are decimal timestamps. Anything else is hashed, which
+    // is enough to recognise it again.
+    static uint64_t parseId(StrView text);
+    // Writes the id as decimal text (at most 20 digits); returns the length
+    static size_t formatId(uint64_t id, char *out, size_t size);
+    static MessageObject internObject(StrView name);
+    static MessageFunction internFunction(StrView name);
+
+private:
+    enum Part
+    {
+        PART_USER,
+        PART_OBJECT,
+        PART_FUNCTION,
+        PART_PARAMETERS,
+        PART_COUNT
+    };
+    void setParts(uint64_t id, long hops, uint32_t time, MessageObject knownObject, MessageFunction knownFunction,
+                  StrView user, StrView objectText, StrView functionText, StrView parameters);
+    StrView part(Part which) const;
+
+    uint8_t lengths[PART_COUNT];
+    char text[NODE_MESSAGE_TEXT];
+};
@@ -0,0 +1,28 @@
+#include "NodeState.h"
+
+SemaphoreHandle_t NodeState::mutex = NULL;
+
+void NodeState::begin()
+{
+    if (mutex == NULL)
+    {
+        mutex = xSemaphoreCreateRecursiveMutex();
+    }
+}
+
+// Before begin() only the setup task is running, so there is nothing to guard
+void NodeState::lock()
+{
+    if (mutex != NULL)
+    {
+        xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    }
+}
+
+void NodeState::unlock()
+{
+    if (mutex != NULL)
+    {
+        xSemaphoreGiveRecursive(mutex);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+
+// =======================
+// Shared node state lock
+// =======================
+// Users, team pages, online nodes, stored messages and the sync flags are
+// touched from the app loop (packet handling, serial commands), the AsyncTCP
+// task (web handlers) and the UI task. All of them go through this one
+// recursive mutex, so handlers may call each other while holding it.
+// The radio task never takes it.
+class NodeState
+{
+public:
+    // Must run before any other task is started
+    static void begin();
+    static void lock();
+    static void unlock();
+
+private:
+    static SemaphoreHandle_t mutex;
+};
+
+// Holds the node state lock for the enclosing scope
+class NodeStateLock
+{
+public:
+    NodeStateLock() { NodeState::lock(); }
+    ~NodeStateLock() { NodeState::unlock(); }
+
+private:
+    NodeStateLock(const NodeStateLock &);
+    NodeStateLock &operator=(const NodeStateLock &);
+};
@@ -1,13 +1,23 @@
+#include "NodeConfig.h"
+#if FEATURE_ENABLE_WEBSERVER
 #include <Arduino.h>
 #include <WiFi.h>
 #include <DNSServer.h>
 #include <ESPAsyncWebServer.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <memory>
 #include <Preferences.h>
 #include "User.h"
 #include "NodeWebServer.h"
 #include "LoraNode.h"
+#include "NodeState.h"
+#include "NodeLog.h"
+#include "Metrics.h"
+#include "Profiler.h"
+#include "PacketCapture.h"
+#include "JsonWriter.h"
+#include "MessageStore.h"
 #include "version.h"
 
 // ====== Config ======
@@ -32,7 +42,12 @@ AsyncWebServer NodeWebServer::httpServer(80);
 DNSServer NodeWebServer::dnsServer;
 bool NodeWebServer::usersSynced = false;
 bool NodeWebServer::pagesSynced = false;
-String NodeWebServer::teamNames[MAX_TEAM_PAGES];
+AsyncEventSource NodeWebServer::events("/events");
+bool NodeWebServer::onlineNodesChanged = false;
+unsigned long NodeWebServer::lastOnlineNodesEventMs = 0;
+// Page slots are keyed by team ID; both tables are reset in loadPagesNVS()
+uint16_t NodeWebServer::pageTeamIds[MAX_TEAM_PAGES];
+int8_t NodeWebServer::pageSlotByTeam[MAX_TEAMS];
 String NodeWebServer::teamPages[MAX_TEAM_PAGES];
 String NodeWebServer::teamPageUpdatedAt[MAX_TEAM_PAGES];
 static Preferences pagesPrefs;
@@ -50,13 +65,6 @@ String escapeHtml(const String &input)
     return out;
 }
 
-String toLowerCopy(const String &input)
-{
-  String out = input;
-  out.toLowerCase();
-  return out;
-}
-
 String urlDecodeSegment(const String &input)
 {
   String out;
@@ -83,62 +91,45 @@ String urlDecodeSegment(const String &input)
   return out;
 }
 
-String slugifyTeam(const String &team)
+uint16_t NodeWebServer::resolveTeamId(const String &teamOrSlug)
 {
-  String out;
-  out.reserve(team.length());
-  for (size_t i = 0; i < team.length(); i++)
+  uint16_t teamId = TeamDictionary::find(teamOrSlug);
+  if (teamId == TEAM_NONE)
   {
-    char c = team.charAt(i);
-    if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
-    {
-      out += (char)tolower(c);
-    }
-    else if (c == ' ' || c == '-' || c == '_')
-    {
-      if (out.length() == 0 || out.charAt(out.length() - 1) == '-')
-      {
-        continue;
-      }
-      out += '-';
-    }
+    teamId = TeamDictionary::findBySlug(urlDecodeSegment(teamOrSlug));
   }
-  return out;
+  return teamId;
 }
 
-static String normalizeTeamName(const String &team)
+int NodeWebServer::findPageSlot(uint16_t teamId)
 {
-  String out = team;
-  out.trim();
-  out.toLowerCase();
-  return out;
+  if (teamId >= MAX_TEAMS)
+  {
+    return -1;
+  }
+  return pageSlotByTeam[teamId];
 }
 
-String NodeWebServer::findTeamNameBySlug(const String &slug)
+static const String emptyPageString;
+
+void NodeWebServer::setUsersSynced(bool synced)
 {
-  String normalized = toLowerCopy(urlDecodeSegment(slug));
-  normalized.replace("_", "-");
-  for (int i = 0; i < MAX_TEAM_PAGES; i++)
+  if (usersSynced != synced)
   {
-    if (teamNames[i].length() == 0)
-    {
-      continue;
-    }
-    String teamName = teamNames[i];
-    if (toLowerCopy(teamName) == normalized)
-    {
-      return teamName;
-    }
-    if (slugifyTeam(teamName) == normalized)
-    {
-      return teamName;
-    }
+    usersSynced = synced;
+    publishSyncState();
+  }
+}
+
+void NodeWebServer::setPagesSynced(bool synced)
+{
+  if (pagesSynced != synced)
+  {
+    pagesSynced = synced;
+    publishSyncState();
   }
-  return "";
 }
 
-void NodeWebServer::setUsersSynced(bool synced) { usersSynced = synced; }
-void NodeWebServer::setPagesSynced(bool synced) { pagesSynced = synced; }
 bool NodeWebServer::isUsersSynced() { return usersSynced; }
 bool NodeWebServer::isPagesSynced()
 {
@@ -146,14 +137,7 @@ bool NodeWebServer::isPagesSynced()
   {
     return true;
   }
-  for (int i = 0; i < MAX_TEAM_PAGES; i++)
-  {
-    if (teamNames[i].length() > 0 && teamPages[i].length() > 0)
-    {
-      return true;
-    }
-  }
-  return false;
+  return getStoredPagesCount() > 0;
 }
 
 void NodeWebServer::savePagesNVS()
@@ -164,11 +148,11 @@ void NodeWebServer::savePagesNVS()
   int stored = 0;
   for (int i = 0; i < MAX_TEAM_PAGES; i++)
   {
-    if (teamNames[i].length() == 0 || teamPages[i].length() == 0)
+    if (pageTeamIds[i] == TEAM_NONE || teamPages[i].length() == 0)
     {
       continue;
     }
-    pagesPrefs.putString(("page" + String(stored) + "_team").c_str(), teamNames[i]);
+    pagesPrefs.putString(("page" + String(stored) + "_team").c_str(), TeamDictionary::name(pageTeamIds[i]));
     pagesPrefs.putString(("page" + String(stored) + "_html").c_str(), teamPages[i]);
     pagesPrefs.putString(("page" + String(stored) + "_updated").c_str(), teamPageUpdatedAt[i]);
     stored++;
@@ -176,17 +160,26 @@ void NodeWebServer::savePagesNVS()
 
   pagesPrefs.putInt("pageCount", stored);
   pagesPrefs.end();
-  Serial.printf("[TEAM-PAGE] Saved %d pages to NVS\n", stored);
+  LOG_I(LOG_TOPIC_WEB, "[TEAM-PAGE] Saved %d pages to NVS", stored);
 }
 
-void NodeWebServer::loadPagesNVS()
+static void resetPageSlots(uint16_t *pageTeamIds, int8_t *pageSlotByTeam, String *teamPages, String *teamPageUpdatedAt, int maxPages)
 {
-  for (int i = 0; i < MAX_TEAM_PAGES; i++)
+  for (int i = 0; i < maxPages; i++)
   {
-    teamNames[i] = "";
+    pageTeamIds[i] = TEAM_NONE;
     teamPages[i] = "";
     teamPageUpdatedAt[i] = "";
   }
+  for (int i = 0; i < MAX_TEAMS; i++)
+  {
+    pageSlotByTeam[i] = -1;
+  }
+}
+
+void NodeWebServer::loadPagesNVS()
+{
+  resetPageSlots(pageTeamIds, pageSlotByTeam, teamPages, teamPageUpdatedAt, MAX_TEAM_PAGES);
 
   pagesPrefs.begin("NodePages", true);
   int count = pagesPrefs.getInt("pageCount", 0);
@@ -196,11 +189,13 @@ void NodeWebServer::loadPagesNVS()
     String team = pagesPrefs.getString(("page" + String(i) + "_team").c_str(), "");
     String html = pagesPrefs.getString(("page" + String(i) + "_html").c_str(), "");
     String updated = pagesPrefs.getString(("page" + String(i) + "_updated").c_str(), "");
-    if (team.length() == 0 || html.length() == 0)
+    uint16_t teamId = User::internTeam(team);
+    if (teamId == TEAM_NONE || html.length() == 0 || pageSlotByTeam[teamId] >= 0)
     {
       continue;
     }
-    teamNames[stored] = team;
+    pageTeamIds[stored] = teamId;
+    pageSlotByTeam[teamId] = stored;
     teamPages[stored] = html;
     teamPageUpdatedAt[stored] = updated;
     stored++;
@@ -208,18 +203,13 @@ void NodeWebServer::loadPagesNVS()
   pagesPrefs.end();
 
   pagesSynced = stored > 0;
-  Serial.printf("[TEAM-PAGE] Loaded %d pages from NVS\n", stored);
-  Serial.printf("[TEAM-PAGE] Total stored pages: %d\n", stored);
+  LOG_I(LOG_TOPIC_WEB, "[TEAM-PAGE] Loaded %d pages from NVS", stored);
+  LOG_I(LOG_TOPIC_WEB, "[TEAM-PAGE] Total stored pages: %d", stored);
 }
 
 void NodeWebServer::clearPages(bool clearNvs)
 {
-  for (int i = 0; i < MAX_TEAM_PAGES; i++)
-  {
-    teamNames[i] = "";
-    teamPages[i] = "";
-    teamPageUpdatedAt[i] = "";
-  }
+  resetPageSlots(pageTeamIds, pageSlotByTeam, teamPages, teamPageUpdatedAt, MAX_TEAM_PAGES);
   pagesSynced = false;
 
   if (clearNvs)
@@ -227,100 +217,68 @@ void NodeWebServer::clearPages(bool clearNvs)
     pagesPrefs.begin("NodePages", false);
     pagesPrefs.clear();
     pagesPrefs.end();
-    Serial.println("[TEAM-PAGE] Cleared pages from NVS");
+    LOG_I(LOG_TOPIC_WEB, "[TEAM-PAGE] Cleared pages from NVS");
   }
 }
 
 void NodeWebServer::storeTeamPage(const String &team, const String &html, const String &updatedAt)
 {
-  String trimmedTeam = team;
-  trimmedTeam.trim();
-  String normalized = normalizeTeamName(trimmedTeam);
-  for (int i = 0; i < MAX_TEAM_PAGES; i++)
+  uint16_t teamId = User::internTeam(team);
+  if (teamId == TEAM_NONE)
   {
-    String existingNorm = normalizeTeamName(teamNames[i]);
-    if (existingNorm == normalized || teamNames[i].length() == 0)
-    {
-      teamNames[i] = trimmedTeam;
-      teamPages[i] = html;
-      teamPageUpdatedAt[i] = updatedAt;
-      Serial.printf("[TEAM-PAGE] Stored team page: %s (len=%d) slot=%d updated=%s\n", team.c_str(), html.length(), i, updatedAt.c_str());
-      savePagesNVS();
-      return;
-    }
+    return;
   }
-}
-
-String NodeWebServer::getTeamPage(const String &team)
-{
-  String normalized = normalizeTeamName(team);
-  for (int i = 0; i < MAX_TEAM_PAGES; i++)
+  int slot = findPageSlot(teamId);
+  for (int i = 0; slot < 0 && i < MAX_TEAM_PAGES; i++)
   {
-    if (normalizeTeamName(teamNames[i]) == normalized)
+    if (pageTeamIds[i] == TEAM_NONE)
     {
-      return teamPages[i];
+      slot = i;
     }
   }
-  String resolved = NodeWebServer::findTeamNameBySlug(team);
-  if (resolved.length() > 0)
+  if (slot < 0)
   {
-    for (int i = 0; i < MAX_TEAM_PAGES; i++)
-    {
-      if (teamNames[i] == resolved)
-      {
-        return teamPages[i];
-      }
-    }
+    return;
   }
-  return "";
+  pageTeamIds[slot] = teamId;
+  pageSlotByTeam[teamId] = slot;
+  teamPages[slot] = html;
+  teamPageUpdatedAt[slot] = updatedAt;
+  LOG_I(LOG_TOPIC_WEB, "[TEAM-PAGE] Stored team page: %s (len=%d) slot=%d updated=%s", team.c_str(), html.length(), slot, updatedAt.c_str());
+  savePagesNVS();
 }
 
-String NodeWebServer::getTeamPageUpdatedAt(const String &team)
+const String &NodeWebServer::getTeamPage(uint16_t teamId)
 {
-  String normalized = normalizeTeamName(team);
-  for (int i = 0; i < MAX_TEAM_PAGES; i++)
-  {
-    if (normalizeTeamName(teamNames[i]) == normalized)
-    {
-      return teamPageUpdatedAt[i];
-    }
-  }
-  String resolved = NodeWebServer::findTeamNameBySlug(team);
-  if (resolved.length() > 0)
-  {
-    for (int i = 0; i < MAX_TEAM_PAGES; i++)
-    {
-      if (teamNames[i] == resolved)
-      {
-        return teamPageUpdatedAt[i];
-      }
-    }
-  }
-  return "";
+  int slot = findPageSlot(teamId);
+  return slot >= 0 ? teamPages[slot] : emptyPageString;
+}
+
+const String &NodeWebServer::getTeamPage(const String &team)
+{
+  return getTeamPage(resolveTeamId(team));
+}
+
+const String &NodeWebServer::getTeamPageUpdatedAt(uint16_t teamId)
+{
+  int slot = findPageSlot(teamId);
+  return slot >= 0 ? teamPageUpdatedAt[slot] : emptyPageString;
+}
+
+const String &NodeWebServer::getTeamPageUpdatedAt(const String &team)
+{
+  return getTeamPageUpdatedAt(resolveTeamId(team));
+}
+
+bool NodeWebServer::hasTeamPage(uint16_t teamId)
+{
+  int slot = findPageSlot(teamId);
+  return slot >= 0 && teamPages[slot].length() > 0;
 }
 
 bool NodeWebServer::hasTeamPage(const String &team)
 {
-  String normalized = normalizeTeamName(team);
-  for (int i = 0; i < MAX_TEAM_PAGES; i++)
-  {
-    if (normalizeTeamName(teamNames[i]) == normalized && teamPages[i].length() > 0)
-    {
-      return true;
-    }
-  }
-  String resolved = NodeWebServer::findTeamNameBySlug(team);
-  if (resolved.length() > 0)
-  {
-    for (int i = 0; i < MAX_TEAM_PAGES; i++)
-    {
-      if (teamNames[i] == resolved && teamPages[i].length() > 0)
-      {
-        return true;
-      }
-    }
-  }
-  return false;
+  return hasTeamPage(resolveTeamId(team));
 }
 
 int NodeWebServer::getStoredPagesCount()
@@ -328,7 +286,7 @@ int NodeWebServer::getStoredPagesCount()
   int count = 0;
   for (int i = 0; i < MAX_TEAM_PAGES; i++)
   {
-    if (teamNames[i].length() > 0 && teamPages[i].length() > 0)
+    if (pageTeamIds[i] != TEAM_NONE && teamPages[i].length() > 0)
     {
       count++;
     }
@@ -336,13 +294,18 @@ int NodeWebServer::getStoredPagesCount()
   return count;
 }
 
-String NodeWebServer::getTeamNameAt(int index)
+uint16_t NodeWebServer::getTeamIdAt(int index)
 {
   if (index < 0 || index >= MAX_TEAM_PAGES)
   {
-    return "";
+    return TEAM_NONE;
   }
-  return teamNames[index];
+  return pageTeamIds[index];
+}
+
+String NodeWebServer::getTeamNameAt(int index)
+{
+  return TeamDictionary::name(getTeamIdAt(index));
 }
 
 String NodeWebServer::getTeamUpdatedAtAt(int index)
@@ -368,14 +331,14 @@ int NodeWebServer::getMaxTeamPages()
   return MAX_TEAM_PAGES;
 }
 
-String getSessionToken(AsyncWebServerRequest *request)
+static String readSessionToken(AsyncWebServerRequest *request)
 {
     String session = "";
-    Serial.println("[INFO] getSessionToken");
+    LOG_D(LOG_TOPIC_AUTH, "[INFO] getSessionToken");
     if (request->hasHeader("Cookie"))
     {
         String cookies = request->getHeader("Cookie")->value();
-        Serial.println("[INFO] Cookies: " + cookies);
+        LOG_V(LOG_TOPIC_AUTH, "[INFO] Cookies: %s", cookies.c_str());
 
         if (cookies.indexOf("session=") >= 0)
         {
@@ -387,23 +350,29 @@ String getSessionToken(AsyncWebServerRequest *request)
         }
     }
 
-    Serial.println("[INFO] Session token: " + session);
     if ((session == "") && (request->hasArg("token")))
     {
-        Serial.println("[INFO] Found token in request: " + request->arg("token"));
+        LOG_V(LOG_TOPIC_AUTH, "[INFO] Found token in request: %s", request->arg("token").c_str());
 
         session = request->arg("token");
     }
+    return session;
+}
 
-    Serial.println("[INFO] Session token: " + session);
-    if ((session != "") && (!User::isValidToken(session)))
+// Resolve the request's session once; handlers use the returned user for name/team/token
+const NodeUser &getSessionUser(AsyncWebServerRequest *request)
+{
+    String session = readSessionToken(request);
+    if (session == "")
     {
-        Serial.println("[INFO] invalid token: " + session);
-        return "";
+        return User::emptyUser;
     }
-    Serial.println("[INFO] Session token: " + session);
-
-    return session;
+    const NodeUser &user = User::getUserBySession(session);
+    if (!User::exists(user))
+    {
+        LOG_V(LOG_TOPIC_AUTH, "[INFO] invalid token: %s", session.c_str());
+    }
+    return user;
 }
 
 const char PAGE_INDEX[] PROGMEM = R"rawliteral(
@@ -660,11 +629,12 @@ const char PAGE_INDEX[] PROGMEM = R"rawliteral(
 </html>
 )rawliteral";
 
-String NodeWebServer::makePage(String session)
+String NodeWebServer::makePage(const NodeUser &sessionUser)
 {
     String page(PAGE_INDEX);
-    String username = User::getNameBySession(session);
-    String team = User::getUserTeamBySession(session);
+    const String session = sessionUser.token();
+    const String username = sessionUser.username();
+    const String team = sessionUser.team();
     String title = String(FIRMWARE_NAME) + " V" + FIRMWARE_VERSION;
   String syncStatus;
   bool usersOk = NodeWebServer::isUsersSynced();
@@ -692,13 +662,14 @@ String NodeWebServer::makePage(String session)
     syncStatus += "</div>";
   }
   String teamPageSection;
-  bool hasTeamPage = (team.length() > 0 && NodeWebServer::hasTeamPage(team));
-  String teamSlug = (team.length() > 0) ? slugifyTeam(team) : "";
+  const uint16_t teamId = sessionUser.teamId;
+  bool hasTeamPage = NodeWebServer::hasTeamPage(teamId);
+  const char *teamSlug = TeamDictionary::slug(teamId);
   if (team.length() > 0 && hasTeamPage)
   {
-    String updatedAt = NodeWebServer::getTeamPageUpdatedAt(team);
+    const String &updatedAt = NodeWebServer::getTeamPageUpdatedAt(teamId);
     String updatedHtml = updatedAt.length() > 0 ? ("<p><small>Laatst bijgewerkt: " + escapeHtml(updatedAt) + "</small></p>") : "";
-    teamPageSection = "<div class='box' id='team-page'><h3>📄 Team Pagina</h3>" + updatedHtml + NodeWebServer::getTeamPage(team) + "</div>";
+    teamPageSection = "<div class='box' id='team-page'><h3>📄 Team Pagina</h3>" + updatedHtml + NodeWebServer::getTeamPage(teamId) + "</div>";
   }
   else if (team.length() > 0)
   {
@@ -709,18 +680,18 @@ String NodeWebServer::makePage(String session)
     teamPageSection = "<div class='box' id='team-page'><h3>📄 Team Pagina</h3><p>Geen team gekoppeld aan gebruiker.</p></div>";
   }
 
-  Serial.printf("[TEAM-PAGE] user=%s team=%s slug=%s hasPage=%s\n",
+  LOG_D(LOG_TOPIC_WEB, "[TEAM-PAGE] user=%s team=%s slug=%s hasPage=%s",
                 username.c_str(),
                 team.c_str(),
-                teamSlug.c_str(),
+                teamSlug,
                 hasTeamPage ? "yes" : "no");
     
     // Links
     String links = "<div class='box'><h3>⚙️ Links</h3><ul>";
     links += "<li><a href='/'>Home</a></li>";
-    if (teamSlug.length() > 0)
+    if (teamSlug[0] != '\0')
     {
-      links += "<li><a href='" + String("/") + teamSlug + "'>Team Pagina</a></li>";
+      links += "<li><a href='/" + String(teamSlug) + "'>Team Pagina</a></li>";
     }
     links += "<li><a href='/debug.html'>Debug Info</a></li>";
     links += "</ul></div>";
@@ -730,18 +701,17 @@ String NodeWebServer::makePage(String session)
     int allPagesCount = 0;
     for (int i = 0; i < MAX_TEAM_PAGES; i++)
     {
-      if (teamNames[i].length() == 0 || teamPages[i].length() == 0)
+      if (pageTeamIds[i] == TEAM_NONE || teamPages[i].length() == 0)
       {
         continue;
       }
-      String pageTeam = teamNames[i];
-      String pageSlug = slugifyTeam(pageTeam);
-      if (pageSlug.length() == 0)
+      const char *pageSlug = TeamDictionary::slug(pageTeamIds[i]);
+      if (pageSlug[0] == '\0')
       {
         continue;
       }
-      String updatedAt = teamPageUpdatedAt[i];
-      allPagesList += "<li><a href='" + String("/") + pageSlug + "'>" + escapeHtml(pageTeam) + "</a>";
+      const String &updatedAt = teamPageUpdatedAt[i];
+      allPagesList += "<li><a href='/" + String(pageSlug) + "'>" + escapeHtml(TeamDictionary::name(pageTeamIds[i])) + "</a>";
       if (updatedAt.length() > 0)
       {
         allPagesList += " <small>(Laatst bijgewerkt: " + escapeHtml(updatedAt) + ")</small>";
@@ -759,14 +729,14 @@ String NodeWebServer::makePage(String session)
     String nodeList = "<div class='box'><h3>🟢 Online Nodes</h3>";
     int onlineCount = LoraNode::getOnlineCount();
     const OnlineNode *onlineNodes = LoraNode::getOnlineNodes();
-    Serial.println("[INFO] Online nodes:" + String(onlineCount));
+    LOG_I(LOG_TOPIC_WEB, "[INFO] Online nodes:%d", onlineCount);
     nodeList += "<p><strong>Total: " + String(onlineCount) + " nodes</strong></p><ul>";
     for (int i = 0; i < onlineCount; i++)
     {
         unsigned long now = millis();
         unsigned long lastSeen = onlineNodes[i].lastSeen;
         unsigned long secondsAgo = (now > lastSeen) ? (now - lastSeen) / 1000 : 0;
-        nodeList += "<li><strong>" + escapeHtml(onlineNodes[i].name) + "</strong> | RSSI: " + String(onlineNodes[i].rssi) + " dBm | Last seen: " + String(secondsAgo) + "s ago</li>";
+        nodeList += "<li><strong>" + escapeHtml(onlineNodes[i].name) + "</strong> | RSSI: " + String(onlineNodes[i].rssi) + " dBm | Last seen: " + String(secondsAgo) + "s ago" + (onlineNodes[i].lowPower ? " | 🔋 low power" : "") + "</li>";
     }
     nodeList += "</ul></div>";
     
@@ -797,8 +767,9 @@ String NodeWebServer::makePage(String session)
     return page;
 }
 
-  String buildTeamPageHtml(const String &teamName, const String &teamSlug, const String &username, bool hasPage, bool usersOk, bool pagesOk, const String &teamHtml)
+  String buildTeamPageHtml(uint16_t teamId, const String &teamSlug, const String &username, bool hasPage, bool usersOk, bool pagesOk, const String &teamHtml)
   {
+    const String teamName = TeamDictionary::name(teamId);
     String page;
     page += "<!DOCTYPE html><html><head><meta charset='UTF-8'>";
     page += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
@@ -814,7 +785,7 @@ String NodeWebServer::makePage(String session)
     page += "<div class='meta'>Team: <strong>" + escapeHtml(teamName) + "</strong></div>";
     if (hasPage)
     {
-      String updatedAt = NodeWebServer::getTeamPageUpdatedAt(teamName);
+      const String &updatedAt = NodeWebServer::getTeamPageUpdatedAt(teamId);
       if (updatedAt.length() > 0)
       {
         page += "<div class='meta'>Laatst bijgewerkt: <strong>" + escapeHtml(updatedAt) + "</strong></div>";
@@ -1050,24 +1021,24 @@ static String buildLoginPageHtml(const String &syncStatus, const String &loginDi
   return loginPage;
 }
 
-static String buildHomeTeamPageHtml(const String &session)
+static String buildHomeTeamPageHtml(const NodeUser &sessionUser)
 {
-  String username = User::getNameBySession(session);
-  String team = User::getUserTeamBySession(session);
-  String teamHtml = (team.length() > 0) ? NodeWebServer::getTeamPage(team) : "";
-  bool hasPage = (team.length() > 0 && NodeWebServer::hasTeamPage(team));
-  String updatedAt = (team.length() > 0) ? NodeWebServer::getTeamPageUpdatedAt(team) : "";
+  const String username = sessionUser.username();
+  const String team = sessionUser.team();
+  const String &teamHtml = NodeWebServer::getTeamPage(sessionUser.teamId);
+  bool hasPage = NodeWebServer::hasTeamPage(sessionUser.teamId);
+  const String &updatedAt = NodeWebServer::getTeamPageUpdatedAt(sessionUser.teamId);
 
   String syncStatus;
   bool usersOk = NodeWebServer::isUsersSynced();
   bool pagesOk = NodeWebServer::isPagesSynced();
   if (usersOk && pagesOk)
   {
-    syncStatus = "<div class='sync ok'>✅ Users en pagina's gesynchroniseerd</div>";
+    syncStatus = "<div class='sync ok' id='sync'>✅ Users en pagina's gesynchroniseerd</div>";
   }
   else
   {
-    syncStatus = "<div class='sync warn'>⚠️ Sync status: ";
+    syncStatus = "<div class='sync warn' id='sync'>⚠️ Sync status: ";
     if (!usersOk) syncStatus += "users ontbreken ";
     if (!pagesOk) syncStatus += "pagina's ontbreken ";
     syncStatus += "</div>";
@@ -1113,6 +1084,7 @@ static String buildHomeTeamPageHtml(const String &session)
     page += "<p>Geen team gekoppeld aan gebruiker.</p>";
   }
   page += "</div>";
+  page += "<div class='card'><h3>🟢 Online Nodes</h3><ul id='nodes'></ul></div>";
 
   page += "<script>(function(){";
   page += "const AP_HOST='192.168.3.1';const AP_URL='http://192.168.3.1/';const TOKEN_KEY='meshnetSession';";
@@ -1127,15 +1099,26 @@ static String buildHomeTeamPageHtml(const String &session)
   page += "document.addEventListener('visibilitychange',function(){if(!document.hidden){attemptReconnect();}});";
   page += "setInterval(attemptReconnect,15000);";
   page += "ensureSession();";
+  // Live sync status and online nodes from /events, or once from /api/nodes
+  page += "function renderNodes(list){const ul=document.getElementById('nodes');ul.textContent='';";
+  page += "list.forEach(function(n){const li=document.createElement('li');const b=document.createElement('strong');";
+  page += "b.textContent=n.n;li.appendChild(b);li.appendChild(document.createTextNode(' | RSSI: '+n.r+' dBm | Last seen: '+n.s+'s ago'+(n.lp?' | 🔋 low power':'')));ul.appendChild(li);});";
+  page += "if(!ul.firstChild){ul.textContent='Geen nodes online.';}}";
+  page += "if(window.EventSource){const es=new EventSource('/events');";
+  page += "es.addEventListener('sync',function(e){const s=JSON.parse(e.data);const el=document.getElementById('sync');";
+  page += "if(s.users&&s.pages){el.className='sync ok';el.textContent=\"✅ Users en pagina's gesynchroniseerd\";}";
+  page += "else{el.className='sync warn';el.textContent='⚠️ Sync status: '+(s.users?'':'users ontbreken ')+(s.pages?'':\"pagina's ontbreken\");}});";
+  page += "es.addEventListener('nodes',function(e){renderNodes(JSON.parse(e.data));});}";
+  page += "else{fetch('/api/nodes').then(function(r){return r.json();}).then(function(d){renderNodes(d.nodes);});}";
   page += "})();</script>";
   page += "</body></html>";
   return page;
 }
 
-static String buildAdminPagesHtml(const String &session)
+static String buildAdminPagesHtml(const NodeUser &sessionUser)
 {
-  String username = User::getNameBySession(session);
-  String team = User::getUserTeamBySession(session);
+  const String username = sessionUser.username();
+  const String team = sessionUser.team();
   String page;
   page += "<!DOCTYPE html><html><head><meta charset='UTF-8'>";
   page += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
@@ -1165,18 +1148,18 @@ static String buildAdminPagesHtml(const String &session)
   int totalTeams = NodeWebServer::getMaxTeamPages();
   for (int i = 0; i < totalTeams; i++)
   {
-    String pageTeam = NodeWebServer::getTeamNameAt(i);
+    uint16_t pageTeamId = NodeWebServer::getTeamIdAt(i);
     int pageLength = NodeWebServer::getTeamPageLengthAt(i);
-    if (pageTeam.length() == 0 || pageLength == 0)
+    if (pageTeamId == TEAM_NONE || pageLength == 0)
     {
       continue;
     }
-    String pageSlug = slugifyTeam(pageTeam);
+    const char *pageSlug = TeamDictionary::slug(pageTeamId);
     String updatedAt = NodeWebServer::getTeamUpdatedAtAt(i);
-    page += "<li><strong>" + escapeHtml(pageTeam) + "</strong>";
-    if (pageSlug.length() > 0)
+    page += "<li><strong>" + escapeHtml(TeamDictionary::name(pageTeamId)) + "</strong>";
+    if (pageSlug[0] != '\0')
     {
-      page += " · <a href='" + String("/") + pageSlug + "'>Open</a>";
+      page += " · <a href='/" + String(pageSlug) + "'>Open</a>";
     }
     if (updatedAt.length() > 0)
     {
@@ -1211,15 +1194,32 @@ static String buildAdminPagesHtml(const String &session)
 }
 
 // ====== Routes ======
+// Counts the request and records how long the handler ran. Responses are sent
+// asynchronously, so this is the time spent building them, not the transfer.
+static ArRequestHandlerFunction timed(ArRequestHandlerFunction handler)
+{
+    return [handler](AsyncWebServerRequest *request)
+    {
+        uint32_t started = micros();
+        handler(request);
+        Metrics::inc(CTR_HTTP_REQUESTS);
+        Metrics::observe(HIST_HTTP_MS, (micros() - started) / 1000);
+    };
+}
+
+static void onRoute(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction handler)
+{
+    NodeWebServer::httpServer.on(uri, method, timed(handler));
+}
+
 void NodeWebServer::setupRoot()
 {
     // Handler for both "/" and "/index.html"
     auto rootHandler = [](AsyncWebServerRequest *request)
     {
-        Serial.println("[INFO] getSessionToken 2");    
-        String session = getSessionToken(request);
-        Serial.println("[INFO] Session token: " + session);
-        if (session == "" ) {
+        NodeStateLock lock;
+        const NodeUser &sessionUser = getSessionUser(request);
+        if (!User::exists(sessionUser)) {
           String syncStatus;
           bool usersOk = NodeWebServer::isUsersSynced();
           bool pagesOk = NodeWebServer::isPagesSynced();
@@ -1254,10 +1254,9 @@ void NodeWebServer::setupRoot()
           response->addHeader("Expires", "0");
           request->send(response);
         } else {
-            Serial.println("[INFO] Session token: " + session);
-            String page = buildHomeTeamPageHtml(session);
+            String page = buildHomeTeamPageHtml(sessionUser);
             AsyncWebServerResponse *response = request->beginResponse(200, "text/html; charset=UTF-8", page);
-            response->addHeader("Set-Cookie", "session=" + session + "; Path=/; Max-Age=86400");
+            response->addHeader("Set-Cookie", "session=" + String(sessionUser.token()) + "; Path=/; Max-Age=86400");
             response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
             response->addHeader("Pragma", "no-cache");
             response->addHeader("Expires", "0");
@@ -1265,8 +1264,8 @@ void NodeWebServer::setupRoot()
         }
     };
     
-    httpServer.on("/", HTTP_GET, rootHandler);
-    httpServer.on("/index.html", HTTP_GET, rootHandler);
+    onRoute("/", HTTP_GET, rootHandler);
+    onRoute("/index.html", HTTP_GET, rootHandler);
 }
 void NodeWebServer::setupCaptivePortal()
 {
@@ -1277,51 +1276,45 @@ void NodeWebServer::setupCaptivePortal()
                   "</body></html>";
 
     // Captive portal common URLs
-    httpServer.on("/generate_204.html", HTTP_GET, [page](AsyncWebServerRequest *request)
+    onRoute("/generate_204.html", HTTP_GET, [page](AsyncWebServerRequest *request)
                   { request->send(204); });
-    httpServer.on("/generate_204", HTTP_GET, [page](AsyncWebServerRequest *request)
+    onRoute("/generate_204", HTTP_GET, [page](AsyncWebServerRequest *request)
                   { request->send(204); });
-    httpServer.on("/fwlink.html", HTTP_GET, [page](AsyncWebServerRequest *request)
+    onRoute("/fwlink.html", HTTP_GET, [page](AsyncWebServerRequest *request)
                   { request->send(204); });
-    httpServer.on("/hotspot-detect.html", HTTP_GET, [](AsyncWebServerRequest *request)
+    onRoute("/hotspot-detect.html", HTTP_GET, [](AsyncWebServerRequest *request)
                   { request->send(204); });
-    httpServer.onNotFound([](AsyncWebServerRequest *request)
+    httpServer.onNotFound(timed([](AsyncWebServerRequest *request)
                           {
+    NodeStateLock lock;
     String path = request->url();
     String slug = path.startsWith("/") ? path.substring(1) : path;
     bool looksLikeSlug = slug.length() > 0 && slug.indexOf('/') == -1 && slug.indexOf('.') == -1;
 
     if (looksLikeSlug)
     {
-      String session = getSessionToken(request);
-      if (session.length() > 0)
+      const NodeUser &sessionUser = getSessionUser(request);
+      if (User::exists(sessionUser))
       {
-        String username = User::getNameBySession(session);
-        String userTeam = User::getUserTeamBySession(session);
-        String userTeamSlug = slugifyTeam(userTeam);
-        String resolvedTeam = "";
-
-        if (slug == userTeamSlug)
+        const String username = sessionUser.username();
+        uint16_t resolvedTeam = sessionUser.teamId;
+        if (slug != TeamDictionary::slug(resolvedTeam))
         {
-          resolvedTeam = userTeam;
-        }
-        else
-        {
-                resolvedTeam = NodeWebServer::findTeamNameBySlug(slug);
+          resolvedTeam = NodeWebServer::resolveTeamId(slug);
         }
 
-        bool hasPage = resolvedTeam.length() > 0 && NodeWebServer::hasTeamPage(resolvedTeam);
-        Serial.printf("[TEAM-PAGE] path=%s slug=%s user=%s team=%s resolved=%s hasPage=%s\n",
+        bool hasPage = NodeWebServer::hasTeamPage(resolvedTeam);
+        LOG_D(LOG_TOPIC_WEB, "[TEAM-PAGE] path=%s slug=%s user=%s team=%s resolved=%s hasPage=%s",
                 path.c_str(),
                 slug.c_str(),
                 username.c_str(),
-                userTeam.c_str(),
-                resolvedTeam.c_str(),
+                sessionUser.team(),
+                TeamDictionary::name(resolvedTeam),
                 hasPage ? "yes" : "no");
 
-        if (resolvedTeam.length() > 0)
+        if (resolvedTeam != TEAM_NONE)
         {
-          String teamHtml = NodeWebServer::getTeamPage(resolvedTeam);
+          const String &teamHtml = NodeWebServer::getTeamPage(resolvedTeam);
           String page = buildTeamPageHtml(
             resolvedTeam,
             slug,
@@ -1341,7 +1334,7 @@ void NodeWebServer::setupCaptivePortal()
     AsyncWebServerResponse *response = request->beginResponse(302);
     response->addHeader("Location", "/");
     request->send(response);
-});
+}));
 }
 
 // Helper function to send login data to Docker API (non-blocking)
@@ -1369,19 +1362,20 @@ void sendLoginToApi(const String &user, const String &team)
         client.print("Connection: close\r\n\r\n");
         client.print(payload);
         
-        Serial.println("[API] Sent connection data to Docker backend for user: " + user);
+        LOG_I(LOG_TOPIC_WEB, "[API] Sent connection data to Docker backend for user: %s", user.c_str());
         
         // Close connection immediately (don't wait for response)
         client.stop();
     } else {
-        Serial.println("[API] Failed to connect to Docker backend");
+        LOG_W(LOG_TOPIC_WEB, "[API] Failed to connect to Docker backend");
     }
 }
 
 void NodeWebServer::setupLogin()
 {
-    httpServer.on("/login.html", HTTP_GET, [](AsyncWebServerRequest *request)
+    onRoute("/login.html", HTTP_GET, [](AsyncWebServerRequest *request)
                   { 
+        NodeStateLock lock;
         bool usersOk = NodeWebServer::isUsersSynced();
         bool pagesOk = NodeWebServer::isPagesSynced();
         bool hasUsers = (User::getUserCount() > 0);
@@ -1417,8 +1411,9 @@ void NodeWebServer::setupLogin()
   request->send(response);
                   });
 
-    httpServer.on("/login", HTTP_POST, [](AsyncWebServerRequest *request)
+    onRoute("/login", HTTP_POST, [](AsyncWebServerRequest *request)
                   {
+        NodeStateLock lock;
         bool usersOk = NodeWebServer::isUsersSynced();
         bool pagesOk = NodeWebServer::isPagesSynced();
         bool hasUsers = (User::getUserCount() > 0);
@@ -1443,29 +1438,21 @@ void NodeWebServer::setupLogin()
         if (request->hasArg("user")) user = request->arg("user");
         if (request->hasArg("pass")) pass = request->arg("pass");
 
-        Serial.println("\n\n========================================");
-        Serial.println("     LOGIN ATTEMPT");
-        Serial.println("========================================");
-        Serial.printf("[LOGIN] Raw inputs from form:\n");
-        Serial.printf("  - username field: '%s' (length=%d)\n", user.c_str(), user.length());
-        Serial.printf("  - password field: '%s' (length=%d)\n", pass.c_str(), pass.length());
+        LOG_D(LOG_TOPIC_AUTH, "[LOGIN] Attempt: user='%s' (length=%d), password length=%d",
+              user.c_str(), user.length(), pass.length());
         
         // Hash the password before comparing with stored hash
         String passHash = User::hashPassword(pass);
-        Serial.printf("[LOGIN] Password hash calculated: '%s'\n", passHash.c_str());
+        LOG_V(LOG_TOPIC_AUTH, "[LOGIN] Password hash calculated: '%s'", passHash.c_str());
         
         if (User::isValidLogin(user, passHash)) {
-            String session = User::createSession(user);
-            
-            // Get user team
-            String team = User::getUserTeamByName(user);
+            const NodeUser &loggedIn = User::getUserByName(user);
+            const String session = loggedIn.token();
+            const String team = loggedIn.team();
             
             // Send connection info to Docker API (non-blocking)
-            Serial.println("\n[LOGIN] ✓ SUCCESS!");
-            Serial.printf("  - Authenticated as: '%s'\n", user.c_str());
-            Serial.printf("  - Team: '%s'\n", team.c_str());
-            Serial.printf("  - Session token: '%s'\n", session.c_str());
-            Serial.println("========================================\n");
+            LOG_I(LOG_TOPIC_AUTH, "[LOGIN] ✓ SUCCESS: '%s' (team '%s')", user.c_str(), team.c_str());
+            LOG_V(LOG_TOPIC_AUTH, "[LOGIN] Session token: '%s'", session.c_str());
             
             sendLoginToApi(user, team);
             
@@ -1474,28 +1461,17 @@ void NodeWebServer::setupLogin()
             response->addHeader("Location", "/");
             request->send(response);
         } else {
-            Serial.println("\n[LOGIN] ✗ FAILED!");
-            Serial.printf("  - User not found or password mismatch\n");
-            Serial.println("========================================\n");
-            
-            String debugMsg = "<h3>❌ Login Failed - DEBUG INFO</h3>";
-            debugMsg += "<p><strong>Attempted User:</strong> " + user + "</p>";
-            debugMsg += "<p><strong>Password Entered:</strong> " + pass + "</p>";
-            debugMsg += "<p><strong>Password Hash:</strong> " + passHash + "</p>";
-            debugMsg += "<h4>Users on Node (" + String(User::getUserCount()) + "):</h4><ul>";
-            for (int i = 0; i < User::getUserCount(); i++) {
-                debugMsg += "<li>" + User::getUserName(i) + "</li>";
-            }
-            debugMsg += "</ul>";
-            debugMsg += "<p><a href='/login.html'>Back to Login</a></p>";
-            Serial.println("[LOGIN FAIL] User: " + user + " | Available users: " + String(User::getUserCount()));
-            request->send(403, "text/html", debugMsg);
+            // Fixed and short: nothing about the table or the attempt goes back
+            LOG_W(LOG_TOPIC_AUTH, "[LOGIN FAIL] User: %s", user.c_str());
+            request->send(403, "text/html",
+                          "<h3>❌ Login mislukt</h3><p>Onbekende gebruiker of verkeerd wachtwoord.</p>"
+                          "<p><a href='/login.html'>Terug naar login</a></p>");
         } });
 }
 
 void NodeWebServer::setupRegister()
 {
-    httpServer.on("/register.html", HTTP_GET, [](AsyncWebServerRequest *request)
+    onRoute("/register.html", HTTP_GET, [](AsyncWebServerRequest *request)
                   { 
         String registerPage = R"rawliteral(
 <!DOCTYPE html>
@@ -1687,14 +1663,16 @@ void NodeWebServer::setupRegister()
         request->send(200, "text/html", registerPage);
                   });
 
-    httpServer.on("/register", HTTP_POST, [](AsyncWebServerRequest *request)
+    onRoute("/register", HTTP_POST, [](AsyncWebServerRequest *request)
                   {
+        NodeStateLock lock;
         String user, pass, team;
         if (request->hasArg("user")) user = request->arg("user");
         if (request->hasArg("pass")) pass = request->arg("pass");
         if (request->hasArg("team")) team = request->arg("team");
 
-        if (User::registerUser(user, pass, team)) {
+        // Users are stored and sent over the mesh by their hash, never the password
+        if (User::registerUser(user, User::hashPassword(pass), team)) {
             String session = User::createSession(user);
             AsyncWebServerResponse *response = request->beginResponse(303);
             response->addHeader("Set-Cookie", "session=" + session + "; Path=/; Max-Age=86400");
@@ -1707,7 +1685,7 @@ void NodeWebServer::setupRegister()
 
 void NodeWebServer::setupLogout()
 {
-    httpServer.on("/logout", HTTP_GET, [](AsyncWebServerRequest *request)
+    onRoute("/logout", HTTP_GET, [](AsyncWebServerRequest *request)
                   {
         AsyncWebServerResponse *response = request->beginResponse(303);
         response->addHeader("Set-Cookie", "session=; Max-Age=0");
@@ -1717,10 +1695,11 @@ void NodeWebServer::setupLogout()
 
 void NodeWebServer::setupAdmin()
 {
-    httpServer.on("/admin", HTTP_GET, [](AsyncWebServerRequest *request)
+    onRoute("/admin", HTTP_GET, [](AsyncWebServerRequest *request)
                   {
-        String session = getSessionToken(request);
-        if (session == "")
+        NodeStateLock lock;
+        const NodeUser &sessionUser = getSessionUser(request);
+        if (!User::exists(sessionUser))
         {
           AsyncWebServerResponse *response = request->beginResponse(302);
           response->addHeader("Location", "/");
@@ -1728,27 +1707,103 @@ void NodeWebServer::setupAdmin()
           return;
         }
 
-        String page = buildAdminPagesHtml(session);
+        String page = buildAdminPagesHtml(sessionUser);
         AsyncWebServerResponse *response = request->beginResponse(200, "text/html; charset=UTF-8", page);
-        response->addHeader("Set-Cookie", "session=" + session + "; Path=/; Max-Age=86400");
+        response->addHeader("Set-Cookie", "session=" + String(sessionUser.token()) + "; Path=/; Max-Age=86400");
         response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
         response->addHeader("Pragma", "no-cache");
         response->addHeader("Expires", "0");
         request->send(response); });
 }
 
+// Debug and scrape endpoints expose internals, so like /sync/refresh they need
+// a session (cookie or ?token=); answers 403 itself when there is none
+static bool requireSession(AsyncWebServerRequest *request)
+{
+    NodeStateLock lock;
+    if (User::exists(getSessionUser(request)))
+    {
+        return true;
+    }
+    request->send(403, "text/plain", "Ongeldig of ontbrekend token.");
+    return false;
+}
+
 void NodeWebServer::setupDebug()
 {
-    httpServer.on("/debug.html", HTTP_GET, [](AsyncWebServerRequest *request)
+    onRoute("/debug.html", HTTP_GET, [](AsyncWebServerRequest *request)
                   {
         String page = "<h2>Debug info</h2>";
-        page += "<p>Aantal berichten: " + String(MAX_MSGS) + "</p>";
+        {
+            NodeStateLock lock;
+            page += "<p>Aantal berichten: " + String(MessageStore::getNextSeq() - MessageStore::getOldestSeq()) +
+                    " van " + String(MessageStore::getCapacity()) +
+                    (MessageStore::isPersistent() ? " (flash)" : " (alleen RAM)") + "</p>";
+        }
+        page += "<p><a href='/debug/profile'>Profiler</a> | <a href='/metrics'>Metrics</a>"
+                " | <a href='/debug/pcap'>Packet capture (PCAP)</a></p>";
         request->send(200, "text/html", page); });
 
-  httpServer.on("/sync/refresh", HTTP_GET, [](AsyncWebServerRequest *request)
+    // Profiler table; ?reset=1 clears it after printing
+    onRoute("/debug/profile", HTTP_GET, [](AsyncWebServerRequest *request)
+                  {
+        if (!requireSession(request))
+        {
+            return;
+        }
+        AsyncResponseStream *response = request->beginResponseStream("text/plain");
+        Profiler::writeReport(*response);
+        if (request->hasArg("reset") && request->arg("reset") == "1")
+        {
+            Profiler::reset();
+            response->println("[PROFILE] reset");
+        }
+        request->send(response); });
+
+    // Capture ring as a PCAP file. Streamed in chunks from a snapshot of the
+    // ring's bounds, so frames arriving during the download are not included.
+    onRoute("/debug/pcap", HTTP_GET, [](AsyncWebServerRequest *request)
+                  {
+        if (!requireSession(request))
+        {
+            return;
+        }
+        struct PcapCursor
+        {
+            uint32_t seq;
+            uint32_t end;
+        };
+        std::shared_ptr<PcapCursor> cursor(new PcapCursor());
+        cursor->seq = PacketCapture::getOldestSeq();
+        cursor->end = PacketCapture::getNextSeq();
+        AsyncWebServerResponse *response = request->beginChunkedResponse("application/vnd.tcpdump.pcap",
+            [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+            {
+                size_t written = 0;
+                if (index == 0)
+                {
+                    written = PacketCapture::writePcapHeader(buffer, maxLen);
+                }
+                return written + PacketCapture::readPcap(cursor->seq, cursor->end, buffer + written, maxLen - written);
+            });
+        response->addHeader("Content-Disposition", "attachment; filename=\"meshnet.pcap\"");
+        request->send(response); });
+
+    // Prometheus scrape endpoint; scrapers pass ?token=
+    onRoute("/metrics", HTTP_GET, [](AsyncWebServerRequest *request)
+                  {
+        if (!requireSession(request))
+        {
+            return;
+        }
+        AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+        Metrics::writePrometheus(*response);
+        request->send(response); });
+
+  onRoute("/sync/refresh", HTTP_GET, [](AsyncWebServerRequest *request)
           {
-    String session = getSessionToken(request);
-    if (session == "")
+    NodeStateLock lock;
+    if (!User::exists(getSessionUser(request)))
     {
       request->send(403, "text/plain", "Ongeldig of ontbrekend token.");
       return;
@@ -1757,7 +1812,7 @@ void NodeWebServer::setupDebug()
     bool hard = request->hasArg("hard") && request->arg("hard") == "1";
     if (hard)
     {
-      Serial.println("[SYNC] Hard refresh requested - clearing users/pages");
+      LOG_I(LOG_TOPIC_SYNC, "[SYNC] Hard refresh requested - clearing users/pages");
       User::clearUsers();
       User::saveUsersNVS();
       clearPages(true);
@@ -1768,7 +1823,7 @@ void NodeWebServer::setupDebug()
     }
     else
     {
-      Serial.println("[SYNC] Refresh requested");
+      LOG_I(LOG_TOPIC_SYNC, "[SYNC] Refresh requested");
       LoraNode::setPagesSynced(false);
       NodeWebServer::setPagesSynced(false);
     }
@@ -1779,60 +1834,93 @@ void NodeWebServer::setupDebug()
     request->send(200, "text/plain", hard ? "Hard refresh gestart" : "Refresh gestart"); });
 }
 
+// Static shell for /msg; the messages come from /api/messages and /events,
+// so the page itself can be cached by the browser
+const char PAGE_MESSAGES[] PROGMEM = R"rawliteral(<!DOCTYPE html>
+<html><head><meta charset='UTF-8'><meta name='viewport' content='width=device-width, initial-scale=1'></head>
+<body>
+<h2>Berichten</h2>
+<form method='POST' action='/msg' id='send'>
+Bericht: <input type='text' name='msg'><br>
+<input type='submit' value='Stuur'></form><br>
+<div id='msgs'></div>
+<script>
+(function(){
+  const token=new URL(window.location.href).searchParams.get('token');
+  const auth=token?'token='+encodeURIComponent(token):'';
+  const list=document.getElementById('msgs');
+  let next=-1;
+  let loading=false;
+  let again=false;
+  function show(m){
+    if(m.i<next){return;}
+    next=m.i+1;
+    const b=document.createElement('b');
+    b.textContent=m.u+':';
+    list.appendChild(b);
+    list.appendChild(document.createTextNode(' '+m.o+' '+m.f+' '+m.p));
+    list.appendChild(document.createElement('br'));
+  }
+  // Pages through /api/messages until it has everything up to 'latest'
+  function load(){
+    if(loading){again=true;return;}
+    loading=true;
+    again=false;
+    const since=next>=0?'since='+next+'&':'';
+    fetch('/api/messages?'+since+auth).then(function(r){
+      if(r.status===403){list.textContent='Ongeldig of ontbrekend token.';throw new Error('forbidden');}
+      return r.json();
+    }).then(function(d){
+      d.messages.forEach(show);
+      if(next<d.next){next=d.next;}
+      loading=false;
+      if(d.next<d.latest||again){load();}
+    }).catch(function(){loading=false;});
+  }
+  load();
+  if(window.EventSource){
+    new EventSource('/events'+(auth?'?'+auth:'')).addEventListener('msg',function(e){
+      const m=JSON.parse(e.data);
+      // Missed some while loading or reconnecting: fetch the gap first
+      if(next>=0&&m.i===next){show(m);}else{load();}
+    });
+  }
+  document.getElementById('send').addEventListener('submit',function(e){
+    e.preventDefault();
+    const form=e.target;
+    fetch('/msg'+(auth?'?'+auth:''),{method:'POST',body:new URLSearchParams(new FormData(form))}).then(function(){form.reset();});
+  });
+})();
+</script>
+</body></html>
+)rawliteral";
+
 void NodeWebServer::setupMessages()
 {
-    // GET: toon berichten
-    httpServer.on("/msg", HTTP_GET, [](AsyncWebServerRequest *request)
+    // GET: toon berichten (static shell, see PAGE_MESSAGES)
+    onRoute("/msg", HTTP_GET, [](AsyncWebServerRequest *request)
                   {
-        String token;
-
-        Serial.println("[INFO] getSessionToken 3");
-    
-        String session = getSessionToken(request);
-        if (session == "" ) {
-            request->send(403, "text/html", "<p>Ongeldig of ontbrekend token.</p>");
-            return;
-        }
-
-        String content = "<h2>Berichten</h2>";
-        content += "<form method='POST' action='/msg'>";
-        content += "Bericht: <input type='text' name='msg'><br>";
-        content += "<input type='submit' value='Stuur'></form><br>";
-
-        NodeMessage msg;
-        for (int i = 0; i < LoraNode::getMsgCount(); i++) {
-            msg = LoraNode::getMessage(i);
-            content += "<b>" + escapeHtml(msg.user) + ":</b> "
-                       + escapeHtml(msg.object) + " "
-                       + escapeHtml(msg.function) + " "
-                       + escapeHtml(msg.parameters) +  "<br>";
-        }
-
-        request->send(200, "text/html", content); });
+        AsyncWebServerResponse *response = request->beginResponse_P(200, "text/html; charset=UTF-8", PAGE_MESSAGES);
+        response->addHeader("Cache-Control", "max-age=3600");
+        request->send(response); });
 
     // POST: voeg bericht toe
-    httpServer.on("/msg", HTTP_POST, [](AsyncWebServerRequest *request)
+    onRoute("/msg", HTTP_POST, [](AsyncWebServerRequest *request)
                   {
-        String msg, user;
-        Serial.println("[INFO] getSessionToken 4");
-    
-        String session = getSessionToken(request);
-        if (session == "") {
+        NodeStateLock lock;
+        String msg;
+        const NodeUser &sessionUser = getSessionUser(request);
+        if (!User::exists(sessionUser)) {
             request->send(403, "text/html", "<p>Ongeldig of ontbrekend token.</p>");
             return;
         }
         if (request->hasArg("msg")) msg = request->arg("msg");
 
-        user = User::getNameBySession(session);
+        const String user = sessionUser.username();
 
         NodeMessage nodeMessage;
-        nodeMessage.msgId = String(millis());
-        nodeMessage.user = user;
-        nodeMessage.TTL = 3;
-        nodeMessage.timestamp = millis();
-        nodeMessage.object = "MSG";
-        nodeMessage.function = "SEND";
-        nodeMessage.parameters = msg;
+        nodeMessage.set(millis(), StrView(user.c_str(), user.length()), 3, millis(), MSG_OBJECT_MSG,
+                        MSG_FUNCTION_SEND, StrView(msg.c_str(), msg.length()));
 
         LoraNode::addMessage(nodeMessage);
 
@@ -1841,19 +1929,399 @@ void NodeWebServer::setupMessages()
         request->send(response); });
 }
 
+// ====== JSON ======
+// Objects shared by the live events and the API:
+//   message  {"i":<seq>,"u":"<user>","o":"<object>","f":"<function>","p":"<parameters>"}
+//   node     {"n":"<node>","r":<rssi>,"s":<seconds since seen>[,"lp":1]}
+//            lp: the node is saving battery and relays less
+//   user     {"n":"<name>","t":"<team>"}
+static void writeMessageField(JsonWriter &json, const char *key, const MessageRecord &record, MessageField field)
+{
+  StrView value = record.field(field);
+  json.key(key);
+  json.string(value.data, value.len);
+}
+
+static size_t messageJsonSize(const MessageRecord &record)
+{
+  size_t size = 48;
+  for (int i = 0; i < MESSAGE_FIELD_COUNT; i++)
+  {
+    StrView value = record.field((MessageField)i);
+    size += JsonWriter::escapedLength(value.data, value.len);
+  }
+  return size;
+}
+
+static void writeMessageJson(JsonWriter &json, const MessageRecord &record)
+{
+  json.raw("{");
+  json.key("i");
+  json.number((unsigned long)record.seq);
+  json.raw(",");
+  writeMessageField(json, "u", record, MESSAGE_FIELD_USER);
+  json.raw(",");
+  writeMessageField(json, "o", record, MESSAGE_FIELD_OBJECT);
+  json.raw(",");
+  writeMessageField(json, "f", record, MESSAGE_FIELD_FUNCTION);
+  json.raw(",");
+  writeMessageField(json, "p", record, MESSAGE_FIELD_PARAMETERS);
+  json.raw("}");
+}
+
+static size_t onlineNodeJsonSize(const OnlineNode &node)
+{
+  return 40 + JsonWriter::escapedLength(node.name.c_str(), node.name.length());
+}
+
+static void writeOnlineNodeJson(JsonWriter &json, const OnlineNode &node, unsigned long now)
+{
+  json.raw("{");
+  json.key("n");
+  json.string(node.name.c_str(), node.name.length());
+  json.raw(",");
+  json.key("r");
+  json.number((long)node.rssi);
+  json.raw(",");
+  json.key("s");
+  json.number((now - node.lastSeen) / 1000);
+  if (node.lowPower)
+  {
+    json.raw(",\"lp\":1");
+  }
+  json.raw("}");
+}
+
+static void writeSyncJson(JsonWriter &json)
+{
+  json.raw("{");
+  json.key("users");
+  json.boolean(NodeWebServer::isUsersSynced());
+  json.raw(",");
+  json.key("pages");
+  json.boolean(NodeWebServer::isPagesSynced());
+  json.raw("}");
+}
+
+// ====== Live events ======
+// Pages keep an EventSource open on /events and patch themselves instead of
+// reloading:
+//   sync   {"users":true,"pages":false}
+//   nodes  [<node>,...]
+//   msg    <message>
+// A new stream gets sync and nodes straight away. Nothing is built when no
+// page is listening.
+// events.send() runs on the loop task and in web handlers while the AsyncTCP
+// task adds and drops clients. That relies on the ESPAsyncWebServer pinned in
+// platformio.ini, whose AsyncEventSource holds a mutex around its client list.
+static std::unique_ptr<char[]> buildSyncEvent()
+{
+  std::unique_ptr<char[]> data(new char[40]);
+  JsonWriter json(data.get(), 39);
+  writeSyncJson(json);
+  data[json.length()] = '\0';
+  return data;
+}
+
+static std::unique_ptr<char[]> buildOnlineNodesEvent()
+{
+  const int onlineCount = LoraNode::getOnlineCount();
+  const OnlineNode *onlineNodes = LoraNode::getOnlineNodes();
+  size_t size = 2;
+  for (int i = 0; i < onlineCount; i++)
+  {
+    size += onlineNodeJsonSize(onlineNodes[i]) + 1;
+  }
+  std::unique_ptr<char[]> data(new char[size + 1]);
+  JsonWriter json(data.get(), size);
+  const unsigned long now = millis();
+  json.raw("[");
+  for (int i = 0; i < onlineCount; i++)
+  {
+    if (i > 0)
+    {
+      json.raw(",");
+    }
+    writeOnlineNodeJson(json, onlineNodes[i], now);
+  }
+  json.raw("]");
+  data[json.length()] = '\0';
+  return data;
+}
+
+void NodeWebServer::publishSyncState()
+{
+  if (events.count() == 0)
+  {
+    return;
+  }
+  events.send(buildSyncEvent().get(), "sync");
+}
+
+void NodeWebServer::publishOnlineNodesChanged()
+{
+  onlineNodesChanged = true;
+}
+
+void NodeWebServer::publishOnlineNodes()
+{
+  onlineNodesChanged = false;
+  lastOnlineNodesEventMs = millis();
+  if (events.count() == 0)
+  {
+    return;
+  }
+  events.send(buildOnlineNodesEvent().get(), "nodes");
+}
+
+void NodeWebServer::publishMessage(uint32_t seq)
+{
+  MessageRecord record;
+  if (events.count() == 0 || !MessageStore::read(seq, record))
+  {
+    return;
+  }
+  const size_t size = messageJsonSize(record);
+  std::unique_ptr<char[]> data(new char[size + 1]);
+  JsonWriter json(data.get(), size);
+  writeMessageJson(json, record);
+  data[json.length()] = '\0';
+  events.send(data.get(), "msg", seq + 1);
+}
+
+void NodeWebServer::setupEvents()
+{
+  // Same session as the pages; anything else falls through to the captive portal
+  events.setFilter([](AsyncWebServerRequest *request)
+                   {
+    NodeStateLock lock;
+    return User::exists(getSessionUser(request)); });
+
+  events.onConnect([](AsyncEventSourceClient *client)
+                   {
+    if (events.count() > SSE_MAX_CLIENTS)
+    {
+      LOG_W(LOG_TOPIC_WEB, "[EVENTS] Too many streams, closing the newest");
+      client->close();
+      return;
+    }
+    NodeStateLock lock;
+    client->send(buildSyncEvent().get(), "sync", 0, SSE_RETRY_MS);
+    client->send(buildOnlineNodesEvent().get(), "nodes");
+    LOG_D(LOG_TOPIC_WEB, "[EVENTS] Stream opened (%u open)", (unsigned)events.count()); });
+
+  httpServer.addHandler(&events);
+}
+
+// ====== JSON API ======
+// Read-only and for logged-in sessions, like the pages:
+//   GET /api/messages?since=<seq>&limit=<n>
+//       {"oldest":<seq>,"next":<seq>,"latest":<seq>,"messages":[<message>,...]}
+//       Messages from since (default: the oldest kept) up to limit of them;
+//       ask again with since=next until next == latest.
+//   GET /api/nodes    {"nodes":[<node>,...]}
+//   GET /api/users?page=<n>
+//       {"page":<n>,"pages":<count>,"total":<users>,"users":[<user>,...]}
+// Lists are streamed as chunked responses that end each chunk on an item
+// boundary, so response memory does not grow with the list. Items removed
+// while a list is being sent are left out.
+typedef bool (*JsonItemWriter)(JsonWriter &json, uint32_t index);
+
+struct JsonListCursor
+{
+  String head;
+  uint32_t next;
+  uint32_t end;
+  JsonItemWriter writeItem;
+  bool headSent;
+  bool firstItem;
+  bool done;
+};
+
+static bool writeMessageItem(JsonWriter &json, uint32_t seq)
+{
+  MessageRecord record;
+  if (!MessageStore::read(seq, record))
+  {
+    return false;
+  }
+  writeMessageJson(json, record);
+  return true;
+}
+
+static bool writeOnlineNodeItem(JsonWriter &json, uint32_t index)
+{
+  if ((int)index >= LoraNode::getOnlineCount())
+  {
+    return false;
+  }
+  writeOnlineNodeJson(json, LoraNode::getOnlineNodes()[index], millis());
+  return true;
+}
+
+static bool writeUserItem(JsonWriter &json, uint32_t index)
+{
+  if ((int)index >= User::getUserCount())
+  {
+    return false;
+  }
+  const String name = User::getUserName(index);
+  const String team = User::getUserTeam(index);
+  json.raw("{");
+  json.key("n");
+  json.string(name.c_str(), name.length());
+  json.raw(",");
+  json.key("t");
+  json.string(team.c_str(), team.length());
+  json.raw("}");
+  return true;
+}
+
+static size_t fillJsonList(JsonListCursor &cursor, uint8_t *buffer, size_t maxLen)
+{
+  if (cursor.done)
+  {
+    return 0;
+  }
+  JsonWriter json((char *)buffer, maxLen);
+  if (!cursor.headSent)
+  {
+    json.raw(cursor.head.c_str(), cursor.head.length());
+    if (json.overflowed())
+    {
+      return RESPONSE_TRY_AGAIN;
+    }
+    cursor.headSent = true;
+  }
+  {
+    NodeStateLock lock;
+    while (cursor.next < cursor.end)
+    {
+      const size_t mark = json.mark();
+      if (!cursor.firstItem)
+      {
+        json.raw(",");
+      }
+      const bool present = cursor.writeItem(json, cursor.next);
+      if (json.overflowed())
+      {
+        json.rollback(mark);
+        if (mark > 0 || maxLen < API_CHUNK_MIN)
+        {
+          break;
+        }
+        // Bigger than any chunk will be; leave it out rather than stall
+      }
+      else if (present)
+      {
+        cursor.firstItem = false;
+      }
+      cursor.next++;
+    }
+  }
+  if (cursor.next >= cursor.end)
+  {
+    const size_t mark = json.mark();
+    json.raw("]}");
+    if (json.overflowed())
+    {
+      json.rollback(mark);
+    }
+    else
+    {
+      cursor.done = true;
+    }
+  }
+  return json.length() > 0 ? json.length() : RESPONSE_TRY_AGAIN;
+}
+
+static void sendJsonList(AsyncWebServerRequest *request, const String &head, uint32_t begin, uint32_t end,
+                         JsonItemWriter writeItem)
+{
+  std::shared_ptr<JsonListCursor> cursor(new JsonListCursor());
+  cursor->head = head;
+  cursor->next = begin;
+  cursor->end = end;
+  cursor->writeItem = writeItem;
+  cursor->headSent = false;
+  cursor->firstItem = true;
+  cursor->done = false;
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+      [cursor](uint8_t *buffer, size_t maxLen, size_t) -> size_t
+      {
+        return fillJsonList(*cursor, buffer, maxLen);
+      });
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+static long argOr(AsyncWebServerRequest *request, const char *name, long fallback)
+{
+  if (!request->hasArg(name))
+  {
+    return fallback;
+  }
+  return request->arg(name).toInt();
+}
+
+void NodeWebServer::setupApi()
+{
+  onRoute("/api/messages", HTTP_GET, [](AsyncWebServerRequest *request)
+          {
+    NodeStateLock lock;
+    if (!User::exists(getSessionUser(request))) {
+      request->send(403, "application/json", "{\"error\":\"unauthorized\"}");
+      return;
+    }
+    const uint32_t oldest = MessageStore::getOldestSeq();
+    const uint32_t latest = MessageStore::getNextSeq();
+    const long since = argOr(request, "since", oldest);
+    const long limit = constrain(argOr(request, "limit", API_MESSAGES_LIMIT), 1, API_MESSAGES_MAX);
+    const uint32_t begin = since < (long)oldest ? oldest : (since > (long)latest ? latest : (uint32_t)since);
+    const uint32_t end = (latest - begin > (uint32_t)limit) ? begin + limit : latest;
+    String head = "{\"oldest\":" + String(oldest) + ",\"next\":" + String(end) +
+                  ",\"latest\":" + String(latest) + ",\"messages\":[";
+    sendJsonList(request, head, begin, end, writeMessageItem); });
+
+  onRoute("/api/nodes", HTTP_GET, [](AsyncWebServerRequest *request)
+          {
+    NodeStateLock lock;
+    if (!User::exists(getSessionUser(request))) {
+      request->send(403, "application/json", "{\"error\":\"unauthorized\"}");
+      return;
+    }
+    sendJsonList(request, "{\"nodes\":[", 0, LoraNode::getOnlineCount(), writeOnlineNodeItem); });
+
+  onRoute("/api/users", HTTP_GET, [](AsyncWebServerRequest *request)
+          {
+    NodeStateLock lock;
+    if (!User::exists(getSessionUser(request))) {
+      request->send(403, "application/json", "{\"error\":\"unauthorized\"}");
+      return;
+    }
+    const int total = User::getUserCount();
+    const int pages = (total + API_USERS_PAGE_SIZE - 1) / API_USERS_PAGE_SIZE;
+    const long page = constrain(argOr(request, "page", 0), 0, pages > 0 ? pages - 1 : 0);
+    const int begin = page * API_USERS_PAGE_SIZE;
+    const int end = min(begin + API_USERS_PAGE_SIZE, total);
+    String head = "{\"page\":" + String(page) + ",\"pages\":" + String(pages) +
+                  ",\"total\":" + String(total) + ",\"users\":[";
+    sendJsonList(request, head, begin, end, writeUserItem); });
+}
+
 // ====== Init ======
 void NodeWebServer::webserverSetup()
 {
-    Serial.println("[DEBUG] Starting webserver setup...");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] Starting webserver setup...");
 
   loadPagesNVS();
-  Serial.println("[DEBUG] loadPagesNVS done");
+  LOG_D(LOG_TOPIC_WEB, "[DEBUG] loadPagesNVS done");
     
     WiFi.mode(WIFI_AP);
-    Serial.println("[DEBUG] WiFi mode set to AP");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] WiFi mode set to AP");
     
     WiFi.softAPConfig(apIP, apIP, IPAddress(255, 255, 255, 0));
-    Serial.println("[DEBUG] Soft AP config set");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] Soft AP config set");
 
     String mac = WiFi.softAPmacAddress();
     mac.replace(":", "");
@@ -1861,39 +2329,51 @@ void NodeWebServer::webserverSetup()
     AP_SSID = String(FIRMWARE_NAME) + "-" + mac + "_V" + String(FIRMWARE_VERSION);
 
     WiFi.softAP(AP_SSID.c_str(), AP_PASS.c_str());
-    Serial.println("[DEBUG] Soft AP started: " + AP_SSID);
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] Soft AP started: %s", AP_SSID.c_str());
 
     setupRoot();
-    Serial.println("[DEBUG] setupRoot done");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] setupRoot done");
     
     setupCaptivePortal();
-    Serial.println("[DEBUG] setupCaptivePortal done");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] setupCaptivePortal done");
     
     setupLogin();
-    Serial.println("[DEBUG] setupLogin done");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] setupLogin done");
     
     setupLogout();
-    Serial.println("[DEBUG] setupLogout done");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] setupLogout done");
 
     setupAdmin();
-    Serial.println("[DEBUG] setupAdmin done");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] setupAdmin done");
     
     setupDebug();
-    Serial.println("[DEBUG] setupDebug done");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] setupDebug done");
     
     setupMessages();
-    Serial.println("[DEBUG] setupMessages done");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] setupMessages done");
+
+    setupEvents();
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] setupEvents done");
+
+    setupApi();
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] setupApi done");
 
     httpServer.begin();
-    Serial.println("[DEBUG] httpServer.begin() called");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] httpServer.begin() called");
     
     dnsServer.start(DNS_PORT, "*", apIP);
-    Serial.println("[DEBUG] dnsServer.start() called");
+    LOG_D(LOG_TOPIC_WEB, "[DEBUG] dnsServer.start() called");
 
-    Serial.println("[INFO] Async Webserver gestart");
+    LOG_I(LOG_TOPIC_WEB, "[INFO] Async Webserver gestart");
 }
 
 void NodeWebServer::webserverLoop()
 {
     dnsServer.processNextRequest();
+    if (onlineNodesChanged && millis() - lastOnlineNodesEventMs >= SSE_NODES_INTERVAL_MS)
+    {
+        NodeStateLock lock;
+        publishOnlineNodes();
+    }
 }
+#endif
@@ -1,6 +1,9 @@
 
 #pragma once
 #include <Arduino.h>
+#include "NodeConfig.h"
+
+#if FEATURE_ENABLE_WEBSERVER
 #include <DNSServer.h>
 #include <ESPAsyncWebServer.h>
 #include "User.h"
@@ -18,6 +21,8 @@ public:
     static void setupDebug();
     static void setupMessages();
     static void setupCaptivePortal();
+    static void setupEvents();
+    static void setupApi();
     static void setUsersSynced(bool synced);
     static void setPagesSynced(bool synced);
     static bool isUsersSynced();
@@ -26,23 +31,57 @@ public:
     static void loadPagesNVS();
     static void clearPages(bool clearNvs);
     static void storeTeamPage(const String &team, const String &html, const String &updatedAt);
-    static String getTeamPage(const String &team);
-    static String getTeamPageUpdatedAt(const String &team);
+    // Team arguments may be a team name or a URL slug
+    static const String &getTeamPage(const String &team);
+    static const String &getTeamPageUpdatedAt(const String &team);
     static bool hasTeamPage(const String &team);
+    static const String &getTeamPage(uint16_t teamId);
+    static const String &getTeamPageUpdatedAt(uint16_t teamId);
+    static bool hasTeamPage(uint16_t teamId);
     static int getStoredPagesCount();
     static int getMaxTeamPages();
+    static uint16_t getTeamIdAt(int index);
     static String getTeamNameAt(int index);
     static String getTeamUpdatedAtAt(int index);
     static int getTeamPageLengthAt(int index);
-    static String findTeamNameBySlug(const String &slug);
+    static uint16_t resolveTeamId(const String &teamOrSlug);
+    // Live updates for open pages (GET /events); callers hold the node
+    // state lock
+    static void publishMessage(uint32_t seq);
+    static void publishOnlineNodesChanged();
     static AsyncWebServer httpServer;
 private:
-    static String makePage(String session);
+    static void publishSyncState();
+    static void publishOnlineNodes();
+    static AsyncEventSource events;
+    static bool onlineNodesChanged;
+    static unsigned long lastOnlineNodesEventMs;
+    static String makePage(const NodeUser &sessionUser);
+    static int findPageSlot(uint16_t teamId);
     static DNSServer dnsServer;
     static bool usersSynced;
     static bool pagesSynced;
     static const int MAX_TEAM_PAGES = 20;
-    static String teamNames[MAX_TEAM_PAGES];
+    static uint16_t pageTeamIds[MAX_TEAM_PAGES];
+    static int8_t pageSlotByTeam[MAX_TEAMS];
     static String teamPages[MAX_TEAM_PAGES];
     static String teamPageUpdatedAt[MAX_TEAM_PAGES];
 };
+#else
+#include "TeamDictionary.h"
+
+// Relay builds have no web server; these keep the mesh code free of #ifs
+class NodeWebServer
+{
+public:
+    static void webserverSetup() {}
+    static void webserverLoop() {}
+    static void setUsersSynced(bool) {}
+    static void setPagesSynced(bool) {}
+    static int getStoredPagesCount() { return 0; }
+    static int getMaxTeamPages() { return 0; }
+    static uint16_t getTeamIdAt(int) { return TEAM_NONE; }
+    static void publishMessage(uint32_t) {}
+    static void publishOnlineNodesChanged() {}
+};
+#endif
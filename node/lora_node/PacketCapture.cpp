@@ -0,0 +1,268 @@
+#include "PacketCapture.h"
+#include <math.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include "LoraNode.h"
+#include "NodeLog.h"
+#include "SerialLink.h"
+
+struct PacketCapture::Entry
+{
+    uint64_t timestampUs; // since boot
+    uint32_t airtimeUs;
+    int16_t rssi;         // dBm
+    int8_t snrQuarterDb;
+    uint8_t direction;
+    uint16_t length;
+    uint8_t data[RX_BUFFER_SIZE];
+};
+
+PacketCapture::Entry *PacketCapture::entries = NULL;
+size_t PacketCapture::depth = 0;
+uint32_t PacketCapture::nextSeq = 0;
+uint32_t PacketCapture::streamSeq = 0;
+bool PacketCapture::streaming = false;
+
+// Guards the entry being written against readers on the other core
+static portMUX_TYPE captureMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Lines sent per streamPending() call, so a burst cannot stall the loop
+#define CAPTURE_STREAM_BATCH 4
+
+void PacketCapture::begin()
+{
+    if (entries != NULL)
+    {
+        return;
+    }
+    size_t count = CAPTURE_DEPTH;
+    void *ring = heap_caps_calloc(count, sizeof(Entry), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ring == NULL)
+    {
+        count = CAPTURE_DEPTH_INTERNAL;
+        ring = heap_caps_calloc(count, sizeof(Entry), MALLOC_CAP_8BIT);
+    }
+    if (ring == NULL)
+    {
+        LOG_W(LOG_TOPIC_RADIO, "[CAPTURE] No memory for the capture ring");
+        return;
+    }
+    depth = count;
+    entries = (Entry *)ring;
+    LOG_I(LOG_TOPIC_RADIO, "[CAPTURE] Keeping the last %u frames", (unsigned)depth);
+}
+
+// =======================
+// Recording
+// =======================
+void PacketCapture::record(CaptureDirection direction, const uint8_t *data, size_t length,
+                           float rssi, float snr, uint32_t airtimeUs)
+{
+    if (entries == NULL)
+    {
+        return;
+    }
+    if (length > RX_BUFFER_SIZE)
+    {
+        length = RX_BUFFER_SIZE;
+    }
+    long quarterDb = lroundf(snr * 4.0f);
+    if (quarterDb < -128) quarterDb = -128;
+    if (quarterDb > 127) quarterDb = 127;
+
+    portENTER_CRITICAL(&captureMux);
+    Entry &entry = entries[nextSeq % depth];
+    entry.timestampUs = (uint64_t)esp_timer_get_time();
+    entry.airtimeUs = airtimeUs;
+    entry.rssi = (int16_t)lroundf(rssi);
+    entry.snrQuarterDb = (int8_t)quarterDb;
+    entry.direction = (uint8_t)direction;
+    entry.length = (uint16_t)length;
+    memcpy(entry.data, data, length);
+    nextSeq++;
+    portEXIT_CRITICAL(&captureMux);
+}
+
+uint32_t PacketCapture::getNextSeq()
+{
+    portENTER_CRITICAL(&captureMux);
+    uint32_t seq = nextSeq;
+    portEXIT_CRITICAL(&captureMux);
+    return seq;
+}
+
+uint32_t PacketCapture::getOldestSeq()
+{
+    portENTER_CRITICAL(&captureMux);
+    uint32_t seq = nextSeq > depth ? nextSeq - depth : 0;
+    portEXIT_CRITICAL(&captureMux);
+    return seq;
+}
+
+// False once seq has been overwritten (or not written yet)
+bool PacketCapture::copyEntry(uint32_t seq, Entry &entry)
+{
+    bool valid = false;
+    portENTER_CRITICAL(&captureMux);
+    if (entries != NULL && seq < nextSeq && nextSeq - seq <= depth)
+    {
+        entry = entries[seq % depth];
+        valid = true;
+    }
+    portEXIT_CRITICAL(&captureMux);
+    return valid;
+}
+
+// =======================
+// PCAP export
+// =======================
+static void putLe16(uint8_t *out, uint16_t value)
+{
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static void putLe32(uint8_t *out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+static void putBe32(uint8_t *out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = (value >> (24 - 8 * i)) & 0xFF;
+    }
+}
+
+size_t PacketCapture::writePcapHeader(uint8_t *out, size_t capacity)
+{
+    if (capacity < PCAP_HEADER_SIZE)
+    {
+        return 0;
+    }
+    putLe32(out, 0xA1B2C3D4); // microsecond timestamps, little endian
+    putLe16(out + 4, 2);
+    putLe16(out + 6, 4);
+    putLe32(out + 8, 0);      // timezone offset
+    putLe32(out + 12, 0);     // timestamp accuracy
+    putLe32(out + 16, LORATAP_HEADER_SIZE + RX_BUFFER_SIZE);
+    putLe32(out + 20, LINKTYPE_LORATAP);
+    return PCAP_HEADER_SIZE;
+}
+
+// LoRaTap v0; multi-byte fields are big endian
+static void writeLoraTap(uint8_t *out, int16_t rssi, int8_t snrQuarterDb, bool received)
+{
+    int packetRssi = received ? rssi + 139 : 0;
+    if (packetRssi < 0) packetRssi = 0;
+    if (packetRssi > 255) packetRssi = 255;
+
+    out[0] = 0; // version
+    out[1] = 0; // padding
+    out[2] = 0;
+    out[3] = LORATAP_HEADER_SIZE;
+    putBe32(out + 4, (uint32_t)(LORA_FREQUENCY_MHZ * 1000000.0));
+    out[8] = (uint8_t)(LORA_BANDWIDTH_KHZ / 125.0); // in 125 kHz steps
+    out[9] = LORA_SPREADING_FACTOR;
+    out[10] = (uint8_t)packetRssi;
+    out[11] = (uint8_t)packetRssi; // max RSSI, not measured separately
+    out[12] = 0;                   // current RSSI, not measured
+    out[13] = (uint8_t)snrQuarterDb;
+    out[14] = LORA_SYNC_WORD;
+}
+
+size_t PacketCapture::readPcap(uint32_t &seq, uint32_t end, uint8_t *out, size_t capacity)
+{
+    size_t written = 0;
+    Entry entry;
+    while (seq < end)
+    {
+        if (!copyEntry(seq, entry))
+        {
+            // Overwritten while the reader was behind; continue at the oldest
+            uint32_t oldest = getOldestSeq();
+            seq = oldest > seq ? oldest : end;
+            continue;
+        }
+        const size_t recordSize = PCAP_RECORD_HEADER_SIZE + LORATAP_HEADER_SIZE + entry.length;
+        if (written + recordSize > capacity)
+        {
+            break;
+        }
+        uint8_t *record = out + written;
+        putLe32(record, (uint32_t)(entry.timestampUs / 1000000));
+        putLe32(record + 4, (uint32_t)(entry.timestampUs % 1000000));
+        putLe32(record + 8, LORATAP_HEADER_SIZE + entry.length);
+        putLe32(record + 12, LORATAP_HEADER_SIZE + entry.length);
+        writeLoraTap(record + PCAP_RECORD_HEADER_SIZE, entry.rssi, entry.snrQuarterDb,
+                     entry.direction == CAPTURE_RX);
+        memcpy(record + PCAP_RECORD_HEADER_SIZE + LORATAP_HEADER_SIZE, entry.data, entry.length);
+        written += recordSize;
+        seq++;
+    }
+    return written;
+}
+
+// =======================
+// Serial export
+// =======================
+size_t PacketCapture::formatLine(uint32_t seq, char *out, size_t capacity)
+{
+    Entry entry;
+    if (!copyEntry(seq, entry))
+    {
+        return 0;
+    }
+    int len = snprintf(out, capacity, "CAP;%lu;%s;%llu;%d;%.2f;%lu;",
+                       (unsigned long)seq, entry.direction == CAPTURE_RX ? "RX" : "TX",
+                       (unsigned long long)entry.timestampUs, entry.rssi,
+                       entry.snrQuarterDb / 4.0, (unsigned long)entry.airtimeUs);
+    if (len < 0 || (size_t)len + entry.length * 2 >= capacity)
+    {
+        return 0;
+    }
+    static const char hex[] = "0123456789abcdef";
+    size_t pos = (size_t)len;
+    for (size_t i = 0; i < entry.length; i++)
+    {
+        out[pos++] = hex[entry.data[i] >> 4];
+        out[pos++] = hex[entry.data[i] & 0x0F];
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+void PacketCapture::setStreaming(bool enabled)
+{
+    streamSeq = getNextSeq();
+    streaming = enabled;
+}
+
+void PacketCapture::streamPending()
+{
+    if (!streaming)
+    {
+        return;
+    }
+    const uint32_t end = getNextSeq();
+    const uint32_t oldest = getOldestSeq();
+    if (streamSeq < oldest)
+    {
+        LOG_W(LOG_TOPIC_RADIO, "[CAPTURE] Stream fell behind, skipped %lu frames",
+              (unsigned long)(oldest - streamSeq));
+        streamSeq = oldest;
+    }
+    char line[64 + RX_BUFFER_SIZE * 2];
+    for (int sent = 0; sent < CAPTURE_STREAM_BATCH && streamSeq < end; sent++, streamSeq++)
+    {
+        size_t len = formatLine(streamSeq, line, sizeof(line));
+        if (len > 0)
+        {
+            SerialLink::sendProto(line, len);
+        }
+    }
+}
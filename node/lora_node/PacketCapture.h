@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include "NodeConfig.h"
+
+// =======================
+// Packet capture
+// =======================
+// The last CAPTURE_DEPTH frames the radio received or sent, with a
+// microsecond timestamp, RSSI/SNR and airtime. Only the radio task records,
+// readers copy entries out under a short critical section and skip anything
+// overwritten while they were reading.
+//
+// Exported as classic PCAP with link type LoRaTap (270): a 15 byte LoRaTap v0
+// header (frequency, bandwidth, SF, RSSI, SNR, sync word) before each frame.
+// The radio does not measure its own transmissions, so TX frames carry
+// packet RSSI 0 (-139 dBm), which no received frame gets near.
+enum CaptureDirection
+{
+    CAPTURE_RX,
+    CAPTURE_TX
+};
+
+#define PCAP_HEADER_SIZE 24
+#define PCAP_RECORD_HEADER_SIZE 16
+#define LORATAP_HEADER_SIZE 15
+#define LINKTYPE_LORATAP 270
+
+class PacketCapture
+{
+public:
+    // Allocates the ring; before this, record() is a no-op
+    static void begin();
+    // Radio task only
+    static void record(CaptureDirection direction, const uint8_t *data, size_t length,
+                       float rssi, float snr, uint32_t airtimeUs);
+
+    // Sequence numbers count every recorded frame; entries in
+    // [getOldestSeq(), getNextSeq()) are still in the ring
+    static uint32_t getOldestSeq();
+    static uint32_t getNextSeq();
+    static size_t getDepth() { return depth; }
+
+    static size_t writePcapHeader(uint8_t *out, size_t capacity);
+    // Writes whole PCAP records for seq up to end, starting at seq, as long as
+    // they fit. Advances seq past what was written (and past entries already
+    // overwritten). Returns the byte count.
+    static size_t readPcap(uint32_t &seq, uint32_t end, uint8_t *out, size_t capacity);
+    // "CAP;<seq>;<RX|TX>;<time us>;<rssi>;<snr>;<airtime us>;<hex payload>"
+    // for one entry; 0 if it was already overwritten
+    static size_t formatLine(uint32_t seq, char *out, size_t capacity);
+
+    // Live copy of every new frame to the gateway as CAP lines
+    static void setStreaming(bool enabled);
+    // App loop: sends the lines for frames recorded since the last call
+    static void streamPending();
+
+private:
+    struct Entry;
+    static bool copyEntry(uint32_t seq, Entry &entry);
+
+    static Entry *entries;
+    static size_t depth;
+    static uint32_t nextSeq;
+    static uint32_t streamSeq;
+    static bool streaming;
+};
@@ -0,0 +1,334 @@
+#include "PacketParser.h"
+#include <ctype.h>
+#include <limits.h>
+
+// =======================
+// StrView
+// =======================
+bool StrView::startsWith(const char *prefix) const
+{
+    size_t n = strlen(prefix);
+    return n <= len && memcmp(data, prefix, n) == 0;
+}
+
+bool StrView::equals(const char *text) const
+{
+    size_t n = strlen(text);
+    return n == len && memcmp(data, text, n) == 0;
+}
+
+bool StrView::equals(StrView other) const
+{
+    return other.len == len && memcmp(data, other.data, len) == 0;
+}
+
+int StrView::find(char c, size_t from) const
+{
+    for (size_t i = from; i < len; i++)
+    {
+        if (data[i] == c)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int StrView::find(const char *needle, size_t from) const
+{
+    size_t n = strlen(needle);
+    if (n == 0 || n > len)
+    {
+        return -1;
+    }
+    for (size_t i = from; i + n <= len; i++)
+    {
+        if (data[i] == needle[0] && memcmp(data + i, needle, n) == 0)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+StrView StrView::substr(size_t pos, size_t count) const
+{
+    if (pos >= len)
+    {
+        return StrView(data + len, 0);
+    }
+    size_t available = len - pos;
+    return StrView(data + pos, count < available ? count : available);
+}
+
+StrView StrView::trimmed() const
+{
+    size_t start = 0;
+    size_t end = len;
+    while (start < end && isspace((unsigned char)data[start]))
+    {
+        start++;
+    }
+    while (end > start && isspace((unsigned char)data[end - 1]))
+    {
+        end--;
+    }
+    return StrView(data + start, end - start);
+}
+
+long StrView::toInt() const
+{
+    size_t i = 0;
+    while (i < len && isspace((unsigned char)data[i]))
+    {
+        i++;
+    }
+    bool negative = false;
+    if (i < len && (data[i] == '-' || data[i] == '+'))
+    {
+        negative = data[i] == '-';
+        i++;
+    }
+    // Saturates like newlib's atol() instead of overflowing
+    const unsigned long limit = negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+    unsigned long value = 0;
+    while (i < len && data[i] >= '0' && data[i] <= '9')
+    {
+        const unsigned digit = (unsigned)(data[i] - '0');
+        value = (value > (limit - digit) / 10) ? limit : value * 10 + digit;
+        i++;
+    }
+    if (negative)
+    {
+        return value > (unsigned long)LONG_MAX ? LONG_MIN : -(long)value;
+    }
+    return (long)value;
+}
+
+// =======================
+// FieldTokenizer
+// =======================
+bool FieldTokenizer::next(StrView &field)
+{
+    if (done)
+    {
+        return false;
+    }
+    int pos = remaining.find(sep);
+    if (pos < 0)
+    {
+        field = remaining;
+        done = true;
+        return true;
+    }
+    field = StrView(remaining.data, (size_t)pos);
+    remaining = remaining.substr((size_t)pos + 1);
+    return true;
+}
+
+// =======================
+// MessageFields
+// =======================
+static StrView trimBlanks(StrView view)
+{
+    while (view.len > 0 && (view.data[0] == ' ' || view.data[0] == '\t'))
+    {
+        view = view.substr(1);
+    }
+    while (view.len > 0 && (view.data[view.len - 1] == ' ' || view.data[view.len - 1] == '\t'))
+    {
+        view.len--;
+    }
+    return view;
+}
+
+void MessageFields::parse(StrView parameters)
+{
+    count = 0;
+    FieldTokenizer items(parameters, ',');
+    StrView item;
+    while (count < MAX_MESSAGE_FIELDS && items.next(item))
+    {
+        int colon = item.find(':');
+        if (colon < 0)
+        {
+            continue;
+        }
+        keys[count] = trimBlanks(item.substr(0, (size_t)colon));
+        values[count] = trimBlanks(item.substr((size_t)colon + 1));
+        count++;
+    }
+}
+
+int MessageFields::findIndex(const char *key) const
+{
+    for (int i = (int)count - 1; i >= 0; i--)
+    {
+        if (keys[i].equals(key))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+StrView MessageFields::get(const char *key) const
+{
+    int i = findIndex(key);
+    return i >= 0 ? values[i] : StrView();
+}
+
+// =======================
+// Packet classification
+// =======================
+struct PacketPrefix
+{
+    const char *prefix;
+    size_t length;
+    PacketType type;
+};
+
+#define PACKET_PREFIX(text, type) { text, sizeof(text) - 1, type }
+
+// Longer prefixes must come before the shorter ones they extend
+static const PacketPrefix prefixTable[] = {
+    PACKET_PREFIX("REQ;STATS;", PKT_REQ_STATS),
+    PACKET_PREFIX("REQ;METRICS;", PKT_REQ_METRICS),
+    PACKET_PREFIX("RESP;METRICS;", PKT_RESP_METRICS),
+    PACKET_PREFIX("RESP;USERS;PART;", PKT_RESP_USERS_PART),
+    PACKET_PREFIX("RESP;USERS;", PKT_RESP_USERS),
+    PACKET_PREFIX("RESP;PAGES;PART;", PKT_RESP_PAGES_PART),
+    PACKET_PREFIX("RESP;PAGES;", PKT_RESP_PAGES),
+    PACKET_PREFIX("RESP;PAGE;", PKT_RESP_PAGE),
+    PACKET_PREFIX("PING;", PKT_PING),
+    PACKET_PREFIX("PONG;", PKT_PONG),
+    PACKET_PREFIX("ACK;", PKT_ACK),
+    PACKET_PREFIX("BCAST;", PKT_BCAST),
+    PACKET_PREFIX("BEACON;", PKT_BEACON),
+    PACKET_PREFIX("MSG;", PKT_MSG),
+};
+static const size_t PREFIX_COUNT = sizeof(prefixTable) / sizeof(prefixTable[0]);
+
+static PacketType matchPrefix(const char *data, size_t len)
+{
+    for (size_t i = 0; i < PREFIX_COUNT; i++)
+    {
+        const PacketPrefix &entry = prefixTable[i];
+        if (entry.length <= len && memcmp(data, entry.prefix, entry.length) == 0)
+        {
+            return entry.type;
+        }
+    }
+    return PKT_UNKNOWN;
+}
+
+static bool isSyncFrame(PacketType type)
+{
+    return type == PKT_RESP_USERS_PART || type == PKT_RESP_USERS ||
+           type == PKT_RESP_PAGES_PART || type == PKT_RESP_PAGES;
+}
+
+PacketType PacketParser::classify(StrView packet, StrView &frame)
+{
+    static const char TX_ECHO[] = "LORA_TX;";
+    if (packet.startsWith(TX_ECHO))
+    {
+        packet = packet.substr(sizeof(TX_ECHO) - 1);
+    }
+
+    frame = packet;
+    PacketType type = matchPrefix(packet.data, packet.len);
+    if (type != PKT_UNKNOWN)
+    {
+        return type;
+    }
+
+    // Sync responses relayed over serial can have log noise in front of them
+    for (size_t i = 1; i < packet.len; i++)
+    {
+        if (packet.data[i] != 'R')
+        {
+            continue;
+        }
+        type = matchPrefix(packet.data + i, packet.len - i);
+        if (isSyncFrame(type))
+        {
+            frame = packet.substr(i);
+            return type;
+        }
+    }
+    return PKT_UNKNOWN;
+}
+
+const char *PacketParser::prefixOf(PacketType type)
+{
+    for (size_t i = 0; i < PREFIX_COUNT; i++)
+    {
+        if (prefixTable[i].type == type)
+        {
+            return prefixTable[i].prefix;
+        }
+    }
+    return "";
+}
+
+size_t PacketParser::splitFields(StrView input, char sep, StrView *fields, size_t maxFields)
+{
+    if (maxFields == 0)
+    {
+        return 0;
+    }
+    FieldTokenizer tokenizer(input, sep);
+    size_t count = 0;
+    StrView field;
+    while (count + 1 < maxFields && tokenizer.next(field))
+    {
+        fields[count++] = field;
+    }
+    if (count + 1 == maxFields && tokenizer.hasMore())
+    {
+        fields[count++] = tokenizer.rest();
+    }
+    return count;
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+char PacketParser::urlDecodeNext(StrView input, size_t &pos)
+{
+    char c = input.data[pos++];
+    if (c == '+')
+    {
+        return ' ';
+    }
+    if (c == '%' && pos + 1 < input.len)
+    {
+        int hi = hexValue(input.data[pos]);
+        int lo = hexValue(input.data[pos + 1]);
+        pos += 2;
+        return (char)(((hi < 0 ? 0 : hi) << 4) | (lo < 0 ? 0 : lo));
+    }
+    return c;
+}
+
+size_t PacketParser::urlDecode(StrView input, char *out, size_t capacity)
+{
+    if (capacity == 0)
+    {
+        return 0;
+    }
+    size_t written = 0;
+    size_t pos = 0;
+    while (pos < input.len && written + 1 < capacity)
+    {
+        out[written++] = urlDecodeNext(input, pos);
+    }
+    out[written] = '\0';
+    return written;
+}
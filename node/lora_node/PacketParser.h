@@ -0,0 +1,112 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// =======================
+// Zero-copy packet parsing
+// =======================
+// Views point into the caller's RX buffer and are only valid while that
+// buffer is. Nothing in here allocates or depends on Arduino, so the parser
+// can also be built on the host.
+struct StrView
+{
+    const char *data;
+    size_t len;
+
+    StrView() : data(""), len(0) {}
+    StrView(const char *d, size_t l) : data(d), len(l) {}
+
+    bool empty() const { return len == 0; }
+    bool startsWith(const char *prefix) const;
+    bool equals(const char *text) const;
+    bool equals(StrView other) const;
+    // Returns -1 when not found
+    int find(char c, size_t from = 0) const;
+    int find(const char *needle, size_t from = 0) const;
+    StrView substr(size_t pos, size_t count = (size_t)-1) const;
+    StrView trimmed() const;
+    // Same rules as String::toInt(): optional sign, leading digits, 0 otherwise
+    long toInt() const;
+};
+
+// Walks a view one separator-delimited field at a time
+class FieldTokenizer
+{
+public:
+    FieldTokenizer(StrView input, char separator) : remaining(input), sep(separator), done(false) {}
+    // Returns false once all fields have been returned
+    bool next(StrView &field);
+    bool hasMore() const { return !done; }
+    // Everything not yet returned by next()
+    StrView rest() const { return done ? StrView() : remaining; }
+
+private:
+    StrView remaining;
+    char sep;
+    bool done;
+};
+
+// =======================
+// Message parameters
+// =======================
+// Flat, fixed-capacity view over "key:value,key:value" parameter strings.
+// Keys and values are trimmed of spaces and tabs; when a key repeats the
+// last value wins. Entries past MAX_MESSAGE_FIELDS are ignored.
+#define MAX_MESSAGE_FIELDS 16
+
+class MessageFields
+{
+public:
+    MessageFields() : count(0) {}
+    explicit MessageFields(StrView parameters) { parse(parameters); }
+    void parse(StrView parameters);
+    bool has(const char *key) const { return findIndex(key) >= 0; }
+    // Empty view when the key is missing
+    StrView get(const char *key) const;
+    size_t size() const { return count; }
+
+private:
+    int findIndex(const char *key) const;
+    StrView keys[MAX_MESSAGE_FIELDS];
+    StrView values[MAX_MESSAGE_FIELDS];
+    size_t count;
+};
+
+enum PacketType
+{
+    PKT_UNKNOWN = 0,
+    PKT_REQ_STATS,
+    PKT_RESP_USERS_PART,
+    PKT_RESP_USERS,
+    PKT_RESP_PAGES_PART,
+    PKT_RESP_PAGE,
+    PKT_RESP_PAGES,
+    PKT_PING,
+    PKT_PONG,
+    PKT_ACK,
+    PKT_BCAST,
+    PKT_BEACON,
+    PKT_MSG,
+    PKT_REQ_METRICS,
+    PKT_RESP_METRICS,
+    PKT_TYPE_COUNT
+};
+
+class PacketParser
+{
+public:
+    // Strips a "LORA_TX;" echo prefix, skips serial noise in front of a
+    // RESP;USERS / RESP;PAGES frame and classifies the packet by its prefix.
+    // frame receives the packet starting at the matched prefix.
+    static PacketType classify(StrView packet, StrView &frame);
+    static const char *prefixOf(PacketType type);
+    // Splits input into at most maxFields fields; the last one keeps the
+    // remainder including separators. Returns the number of fields.
+    static size_t splitFields(StrView input, char sep, StrView *fields, size_t maxFields);
+    // Decodes %XX and '+' into out (always NUL-terminated). Returns the
+    // decoded length, truncated to capacity - 1.
+    static size_t urlDecode(StrView input, char *out, size_t capacity);
+    // Decodes one character starting at pos (pos < input.len) and advances pos
+    static char urlDecodeNext(StrView input, size_t &pos);
+};
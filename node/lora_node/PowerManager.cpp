@@ -0,0 +1,117 @@
+#include "PowerManager.h"
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include "LoraNode.h"
+#include "Metrics.h"
+#include "NodeLog.h"
+#include "SerialLink.h"
+
+NodeButton *PowerManager::button = NULL;
+uint32_t PowerManager::cpuMhz = 0;
+uint32_t PowerManager::sleepCount = 0;
+unsigned long PowerManager::lastCheckMs = 0;
+unsigned long PowerManager::lastButtonWakeMs = 0;
+
+// =======================
+// Setup
+// =======================
+void PowerManager::begin(NodeButton &nodeButton)
+{
+    button = &nodeButton;
+    cpuMhz = getCpuFrequencyMhz();
+    Metrics::set(GAUGE_CPU_MHZ, cpuMhz);
+#if POWER_SAVE
+    LOG_I(LOG_TOPIC_SYS, "[POWER] Light sleep on while WiFi is off, radio preamble %d", LORA_PREAMBLE_LENGTH);
+#endif
+}
+
+// =======================
+// Loop
+// =======================
+void PowerManager::idle()
+{
+    const unsigned long nowMs = millis();
+    if (nowMs - lastCheckMs >= POWER_CHECK_INTERVAL_MS)
+    {
+        lastCheckMs = nowMs;
+        updateCpuFrequency();
+    }
+    if (canSleep())
+    {
+        lightSleep();
+        return;
+    }
+    vTaskDelay(pdMS_TO_TICKS(POWER_LOOP_IDLE_MS));
+}
+
+void PowerManager::updateCpuFrequency()
+{
+    const uint32_t target = WiFi.softAPgetStationNum() > 0 ? POWER_CPU_ACTIVE_MHZ : POWER_CPU_IDLE_MHZ;
+    if (target == cpuMhz)
+    {
+        return;
+    }
+    if (!setCpuFrequencyMhz(target))
+    {
+        LOG_W(LOG_TOPIC_SYS, "[POWER] Cannot switch CPU to %lu MHz", (unsigned long)target);
+        return;
+    }
+    LOG_I(LOG_TOPIC_SYS, "[POWER] CPU %lu -> %lu MHz", (unsigned long)cpuMhz, (unsigned long)target);
+    cpuMhz = target;
+    Metrics::set(GAUGE_CPU_MHZ, cpuMhz);
+}
+
+// =======================
+// Light sleep
+// =======================
+bool PowerManager::canSleep()
+{
+#if POWER_SAVE
+    const unsigned long nowMs = millis();
+    return WiFi.getMode() == WIFI_OFF && LoraNode::isRadioIdle() &&
+           nowMs - SerialLink::getLastRxMs() > POWER_SERIAL_QUIET_MS &&
+           (lastButtonWakeMs == 0 || nowMs - lastButtonWakeMs > POWER_BUTTON_AWAKE_MS);
+#else
+    return false;
+#endif
+}
+
+void PowerManager::lightSleep()
+{
+    const gpio_num_t dio1 = (gpio_num_t)LORA_DIO1;
+    const gpio_num_t buttonPin = (gpio_num_t)button->getPin();
+
+    // Wake-ups share the pins' interrupt type, and a level interrupt would
+    // fire for as long as DIO1 has a frame or the button is held; keep both
+    // masked while asleep
+    gpio_intr_disable(dio1);
+    gpio_intr_disable(buttonPin);
+    gpio_wakeup_enable(dio1, GPIO_INTR_HIGH_LEVEL);
+    gpio_wakeup_enable(buttonPin, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup((uint64_t)POWER_SLEEP_MAX_MS * 1000);
+    // Whatever is still in the UART FIFO would otherwise wait for the wake-up
+    Serial.flush();
+
+    const unsigned long startMs = millis();
+    esp_light_sleep_start();
+    const unsigned long sleptMs = millis() - startMs;
+
+    gpio_wakeup_disable(dio1);
+    gpio_set_intr_type(dio1, GPIO_INTR_POSEDGE);
+    gpio_intr_enable(dio1);
+    gpio_wakeup_disable(buttonPin);
+    gpio_set_intr_type(buttonPin, GPIO_INTR_ANYEDGE);
+    if (digitalRead(buttonPin) == LOW)
+    {
+        // The press that woke us happened with the interrupt masked
+        lastButtonWakeMs = millis();
+        button->injectEdge(true, lastButtonWakeMs);
+    }
+    gpio_intr_enable(buttonPin);
+    LoraNode::checkRadioIrq();
+
+    sleepCount++;
+    Metrics::inc(CTR_SLEEP_MS, sleptMs);
+}
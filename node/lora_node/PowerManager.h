@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include "NodeConfig.h"
+#include "NodeButton.h"
+
+// =======================
+// Power management
+// =======================
+// Runs at the end of every loop() pass, on the loop task. The CPU clock
+// follows the access point: POWER_CPU_ACTIVE_MHZ while a phone or laptop is
+// connected, POWER_CPU_IDLE_MHZ otherwise.
+//
+// In POWER_SAVE builds the loop also parks the CPU in light sleep when
+// nothing needs it: WiFi is off, the radio is listening with nothing
+// queued, and the gateway UART has been quiet. DIO1 (the SX1262 has a
+// frame), the button or a timer of at most POWER_SLEEP_MAX_MS wakes it.
+// The radio keeps listening on its own meanwhile, so sleeping loses no
+// frames.
+class PowerManager
+{
+public:
+    static void begin(NodeButton &button);
+    // Sleeps or yields until the loop has work again
+    static void idle();
+
+    static uint32_t getCpuMhz() { return cpuMhz; }
+    static uint32_t getSleepCount() { return sleepCount; }
+
+private:
+    static void updateCpuFrequency();
+    static bool canSleep();
+    static void lightSleep();
+
+    static NodeButton *button;
+    static uint32_t cpuMhz;
+    static uint32_t sleepCount;
+    static unsigned long lastCheckMs;
+    static unsigned long lastButtonWakeMs;
+};
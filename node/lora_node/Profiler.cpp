@@ -0,0 +1,158 @@
+#include "Profiler.h"
+
+struct ProfileStats
+{
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t lastMarkUs;   // markPeriod() only
+    uint32_t lastPeriodUs; // markPeriod() only
+    uint32_t buckets[PROFILE_BUCKETS];
+};
+
+static ProfileStats stats[PROF_COUNT];
+// Sections are written by different tasks on both cores and read by the
+// serial command and the web server; the critical sections are a few dozen
+// instructions long
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const sectionNames[PROF_COUNT] = {
+    "loop", "loop_period", "loop_jitter", "serial", "packets", "dns",
+    "display", "battery", "button", "ui_period", "radio_rx", "radio_tx",
+};
+
+// =======================
+// Histogram buckets
+// =======================
+// 0-3 us get a bucket each; above that every power of two is split into
+// four equal buckets: 4,5,6,7 | 8-9,10-11,12-13,14-15 | 16-19,...
+static uint32_t bucketOf(uint32_t us)
+{
+    if (us < 4)
+    {
+        return us;
+    }
+    const uint32_t msb = 31 - __builtin_clz(us);
+    const uint32_t bucket = (msb - 1) * 4 + ((us >> (msb - 2)) & 3);
+    return bucket < PROFILE_BUCKETS ? bucket : PROFILE_BUCKETS - 1;
+}
+
+// Largest value that falls into bucket
+static uint32_t bucketLimit(uint32_t bucket)
+{
+    if (bucket < 4)
+    {
+        return bucket;
+    }
+    const uint32_t msb = bucket / 4 + 1;
+    const uint32_t lower = (4 + bucket % 4) << (msb - 2);
+    return lower + (1u << (msb - 2)) - 1;
+}
+
+// Upper bound of the bucket holding the q-th permille sample, capped at max
+static uint32_t percentile(const ProfileStats &s, uint32_t permille)
+{
+    const uint32_t rank = (uint32_t)(((uint64_t)s.count * permille + 999) / 1000);
+    uint32_t seen = 0;
+    for (uint32_t b = 0; b < PROFILE_BUCKETS; b++)
+    {
+        seen += s.buckets[b];
+        if (seen >= rank)
+        {
+            const uint32_t limit = bucketLimit(b);
+            return limit < s.maxUs ? limit : s.maxUs;
+        }
+    }
+    return s.maxUs;
+}
+
+// =======================
+// Recording
+// =======================
+static void recordLocked(ProfileStats &s, uint32_t us)
+{
+    if (s.count == 0 || us < s.minUs)
+    {
+        s.minUs = us;
+    }
+    if (us > s.maxUs)
+    {
+        s.maxUs = us;
+    }
+    s.count++;
+    s.totalUs += us;
+    s.buckets[bucketOf(us)]++;
+}
+
+void Profiler::record(ProfileSection section, uint32_t us)
+{
+    portENTER_CRITICAL(&statsMux);
+    recordLocked(stats[section], us);
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void Profiler::markPeriod(ProfileSection period, ProfileSection jitter)
+{
+    const uint32_t nowUs = micros();
+    portENTER_CRITICAL(&statsMux);
+    ProfileStats &s = stats[period];
+    if (s.lastMarkUs != 0)
+    {
+        const uint32_t periodUs = nowUs - s.lastMarkUs;
+        recordLocked(s, periodUs);
+        if (jitter != PROF_COUNT && s.lastPeriodUs != 0)
+        {
+            const uint32_t change = periodUs > s.lastPeriodUs ? periodUs - s.lastPeriodUs : s.lastPeriodUs - periodUs;
+            recordLocked(stats[jitter], change);
+        }
+        s.lastPeriodUs = periodUs;
+    }
+    s.lastMarkUs = nowUs;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void Profiler::reset()
+{
+    portENTER_CRITICAL(&statsMux);
+    memset(stats, 0, sizeof(stats));
+    portEXIT_CRITICAL(&statsMux);
+}
+
+// =======================
+// Report
+// =======================
+size_t Profiler::formatHeader(char *out, size_t capacity)
+{
+    int len = snprintf(out, capacity, "[PROFILE] %-11s %8s %8s %8s %8s %8s %8s  (us, cpu %u MHz)",
+                       "section", "count", "min", "avg", "p50", "p99", "max", (unsigned)ESP.getCpuFreqMHz());
+    return len < 0 ? 0 : ((size_t)len < capacity ? (size_t)len : capacity - 1);
+}
+
+size_t Profiler::formatRow(ProfileSection section, char *out, size_t capacity)
+{
+    // Copy out so the histogram walk does not hold the lock
+    ProfileStats s;
+    portENTER_CRITICAL(&statsMux);
+    s = stats[section];
+    portEXIT_CRITICAL(&statsMux);
+
+    const uint32_t avg = s.count ? (uint32_t)(s.totalUs / s.count) : 0;
+    int len = snprintf(out, capacity, "[PROFILE] %-11s %8lu %8lu %8lu %8lu %8lu %8lu",
+                       sectionNames[section], (unsigned long)s.count, (unsigned long)s.minUs,
+                       (unsigned long)avg, (unsigned long)percentile(s, 500),
+                       (unsigned long)percentile(s, 990), (unsigned long)s.maxUs);
+    return len < 0 ? 0 : ((size_t)len < capacity ? (size_t)len : capacity - 1);
+}
+
+void Profiler::writeReport(Print &out)
+{
+    char line[128];
+    formatHeader(line, sizeof(line));
+    out.println(line);
+    for (int section = 0; section < PROF_COUNT; section++)
+    {
+        formatRow((ProfileSection)section, line, sizeof(line));
+        out.println(line);
+    }
+}
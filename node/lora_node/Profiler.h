@@ -0,0 +1,73 @@
+#pragma once
+#include <Arduino.h>
+#include "NodeConfig.h"
+
+// =======================
+// Subsystem profiler
+// =======================
+// Each section collects count, min, max, total and a log-linear histogram of
+// its durations in microseconds. Durations are taken from the CPU cycle
+// counter, which is per core; every section is only recorded from one task,
+// which is pinned, so start and end read the same counter. A scope includes
+// any time the task was preempted, so it is the latency the caller saw.
+enum ProfileSection
+{
+    PROF_LOOP,         // one pass of loop()
+    PROF_LOOP_PERIOD,  // start of one loop() pass to the next
+    PROF_LOOP_JITTER,  // change in loop period from one pass to the next
+    PROF_SERIAL,       // RPI4::loop()
+    PROF_PACKETS,      // LoraNode::loop()
+    PROF_DNS,          // NodeWebServer::webserverLoop()
+    PROF_DISPLAY,      // Node_display_update() in the UI task
+    PROF_BATTERY,      // battery sample burst, polled from loop()
+    PROF_BUTTON,       // NodeButton::update()
+    PROF_UI_PERIOD,    // start of one UI task pass to the next
+    PROF_RADIO_RX,     // reading a packet out of the SX1262
+    PROF_RADIO_TX,     // radio.transmit(), i.e. airtime
+    PROF_COUNT
+};
+
+class Profiler
+{
+public:
+    static void record(ProfileSection section, uint32_t us);
+    // Records the time since the previous mark into period and the change
+    // from the previous period into jitter (PROF_COUNT for none)
+    static void markPeriod(ProfileSection period, ProfileSection jitter);
+    static void reset();
+
+    static uint32_t cyclesToUs(uint32_t cycles) { return cycles / ESP.getCpuFreqMHz(); }
+
+    // One "<section> count min avg p50 p99 max" line (times in us), no newline
+    static size_t formatRow(ProfileSection section, char *out, size_t capacity);
+    static size_t formatHeader(char *out, size_t capacity);
+    static void writeReport(Print &out);
+};
+
+// Times the enclosing scope
+class ProfileScope
+{
+public:
+    explicit ProfileScope(ProfileSection section) : section(section), started(ESP.getCycleCount()) {}
+    ~ProfileScope() { Profiler::record(section, Profiler::cyclesToUs(ESP.getCycleCount() - started)); }
+
+private:
+    ProfileScope(const ProfileScope &);
+    ProfileScope &operator=(const ProfileScope &);
+
+    ProfileSection section;
+    uint32_t started;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if PROFILE_ENABLED
+#define PROFILE_SCOPE(section) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(section)
+#define PROFILE_PERIOD(period, jitter) Profiler::markPeriod(period, jitter)
+#define PROFILE_RECORD(section, us) Profiler::record(section, us)
+#else
+#define PROFILE_SCOPE(section) do { } while (0)
+#define PROFILE_PERIOD(period, jitter) do { } while (0)
+#define PROFILE_RECORD(section, us) do { } while (0)
+#endif
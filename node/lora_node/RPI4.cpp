@@ -1,26 +1,78 @@
 #include <Arduino.h>
 #include "rpi4.h"
 #include "LoraNode.h"
+#include "NodeState.h"
+#include "NodeLog.h"
+#include "SerialLink.h"
+
+static const SerialCommand *commandTable = NULL;
+static size_t commandCount = 0;
 
 void RPI4::setup() {
-    Serial.begin(115200);
+    SerialLink::begin();
     delay(200);
 }
 
-void RPI4::loop() {
-  // Ook USB berichten van de Pi lezen
-  if (Serial.available()) {
-    String msg = Serial.readStringUntil('\n');
-    Serial.print("RPi stuurde: ");
-    Serial.println(msg);
-    if (msg.startsWith("LORA_TX;"))
-    {
-      String packet = msg.substring(String("LORA_TX;").length());
-      LoraNode::transmitRaw(packet);
-    }
-    else
+void RPI4::setCommands(const SerialCommand *commands, size_t count) {
+    commandTable = commands;
+    commandCount = count;
+}
+
+static bool matchesCommand(const char *name, const char *line, size_t length) {
+  return name != NULL && strlen(name) == length && strncasecmp(name, line, length) == 0;
+}
+
+static const SerialCommand *findCommand(const char *line, size_t length) {
+  for (size_t i = 0; i < commandCount; i++)
+  {
+    if (matchesCommand(commandTable[i].name, line, length) || matchesCommand(commandTable[i].alias, line, length))
     {
-      LoraNode::handlePacket(msg);
+      return &commandTable[i];
     }
   }
-}
\ No newline at end of file
+  return NULL;
+}
+
+// One protocol frame (or text line) from the Pi; parsed in place
+static void handleFrame(const char *payload, size_t length) {
+  static const char LORA_TX[] = "LORA_TX;";
+  static const size_t LORA_TX_LEN = sizeof(LORA_TX) - 1;
+
+  while (length > 0 && isspace((unsigned char)payload[0]))
+  {
+    payload++;
+    length--;
+  }
+  while (length > 0 && isspace((unsigned char)payload[length - 1]))
+  {
+    length--;
+  }
+  if (length == 0)
+  {
+    return;
+  }
+
+  LOG_D(LOG_TOPIC_SYS, "RPi stuurde: %.*s", (int)length, payload);
+  if (length >= LORA_TX_LEN && memcmp(payload, LORA_TX, LORA_TX_LEN) == 0)
+  {
+    LoraNode::transmitRaw(payload + LORA_TX_LEN, length - LORA_TX_LEN, TX_ORIGIN_GATEWAY);
+    return;
+  }
+
+  const SerialCommand *command = findCommand(payload, length);
+  if (command != NULL)
+  {
+    NodeStateLock lock;
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Command received: %.*s", (int)length, payload);
+    command->run();
+    return;
+  }
+
+  LOG_D(LOG_TOPIC_SYS, "[SERIAL] Forwarding to LoRa handler: %.*s", (int)length, payload);
+  LoraNode::handlePacket(payload, length);
+}
+
+void RPI4::loop() {
+  // USB berichten van de Pi lezen; never blocks
+  SerialLink::poll(handleFrame);
+}
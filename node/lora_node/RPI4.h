@@ -1,10 +1,20 @@
 #pragma once
 #include <Arduino.h>
 
+// A serial command: the whole line must match name or alias (case-insensitive)
+struct SerialCommand
+{
+  const char *name;
+  const char *alias; // NULL when there is only one spelling
+  void (*run)();
+};
+
 class RPI4
 {
   // Public getters for webserver access
 public:
   static void setup();
   static void loop();
+  // Lines that are neither LORA_TX nor in the table go to LoraNode::handlePacket
+  static void setCommands(const SerialCommand *commands, size_t count);
 };
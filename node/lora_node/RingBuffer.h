@@ -0,0 +1,222 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// =======================
+// Fixed-capacity ring buffers
+// =======================
+// Header-only, no heap, no Arduino dependency (the same header is used by the
+// host tests in node/test). Capacity must be a power of two. Producer and
+// consumer indices live on separate cache lines so the two sides do not
+// invalidate each other's line on every operation.
+//
+//   SpscRing  one producer task, one consumer task; wait-free
+//   MpscRing  any number of producer tasks, one consumer task
+//
+// Neither variant may be pushed to from an ISR that can interrupt a producer
+// of the same ring on the same core.
+#ifndef RING_CACHE_LINE
+#define RING_CACHE_LINE 64
+#endif
+
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(Capacity <= 0x80000000u, "Capacity too large for 32-bit indices");
+
+public:
+    SpscRing() : tail(0), headCache(0), head(0), tailCache(0) {}
+
+    static size_t capacity() { return Capacity; }
+
+    // ---- Producer side ----
+    bool push(const T &item)
+    {
+        T *slot = claim();
+        if (slot == NULL)
+        {
+            return false;
+        }
+        *slot = item;
+        publish();
+        return true;
+    }
+
+    // Returns the next free slot to fill in place, or NULL when full.
+    // Must be followed by publish() before the next claim().
+    T *claim()
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - headCache >= Capacity)
+        {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache >= Capacity)
+            {
+                return NULL;
+            }
+        }
+        return &slots[t & (Capacity - 1)];
+    }
+
+    void publish()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ---- Consumer side ----
+    bool pop(T &item)
+    {
+        const T *slot = front();
+        if (slot == NULL)
+        {
+            return false;
+        }
+        item = *slot;
+        release();
+        return true;
+    }
+
+    // Returns the oldest item without removing it, or NULL when empty.
+    // The slot stays valid until release().
+    const T *front()
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tailCache)
+        {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h == tailCache)
+            {
+                return NULL;
+            }
+        }
+        return &slots[h & (Capacity - 1)];
+    }
+
+    void release()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ---- Either side (approximate while the other side is running) ----
+    size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    // Producer line
+    alignas(RING_CACHE_LINE) std::atomic<uint32_t> tail;
+    uint32_t headCache;
+    // Consumer line
+    alignas(RING_CACHE_LINE) std::atomic<uint32_t> head;
+    uint32_t tailCache;
+
+    alignas(RING_CACHE_LINE) T slots[Capacity];
+};
+
+// Bounded multi-producer queue (per-slot sequence numbers, after Vyukov).
+// Producers claim a slot with one CAS; the consumer never writes a shared
+// index that producers spin on. A producer preempted between claiming and
+// publishing only delays the consumer, it never corrupts the ring.
+template <typename T, size_t Capacity>
+class MpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(Capacity <= 0x40000000u, "Capacity too large for 32-bit sequences");
+
+public:
+    MpscRing() : enqueuePos(0), dequeuePos(0)
+    {
+        for (uint32_t i = 0; i < Capacity; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    static size_t capacity() { return Capacity; }
+
+    // ---- Any producer ----
+    bool push(const T &item)
+    {
+        uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;)
+        {
+            cell = &cells[pos & (Capacity - 1)];
+            uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // ---- Single consumer ----
+    bool pop(T &item)
+    {
+        const T *slot = front();
+        if (slot == NULL)
+        {
+            return false;
+        }
+        item = *slot;
+        release();
+        return true;
+    }
+
+    const T *front()
+    {
+        uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell &cell = cells[pos & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+        {
+            return NULL;
+        }
+        return &cell.value;
+    }
+
+    void release()
+    {
+        uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+        cells[pos & (Capacity - 1)].sequence.store(pos + Capacity, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+    }
+
+    // Approximate while producers are running
+    size_t size() const
+    {
+        return enqueuePos.load(std::memory_order_relaxed) - dequeuePos.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint32_t> sequence;
+        T value;
+    };
+
+    alignas(RING_CACHE_LINE) std::atomic<uint32_t> enqueuePos;
+    alignas(RING_CACHE_LINE) std::atomic<uint32_t> dequeuePos;
+    alignas(RING_CACHE_LINE) Cell cells[Capacity];
+};
@@ -0,0 +1,357 @@
+#include "SerialLink.h"
+#include "RingBuffer.h"
+
+uint8_t SerialLink::txSeq = 0;
+uint8_t SerialLink::lastDeliveredSeq = 0;
+uint32_t SerialLink::crcErrors = 0;
+uint32_t SerialLink::droppedFrames = 0;
+unsigned long SerialLink::lastRxMs = 0;
+
+// SLIP (RFC 1055)
+static const uint8_t SLIP_END = 0xC0;
+static const uint8_t SLIP_ESC = 0xDB;
+static const uint8_t SLIP_ESC_END = 0xDC;
+static const uint8_t SLIP_ESC_ESC = 0xDD;
+
+static const size_t LINK_HEADER_LEN = 3;
+static const size_t LINK_CRC_LEN = 2;
+
+// Serialises UART writes and the log line buffer across tasks
+static SemaphoreHandle_t linkMutex = NULL;
+
+class LinkLock
+{
+public:
+    LinkLock()
+    {
+        if (linkMutex != NULL)
+        {
+            xSemaphoreTakeRecursive(linkMutex, portMAX_DELAY);
+        }
+    }
+    ~LinkLock()
+    {
+        if (linkMutex != NULL)
+        {
+            xSemaphoreGiveRecursive(linkMutex);
+        }
+    }
+};
+
+// Filled by the UART event task, drained by poll() on the app loop
+static SpscRing<uint8_t, SERIAL_LINK_RX_RING> rxBytes;
+static volatile uint32_t rxOverflowBytes = 0;
+
+// Frame (or text line) being reassembled
+static uint8_t rxFrame[SERIAL_LINK_MAX_FRAME > SERIAL_LINE_MAX ? SERIAL_LINK_MAX_FRAME : SERIAL_LINE_MAX];
+static size_t rxLength = 0;
+static bool rxEscaped = false;
+static bool rxOverflow = false;
+
+// Runs in the UART driver's event task whenever bytes arrive
+static void onUartReceive()
+{
+    while (Serial.available() > 0)
+    {
+        uint8_t c = (uint8_t)Serial.read();
+        if (!rxBytes.push(c))
+        {
+            rxOverflowBytes++;
+        }
+    }
+}
+
+uint32_t SerialLink::getRxOverflowBytes()
+{
+    return rxOverflowBytes;
+}
+
+static uint8_t nextSeq(uint8_t seq)
+{
+    return seq == 255 ? 1 : seq + 1;
+}
+
+// =======================
+// CRC-16/CCITT-FALSE
+// =======================
+static uint16_t crc16Update(uint16_t crc, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint16_t SerialLink::crc16(const uint8_t *data, size_t length)
+{
+    return crc16Update(0xFFFF, data, length);
+}
+
+// =======================
+// Setup
+// =======================
+void SerialLink::begin()
+{
+    if (linkMutex == NULL)
+    {
+        linkMutex = xSemaphoreCreateRecursiveMutex();
+    }
+    Serial.setRxBufferSize(SERIAL_LINK_RX_BUFFER);
+    Serial.begin(SERIAL_LINK_BAUD);
+    Serial.onReceive(onUartReceive);
+#if SERIAL_LINK_FRAMED
+    const uint8_t hello = LINK_CTRL_HELLO;
+    writeFrame(LINK_CH_CONTROL, 0, &hello, 1);
+#endif
+}
+
+// =======================
+// TX
+// =======================
+// Escapes into a small staging buffer so the UART sees few large writes
+class SlipWriter
+{
+public:
+    SlipWriter() : used(0) {}
+    void raw(uint8_t b)
+    {
+        if (used == sizeof(buffer))
+        {
+            flush();
+        }
+        buffer[used++] = b;
+    }
+    void escaped(const uint8_t *data, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            if (data[i] == SLIP_END)
+            {
+                raw(SLIP_ESC);
+                raw(SLIP_ESC_END);
+            }
+            else if (data[i] == SLIP_ESC)
+            {
+                raw(SLIP_ESC);
+                raw(SLIP_ESC_ESC);
+            }
+            else
+            {
+                raw(data[i]);
+            }
+        }
+    }
+    void flush()
+    {
+        Serial.write(buffer, used);
+        used = 0;
+    }
+
+private:
+    uint8_t buffer[64];
+    size_t used;
+};
+
+void SerialLink::writeFrame(uint8_t channel, uint8_t seq, const uint8_t *payload, size_t length)
+{
+    LinkLock lock;
+    uint8_t header[LINK_HEADER_LEN] = {channel, seq, lastDeliveredSeq};
+    uint16_t crc = crc16Update(0xFFFF, header, sizeof(header));
+    crc = crc16Update(crc, payload, length);
+    uint8_t trailer[LINK_CRC_LEN] = {(uint8_t)(crc >> 8), (uint8_t)(crc & 0xFF)};
+
+    SlipWriter out;
+    // A leading END flushes any line noise the gateway has buffered
+    out.raw(SLIP_END);
+    out.escaped(header, sizeof(header));
+    out.escaped(payload, length);
+    out.escaped(trailer, sizeof(trailer));
+    out.raw(SLIP_END);
+    out.flush();
+}
+
+void SerialLink::sendSequenced(uint8_t channel, const char *payload, size_t length)
+{
+    const size_t maxPayload = SERIAL_LINK_MAX_FRAME - LINK_HEADER_LEN - LINK_CRC_LEN;
+    if (length > maxPayload)
+    {
+        length = maxPayload;
+    }
+    LinkLock lock;
+    txSeq = nextSeq(txSeq);
+    writeFrame(channel, txSeq, (const uint8_t *)payload, length);
+}
+
+void SerialLink::sendProto(const char *payload, size_t length)
+{
+#if SERIAL_LINK_FRAMED
+    sendSequenced(LINK_CH_PROTO, payload, length);
+#else
+    LinkLock lock;
+    Serial.write((const uint8_t *)payload, length);
+    Serial.write('\n');
+#endif
+}
+
+void SerialLink::sendLog(const char *text, size_t length)
+{
+#if SERIAL_LINK_FRAMED
+    sendSequenced(LINK_CH_LOG, text, length);
+#else
+    LinkLock lock;
+    Serial.write((const uint8_t *)text, length);
+    Serial.write('\n');
+#endif
+}
+
+// =======================
+// RX
+// =======================
+void SerialLink::sendAck()
+{
+    const uint8_t ack[2] = {LINK_CTRL_ACK, SERIAL_LINK_WINDOW};
+    writeFrame(LINK_CH_CONTROL, 0, ack, sizeof(ack));
+}
+
+void SerialLink::handleFrame(const uint8_t *frame, size_t length, LinkFrameHandler handler)
+{
+    if (length < LINK_HEADER_LEN + LINK_CRC_LEN)
+    {
+        crcErrors++;
+        return;
+    }
+    const size_t bodyLength = length - LINK_CRC_LEN;
+    const uint16_t expected = ((uint16_t)frame[bodyLength] << 8) | frame[bodyLength + 1];
+    if (crc16(frame, bodyLength) != expected)
+    {
+        crcErrors++;
+        return;
+    }
+
+    const uint8_t channel = frame[0];
+    const uint8_t seq = frame[1];
+    const char *payload = (const char *)frame + LINK_HEADER_LEN;
+    const size_t payloadLength = bodyLength - LINK_HEADER_LEN;
+
+    if (channel == LINK_CH_CONTROL)
+    {
+        if (payloadLength > 0 && payload[0] == LINK_CTRL_HELLO)
+        {
+            // Gateway restarted; its next frame is seq 1
+            lastDeliveredSeq = 0;
+            sendAck();
+        }
+        return;
+    }
+    if (channel != LINK_CH_PROTO)
+    {
+        return;
+    }
+    if (seq == 0)
+    {
+        handler(payload, payloadLength);
+        return;
+    }
+    if (seq != nextSeq(lastDeliveredSeq))
+    {
+        // Duplicate after a lost ack, or a gap after a lost frame: the ack
+        // tells the gateway where to resume
+        droppedFrames++;
+        sendAck();
+        return;
+    }
+    // Ack only after handling so a slow handler also slows the gateway down
+    handler(payload, payloadLength);
+    lastDeliveredSeq = seq;
+    sendAck();
+}
+
+void SerialLink::feedFramed(uint8_t c, LinkFrameHandler handler)
+{
+    if (c == SLIP_END)
+    {
+        if (rxOverflow)
+        {
+            droppedFrames++;
+        }
+        else if (rxLength > 0)
+        {
+            handleFrame(rxFrame, rxLength, handler);
+        }
+        rxLength = 0;
+        rxEscaped = false;
+        rxOverflow = false;
+        return;
+    }
+    if (c == SLIP_ESC)
+    {
+        rxEscaped = true;
+        return;
+    }
+    if (rxEscaped)
+    {
+        c = (c == SLIP_ESC_END) ? SLIP_END : (c == SLIP_ESC_ESC) ? SLIP_ESC : c;
+        rxEscaped = false;
+    }
+    if (rxLength < SERIAL_LINK_MAX_FRAME)
+    {
+        rxFrame[rxLength++] = c;
+    }
+    else
+    {
+        rxOverflow = true;
+    }
+}
+
+void SerialLink::feedText(uint8_t c, LinkFrameHandler handler)
+{
+    if (c == '\n')
+    {
+        if (rxOverflow)
+        {
+            droppedFrames++;
+        }
+        else if (rxLength > 0)
+        {
+            handler((const char *)rxFrame, rxLength);
+        }
+        rxLength = 0;
+        rxOverflow = false;
+        return;
+    }
+    if (c == '\r')
+    {
+        return;
+    }
+    if (rxLength < SERIAL_LINE_MAX)
+    {
+        rxFrame[rxLength++] = c;
+    }
+    else
+    {
+        rxOverflow = true;
+    }
+}
+
+void SerialLink::poll(LinkFrameHandler handler)
+{
+    // Bounded so a flood on the UART cannot starve the rest of the loop
+    uint8_t c;
+    if (!rxBytes.empty())
+    {
+        lastRxMs = millis();
+    }
+    for (int budget = SERIAL_LINK_RX_RING; budget > 0 && rxBytes.pop(c); budget--)
+    {
+#if SERIAL_LINK_FRAMED
+        feedFramed(c, handler);
+#else
+        feedText(c, handler);
+#endif
+    }
+}
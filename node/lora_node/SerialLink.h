@@ -0,0 +1,64 @@
+#pragma once
+#include <Arduino.h>
+#include "NodeConfig.h"
+
+// =======================
+// Framed serial link
+// =======================
+// Frame (before SLIP escaping, delimited by 0xC0):
+//   [channel][seq][ack][payload ...][crc16 hi][crc16 lo]
+// CRC is CRC-16/CCITT-FALSE over everything before it. seq 0 means
+// "unsequenced" (control frames); sequenced frames count 1..255 and wrap.
+// Gateway -> node protocol frames are go-back-N: the node only delivers the
+// next expected seq and acks the last one it delivered, the gateway keeps at
+// most SERIAL_LINK_WINDOW frames unacked and resends on timeout. Node ->
+// gateway frames are numbered so the gateway can count losses, but they are
+// not retransmitted.
+enum LinkChannel
+{
+    LINK_CH_CONTROL = 0,
+    LINK_CH_PROTO = 1,
+    LINK_CH_LOG = 2
+};
+
+// Control frame payloads
+#define LINK_CTRL_HELLO 'H' // sender (re)started, reset sequence state
+#define LINK_CTRL_ACK 'A'   // followed by one byte: free receive window
+
+// Receives one protocol frame or line; payload is not NUL-terminated
+typedef void (*LinkFrameHandler)(const char *payload, size_t length);
+
+class SerialLink
+{
+public:
+    static void begin();
+    // Parses the bytes the UART callback has queued and hands complete
+    // protocol frames (or text lines) to handler. Never blocks.
+    static void poll(LinkFrameHandler handler);
+    // Safe to call from any task
+    static void sendProto(const char *payload, size_t length);
+    static void sendProto(const String &line) { sendProto(line.c_str(), line.length()); }
+    static void sendLog(const char *text, size_t length);
+
+    static uint16_t crc16(const uint8_t *data, size_t length);
+    static uint32_t getCrcErrors() { return crcErrors; }
+    static uint32_t getDroppedFrames() { return droppedFrames; }
+    // Bytes lost because the app loop fell behind the UART
+    static uint32_t getRxOverflowBytes();
+    // millis() when poll() last found bytes from the gateway, 0 if never
+    static unsigned long getLastRxMs() { return lastRxMs; }
+
+private:
+    static void writeFrame(uint8_t channel, uint8_t seq, const uint8_t *payload, size_t length);
+    static void sendSequenced(uint8_t channel, const char *payload, size_t length);
+    static void sendAck();
+    static void handleFrame(const uint8_t *frame, size_t length, LinkFrameHandler handler);
+    static void feedFramed(uint8_t c, LinkFrameHandler handler);
+    static void feedText(uint8_t c, LinkFrameHandler handler);
+
+    static uint8_t txSeq;
+    static uint8_t lastDeliveredSeq;
+    static uint32_t crcErrors;
+    static uint32_t droppedFrames;
+    static unsigned long lastRxMs;
+};
@@ -0,0 +1,258 @@
+#include "TeamDictionary.h"
+#include "NodeLog.h"
+
+TeamEntry TeamDictionary::entries[MAX_TEAMS];
+int16_t TeamDictionary::nameIndex[TEAM_INDEX_SIZE] = {0};
+int16_t TeamDictionary::slugIndex[TEAM_INDEX_SIZE] = {0};
+int TeamDictionary::count = 0;
+
+static const uint32_t FNV_OFFSET = 2166136261u;
+static const uint32_t FNV_PRIME = 16777619u;
+
+static void trimSpan(const char *&text, size_t &length)
+{
+    while (length > 0 && isspace((unsigned char)text[0]))
+    {
+        text++;
+        length--;
+    }
+    while (length > 0 && isspace((unsigned char)text[length - 1]))
+    {
+        length--;
+    }
+}
+
+static uint32_t hashNormalized(const char *text, size_t length)
+{
+    uint32_t h = FNV_OFFSET;
+    for (size_t i = 0; i < length; i++)
+    {
+        h ^= (uint8_t)tolower((unsigned char)text[i]);
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+// Slug lookups are case-insensitive and treat '_' like '-'
+static char slugChar(char c)
+{
+    if (c == '_')
+    {
+        return '-';
+    }
+    return (char)tolower((unsigned char)c);
+}
+
+static uint32_t hashSlug(const char *text, size_t length)
+{
+    uint32_t h = FNV_OFFSET;
+    for (size_t i = 0; i < length; i++)
+    {
+        h ^= (uint8_t)slugChar(text[i]);
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static String makeSlug(const char *text, size_t length)
+{
+    String out;
+    out.reserve(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = text[i];
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+        {
+            out += (char)tolower(c);
+        }
+        else if (c == ' ' || c == '-' || c == '_')
+        {
+            if (out.length() == 0 || out.charAt(out.length() - 1) == '-')
+            {
+                continue;
+            }
+            out += '-';
+        }
+    }
+    return out;
+}
+
+// Index slots hold ID + 1 so the zero-initialised arrays start out empty
+static void insertIndex(int16_t *index, uint32_t hash, int id)
+{
+    uint32_t pos = hash & (TEAM_INDEX_SIZE - 1);
+    while (index[pos] != 0)
+    {
+        pos = (pos + 1) & (TEAM_INDEX_SIZE - 1);
+    }
+    index[pos] = (int16_t)(id + 1);
+}
+
+uint16_t TeamDictionary::find(const char *name, size_t length)
+{
+    trimSpan(name, length);
+    if (length == 0)
+    {
+        return TEAM_NONE;
+    }
+    uint32_t h = hashNormalized(name, length);
+    uint32_t pos = h & (TEAM_INDEX_SIZE - 1);
+    while (nameIndex[pos] != 0)
+    {
+        const TeamEntry &entry = entries[nameIndex[pos] - 1];
+        if (entry.hash == h && entry.normalized.length() == length &&
+            strncasecmp(entry.normalized.c_str(), name, length) == 0)
+        {
+            return (uint16_t)(nameIndex[pos] - 1);
+        }
+        pos = (pos + 1) & (TEAM_INDEX_SIZE - 1);
+    }
+    return TEAM_NONE;
+}
+
+uint16_t TeamDictionary::findBySlug(const String &slug)
+{
+    const char *text = slug.c_str();
+    size_t length = slug.length();
+    trimSpan(text, length);
+    if (length == 0)
+    {
+        return TEAM_NONE;
+    }
+
+    uint32_t h = hashSlug(text, length);
+    uint32_t pos = h & (TEAM_INDEX_SIZE - 1);
+    while (slugIndex[pos] != 0)
+    {
+        const TeamEntry &entry = entries[slugIndex[pos] - 1];
+        if (entry.slugHash == h && entry.slug.length() == length)
+        {
+            size_t i = 0;
+            while (i < length && entry.slug.charAt(i) == slugChar(text[i]))
+            {
+                i++;
+            }
+            if (i == length)
+            {
+                return (uint16_t)(slugIndex[pos] - 1);
+            }
+        }
+        pos = (pos + 1) & (TEAM_INDEX_SIZE - 1);
+    }
+    return find(text, length);
+}
+
+uint16_t TeamDictionary::intern(const char *name, size_t length)
+{
+    trimSpan(name, length);
+    if (length == 0)
+    {
+        return TEAM_NONE;
+    }
+    uint16_t existing = find(name, length);
+    if (existing != TEAM_NONE)
+    {
+        return existing;
+    }
+    // Reuse the first slot freed by collect() before growing
+    int id = 0;
+    while (id < count && entries[id].name.length() > 0)
+    {
+        id++;
+    }
+    if (id >= MAX_TEAMS)
+    {
+        LOG_W(LOG_TOPIC_USER, "[TEAMS] Dictionary full, team not interned");
+        return TEAM_NONE;
+    }
+
+    TeamEntry &entry = entries[id];
+    entry.name.reserve(length);
+    entry.name = "";
+    entry.name.concat(name, length);
+    entry.normalized = entry.name;
+    entry.normalized.toLowerCase();
+    entry.slug = makeSlug(name, length);
+    entry.hash = hashNormalized(name, length);
+    entry.slugHash = hashSlug(entry.slug.c_str(), entry.slug.length());
+
+    insertIndex(nameIndex, entry.hash, id);
+    if (entry.slug.length() > 0)
+    {
+        insertIndex(slugIndex, entry.slugHash, id);
+    }
+    if (id == count)
+    {
+        count++;
+    }
+    LOG_I(LOG_TOPIC_USER, "[TEAMS] Interned team %d: %s (/%s)", id, entry.name.c_str(), entry.slug.c_str());
+    return (uint16_t)id;
+}
+
+int TeamDictionary::collect(const bool referenced[MAX_TEAMS])
+{
+    int freed = 0;
+    for (int id = 0; id < count; id++)
+    {
+        if (!referenced[id] && entries[id].name.length() > 0)
+        {
+            entries[id] = TeamEntry();
+            freed++;
+        }
+    }
+    while (count > 0 && entries[count - 1].name.length() == 0)
+    {
+        count--;
+    }
+
+    // Probe chains may run through freed slots, so both indexes are rebuilt
+    memset(nameIndex, 0, sizeof(nameIndex));
+    memset(slugIndex, 0, sizeof(slugIndex));
+    for (int id = 0; id < count; id++)
+    {
+        const TeamEntry &entry = entries[id];
+        if (entry.name.length() == 0)
+        {
+            continue;
+        }
+        insertIndex(nameIndex, entry.hash, id);
+        if (entry.slug.length() > 0)
+        {
+            insertIndex(slugIndex, entry.slugHash, id);
+        }
+    }
+    LOG_I(LOG_TOPIC_USER, "[TEAMS] Freed %d unreferenced teams, %d IDs in use", freed, count);
+    return freed;
+}
+
+const char *TeamDictionary::name(uint16_t id)
+{
+    if (id >= count)
+    {
+        return "";
+    }
+    return entries[id].name.c_str();
+}
+
+const char *TeamDictionary::slug(uint16_t id)
+{
+    if (id >= count)
+    {
+        return "";
+    }
+    return entries[id].slug.c_str();
+}
+
+uint32_t TeamDictionary::hash(uint16_t id)
+{
+    if (id >= count)
+    {
+        return 0;
+    }
+    return entries[id].hash;
+}
+
+int TeamDictionary::getCount()
+{
+    return count;
+}
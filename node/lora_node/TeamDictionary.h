@@ -0,0 +1,61 @@
+#pragma once
+#include <Arduino.h>
+
+// =======================
+// Interned team names
+// =======================
+// Users and team pages reference teams by a small integer ID. Names are
+// interned once (at sync/load time) together with their normalized form,
+// URL slug and hashes, so request handlers resolve a team in O(1) without
+// building temporary strings. IDs stay valid while something references
+// them; collect() frees the unreferenced ones and intern() reuses them.
+//
+// MAX_TEAMS bounds the distinct teams of the whole user table: 256 is one
+// team per 20 users at the full 5000. During a sync the old and the new
+// table's teams must fit together. Users whose team does not fit get
+// TEAM_NONE, which the sync reports as an error.
+#ifndef MAX_TEAMS
+#define MAX_TEAMS 256
+#endif
+#define TEAM_NONE 0xFFFF
+// Open-addressing index size, power of two and at least 2x MAX_TEAMS
+#define TEAM_INDEX_SIZE (2 * MAX_TEAMS)
+
+static_assert((TEAM_INDEX_SIZE & (TEAM_INDEX_SIZE - 1)) == 0, "MAX_TEAMS must be a power of two");
+// Index slots hold ID + 1 in an int16_t, and TEAM_NONE must stay out of range
+static_assert(MAX_TEAMS < 0x7FFF, "MAX_TEAMS too large for the team index");
+
+struct TeamEntry
+{
+    String name;        // as first seen, trimmed
+    String normalized;  // trimmed, lower case
+    String slug;        // URL path segment, e.g. "red-team"
+    uint32_t hash;      // FNV-1a of normalized
+    uint32_t slugHash;  // FNV-1a of slug
+};
+
+class TeamDictionary
+{
+public:
+    // Returns the ID for a team (trimmed, case-insensitive match), adding it if new
+    static uint16_t intern(const char *name, size_t length);
+    static uint16_t intern(const String &name) { return intern(name.c_str(), name.length()); }
+    // Lookups only; return TEAM_NONE when the team is unknown
+    static uint16_t find(const char *name, size_t length);
+    static uint16_t find(const String &name) { return find(name.c_str(), name.length()); }
+    // Accepts a slug ('_' and '-' are equivalent, case-insensitive) or a plain team name
+    static uint16_t findBySlug(const String &slug);
+    static const char *name(uint16_t id);
+    static const char *slug(uint16_t id);
+    static uint32_t hash(uint16_t id);
+    // Upper bound for IDs; freed IDs below it have an empty name
+    static int getCount();
+    // Frees every team not marked in referenced[] and returns how many went
+    static int collect(const bool referenced[MAX_TEAMS]);
+
+private:
+    static TeamEntry entries[MAX_TEAMS];
+    static int16_t nameIndex[TEAM_INDEX_SIZE];
+    static int16_t slugIndex[TEAM_INDEX_SIZE];
+    static int count;
+};
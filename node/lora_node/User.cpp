@@ -1,58 +1,664 @@
 #include "User.h"
 #include "LoraNode.h"
+#include "NodeLog.h"
+#include "NodeWebServer.h"
 #include "Preferences.h"
 #include <HTTPClient.h>
 #include <mbedtls/sha256.h>
+#include <esp_heap_caps.h>
 
-NodeUser User::users[MAX_USERS];
 int User::userCount = 0;
 Preferences User::prefs;
 bool User::runtimeCacheOnly = false;
+const NodeUser User::emptyUser = {0, 0, 0, 0, TEAM_NONE, {0}};
+
+// =======================
+// Compact user table
+// =======================
+// Two tables are kept so a sync can build the new user set next to the live
+// one (preserving tokens) and then swap. Offset 0 of every arena is "".
+struct UserTable
+{
+    NodeUser *records;
+    char *arena;
+    uint32_t arenaSize;
+    uint32_t arenaUsed;
+    int count;
+};
+
+static UserTable userTables[2];
+static int activeTable = 0;
+static int userCapacity = 0;
+static int16_t *tokenIndex = nullptr;
+static int16_t *nameIndex = nullptr;
+static uint32_t indexMask = 0;
+
+static void *allocUserMemory(size_t bytes)
+{
+    void *ptr = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ptr == nullptr)
+    {
+        ptr = heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+    }
+    return ptr;
+}
+
+static void resetTable(UserTable &table)
+{
+    table.count = 0;
+    table.arenaUsed = 1;
+    if (table.arena != nullptr)
+    {
+        table.arena[0] = '\0';
+    }
+}
+
+static void freeUserTables()
+{
+    for (int t = 0; t < 2; t++)
+    {
+        heap_caps_free(userTables[t].records);
+        heap_caps_free(userTables[t].arena);
+        userTables[t].records = nullptr;
+        userTables[t].arena = nullptr;
+    }
+    heap_caps_free(tokenIndex);
+    heap_caps_free(nameIndex);
+    tokenIndex = nullptr;
+    nameIndex = nullptr;
+}
+
+static bool ensureUserTables()
+{
+    if (userCapacity > 0)
+    {
+        return true;
+    }
+
+    // Without PSRAM the table would compete with WiFi for internal heap
+    int capacity = psramFound() ? MAX_USERS : MAX_USERS_INTERNAL;
+    for (; capacity >= 16; capacity /= 2)
+    {
+        uint32_t indexSize = 1;
+        while (indexSize < (uint32_t)capacity * 2)
+        {
+            indexSize <<= 1;
+        }
+        uint32_t arenaSize = (uint32_t)capacity * USER_ARENA_BYTES_PER_USER;
+
+        bool ok = true;
+        for (int t = 0; t < 2; t++)
+        {
+            userTables[t].records = (NodeUser *)allocUserMemory(sizeof(NodeUser) * capacity);
+            userTables[t].arena = (char *)allocUserMemory(arenaSize);
+            userTables[t].arenaSize = arenaSize;
+            ok = ok && userTables[t].records != nullptr && userTables[t].arena != nullptr;
+        }
+        tokenIndex = (int16_t *)allocUserMemory(sizeof(int16_t) * indexSize);
+        nameIndex = (int16_t *)allocUserMemory(sizeof(int16_t) * indexSize);
+        ok = ok && tokenIndex != nullptr && nameIndex != nullptr;
+
+        if (ok)
+        {
+            userCapacity = capacity;
+            indexMask = indexSize - 1;
+            resetTable(userTables[0]);
+            resetTable(userTables[1]);
+            for (uint32_t i = 0; i < indexSize; i++)
+            {
+                tokenIndex[i] = -1;
+                nameIndex[i] = -1;
+            }
+            LOG_I(LOG_TOPIC_USER, "[USER] User table ready: capacity=%d (%s)", capacity, psramFound() ? "PSRAM" : "internal RAM");
+            return true;
+        }
+        freeUserTables();
+    }
+
+    LOG_E(LOG_TOPIC_USER, "[USER] ✗ Could not allocate user table");
+    return false;
+}
+
+static bool arenaAppend(UserTable &table, const char *text, size_t length, uint32_t &offset, uint8_t &storedLength)
+{
+    if (length > 255 || table.arenaUsed + length + 1 > table.arenaSize)
+    {
+        return false;
+    }
+    offset = table.arenaUsed;
+    memcpy(table.arena + offset, text, length);
+    table.arena[offset + length] = '\0';
+    table.arenaUsed += length + 1;
+    storedLength = (uint8_t)length;
+    return true;
+}
+
+static NodeUser *appendUser(UserTable &table, const char *name, size_t nameLength,
+                            const char *token, size_t tokenLength,
+                            uint16_t teamId, const uint8_t digest[USER_HASH_LEN])
+{
+    if (table.count >= userCapacity)
+    {
+        return nullptr;
+    }
+    NodeUser &record = table.records[table.count];
+    uint32_t arenaMark = table.arenaUsed;
+    if (!arenaAppend(table, name, nameLength, record.nameOffset, record.nameLength) ||
+        !arenaAppend(table, token, tokenLength, record.tokenOffset, record.tokenLength))
+    {
+        table.arenaUsed = arenaMark;
+        return nullptr;
+    }
+    record.teamId = teamId;
+    memcpy(record.passwordHash, digest, USER_HASH_LEN);
+    table.count++;
+    return &record;
+}
+
+const char *NodeUser::username() const { return User::arenaString(nameOffset); }
+const char *NodeUser::token() const { return User::arenaString(tokenOffset); }
+const char *NodeUser::team() const { return TeamDictionary::name(teamId); }
+
+const char *User::arenaString(uint32_t offset)
+{
+    const UserTable &table = userTables[activeTable];
+    if (table.arena == nullptr || offset >= table.arenaUsed)
+    {
+        return "";
+    }
+    return table.arena + offset;
+}
+
+// =======================
+// Token / username index
+// =======================
+// FNV-1a; usernames are case-folded so login stays case-insensitive
+static uint32_t hashKey(const char *key, size_t length, bool foldCase)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = key[i];
+        if (foldCase)
+        {
+            c = (char)tolower((unsigned char)c);
+        }
+        h ^= (uint8_t)c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void insertSlot(int16_t *index, uint32_t hash, int16_t slot)
+{
+    uint32_t pos = hash & indexMask;
+    while (index[pos] >= 0)
+    {
+        pos = (pos + 1) & indexMask;
+    }
+    index[pos] = slot;
+}
+
+static void indexRecord(const UserTable &table, int slot)
+{
+    const NodeUser &record = table.records[slot];
+    if (record.tokenLength > 0)
+    {
+        insertSlot(tokenIndex, hashKey(table.arena + record.tokenOffset, record.tokenLength, false), slot);
+    }
+    if (record.nameLength > 0)
+    {
+        insertSlot(nameIndex, hashKey(table.arena + record.nameOffset, record.nameLength, true), slot);
+    }
+}
+
+static int findSlot(const UserTable &table, const int16_t *index, const char *key, size_t length, bool byName)
+{
+    if (length == 0 || index == nullptr)
+    {
+        return -1;
+    }
+    uint32_t pos = hashKey(key, length, byName) & indexMask;
+    while (index[pos] >= 0)
+    {
+        const NodeUser &candidate = table.records[index[pos]];
+        if (byName)
+        {
+            if (candidate.nameLength == length && strncasecmp(table.arena + candidate.nameOffset, key, length) == 0)
+            {
+                return index[pos];
+            }
+        }
+        else if (candidate.tokenLength == length && memcmp(table.arena + candidate.tokenOffset, key, length) == 0)
+        {
+            return index[pos];
+        }
+        pos = (pos + 1) & indexMask;
+    }
+    return -1;
+}
+
+void User::rebuildIndex()
+{
+    if (tokenIndex == nullptr)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i <= indexMask; i++)
+    {
+        tokenIndex[i] = -1;
+        nameIndex[i] = -1;
+    }
+    const UserTable &table = userTables[activeTable];
+    for (int i = 0; i < table.count; i++)
+    {
+        indexRecord(table, i);
+    }
+    User::userCount = table.count;
+}
+
+const NodeUser &User::getUserBySession(const String &token)
+{
+    const UserTable &table = userTables[activeTable];
+    int slot = findSlot(table, tokenIndex, token.c_str(), token.length(), false);
+    return slot >= 0 ? table.records[slot] : emptyUser;
+}
+
+const NodeUser &User::getUserByName(const String &name)
+{
+    const UserTable &table = userTables[activeTable];
+    int slot = findSlot(table, nameIndex, name.c_str(), name.length(), true);
+    return slot >= 0 ? table.records[slot] : emptyUser;
+}
+
+// =======================
+// Team references
+// =======================
+// The dictionary holds MAX_TEAMS names for the whole table (see
+// TeamDictionary.h). Teams no user or team page points at any more are freed
+// once it fills up. A sync replacing every team can need room for the old and
+// the new ones at once; it then builds again after the swap. A table with more
+// than MAX_TEAMS teams never fits: those users get no team and the sync logs it.
+static int droppedTeams = 0;
+
+static void markUserTeams(const UserTable &table, bool referenced[MAX_TEAMS])
+{
+    for (int i = 0; i < table.count; i++)
+    {
+        if (table.records[i].teamId < MAX_TEAMS)
+        {
+            referenced[table.records[i].teamId] = true;
+        }
+    }
+}
+
+// building is the table a sync is filling next to the active one, if any
+static void collectTeams(const UserTable *building)
+{
+    bool referenced[MAX_TEAMS] = {false};
+    markUserTeams(userTables[activeTable], referenced);
+    if (building != nullptr)
+    {
+        markUserTeams(*building, referenced);
+    }
+    for (int i = 0; i < NodeWebServer::getMaxTeamPages(); i++)
+    {
+        uint16_t teamId = NodeWebServer::getTeamIdAt(i);
+        if (teamId < MAX_TEAMS)
+        {
+            referenced[teamId] = true;
+        }
+    }
+    TeamDictionary::collect(referenced);
+}
+
+static bool isBlank(const char *text, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if (!isspace((unsigned char)text[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint16_t internTeam(const char *team, size_t length, const UserTable *building)
+{
+    uint16_t teamId = TeamDictionary::intern(team, length);
+    if (teamId != TEAM_NONE || isBlank(team, length))
+    {
+        return teamId;
+    }
+    collectTeams(building);
+    teamId = TeamDictionary::intern(team, length);
+    if (teamId == TEAM_NONE)
+    {
+        droppedTeams++;
+    }
+    return teamId;
+}
+
+uint16_t User::internTeam(const String &team)
+{
+    return ::internTeam(team.c_str(), team.length(), nullptr);
+}
+
+// =======================
+// Password hashes
+// =======================
+static int hexNibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool User::parseHashHex(const char *hex, size_t length, uint8_t digest[USER_HASH_LEN])
+{
+    if (length != USER_HASH_LEN * 2)
+    {
+        return false;
+    }
+    for (int i = 0; i < USER_HASH_LEN; i++)
+    {
+        int hi = hexNibble(hex[i * 2]);
+        int lo = hexNibble(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0)
+        {
+            return false;
+        }
+        digest[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return true;
+}
+
+// Stored hashes are SHA-256 hex digests. Anything else (a missing or "null"
+// hash from the backend, an empty field) is rejected rather than taken as a
+// password, which would let that text log in.
+static bool digestFromField(const char *name, size_t nameLength, const char *value, size_t length,
+                            uint8_t digest[USER_HASH_LEN])
+{
+    if (User::parseHashHex(value, length, digest))
+    {
+        return true;
+    }
+    LOG_W(LOG_TOPIC_USER, "[User] ✗ '%.*s' has no valid password hash, user not added", (int)nameLength, name);
+    return false;
+}
+
+void User::hashPassword(const String &pwd, uint8_t digest[USER_HASH_LEN])
+{
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, (const unsigned char *)pwd.c_str(), pwd.length());
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+}
+
+String User::hashPassword(const String &pwd)
+{
+    unsigned char hash[USER_HASH_LEN];
+    User::hashPassword(pwd, hash);
+
+    char hex[65];
+    for (int i = 0; i < USER_HASH_LEN; i++)
+    {
+        sprintf(hex + (i * 2), "%02x", hash[i]);
+    }
+    hex[64] = '\0';
+
+    String result = String(hex);
+    LOG_V(LOG_TOPIC_AUTH, "[USER] hashPassword -> '%s'", result.c_str());
+    return result;
+}
+
+// =======================
+// NVS persistence
+// =======================
+// Format 2: a "teams" blob (NUL-separated names in ID order, empty for
+// unreferenced IDs) plus one blob per
+// USERS_PER_NVS_BLOB users: teamId(2) hash(32) nameLen(1) name tokenLen(1) token.
+static const uint8_t USERS_NVS_FORMAT = 2;
+
+static void saveTeamsBlob()
+{
+    // Teams no user references are written as empty names, which keeps the
+    // stored IDs in place and loads back as TEAM_NONE
+    bool referenced[MAX_TEAMS] = {false};
+    markUserTeams(userTables[activeTable], referenced);
+    size_t length = 0;
+    int teams = 0;
+    for (int i = 0; i < TeamDictionary::getCount(); i++)
+    {
+        if (referenced[i])
+        {
+            length += strlen(TeamDictionary::name(i));
+            teams = i + 1;
+        }
+    }
+    if (teams == 0)
+    {
+        User::prefs.remove("teams");
+        return;
+    }
+    length += teams;
+    char *buffer = (char *)malloc(length);
+    if (buffer == nullptr)
+    {
+        return;
+    }
+    size_t pos = 0;
+    for (int i = 0; i < teams; i++)
+    {
+        const char *name = referenced[i] ? TeamDictionary::name(i) : "";
+        size_t nameLength = strlen(name) + 1;
+        memcpy(buffer + pos, name, nameLength);
+        pos += nameLength;
+    }
+    User::prefs.putBytes("teams", buffer, length);
+    free(buffer);
+}
+
+static bool saveUserChunk(int chunk)
+{
+    const UserTable &table = userTables[activeTable];
+    int first = chunk * USERS_PER_NVS_BLOB;
+    int last = min(first + USERS_PER_NVS_BLOB, table.count);
+    size_t length = 0;
+    for (int i = first; i < last; i++)
+    {
+        length += 2 + USER_HASH_LEN + 1 + table.records[i].nameLength + 1 + table.records[i].tokenLength;
+    }
+    uint8_t *buffer = (uint8_t *)malloc(length);
+    if (buffer == nullptr)
+    {
+        return false;
+    }
+    size_t pos = 0;
+    for (int i = first; i < last; i++)
+    {
+        const NodeUser &record = table.records[i];
+        buffer[pos++] = (uint8_t)(record.teamId & 0xFF);
+        buffer[pos++] = (uint8_t)(record.teamId >> 8);
+        memcpy(buffer + pos, record.passwordHash, USER_HASH_LEN);
+        pos += USER_HASH_LEN;
+        buffer[pos++] = record.nameLength;
+        memcpy(buffer + pos, table.arena + record.nameOffset, record.nameLength);
+        pos += record.nameLength;
+        buffer[pos++] = record.tokenLength;
+        memcpy(buffer + pos, table.arena + record.tokenOffset, record.tokenLength);
+        pos += record.tokenLength;
+    }
+    bool ok = User::prefs.putBytes(("u" + String(chunk)).c_str(), buffer, length) == length;
+    free(buffer);
+    return ok;
+}
+
+// Persists only the chunk holding one user after an incremental change
+static void saveUserChunkNVS(int slot)
+{
+    if (User::runtimeCacheOnly)
+    {
+        return;
+    }
+    User::prefs.begin("User::users", false);
+    if (User::prefs.getUChar("format", 0) != USERS_NVS_FORMAT)
+    {
+        User::prefs.end();
+        User::saveUsersNVS();
+        return;
+    }
+    saveTeamsBlob();
+    int chunk = slot / USERS_PER_NVS_BLOB;
+    if (saveUserChunk(chunk))
+    {
+        User::prefs.putInt("userCount", User::userCount);
+    }
+    else
+    {
+        LOG_E(LOG_TOPIC_USER, "[User] ✗ NVS full, user chunk %d not persisted", chunk);
+    }
+    User::prefs.end();
+}
 
 void User::saveUsersNVS()
 {
     if (User::runtimeCacheOnly)
     {
-        Serial.println("[User] Runtime cache only - skipping NVS save");
+        LOG_I(LOG_TOPIC_USER, "[User] Runtime cache only - skipping NVS save");
         return;
     }
     prefs.begin("User::users", false);
     prefs.clear();
-    for (int i = 0; i < User::userCount; i++)
+    prefs.putUChar("format", USERS_NVS_FORMAT);
+    saveTeamsBlob();
+
+    // Users beyond what fits in the NVS partition are re-fetched on the next sync
+    int saved = 0;
+    int chunks = (User::userCount + USERS_PER_NVS_BLOB - 1) / USERS_PER_NVS_BLOB;
+    for (int chunk = 0; chunk < chunks; chunk++)
     {
-        Serial.printf("[User] Saving user: %s\n", User::users[i].username.c_str());
-        User::prefs.putString(("user" + String(i) + "_name").c_str(), User::users[i].username);
-        User::prefs.putString(("user" + String(i) + "_token").c_str(), User::users[i].token);
-        User::prefs.putString(("user" + String(i) + "_hash").c_str(), User::users[i].passwordHash);
-        User::prefs.putString(("user" + String(i) + "_team").c_str(), User::users[i].team);
+        if (!saveUserChunk(chunk))
+        {
+            LOG_E(LOG_TOPIC_USER, "[User] ✗ NVS full after %d users", saved);
+            break;
+        }
+        saved = min((chunk + 1) * USERS_PER_NVS_BLOB, User::userCount);
     }
-    User::prefs.putInt("userCount", User::userCount);
+    User::prefs.putInt("userCount", saved);
     User::prefs.end();
+    LOG_I(LOG_TOPIC_USER, "[User] Saved %d users to NVS", saved);
+}
+
+// Pre-format-2 layout: four string keys per user
+static void loadLegacyUsers(UserTable &table, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        String name = User::prefs.getString(("user" + String(i) + "_name").c_str(), "");
+        String token = User::prefs.getString(("user" + String(i) + "_token").c_str(), "");
+        String hash = User::prefs.getString(("user" + String(i) + "_hash").c_str(), "");
+        String team = User::prefs.getString(("user" + String(i) + "_team").c_str(), "");
+        uint8_t digest[USER_HASH_LEN];
+        if (!digestFromField(name.c_str(), name.length(), hash.c_str(), hash.length(), digest))
+        {
+            continue;
+        }
+        appendUser(table, name.c_str(), name.length(), token.c_str(), token.length(), TeamDictionary::intern(team), digest);
+    }
+}
+
+static void loadUserChunks(UserTable &table, int count)
+{
+    // Stored team IDs are remapped through the dictionary, which may already hold teams
+    uint16_t teamMap[MAX_TEAMS];
+    int storedTeams = 0;
+    size_t teamsLength = User::prefs.getBytesLength("teams");
+    if (teamsLength > 0)
+    {
+        char *teams = (char *)malloc(teamsLength);
+        if (teams != nullptr)
+        {
+            User::prefs.getBytes("teams", teams, teamsLength);
+            size_t pos = 0;
+            while (pos < teamsLength && storedTeams < MAX_TEAMS)
+            {
+                size_t nameLength = strnlen(teams + pos, teamsLength - pos);
+                teamMap[storedTeams++] = TeamDictionary::intern(teams + pos, nameLength);
+                pos += nameLength + 1;
+            }
+            free(teams);
+        }
+    }
+
+    int chunks = (count + USERS_PER_NVS_BLOB - 1) / USERS_PER_NVS_BLOB;
+    for (int chunk = 0; chunk < chunks; chunk++)
+    {
+        String key = "u" + String(chunk);
+        size_t length = User::prefs.getBytesLength(key.c_str());
+        uint8_t *buffer = (length > 0) ? (uint8_t *)malloc(length) : nullptr;
+        if (buffer == nullptr)
+        {
+            break;
+        }
+        User::prefs.getBytes(key.c_str(), buffer, length);
+        size_t pos = 0;
+        while (pos + 2 + USER_HASH_LEN + 1 <= length)
+        {
+            uint16_t storedTeam = buffer[pos] | (buffer[pos + 1] << 8);
+            const uint8_t *digest = buffer + pos + 2;
+            pos += 2 + USER_HASH_LEN;
+            uint8_t nameLength = buffer[pos++];
+            if (pos + nameLength + 1 > length)
+            {
+                break;
+            }
+            const char *name = (const char *)buffer + pos;
+            pos += nameLength;
+            uint8_t tokenLength = buffer[pos++];
+            if (pos + tokenLength > length)
+            {
+                break;
+            }
+            const char *token = (const char *)buffer + pos;
+            pos += tokenLength;
+            uint16_t teamId = storedTeam < storedTeams ? teamMap[storedTeam] : TEAM_NONE;
+            appendUser(table, name, nameLength, token, tokenLength, teamId, digest);
+        }
+        free(buffer);
+    }
 }
 
 void User::loadUsersNVS()
 {
-    Serial.println("\n=== [USER] Loading users from NVS ===");
+    LOG_I(LOG_TOPIC_USER, "=== [USER] Loading users from NVS ===");
+    if (!ensureUserTables())
+    {
+        return;
+    }
+    UserTable &table = userTables[activeTable];
+    resetTable(table);
+
     User::prefs.begin("User::users", true);
-    User::userCount = User::prefs.getInt("userCount", 0);
-    Serial.printf("[USER] Found %d stored users\n", User::userCount);
-    
-    for (int i = 0; i < User::userCount; i++)
-    {
-        User::users[i].username = User::prefs.getString(("user" + String(i) + "_name").c_str(), "");
-        User::users[i].token = User::prefs.getString(("user" + String(i) + "_token").c_str(), "");
-        User::users[i].passwordHash = User::prefs.getString(("user" + String(i) + "_hash").c_str(), "");
-        User::users[i].team = User::prefs.getString(("user" + String(i) + "_team").c_str(), "");
-
-        Serial.printf("\n[USER] User[%d] loaded:\n", i);
-        Serial.printf("  - Username: '%s'\n", User::users[i].username.c_str());
-        Serial.printf("  - Team: '%s'\n", User::users[i].team.c_str());
-        Serial.printf("  - Token: '%s' (length=%d)\n", User::users[i].token.c_str(), User::users[i].token.length());
-        Serial.printf("  - PasswordHash: '%s' (length=%d)\n", User::users[i].passwordHash.c_str(), User::users[i].passwordHash.length());
+    int count = User::prefs.getInt("userCount", 0);
+    uint8_t format = User::prefs.getUChar("format", 1);
+    LOG_I(LOG_TOPIC_USER, "[USER] Found %d stored users (format %d)", count, format);
+    if (format < USERS_NVS_FORMAT)
+    {
+        loadLegacyUsers(table, count);
+    }
+    else
+    {
+        loadUserChunks(table, count);
     }
     User::prefs.end();
-    Serial.printf("[USER] Total users loaded: %d\n", User::userCount);
-    Serial.println("=== [USER] NVS load complete ===\n");
+    User::rebuildIndex();
+    LOG_I(LOG_TOPIC_USER, "[USER] Total users loaded: %d", User::userCount);
+    LOG_I(LOG_TOPIC_USER, "=== [USER] NVS load complete ===");
 }
 
 String User::generateToken()
@@ -64,56 +670,68 @@ String User::generateToken()
 
 bool User::registerUserWithToken(const String &name, const String &pwdHash, const String &team, String token)
 {
-    Serial.printf("[User] Adding new user: %s\n", name.c_str());
-    Serial.printf("[User] New token: %s\n", token.c_str());
-    Serial.printf("[User] New password hash: %s\n", pwdHash.c_str());
-    Serial.printf("[User] userCount: %d\n", User::userCount);
+    LOG_I(LOG_TOPIC_USER, "[User] Adding new user: %s", name.c_str());
+    LOG_V(LOG_TOPIC_AUTH, "[User] New token: %s", token.c_str());
+    LOG_V(LOG_TOPIC_AUTH, "[User] New password hash: %s", pwdHash.c_str());
+    LOG_D(LOG_TOPIC_USER, "[User] userCount: %d", User::userCount);
 
-    User::users[User::userCount].username = name;
-    User::users[User::userCount].token = token;
-    User::users[User::userCount].passwordHash = pwdHash;
-    User::users[User::userCount].team = team;
-    User::userCount++;
-    User::saveUsersNVS();
+    if (!ensureUserTables())
+    {
+        return false;
+    }
+    if (User::exists(User::getUserByName(name)))
+    {
+        LOG_I(LOG_TOPIC_USER, "[User] User '%s' already known, not added again", name.c_str());
+        return true;
+    }
+
+    uint8_t digest[USER_HASH_LEN];
+    if (!digestFromField(name.c_str(), name.length(), pwdHash.c_str(), pwdHash.length(), digest))
+    {
+        return false;
+    }
+    UserTable &table = userTables[activeTable];
+    if (appendUser(table, name.c_str(), name.length(), token.c_str(), token.length(),
+                   User::internTeam(team), digest) == nullptr)
+    {
+        LOG_E(LOG_TOPIC_USER, "[User] ✗ User table full");
+        return false;
+    }
+    indexRecord(table, table.count - 1);
+    User::userCount = table.count;
+    saveUserChunkNVS(table.count - 1);
 
+    const String parameters = "name:" + name + ",pwdHash:" + pwdHash + ",token:" + token + ",team:" + team;
     NodeMessage nodeMessage;
-    nodeMessage.msgId = String(millis());
-    nodeMessage.user = name;
-    nodeMessage.TTL = 3;
-    nodeMessage.timestamp = millis();
-    nodeMessage.object = "USER";
-    nodeMessage.function = "ADD";
-    nodeMessage.parameters = "name:" + name + ",pwdHash:" + pwdHash + ",token:" + token + ",team:" + team;
+    nodeMessage.set(millis(), StrView(name.c_str(), name.length()), 3, millis(), MSG_OBJECT_USER,
+                    MSG_FUNCTION_ADD, StrView(parameters.c_str(), parameters.length()));
 
     LoraNode::loraSend(nodeMessage);
     return true;
 }
 bool User::registerUser(const String &name, const String &pwdHash, const String &team)
 {
-    Serial.println("\n=== [USER] registerUser() called ===");
-    Serial.printf("[USER] Name: '%s'\n", name.c_str());
-    Serial.printf("[USER] PwdHash: '%s' (length=%d)\n", pwdHash.c_str(), pwdHash.length());
-    Serial.printf("[USER] Team: '%s'\n", team.c_str());
-    Serial.printf("[USER] Current user count: %d\n", User::userCount);
-    
+    LOG_D(LOG_TOPIC_USER, "=== [USER] registerUser() called ===");
+    LOG_D(LOG_TOPIC_USER, "[USER] Name: '%s'", name.c_str());
+    LOG_V(LOG_TOPIC_AUTH, "[USER] PwdHash: '%s' (length=%d)", pwdHash.c_str(), pwdHash.length());
+    LOG_D(LOG_TOPIC_USER, "[USER] Team: '%s'", team.c_str());
+    LOG_D(LOG_TOPIC_USER, "[USER] Current user count: %d", User::userCount);
+
     // Check if user already exists
-    for (int i = 0; i < User::userCount; i++)
+    if (User::exists(User::getUserByName(name)))
     {
-        if (User::users[i].username == name)
-        {
-            Serial.printf("[USER] ✗ User '%s' already exists!\n", name.c_str());
-            return true;  // User already exists, don't re-register
-        }
+        LOG_W(LOG_TOPIC_USER, "[USER] ✗ User '%s' already exists!", name.c_str());
+        return true;  // User already exists, don't re-register
     }
 
     String token = User::generateToken();
-    if (User::userCount < MAX_USERS)
+    if (User::userCount < User::getUserCapacity())
     {
-        Serial.printf("[USER] ✓ Registering new user...\n");
+        LOG_D(LOG_TOPIC_USER, "[USER] ✓ Registering new user...");
         return User::registerUserWithToken(name, pwdHash, team, token);
     }
-    
-    Serial.printf("[USER] ✗ Max users exceeded! Cannot register.\n");
+
+    LOG_E(LOG_TOPIC_USER, "[USER] ✗ Max users exceeded! Cannot register.");
     return false;
 }
 
@@ -124,33 +742,28 @@ bool User::addOrUpdateUser(const String &name, const String &pwdHash, String &to
         return false;
     }
 
-    for (int i = 0; i < User::userCount; i++)
+    UserTable &table = userTables[activeTable];
+    int i = findSlot(table, tokenIndex, token.c_str(), token.length(), false);
+    if (i < 0)
     {
-        if (User::users[i].token == token)
-        {
-            User::users[i].team = team;
-            if (pwdHash != "")
-            {
-                User::users[i].passwordHash = User::hashPassword(pwdHash);
-            }
-            Serial.printf("[User] Updated user: %s\n", name.c_str());
-
-            NodeMessage nodeMessage;
-            nodeMessage.msgId = String(millis());
-            nodeMessage.user = name;
-            nodeMessage.TTL = 3;
-            nodeMessage.timestamp = millis();
-            nodeMessage.object = "USER";
-            nodeMessage.function = "ADD";
-            nodeMessage.parameters = "name:" + name + ", pwdHash:" + pwdHash + ", token:" + token + ", team:" + team;
-            
-            LoraNode::loraSend(nodeMessage);
-            User::saveUsersNVS();
-            return true;
-        }
+        return false;
     }
 
-    return false;
+    table.records[i].teamId = User::internTeam(team);
+    if (pwdHash != "")
+    {
+        User::hashPassword(pwdHash, table.records[i].passwordHash);
+    }
+    LOG_I(LOG_TOPIC_USER, "[User] Updated user: %s", name.c_str());
+
+    const String parameters = "name:" + name + ", pwdHash:" + pwdHash + ", token:" + token + ", team:" + team;
+    NodeMessage nodeMessage;
+    nodeMessage.set(millis(), StrView(name.c_str(), name.length()), 3, millis(), MSG_OBJECT_USER,
+                    MSG_FUNCTION_ADD, StrView(parameters.c_str(), parameters.length()));
+
+    LoraNode::loraSend(nodeMessage);
+    saveUserChunkNVS(i);
+    return true;
 }
 
 int User::getUserCount()
@@ -158,11 +771,17 @@ int User::getUserCount()
     return User::userCount;
 }
 
+int User::getUserCapacity()
+{
+    ensureUserTables();
+    return userCapacity;
+}
+
 String User::getUserName(int index)
 {
     if (index >= 0 && index < User::userCount)
     {
-        return users[index].username;
+        return userTables[activeTable].records[index].username();
     }
     return "Unknown";
 }
@@ -171,153 +790,95 @@ String User::getUserTeam(int index)
 {
     if (index >= 0 && index < User::userCount)
     {
-        return users[index].team;
+        return userTables[activeTable].records[index].team();
     }
     return "Unknown";
 }
 
 String User::getUserTeamByName(const String &name)
 {
-    for (int i = 0; i < User::userCount; i++)
-    {
-        if (User::users[i].username == name)
-        {
-            return users[i].team;
-        }
-    }
-    return "Unknown";
+    const NodeUser &user = User::getUserByName(name);
+    return User::exists(user) ? String(user.team()) : String("Unknown");
 }
 
 bool User::isValidToken(const String &token)
 {
-    for (int i = 0; i < User::userCount; i++)
-    {
-        if (User::users[i].token == token)
-            return true;
-    }
-    return false;
+    return User::exists(User::getUserBySession(token));
 }
 bool User::isValidLogin(const String &user, const String &pwdHash)
 {
-    Serial.println("\n=== [LOGIN] Starting validation ===");
-    Serial.printf("[LOGIN] Incoming user: '%s'\n", user.c_str());
-    Serial.printf("[LOGIN] Incoming hash: '%s' (length=%d)\n", pwdHash.c_str(), pwdHash.length());
-    Serial.printf("[LOGIN] Stored users count: %d\n", User::userCount);
-
-    for (int i = 0; i < User::userCount; i++)
-    {
-        Serial.printf("\n[LOGIN] Checking user[%d]:\n", i);
-        Serial.printf("  - Username: '%s'\n", users[i].username.c_str());
-        Serial.printf("  - Username match (case-insensitive): %s\n", 
-                      users[i].username.equalsIgnoreCase(user) ? "YES" : "NO");
-        Serial.printf("  - Stored hash: '%s'\n", users[i].passwordHash.c_str());
-        Serial.printf("  - Hash match: %s\n", 
-                      (users[i].passwordHash == pwdHash) ? "YES" : "NO");
-        
-        // Case-insensitive username comparison
-        if (users[i].username.equalsIgnoreCase(user)) {
-            Serial.printf("[LOGIN] Username matched! Comparing hashes...\n");
-            Serial.printf("  - Expected: '%s'\n", users[i].passwordHash.c_str());
-            Serial.printf("  - Got:      '%s'\n", pwdHash.c_str());
-            
-            // DEBUG: Per-character comparison
-            Serial.println("[DEBUG] Per-character hash comparison:");
-            int minLen = min(users[i].passwordHash.length(), pwdHash.length());
-            for (int j = 0; j < minLen; j++) {
-                Serial.printf("  [%d] expected='%c'(%d) got='%c'(%d) %s\n", 
-                    j, 
-                    users[i].passwordHash[j], users[i].passwordHash[j],
-                    pwdHash[j], pwdHash[j],
-                    (users[i].passwordHash[j] == pwdHash[j]) ? "✓" : "✗");
-            }
-            Serial.printf("[DEBUG] Length mismatch: expected=%d, got=%d\n", 
-                users[i].passwordHash.length(), pwdHash.length());
-            
-            if (users[i].passwordHash == pwdHash) {
-                Serial.println("[LOGIN] ✓ PASSWORD MATCH - LOGIN SUCCESSFUL\n");
-                return true;
-            } else {
-                Serial.println("[LOGIN] ✗ PASSWORD MISMATCH - LOGIN FAILED\n");
-            }
+    LOG_D(LOG_TOPIC_AUTH, "=== [LOGIN] Starting validation ===");
+    LOG_D(LOG_TOPIC_AUTH, "[LOGIN] Incoming user: '%s'", user.c_str());
+    LOG_V(LOG_TOPIC_AUTH, "[LOGIN] Incoming hash: '%s' (length=%d)", pwdHash.c_str(), pwdHash.length());
+    LOG_D(LOG_TOPIC_AUTH, "[LOGIN] Stored users count: %d", User::userCount);
+
+    uint8_t digest[USER_HASH_LEN];
+    if (!User::parseHashHex(pwdHash.c_str(), pwdHash.length(), digest))
+    {
+        LOG_W(LOG_TOPIC_AUTH, "[LOGIN] ✗ Malformed password hash - LOGIN FAILED");
+        return false;
+    }
+
+    // Case-insensitive username lookup through the name index
+    const NodeUser &stored = User::getUserByName(user);
+    if (User::exists(stored)) {
+        LOG_D(LOG_TOPIC_AUTH, "[LOGIN] Username matched! Comparing hashes...");
+
+        // Compare every byte so the timing does not reveal where a mismatch is
+        uint8_t diff = 0;
+        for (int i = 0; i < USER_HASH_LEN; i++)
+        {
+            diff |= stored.passwordHash[i] ^ digest[i];
         }
+        if (diff == 0) {
+            LOG_I(LOG_TOPIC_AUTH, "[LOGIN] ✓ PASSWORD MATCH - LOGIN SUCCESSFUL");
+            return true;
+        }
+        LOG_W(LOG_TOPIC_AUTH, "[LOGIN] ✗ PASSWORD MISMATCH - LOGIN FAILED");
+        return false;
     }
-    
-    Serial.println("[LOGIN] ✗ NO USER MATCH FOUND - LOGIN FAILED\n");
+
+    LOG_W(LOG_TOPIC_AUTH, "[LOGIN] ✗ NO USER MATCH FOUND - LOGIN FAILED");
     return false;
 }
 
 String User::createSession(const String &username)
 {
-    for (int i = 0; i < User::userCount; i++)
-    {
-        if (User::users[i].username == username)
-            return User::users[i].token;
-    }
-    return "";
+    return User::getUserByName(username).token();
 }
 
 String User::getNameBySession(const String &token)
 {
-    for (int i = 0; i < User::userCount; i++)
-    {
-        if (User::users[i].token == token)
-            return User::users[i].username;
-    }
-    return "Unknown";
+    const NodeUser &user = User::getUserBySession(token);
+    return User::exists(user) ? String(user.username()) : String("Unknown");
 }
 
 String User::getUserTeamBySession(const String &token)
 {
-    for (int i = 0; i < User::userCount; i++)
-    {
-        if (User::users[i].token == token)
-            return User::users[i].team;
-    }
-    return "Unknown";
-}
-
-String User::hashPassword(const String &pwd)
-{
-    unsigned char hash[32];
-    mbedtls_sha256_context ctx;
-    mbedtls_sha256_init(&ctx);
-    mbedtls_sha256_starts(&ctx, 0);
-    mbedtls_sha256_update(&ctx, (const unsigned char *)pwd.c_str(), pwd.length());
-    mbedtls_sha256_finish(&ctx, hash);
-    mbedtls_sha256_free(&ctx);
-
-    char hex[65];
-    for (int i = 0; i < 32; i++)
-    {
-        sprintf(hex + (i * 2), "%02x", hash[i]);
-    }
-    hex[64] = '\0';
-
-    String result = String(hex);
-    Serial.printf("[USER] hashPassword('%s') -> '%s'\n", pwd.c_str(), result.c_str());
-    return result;
+    const NodeUser &user = User::getUserBySession(token);
+    return User::exists(user) ? String(user.team()) : String("Unknown");
 }
 
 String User::getUsers()
 {
     String userList;
-    for (int i = 0; i < User::userCount; i++)
+    const UserTable &table = userTables[activeTable];
+    for (int i = 0; i < table.count; i++)
     {
-        userList += User::users[i].username + ",";
+        userList += table.records[i].username();
+        userList += ",";
     }
     return userList;
 }
 
 void User::clearUsers()
 {
-    User::userCount = 0;
-    for (int i = 0; i < MAX_USERS; i++)
+    if (ensureUserTables())
     {
-        User::users[i].username = "";
-        User::users[i].passwordHash = "";
-        User::users[i].token = "";
-        User::users[i].team = "";
+        resetTable(userTables[activeTable]);
     }
+    User::userCount = 0;
+    User::rebuildIndex();
 }
 
 void User::setRuntimeCacheOnly(bool enabled)
@@ -325,185 +886,215 @@ void User::setRuntimeCacheOnly(bool enabled)
     User::runtimeCacheOnly = enabled;
 }
 
+// Adds a synced user to the table being built, keeping the token of an
+// existing user with the same name so sessions survive a sync. Returns false
+// only when the table is full; users without a valid hash are left out.
+static bool addSyncedUser(UserTable &next, const char *name, size_t nameLength,
+                          const char *hash, size_t hashLength,
+                          const char *team, size_t teamLength)
+{
+    const UserTable &current = userTables[activeTable];
+    uint8_t digest[USER_HASH_LEN];
+    if (!digestFromField(name, nameLength, hash, hashLength, digest))
+    {
+        return true; // skipped, the table is not full
+    }
+    uint16_t teamId = internTeam(team, teamLength, &next);
+
+    int oldSlot = findSlot(current, nameIndex, name, nameLength, true);
+    if (oldSlot >= 0 && current.records[oldSlot].tokenLength > 0)
+    {
+        const NodeUser &old = current.records[oldSlot];
+        return appendUser(next, name, nameLength, current.arena + old.tokenOffset, old.tokenLength, teamId, digest) != nullptr;
+    }
+    String token = User::generateToken();
+    return appendUser(next, name, nameLength, token.c_str(), token.length(), teamId, digest) != nullptr;
+}
+
+// Swaps the synced table in and frees the teams only the old one used. Returns
+// true when teams were dropped for lack of room while the old table still
+// held its teams: the caller then builds the table once more.
+static bool swapInSyncedTable(int &pass)
+{
+    activeTable = 1 - activeTable;
+    User::rebuildIndex();
+    collectTeams(nullptr);
+    if (droppedTeams > 0 && pass++ == 0)
+    {
+        LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] Team dictionary full for %d users, rebuilding with the freed IDs", droppedTeams);
+        return true;
+    }
+    if (droppedTeams > 0)
+    {
+        LOG_E(LOG_TOPIC_SYNC, "[USER-SYNC] ✗ More than %d teams, %d users without team", MAX_TEAMS, droppedTeams);
+    }
+    return false;
+}
+
 bool User::setUsersFromSyncPayload(const String &payload)
 {
-    Serial.println("[USER-SYNC] Parsing users payload");
+    LOG_I(LOG_TOPIC_SYNC, "[USER-SYNC] Parsing users payload");
     if (payload.length() == 0)
     {
-        Serial.println("[USER-SYNC] Empty payload");
+        LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] Empty payload");
         return false;
     }
-
-    // Preserve existing tokens so sessions survive sync refreshes
-    NodeUser oldUsers[MAX_USERS];
-    int oldCount = User::userCount;
-    for (int i = 0; i < oldCount && i < MAX_USERS; i++)
+    if (!ensureUserTables())
     {
-        oldUsers[i] = User::users[i];
+        return false;
     }
 
-    User::clearUsers();
-
-    int start = 0;
-    while (start < payload.length() && User::userCount < MAX_USERS)
+    const char *data = payload.c_str();
+    size_t length = payload.length();
+    int pass = 0;
+    do
     {
-        int end = payload.indexOf(';', start);
-        if (end == -1) end = payload.length();
-        String entry = payload.substring(start, end);
-        entry.trim();
-        if (entry.length() > 0)
-        {
-            int p1 = entry.indexOf('|');
-            int p2 = entry.indexOf('|', p1 + 1);
+        UserTable &next = userTables[1 - activeTable];
+        resetTable(next);
+        droppedTeams = 0;
 
-            if (p1 > 0 && p2 > p1)
+        // Single pass over "name|hash|team;name|hash|team;..." without temporaries
+        size_t start = 0;
+        int skipped = 0;
+        while (start < length)
+        {
+            size_t end = start;
+            while (end < length && data[end] != ';')
             {
-                String username = entry.substring(0, p1);
-                String pwdHash = entry.substring(p1 + 1, p2);
-                String team = entry.substring(p2 + 1);
+                end++;
+            }
+            size_t s = start;
+            size_t e = end;
+            while (s < e && isspace((unsigned char)data[s])) s++;
+            while (e > s && isspace((unsigned char)data[e - 1])) e--;
 
-                User::users[User::userCount].username = username;
-                User::users[User::userCount].passwordHash = pwdHash;
-                User::users[User::userCount].team = team;
+            if (e > s)
+            {
+                size_t p1 = s;
+                while (p1 < e && data[p1] != '|') p1++;
+                size_t p2 = p1 + 1;
+                while (p2 < e && data[p2] != '|') p2++;
 
-                // Reuse token if user existed before, otherwise generate a new one
-                String preservedToken = "";
-                for (int i = 0; i < oldCount; i++)
+                if (p1 > s && p1 < e && p2 < e)
                 {
-                    if (oldUsers[i].username.equalsIgnoreCase(username) && oldUsers[i].token.length() > 0)
+                    if (!addSyncedUser(next, data + s, p1 - s, data + p1 + 1, p2 - p1 - 1, data + p2 + 1, e - p2 - 1))
                     {
-                        preservedToken = oldUsers[i].token;
+                        LOG_E(LOG_TOPIC_SYNC, "[USER-SYNC] ✗ User table full at %d users", next.count);
                         break;
                     }
                 }
-                User::users[User::userCount].token = preservedToken.length() > 0 ? preservedToken : User::generateToken();
-                Serial.printf("[USER-SYNC] Added user: %s | Team: %s\n", username.c_str(), team.c_str());
-                User::userCount++;
-            }
-            else
-            {
-                Serial.printf("[USER-SYNC] Skipping invalid entry: %s\n", entry.c_str());
+                else
+                {
+                    skipped++;
+                }
             }
-        }
 
-        start = end + 1;
-    }
+            start = end + 1;
+        }
 
-    Serial.printf("[USER-SYNC] Total users loaded: %d\n", User::userCount);
+        if (skipped > 0)
+        {
+            LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] Skipped %d invalid entries", skipped);
+        }
+    } while (swapInSyncedTable(pass));
+    LOG_I(LOG_TOPIC_SYNC, "[USER-SYNC] Total users loaded: %d", User::userCount);
     User::saveUsersNVS();
     return User::userCount > 0;
 }
 
 bool User::syncUsersFromDatabase(const String &apiUrl)
 {
-    Serial.println("\n[USER-SYNC] Starting synchronization from database...");
-    
+    LOG_I(LOG_TOPIC_SYNC, "[USER-SYNC] Starting synchronization from database...");
+
     HTTPClient http;
-    
+
     String fullUrl = apiUrl + "/api/sync/users";
-    Serial.printf("[USER-SYNC] Fetching from: %s\n", fullUrl.c_str());
-    
+    LOG_I(LOG_TOPIC_SYNC, "[USER-SYNC] Fetching from: %s", fullUrl.c_str());
+
     http.begin(fullUrl);
     int httpCode = http.GET();
-    
+
     if (httpCode != HTTP_CODE_OK) {
-        Serial.printf("[USER-SYNC] Failed to fetch users! HTTP Code: %d\n", httpCode);
+        LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] Failed to fetch users! HTTP Code: %d", httpCode);
         http.end();
         return false;
     }
-    
+
     String payload = http.getString();
     http.end();
-    
-    Serial.printf("[USER-SYNC] Received payload (%d bytes):\n", payload.length());
-    Serial.println(payload);
-    
+
+    LOG_I(LOG_TOPIC_SYNC, "[USER-SYNC] Received payload (%d bytes)", payload.length());
+
     // Parse JSON response
     // Format: {"status":"success","user_count":2,"users":[{"username":"test","team":"Red Team","password_hash":"abc123..."},{"username":"sander","team":"Blue Team","password_hash":"def456..."}]}
-    
+
     // Simple JSON parsing (no external library)
     int user_count_pos = payload.indexOf("\"user_count\":");
     if (user_count_pos == -1) {
-        Serial.println("[USER-SYNC] Invalid response format!");
+        LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] Invalid response format!");
         return false;
     }
-    
-    // Preserve existing tokens so sessions survive sync refreshes
-    NodeUser oldUsers[MAX_USERS];
-    int oldCount = User::userCount;
-    for (int i = 0; i < oldCount && i < MAX_USERS; i++)
-    {
-        oldUsers[i] = User::users[i];
-    }
 
-    // Clear existing users
-    User::userCount = 0;
-    
     // Extract users array
     int users_array_start = payload.indexOf("\"users\":[");
     int users_array_end = payload.lastIndexOf("]");
-    
+
     if (users_array_start == -1 || users_array_end == -1) {
-        Serial.println("[USER-SYNC] Could not find users array in response!");
+        LOG_W(LOG_TOPIC_SYNC, "[USER-SYNC] Could not find users array in response!");
         return false;
     }
-    
-    String usersJson = payload.substring(users_array_start + 9, users_array_end);
-    Serial.printf("[USER-SYNC] Users JSON: %s\n", usersJson.c_str());
-    
-    // Parse each user object
-    int userStartPos = 0;
-    while (userStartPos < usersJson.length() && User::userCount < MAX_USERS) {
-        int objectStart = usersJson.indexOf("{", userStartPos);
-        int objectEnd = usersJson.indexOf("}", objectStart);
-        
-        if (objectStart == -1 || objectEnd == -1) break;
-        
-        String userObj = usersJson.substring(objectStart + 1, objectEnd);
-        Serial.printf("[USER-SYNC] Parsing user object: %s\n", userObj.c_str());
-        
-        // Extract username
-        int usernamePos = userObj.indexOf("\"username\":\"");
-        int usernameEnd = userObj.indexOf("\"", usernamePos + 12);
-        String username = userObj.substring(usernamePos + 12, usernameEnd);
-        
-        // Extract team
-        int teamPos = userObj.indexOf("\"team\":\"");
-        int teamEnd = userObj.indexOf("\"", teamPos + 8);
-        String team = userObj.substring(teamPos + 8, teamEnd);
-        
-        // Extract password_hash
-        int hashPos = userObj.indexOf("\"password_hash\":\"");
-        int hashEnd = userObj.indexOf("\"", hashPos + 17);
-        String pwdHash = userObj.substring(hashPos + 17, hashEnd);
-        
-        Serial.printf("[USER-SYNC] User[%d]: %s | Team: %s | Hash: %s\n", 
-                      User::userCount, username.c_str(), team.c_str(), pwdHash.c_str());
-        
-        // Add user
-        User::users[User::userCount].username = username;
-        User::users[User::userCount].team = team;
-        User::users[User::userCount].passwordHash = pwdHash;
-
-        // Reuse token if user existed before, otherwise generate a new one
-        String preservedToken = "";
-        for (int i = 0; i < oldCount; i++)
-        {
-            if (oldUsers[i].username.equalsIgnoreCase(username) && oldUsers[i].token.length() > 0)
+    if (!ensureUserTables())
+    {
+        return false;
+    }
+
+    const char *json = payload.c_str();
+    int pass = 0;
+    do
+    {
+        UserTable &next = userTables[1 - activeTable];
+        resetTable(next);
+        droppedTeams = 0;
+
+        // Parse each user object
+        int userStartPos = users_array_start + 9;
+        while (userStartPos < users_array_end) {
+            int objectStart = payload.indexOf("{", userStartPos);
+            int objectEnd = payload.indexOf("}", objectStart);
+
+            if (objectStart == -1 || objectEnd == -1 || objectEnd > users_array_end) break;
+
+            // Extract username
+            int usernamePos = payload.indexOf("\"username\":\"", objectStart) + 12;
+            int usernameEnd = payload.indexOf("\"", usernamePos);
+
+            // Extract team
+            int teamPos = payload.indexOf("\"team\":\"", objectStart) + 8;
+            int teamEnd = payload.indexOf("\"", teamPos);
+
+            // Extract password_hash
+            int hashPos = payload.indexOf("\"password_hash\":\"", objectStart) + 17;
+            int hashEnd = payload.indexOf("\"", hashPos);
+
+            if (usernamePos >= 12 && usernameEnd > usernamePos && usernameEnd < objectEnd &&
+                teamPos >= 8 && teamEnd >= teamPos && teamEnd < objectEnd &&
+                hashPos >= 17 && hashEnd > hashPos && hashEnd < objectEnd)
             {
-                preservedToken = oldUsers[i].token;
-                break;
+                if (!addSyncedUser(next, json + usernamePos, usernameEnd - usernamePos,
+                                   json + hashPos, hashEnd - hashPos,
+                                   json + teamPos, teamEnd - teamPos))
+                {
+                    LOG_E(LOG_TOPIC_SYNC, "[USER-SYNC] ✗ User table full at %d users", next.count);
+                    break;
+                }
             }
+            userStartPos = objectEnd + 1;
         }
-        User::users[User::userCount].token = preservedToken.length() > 0 ? preservedToken : User::generateToken();
-        
-        User::userCount++;
-        userStartPos = objectEnd + 1;
-    }
-    
+    } while (swapInSyncedTable(pass));
+
     // Save to NVS
     User::saveUsersNVS();
-    
-    Serial.printf("[USER-SYNC] Successfully synced %d users from database!\n", User::userCount);
+
+    LOG_I(LOG_TOPIC_SYNC, "[USER-SYNC] Successfully synced %d users from database!", User::userCount);
     return true;
-}
\ No newline at end of file
+}
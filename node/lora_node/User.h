@@ -2,22 +2,37 @@
 #define USER_H
 #include <Arduino.h>
 #include <Preferences.h>
-#define MAX_USERS 50
+#include "TeamDictionary.h"
 
+// Capacity target; the table is allocated from PSRAM at first use and shrinks
+// automatically if that much memory is not available.
+#define MAX_USERS 5000
+// Capacity used when the board has no PSRAM
+#define MAX_USERS_INTERNAL 200
+// Bytes of username + token text budgeted per user in the string arena
+#define USER_ARENA_BYTES_PER_USER 48
+#define USER_HASH_LEN 32
+// Users per NVS blob when persisting the table
+#define USERS_PER_NVS_BLOB 32
+
+// Compact user record: strings live in the user string arena, the team is an
+// interned ID and the password hash is the raw 32-byte SHA-256 digest.
 struct NodeUser
 {
-    String username;
-    String passwordHash;
-    String token;
-    String team;
+    uint32_t nameOffset;
+    uint32_t tokenOffset;
+    uint8_t nameLength;
+    uint8_t tokenLength;
+    uint16_t teamId;
+    uint8_t passwordHash[USER_HASH_LEN];
+
+    const char *username() const;
+    const char *token() const;
+    const char *team() const;
 };
 
 struct User
 {
-    String username;
-    String token;
-    String passwordHash;
-    // static methods below
     static void loadUsersNVS();
     static bool registerUserWithToken(const String &name, const String &pwdHash, const String &team, String userToken);
     static bool registerUser (const String &name, const String &pwdHash, const String &team);
@@ -28,10 +43,15 @@ struct User
     static String getNameBySession(const String &token);
     static String getUserTeamBySession(const String &token);
     static String hashPassword(const String &pwd);
+    static void hashPassword(const String &pwd, uint8_t digest[USER_HASH_LEN]);
+    static bool parseHashHex(const char *hex, size_t length, uint8_t digest[USER_HASH_LEN]);
     static String getUsers();
     static int getUserCount();
+    static int getUserCapacity();
     static void saveUsersNVS();
     static String generateToken();
+    // Interns a team, freeing teams nothing references when the dictionary is full
+    static uint16_t internTeam(const String &team);
     static String getUserName(int index);
     static String getUserTeam(int index);
     static String getUserTeamByName(const String &name);
@@ -39,11 +59,17 @@ struct User
     static void setRuntimeCacheOnly(bool enabled);
     static bool setUsersFromSyncPayload(const String &payload);
     static bool syncUsersFromDatabase(const String &apiUrl);
+    // O(1) lookups through the token/name index; return emptyUser on miss
+    static const NodeUser &getUserBySession(const String &token);
+    static const NodeUser &getUserByName(const String &name);
+    static bool exists(const NodeUser &user) { return &user != &emptyUser; }
+    static const char *arenaString(uint32_t offset);
+    static void rebuildIndex();
 
 public:
-    static NodeUser users[MAX_USERS];
     static int userCount;
     static bool runtimeCacheOnly;
+    static const NodeUser emptyUser;
 
     static Preferences prefs;
 };
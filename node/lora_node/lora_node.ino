@@ -5,131 +5,276 @@
 #include "User.h"
 #include "NodeWebServer.h"
 #include "node_display.h"
+#include "node_battery.h"
 #include "NodeButton.h"
+#include "NodeConfig.h"
+#include "NodeState.h"
+#include "NodeLog.h"
+#include "Metrics.h"
+#include "Profiler.h"
+#include "PacketCapture.h"
+#include "SerialLink.h"
+#include "PowerManager.h"
+#include "DutyPolicy.h"
 
 // ---------------- CONFIG ----------------
 
-#define MAX_MSGS 50
-#define MAX_ONLINE_NODES 20
-#define NODE_TIMEOUT 60000    // 60s voor offline
+#define BUTTON_PIN 0
+NodeButton button(BUTTON_PIN);
 
-NodeButton button(0); // Vervang 0 door het juiste pinnummer
+// Task layout (see NodeConfig.h):
+//   core 0: radio task (LoraNode), owns the SX1262
+//   core 1: loop() for serial, packet handling and DNS; AsyncTCP for the
+//           web server; uiTask for the OLED and the button
+static void uiTask(void * /*param*/) {
+    for (;;) {
+        PROFILE_PERIOD(PROF_UI_PERIOD, PROF_COUNT);
+        {
+            PROFILE_SCOPE(PROF_DISPLAY);
+            Node_display_update();
+        }
+        {
+            PROFILE_SCOPE(PROF_BUTTON);
+            button.update();
+        }
+
+        ButtonEvent event;
+        while (button.nextEvent(event)) {
+            switch (event) {
+            case BUTTON_EVENT_PRESS:
+                Node_display_wake();
+                break;
+            case BUTTON_EVENT_CLICK:
+                LOG_I(LOG_TOPIC_UI, "Single click detected!");
+                break;
+            case BUTTON_EVENT_DOUBLE_CLICK:
+                LOG_I(LOG_TOPIC_UI, "Double click detected!");
+                break;
+            case BUTTON_EVENT_LONG_PRESS:
+                LOG_I(LOG_TOPIC_UI, "Long press detected!");
+                break;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(UI_TASK_PERIOD_MS));
+    }
+}
+
+// =======================
+// Serial commands
+// =======================
+// Run by RPI4 with the node state lock held
+#if FEATURE_ENABLE_WEBSERVER
+static void cmdRequestUsers() {
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Triggering users sync request");
+    LoraNode::requestUsers();
+}
+
+static void cmdRequestPages() {
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Triggering pages sync request");
+    LoraNode::requestPages();
+}
+
+static void cmdRefresh() {
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Refreshing users/pages");
+    LoraNode::setPagesSynced(false);
+    NodeWebServer::setPagesSynced(false);
+    LoraNode::requestUsers();
+}
+
+static void cmdHardRefresh() {
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Hard refresh: clearing users/pages and reloading");
+    User::clearUsers();
+    User::saveUsersNVS();
+    NodeWebServer::clearPages(true);
+    LoraNode::setUsersSynced(false);
+    NodeWebServer::setUsersSynced(false);
+    LoraNode::setPagesSynced(false);
+    NodeWebServer::setPagesSynced(false);
+    LoraNode::requestUsers();
+}
+#endif
+
+static void cmdStatus() {
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] UsersSynced=%s PagesSynced=%s StoredPages=%d Users=%d CPU=%luMHz Sleeps=%lu Duty=%s",
+                  LoraNode::isUsersSynced() ? "true" : "false",
+                  LoraNode::isPagesSynced() ? "true" : "false",
+                  NodeWebServer::getStoredPagesCount(),
+                  User::getUserCount(),
+                  (unsigned long)PowerManager::getCpuMhz(),
+                  (unsigned long)PowerManager::getSleepCount(),
+                  DutyPolicy::getModeName(DutyPolicy::getMode()));
+}
+
+#if FEATURE_ENABLE_WEBSERVER
+static void cmdListPages() {
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Stored pages:");
+    for (int i = 0; i < 10; i++) {
+        String name = NodeWebServer::getTeamNameAt(i);
+        int len = NodeWebServer::getTeamPageLengthAt(i);
+        String updated = NodeWebServer::getTeamUpdatedAtAt(i);
+        if (name.length() == 0 && len == 0) {
+            continue;
+        }
+        LOG_I(LOG_TOPIC_SYS, "  [%d] team='%s' len=%d updated=%s", i, name.c_str(), len, updated.c_str());
+    }
+}
+
+static void cmdListUsers() {
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Users:");
+    for (int i = 0; i < User::getUserCount(); i++) {
+        LOG_I(LOG_TOPIC_SYS, "  [%d] user='%s' team='%s'", i, User::getUserName(i).c_str(), User::getUserTeam(i).c_str());
+    }
+}
+#endif
+
+static void cmdMetrics() {
+    char response[RX_BUFFER_SIZE];
+    size_t length = Metrics::buildResponse(LoraNode::getNodeName().c_str(), response, sizeof(response));
+    if (length > 0) {
+        SerialLink::sendProto(response, length);
+    }
+}
+
+static void cmdProfile() {
+    char line[128];
+    Profiler::formatHeader(line, sizeof(line));
+    LOG_I(LOG_TOPIC_SYS, "%s", line);
+    for (int section = 0; section < PROF_COUNT; section++) {
+        Profiler::formatRow((ProfileSection)section, line, sizeof(line));
+        LOG_I(LOG_TOPIC_SYS, "%s", line);
+    }
+}
+
+static void cmdProfileReset() {
+    Profiler::reset();
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Profiler reset");
+}
+
+// Whole capture ring as CAP lines, oldest first
+static void cmdCapture() {
+    char line[64 + RX_BUFFER_SIZE * 2];
+    const uint32_t end = PacketCapture::getNextSeq();
+    for (uint32_t seq = PacketCapture::getOldestSeq(); seq < end; seq++) {
+        size_t length = PacketCapture::formatLine(seq, line, sizeof(line));
+        if (length > 0) {
+            SerialLink::sendProto(line, length);
+        }
+    }
+}
+
+static void cmdCaptureOn() {
+    PacketCapture::setStreaming(true);
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Capture streaming on");
+}
+
+static void cmdCaptureOff() {
+    PacketCapture::setStreaming(false);
+    LOG_I(LOG_TOPIC_SYS, "[SERIAL] Capture streaming off");
+}
+
+static const SerialCommand serialCommands[] = {
+#if FEATURE_ENABLE_WEBSERVER
+    {"REQ;USERS", "USERS", cmdRequestUsers},
+    {"REQ;PAGES", "PAGES", cmdRequestPages},
+    {"REFRESH", NULL, cmdRefresh},
+    {"HARDREFRESH", NULL, cmdHardRefresh},
+    {"LISTPAGES", NULL, cmdListPages},
+    {"LISTUSERS", NULL, cmdListUsers},
+#endif
+    {"STATUS", NULL, cmdStatus},
+    {"METRICS", NULL, cmdMetrics},
+    {"PROFILE", NULL, cmdProfile},
+    {"PROFILE;RESET", NULL, cmdProfileReset},
+    {"CAPTURE", NULL, cmdCapture},
+    {"CAPTURE;ON", NULL, cmdCaptureOn},
+    {"CAPTURE;OFF", NULL, cmdCaptureOff},
+};
+
+// Feeds the battery level to the duty policy; cheap enough for every pass
+static void updateDutyPolicy() {
+    const int percent = Node_battery_present() ? Node_battery_percent() : -1;
+    if (DutyPolicy::update(percent)) {
+        const DutyMode mode = DutyPolicy::getMode();
+        LOG_I(LOG_TOPIC_SYS, "[POWER] Duty mode %s at %d%% battery, relaying %d%%",
+                      DutyPolicy::getModeName(mode), percent, DutyPolicy::getRelayPercent());
+        Metrics::set(GAUGE_DUTY_MODE, mode);
+    }
+}
 
 void setup() {
-    Serial.begin(115200);
-    delay(1000);
+    RPI4::setup();
+    delay(800);
     
-    Serial.println("\n\n");
-    Serial.println("╔════════════════════════════════════════╗");
-    Serial.printf("║  🚀 MeshNet V%s - STARTING UP      ║\n", FIRMWARE_VERSION);
-    Serial.println("╚════════════════════════════════════════╝");
-    Serial.println("");
+    LOG_I(LOG_TOPIC_SYS, "╔════════════════════════════════════════╗");
+    LOG_I(LOG_TOPIC_SYS, "║  🚀 MeshNet V%s - STARTING UP      ║", FIRMWARE_VERSION);
+    LOG_I(LOG_TOPIC_SYS, "╚════════════════════════════════════════╝");
     
     // VERSION VERIFICATION
-    Serial.println("[VERSION] Firmware Details:");
-    Serial.printf("[VERSION]   Name: %s\n", FIRMWARE_NAME);
-    Serial.printf("[VERSION]   Version: %s\n", FIRMWARE_VERSION);
-    Serial.printf("[VERSION]   Build: %s %s\n", FIRMWARE_BUILD_DATE, FIRMWARE_BUILD_TIME);
-    Serial.printf("[VERSION] ✓ MeshNet V%s confirmed\n\n", FIRMWARE_VERSION);
+    LOG_I(LOG_TOPIC_SYS, "[VERSION] Firmware Details:");
+    LOG_I(LOG_TOPIC_SYS, "[VERSION]   Name: %s", FIRMWARE_NAME);
+    LOG_I(LOG_TOPIC_SYS, "[VERSION]   Version: %s", FIRMWARE_VERSION);
+    LOG_I(LOG_TOPIC_SYS, "[VERSION]   Build: %s %s", FIRMWARE_BUILD_DATE, FIRMWARE_BUILD_TIME);
+    LOG_I(LOG_TOPIC_SYS, "[VERSION] ✓ MeshNet V%s confirmed", FIRMWARE_VERSION);
     
-    RPI4::setup();
+    NodeState::begin();
+    // Log calls from here on only queue a record; the log task writes them out
+    NodeLog::begin();
+    RPI4::setCommands(serialCommands, sizeof(serialCommands) / sizeof(serialCommands[0]));
+#if FEATURE_ENABLE_WEBSERVER
     User::setRuntimeCacheOnly(false);
     User::loadUsersNVS();
     LoraNode::setUsersSynced(User::getUserCount() > 0);
     NodeWebServer::setUsersSynced(User::getUserCount() > 0);
     NodeWebServer::setPagesSynced(false);
+#else
+    // Nothing to serve, so the radio gets the air to itself and light
+    // sleep stays possible
+    WiFi.mode(WIFI_OFF);
+#endif
 
-    Serial.println("[SETUP] Waiting for LoRa init before sync...");
+    LOG_I(LOG_TOPIC_SYS, "[SETUP] Waiting for LoRa init before sync...");
     
     NodeWebServer::webserverSetup();
     LoraNode::setup();
+    battery_init();
     Node_display_setup();
     button.begin();
+    PowerManager::begin(button);
+    xTaskCreatePinnedToCore(uiTask, "ui", UI_TASK_STACK, NULL, UI_TASK_PRIORITY, NULL, APP_TASK_CORE);
 
+#if FEATURE_ENABLE_WEBSERVER
     bool hasStoredPages = NodeWebServer::getStoredPagesCount() > 0;
     LoraNode::setPagesSynced(hasStoredPages);
     NodeWebServer::setPagesSynced(hasStoredPages);
+#endif
 
-    Serial.printf("[SETUP] Stored users: %d | Stored pages: %d\n",
+    LOG_I(LOG_TOPIC_SYS, "[SETUP] Stored users: %d | Stored pages: %d",
                   User::getUserCount(),
                   NodeWebServer::getStoredPagesCount());
     
-    Serial.println("\n[SETUP] ✓ Setup complete - ready for login");
-    Serial.println("========================================\n");
+    LOG_I(LOG_TOPIC_SYS, "[SETUP] ✓ Setup complete - ready for login");
+    LOG_I(LOG_TOPIC_SYS, "========================================");
 }
 
 void loop() {
-    RPI4::loop();
-    LoraNode::loop();
-    NodeWebServer::webserverLoop();
-    Node_display_update();
-
-        button.update();
-
-    if (button.isSingleClick()) {
-        Serial.println("Single click detected!");
-    }
-    if (button.isDoubleClick()) {
-        Serial.println("Double click detected!");
+    uint32_t started = micros();
+    PROFILE_PERIOD(PROF_LOOP_PERIOD, PROF_LOOP_JITTER);
+    {
+        PROFILE_SCOPE(PROF_SERIAL);
+        RPI4::loop();
     }
-    if (button.isLongPress()) {
-        Serial.println("Long press detected!");
+    {
+        PROFILE_SCOPE(PROF_PACKETS);
+        LoraNode::loop();
     }
-
-    if (Serial.available()) {
-        String cmd = Serial.readStringUntil('\n');
-        cmd.trim();
-        if (cmd.length() == 0) {
-            return;
-        }
-        Serial.println("[SERIAL] Command received: " + cmd);
-        if (cmd.equalsIgnoreCase("REQ;USERS") || cmd.equalsIgnoreCase("USERS")) {
-            Serial.println("[SERIAL] Triggering users sync request");
-            LoraNode::requestUsers();
-        } else if (cmd.equalsIgnoreCase("REQ;PAGES") || cmd.equalsIgnoreCase("PAGES")) {
-            Serial.println("[SERIAL] Triggering pages sync request");
-            LoraNode::requestPages();
-        } else if (cmd.equalsIgnoreCase("REFRESH")) {
-            Serial.println("[SERIAL] Refreshing users/pages");
-            LoraNode::setPagesSynced(false);
-            NodeWebServer::setPagesSynced(false);
-            LoraNode::requestUsers();
-        } else if (cmd.equalsIgnoreCase("HARDREFRESH")) {
-            Serial.println("[SERIAL] Hard refresh: clearing users/pages and reloading");
-            User::clearUsers();
-            User::saveUsersNVS();
-            NodeWebServer::clearPages(true);
-            LoraNode::setUsersSynced(false);
-            NodeWebServer::setUsersSynced(false);
-            LoraNode::setPagesSynced(false);
-            NodeWebServer::setPagesSynced(false);
-            LoraNode::requestUsers();
-        } else if (cmd.equalsIgnoreCase("STATUS")) {
-            Serial.printf("[SERIAL] UsersSynced=%s PagesSynced=%s StoredPages=%d Users=%d\n",
-                          LoraNode::isUsersSynced() ? "true" : "false",
-                          LoraNode::isPagesSynced() ? "true" : "false",
-                          NodeWebServer::getStoredPagesCount(),
-                          User::getUserCount());
-        } else if (cmd.equalsIgnoreCase("LISTPAGES")) {
-            Serial.println("[SERIAL] Stored pages:");
-            for (int i = 0; i < 10; i++) {
-                String name = NodeWebServer::getTeamNameAt(i);
-                int len = NodeWebServer::getTeamPageLengthAt(i);
-                String updated = NodeWebServer::getTeamUpdatedAtAt(i);
-                if (name.length() == 0 && len == 0) {
-                    continue;
-                }
-                Serial.printf("  [%d] team='%s' len=%d updated=%s\n", i, name.c_str(), len, updated.c_str());
-            }
-        } else if (cmd.equalsIgnoreCase("LISTUSERS")) {
-            Serial.println("[SERIAL] Users:");
-            for (int i = 0; i < User::getUserCount(); i++) {
-                Serial.printf("  [%d] user='%s' team='%s'\n", i, User::getUserName(i).c_str(), User::getUserTeam(i).c_str());
-            }
-        } else {
-            Serial.println("[SERIAL] Forwarding to LoRa handler: " + cmd);
-            LoraNode::handlePacket(cmd);
-        }
+    {
+        PROFILE_SCOPE(PROF_DNS);
+        NodeWebServer::webserverLoop();
     }
-
-}
\ No newline at end of file
+    Node_battery_poll();
+    updateDutyPolicy();
+    uint32_t elapsed = micros() - started;
+    Metrics::observe(HIST_LOOP_US, elapsed);
+    PROFILE_RECORD(PROF_LOOP, elapsed);
+    PowerManager::idle();
+}
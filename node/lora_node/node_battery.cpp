@@ -1,51 +1,104 @@
 #include "Node_battery.h"
 #include <Arduino.h>
-#include <OLEDDisplay.h>
+#include "NodeConfig.h"
+#include "Metrics.h"
+#include "Profiler.h"
 
 #define VBAT_CTRL GPIO_NUM_37
 #define VBAT_ADC  GPIO_NUM_1
 
-static float last_vbat = 0.0;
-static unsigned long last_update = 0;
+// =======================
+// Measurement state machine
+// =======================
+// IDLE -> SETTLING (divider on, wait BATTERY_SETTLE_MS) -> sample burst ->
+// IDLE. Node_battery_poll() only ever looks at the clock or does one short
+// burst of calibrated reads, so the caller never waits on the divider.
+enum BatteryState {
+  BATTERY_IDLE,
+  BATTERY_SETTLING
+};
+
+static BatteryState state = BATTERY_IDLE;
+static unsigned long state_since = 0;
+static bool measured = false;
+// Filtered pack voltage; written by the loop task, read by the UI task
+static volatile float filtered_vbat = 0.0;
+
+// Resting LiPo voltage against remaining charge, every 5%
+static const float lipo_curve[] = {
+  3.27, 3.61, 3.69, 3.71, 3.73, 3.75, 3.77, 3.79, 3.80, 3.82, 3.84,
+  3.85, 3.87, 3.91, 3.95, 3.98, 4.02, 4.08, 4.11, 4.15, 4.20
+};
+static const int lipo_curve_points = sizeof(lipo_curve) / sizeof(lipo_curve[0]);
 
 void battery_init() {
   pinMode(VBAT_CTRL, OUTPUT);
   digitalWrite(VBAT_CTRL, LOW); // standaard uit
   analogReadResolution(12);     // 12-bit ADC (0–4095)
+  analogSetPinAttenuation(VBAT_ADC, ADC_11db);
+  // First measurement right away
+  state_since = millis() - BATTERY_INTERVAL_MS;
 }
 
-float Node_battery_voltage_cached(unsigned long interval_ms = 30000) {
-    unsigned long now = millis();
-    if ((now - last_update > interval_ms) || (last_vbat == 0) ) {
-        last_vbat = Node_battery_voltage();
-        last_update = now;
-    }
-    return last_vbat;
+// Averages a burst of reads; analogReadMilliVolts() applies the eFuse ADC
+// calibration, and a burst takes well under a millisecond
+static float read_pack_voltage() {
+  uint32_t millivolts = 0;
+  for (int i = 0; i < BATTERY_SAMPLES; i++) {
+    millivolts += analogReadMilliVolts(VBAT_ADC);
+  }
+  return millivolts / (float)BATTERY_SAMPLES / 1000.0 * BATTERY_DIVIDER_RATIO;
 }
 
-// Lees spanning in Volt
-float Node_battery_voltage() {
-  digitalWrite(VBAT_CTRL, HIGH);    // spanningsdeler aan
-  delay(10);                       // even stabiliseren
+void Node_battery_poll() {
+  unsigned long now = millis();
+  switch (state) {
+  case BATTERY_IDLE:
+    if (now - state_since >= BATTERY_INTERVAL_MS) {
+      digitalWrite(VBAT_CTRL, HIGH);    // spanningsdeler aan
+      state = BATTERY_SETTLING;
+      state_since = now;
+    }
+    break;
+
+  case BATTERY_SETTLING:
+    if (now - state_since >= BATTERY_SETTLE_MS) {
+      PROFILE_SCOPE(PROF_BATTERY);
+      float vbat = read_pack_voltage();
+      digitalWrite(VBAT_CTRL, LOW);    // weer uit om stroom te sparen
+
+      // EWMA, seeded by the first reading so boot does not start at 0%
+      filtered_vbat = measured ? filtered_vbat + BATTERY_EWMA_ALPHA * (vbat - filtered_vbat) : vbat;
+      measured = true;
+      Metrics::set(GAUGE_BATTERY_MV, (uint32_t)(filtered_vbat * 1000));
 
-  int raw = 0;
-  for (int i = 0; i < 5; i++) {
-      raw += analogRead(VBAT_ADC);
-      delay(2);
+      state = BATTERY_IDLE;
+      state_since = now;
+    }
+    break;
   }
-  raw /= 5;  
-  digitalWrite(VBAT_CTRL, LOW);    // weer uit om stroom te sparen
+}
+
+// Gefilterde spanning in Volt; 0 until the first measurement
+float Node_battery_voltage() {
+  return filtered_vbat;
+}
 
-  float voltage = (raw / 4095.0) * 3.3; // ADC naar spanning
-  voltage *= 2.0;                       // spanningsdeler = 1/2
-  return voltage;
+bool Node_battery_present() {
+  return measured && filtered_vbat >= BATTERY_PRESENT_MIN_V;
 }
 
-// Spanning naar percentage (lineair, 0.5V = 0%, 3.7V = 100%)
+// Spanning naar percentage via de LiPo-ontlaadcurve, lineair tussen de punten
 int Node_battery_percent() {
-  float v = Node_battery_voltage_cached();
-  int percent = map(v * 100, 50, 370, 0, 100); // in centivolt
-  if (percent < 0)   percent = 0;
-  if (percent > 100) percent = 100;
-  return percent;
+  float v = filtered_vbat;
+  if (v <= lipo_curve[0]) {
+    return 0;
+  }
+  for (int i = 1; i < lipo_curve_points; i++) {
+    if (v < lipo_curve[i]) {
+      float fraction = (v - lipo_curve[i - 1]) / (lipo_curve[i] - lipo_curve[i - 1]);
+      return (int)((i - 1 + fraction) * 100 / (lipo_curve_points - 1) + 0.5);
+    }
+  }
+  return 100;
 }
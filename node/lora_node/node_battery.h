@@ -1,6 +1,10 @@
-
 #pragma once
 
 void battery_init();
+// Advances the battery measurement; returns at once, call it every loop pass
+void Node_battery_poll();
+// Filtered pack voltage from the last measurement (0 before the first one)
 float Node_battery_voltage();
 int Node_battery_percent();
+// False until measured, and when no cell is fitted
+bool Node_battery_present();
@@ -1,80 +1,162 @@
+#include "NodeConfig.h"
+#if FEATURE_ENABLE_DISPLAY
 #include "node_display.h"
 #include "node_battery.h"
 #include <Wire.h>
 #include <WiFi.h>
 #include "LoraNode.h"
+#include "NodeState.h"
+#include "MessageStore.h"
+#include "Metrics.h"
 
 SSD1306Wire display(0x3c, SDA_OLED, SCL_OLED, GEOMETRY_128_64);
 OLEDDisplayUi ui(&display);
 
 #define VEXT GPIO_NUM_36
 
-volatile int currentFrame = 0;
-unsigned long lastFrameSwitch = 0;
-const unsigned long frameSwitchInterval = 30000; // 30 seconden
+// =======================
+// Display model
+// =======================
+// Everything the frames show, kept as finished text. The UI task samples the
+// sources every DISPLAY_SAMPLE_MS and rebuilds a line only when its value
+// changed; the frame callbacks just draw. A redraw (and the I2C push that
+// comes with it) happens only while a transition runs or when something on
+// the frame being shown changed.
+enum DisplayFrame
+{
+    FRAME_INFO,
+    FRAME_BATTERY,
+    FRAME_NODES,
+    FRAME_BROADCAST,
+    FRAME_COUNT
+};
+
+struct DisplayModel
+{
+    String macLine;
+    String idLine;
+    int batteryPercent;
+    String batteryLine;
+    int onlineCount;
+    String onlineLine;
+    // MessageStore::getNextSeq() when the broadcast lines were last built
+    uint32_t messageSeq;
+    bool hasMessage;
+    String fromLine;
+    String contentLine;
+    String ttlLine;
+};
+
+static DisplayModel model;
+// Bit per DisplayFrame that has not been drawn since its text changed
+static uint8_t changedFrames = 0;
+static bool displayAwake = true;
+static unsigned long lastActivityMs = 0;
+static unsigned long lastSampleMs = 0;
+
+static int currentFrame = 0;
+static unsigned long lastFrameSwitch = 0;
+static const unsigned long frameSwitchInterval = 30000; // 30 seconden
+
+static void markChanged(DisplayFrame frame)
+{
+    changedFrames |= 1 << frame;
+}
+
+static void sampleModel()
+{
+    const int battery = Node_battery_percent();
+    if (battery != model.batteryPercent)
+    {
+        model.batteryPercent = battery;
+        model.batteryLine = "Batterij " + String(battery) + "%";
+        markChanged(FRAME_BATTERY);
+    }
+
+    int online;
+    uint32_t nextSeq;
+    MessageRecord msg;
+    bool readMessage = false;
+    {
+        NodeStateLock lock;
+        online = LoraNode::getOnlineCount();
+        nextSeq = MessageStore::getNextSeq();
+        if (nextSeq != model.messageSeq && nextSeq > 0)
+        {
+            readMessage = MessageStore::read(nextSeq - 1, msg);
+        }
+    }
+
+    if (online != model.onlineCount)
+    {
+        model.onlineCount = online;
+        model.onlineLine = "nodes: " + String(online);
+        markChanged(FRAME_NODES);
+    }
+
+    if (nextSeq != model.messageSeq)
+    {
+        // The first sample after boot shows the stored message without
+        // waking the screen; later ones are new broadcasts
+        const bool isNew = model.messageSeq != 0;
+        model.messageSeq = nextSeq;
+        model.hasMessage = readMessage;
+        if (readMessage)
+        {
+            model.fromLine = "From: " + msg.fieldString(MESSAGE_FIELD_USER);
+
+            // Truncate content if needed
+            StrView params = msg.field(MESSAGE_FIELD_PARAMETERS);
+            model.contentLine = "";
+            if (params.len > 30) {
+                model.contentLine.concat(params.data, 27);
+                model.contentLine += "...";
+            } else {
+                model.contentLine.concat(params.data, params.len);
+            }
+            model.ttlLine = "TTL: " + String(msg.ttl) + "s";
+        }
+        markChanged(FRAME_BROADCAST);
+        if (isNew && readMessage)
+        {
+            Node_display_wake();
+        }
+    }
+}
 
 void frame1(OLEDDisplay *display, OLEDDisplayUiState* state, int16_t x, int16_t y) {
     display->setFont(ArialMT_Plain_10);
-    String mac = WiFi.softAPmacAddress();
-    String nodeId = LoraNode::getNodeName();
-    display->drawString(x, y, "MAC: " + mac);
-    display->drawString(x, y + 12, "ID: " + nodeId);
+    display->drawString(x, y, model.macLine);
+    display->drawString(x, y + 12, model.idLine);
 }
 
 void frame2(OLEDDisplay *display, OLEDDisplayUiState* state, int16_t x, int16_t y) {
     display->setFont(ArialMT_Plain_16);
-    display->drawString(x, y, "Batterij " + String(Node_battery_percent()) + "%");
+    display->drawString(x, y, model.batteryLine);
 }
 
 void frame3(OLEDDisplay *display, OLEDDisplayUiState* state, int16_t x, int16_t y) {
     display->setFont(ArialMT_Plain_16);
-    display->drawString(x, y, "nodes: " + String(LoraNode::getOnlineCount()) );
+    display->drawString(x, y, model.onlineLine);
 }
 
 void frame4(OLEDDisplay *display, OLEDDisplayUiState* state, int16_t x, int16_t y) {
-    // Get latest broadcast message
-    const NodeMessage *messages = LoraNode::getMessages();
-    int msgWriteIndex = LoraNode::getMsgWriteIndex();
-    
     display->setFont(ArialMT_Plain_16);
     display->drawString(x, y, "📢 Broadcast");
     display->setFont(ArialMT_Plain_10);
     
-    if (msgWriteIndex > 0) {
-        // Display the most recent message
-        // msgWriteIndex points to NEXT write position, so latest is at index-1
-        int lastMsgIndex = msgWriteIndex - 1;
-        if (lastMsgIndex < 0) lastMsgIndex = MAX_MSGS - 1;
-        
-        const NodeMessage &msg = messages[lastMsgIndex];
-        
-        // Show sender
-        display->drawString(x, y + 16, "From: " + msg.user);
-        
-        // Truncate content if needed
-        String content = msg.parameters;
-        if (content.length() > 30) {
-            content = content.substring(0, 27) + "...";
-        }
-        display->drawString(x, y + 28, content);
-        
-        // Show TTL remaining
-        display->drawString(x, y + 40, "TTL: " + String(msg.TTL) + "s");
+    if (model.hasMessage) {
+        // Display the most recent message (also after a reboot)
+        display->drawString(x, y + 16, model.fromLine);
+        display->drawString(x, y + 28, model.contentLine);
+        display->drawString(x, y + 40, model.ttlLine);
     } else {
         // No messages yet
         display->drawString(x, y + 20, "No broadcasts");
     }
 }
 
-FrameCallback frames[4] = { frame1, frame2, frame3, frame4 };
-
-void overlay(OLEDDisplay *display, OLEDDisplayUiState* state) {
-    int bat = Node_battery_percent();
-    display->setFont(ArialMT_Plain_16);
-    String ssid = WiFi.softAPSSID();
-    //display->drawString(0, 0, ssid);
-//    display->drawString(0, 0, String(bat) + "%");
-}
+FrameCallback frames[FRAME_COUNT] = { frame1, frame2, frame3, frame4 };
 
 void heltec_display_power(bool on) {
     if (on) {
@@ -90,8 +172,6 @@ void heltec_display_power(bool on) {
 }
 
 void Node_display_setup() {
-    battery_init();
-
     pinMode(VEXT, OUTPUT);
     digitalWrite(VEXT, LOW);  // ✅ laag = OLED krijgt stroom
     delay(10);
@@ -109,20 +189,71 @@ void Node_display_setup() {
 //    display.setFont(ArialMT_Plain_16);
 //    display.drawString(0, 16, "Battery: " + String(Node_battery_percent()) + "%");
 
+    // Fixed text, so it is built once; the other lines start out unknown
+    model.macLine = "MAC: " + WiFi.softAPmacAddress();
+    model.idLine = "ID: " + LoraNode::getNodeName();
+    model.batteryPercent = -1;
+    model.onlineCount = -1;
+    model.messageSeq = 0;
+    model.hasMessage = false;
+    changedFrames = (1 << FRAME_COUNT) - 1;
+
+    // The target FPS only paces transitions; frames switch on our own timer
     ui.setTargetFPS(30);
-    ui.setFrames(frames, 4);
-    ui.setOverlays(new OverlayCallback[1]{ overlay }, 1);
+    ui.setFrames(frames, FRAME_COUNT);
+    ui.disableAutoTransition();
     ui.init();
+    lastActivityMs = millis();
+}
+
+void Node_display_wake() {
+    lastActivityMs = millis();
+    if (displayAwake) {
+        return;
+    }
+    display.displayOn();
+    displayAwake = true;
+    lastFrameSwitch = lastActivityMs;
+    // The buffer went stale while the panel was off
+    changedFrames = (1 << FRAME_COUNT) - 1;
 }
 
 void Node_display_update() {
-    int remainingTimeBudget = ui.update();
+    unsigned long now = millis();
+    if (now - lastSampleMs >= DISPLAY_SAMPLE_MS) {
+        lastSampleMs = now;
+        sampleModel();
+    }
+
+    if (!displayAwake) {
+        return;
+    }
+    if (now - lastActivityMs > DISPLAY_SLEEP_MS) {
+        display.displayOff();
+        displayAwake = false;
+        return;
+    }
 
     // Iedere 30 seconden naar volgende frame
-    unsigned long now = millis();
     if (now - lastFrameSwitch > frameSwitchInterval) {
-        currentFrame = (currentFrame + 1) % 4; // aantal frames
+        currentFrame = (currentFrame + 1) % FRAME_COUNT;
         ui.switchToFrame(currentFrame);
+        // No transition runs, so the panel still shows the old frame
+        markChanged((DisplayFrame)currentFrame);
         lastFrameSwitch = now;
     }
+
+    OLEDDisplayUiState *state = ui.getUiState();
+    const bool changed = (changedFrames & (1 << state->currentFrame)) != 0;
+    if (state->frameState != IN_TRANSITION && !changed) {
+        return;
+    }
+    // update() only draws once its frame interval has passed
+    const uint64_t lastTick = state->lastUpdate;
+    ui.update();
+    if (state->lastUpdate != lastTick) {
+        changedFrames &= ~(1 << state->currentFrame);
+        Metrics::inc(CTR_DISPLAY_FRAMES);
+    }
 }
+#endif
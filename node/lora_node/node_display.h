@@ -1,4 +1,7 @@
 #pragma once
+#include "NodeConfig.h"
+
+#if FEATURE_ENABLE_DISPLAY
 #include <SSD1306Wire.h>
 #include <OLEDDisplayUi.h>
 
@@ -13,8 +16,10 @@ extern uint8_t loraBuf[128];
 extern String lastLoRaMsg;
 
 void Node_display_setup();
+// Redraws only when the shown values change or a transition runs
 void Node_display_update();
-int getBatteryPercent();
+// Switches the panel back on after DISPLAY_SLEEP_MS without activity
+void Node_display_wake();
 
 // Frame callbacks
 void frame1(OLEDDisplay *display, OLEDDisplayUiState* state, int16_t x, int16_t y);
@@ -22,6 +27,8 @@ void frame2(OLEDDisplay *display, OLEDDisplayUiState* state, int16_t x, int16_t
 void frame3(OLEDDisplay *display, OLEDDisplayUiState* state, int16_t x, int16_t y);
 void frame4(OLEDDisplay *display, OLEDDisplayUiState* state, int16_t x, int16_t y);
 extern FrameCallback frames[4];
-
-// Overlay callback
-void overlay(OLEDDisplay *display, OLEDDisplayUiState* state);
+#else
+inline void Node_display_setup() {}
+inline void Node_display_update() {}
+inline void Node_display_wake() {}
+#endif
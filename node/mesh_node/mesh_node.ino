@@ -66,6 +66,9 @@ bool display_initialized = false;
 unsigned long last_discover_time = 0;
 unsigned long last_status_time = 0;
 unsigned long last_button_press = 0;
+// Set by the button interrupt, handled in loop()
+volatile bool button_pending = false;
+volatile unsigned long button_pressed_at = 0;
 int message_count = 0;
 int relay_count = 0;
 
@@ -287,8 +290,17 @@ void handle_config(String msg) {
 
 // ============ BUTTON HANDLER ============
 
-void button_callback() {
-  unsigned long now = millis();
+// Interrupt context: only note the press. Serial, the display and the
+// radio all block, so the work happens in handle_button() from loop().
+void IRAM_ATTR button_callback() {
+  button_pressed_at = millis();
+  button_pending = true;
+}
+
+void handle_button() {
+  if (!button_pending) return;
+  button_pending = false;
+  unsigned long now = button_pressed_at;
   
   if (now - last_button_press < 500) {
     // Debounce
@@ -364,6 +376,8 @@ void setup() {
 // ============ MAIN LOOP ============
 
 void loop() {
+  handle_button();
+
   // Read battery status periodically
   static unsigned long last_battery_read = 0;
   if (millis() - last_battery_read > 5000) {
@@ -0,0 +1,110 @@
+// Throughput of LoraNode::handlePacket() per packet type, plus heap
+// allocations per packet. Numbers are only comparable on the same machine.
+// The host String is std::string based, so allocation counts are close to
+// but not identical to the ESP32 WString (which has no small string buffer).
+// Run with LORA_HOST_LOG unset, otherwise the log output dominates.
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include "LoraNode.h"
+#include "NodeState.h"
+
+// =======================
+// Allocation counting
+// =======================
+static uint64_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Frames with %u get a unique number per packet so duplicate
+// suppression does not short-circuit the path being measured
+static void benchPacket(const char *name, const char *format, size_t count)
+{
+    std::vector<std::string> frames;
+    frames.reserve(count);
+    char buf[RX_BUFFER_SIZE + 1];
+    for (size_t i = 0; i < count; i++)
+    {
+        snprintf(buf, sizeof(buf), format, (unsigned)(1000000 + i));
+        frames.push_back(buf);
+    }
+
+    const uint64_t allocationsBefore = allocations;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(buf, frames[i].c_str(), frames[i].size() + 1);
+        LoraNode::handlePacket(buf, frames[i].size());
+    }
+    double seconds = secondsSince(start);
+    double perPacket = (double)(allocations - allocationsBefore) / count;
+    printf("%-20s %10.0f packets/s %7.2f us/packet %6.1f allocs/packet\n", name,
+           count / seconds, seconds * 1e6 / count, perPacket);
+}
+
+static void benchNodeMessage(size_t count)
+{
+    String text("MSG;1700000001;alice;3;1700000001;MSG;SEND;text:hello,node:LoRA_112233445566_4.0.0");
+    const uint64_t allocationsBefore = allocations;
+    Clock::time_point start = Clock::now();
+    size_t fields = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        NodeMessage message;
+        LoraNode::nodeMessageFromString(text, message);
+        fields += message.parameters().len;
+    }
+    double seconds = secondsSince(start);
+    double perPacket = (double)(allocations - allocationsBefore) / count;
+    printf("%-20s %10.0f packets/s %7.2f us/packet %6.1f allocs/packet  (%zu)\n", "nodeMessageFromString",
+           count / seconds, seconds * 1e6 / count, perPacket, fields);
+}
+
+int main()
+{
+    NodeState::begin();
+    LoraNode::setup();
+
+    const size_t count = 200000;
+    benchPacket("PING", "PING;LoRA_112233445566_4.0.0", count);
+    benchPacket("PONG", "PONG;LoRA_112233445566_4.0.0;%u", count);
+    benchPacket("BEACON", "BEACON;LoRA_112233445566_4.0.0", count);
+    benchPacket("ACK", "ACK;%u;LoRA_112233445566_4.0.0;MSG;SEND;123456", count);
+    benchPacket("BCAST", "BCAST;%u;alice;3;Hello everyone", count);
+    benchPacket("MSG relay", "MSG;%u;alice;3;1700000001;MSG;SEND;text:hello,node:LoRA_112233445566_4.0.0",
+                count);
+    benchPacket("MSG duplicate", "MSG;1700000001;alice;3;1700000001;MSG;SEND;text:hello", count);
+    benchPacket("REQ;STATS", "REQ;STATS;", count);
+    benchNodeMessage(count);
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Throughput of the ring buffers between two (or more) host threads.
+// Numbers are only comparable on the same machine; the point is to catch
+// regressions such as false sharing or an extra fence on the hot path.
+// Both sides yield when the ring is full/empty so the benchmark also
+// finishes on a single-core host.
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "RingBuffer.h"
+
+// Same shape as a LoRa RX frame on the node
+struct Frame
+{
+    uint16_t length;
+    float rssi;
+    float snr;
+    char data[256];
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const char *name, uint64_t items, size_t itemSize, double seconds)
+{
+    printf("%-28s %8.2f Mops/s %9.1f MB/s  (%.3f s)\n", name,
+           items / seconds / 1e6, items * itemSize / seconds / 1e6, seconds);
+}
+
+template <typename Ring, typename T>
+static void benchSpsc(const char *name, uint64_t items)
+{
+    static Ring ring;
+    std::thread producer([items]() {
+        T item;
+        memset(&item, 0, sizeof(item));
+        for (uint64_t i = 0; i < items; i++)
+        {
+            while (!ring.push(item))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    Clock::time_point start = Clock::now();
+    T item;
+    for (uint64_t i = 0; i < items;)
+    {
+        if (ring.pop(item))
+        {
+            i++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    double seconds = secondsSince(start);
+    producer.join();
+    report(name, items, sizeof(T), seconds);
+}
+
+// Zero-copy path used by the radio task: fill the slot in place
+static void benchSpscInPlace(uint64_t items)
+{
+    static SpscRing<Frame, 16> ring;
+    std::thread producer([items]() {
+        for (uint64_t i = 0; i < items; i++)
+        {
+            Frame *slot;
+            while ((slot = ring.claim()) == NULL)
+            {
+                std::this_thread::yield();
+            }
+            slot->length = 32;
+            memset(slot->data, 'x', 32);
+            ring.publish();
+        }
+    });
+    Clock::time_point start = Clock::now();
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < items;)
+    {
+        const Frame *frame = ring.front();
+        if (frame != NULL)
+        {
+            sum += frame->length;
+            ring.release();
+            i++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    double seconds = secondsSince(start);
+    producer.join();
+    report("spsc frame claim/front", items, sizeof(Frame), seconds);
+    if (sum != items * 32)
+    {
+        printf("unexpected checksum\n");
+    }
+}
+
+static void benchMpsc(unsigned producers, uint64_t perProducer)
+{
+    static MpscRing<uint32_t, 1024> ring;
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < producers; p++)
+    {
+        threads.push_back(std::thread([perProducer]() {
+            for (uint64_t i = 0; i < perProducer; i++)
+            {
+                while (!ring.push((uint32_t)i))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    Clock::time_point start = Clock::now();
+    uint64_t total = producers * perProducer;
+    uint32_t v;
+    for (uint64_t i = 0; i < total;)
+    {
+        if (ring.pop(v))
+        {
+            i++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    double seconds = secondsSince(start);
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    char name[40];
+    snprintf(name, sizeof(name), "mpsc u32 x%u producers", producers);
+    report(name, total, sizeof(uint32_t), seconds);
+}
+
+int main()
+{
+    benchSpsc<SpscRing<uint32_t, 1024>, uint32_t>("spsc u32", 50000000);
+    benchSpsc<SpscRing<Frame, 16>, Frame>("spsc frame copy", 5000000);
+    benchSpscInPlace(5000000);
+    benchMpsc(1, 20000000);
+    benchMpsc(2, 10000000);
+    benchMpsc(4, 5000000);
+    return 0;
+}
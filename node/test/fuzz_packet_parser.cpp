@@ -0,0 +1,252 @@
+// Fuzz target for the LoRa packet path: LoraNode::handlePacket() and
+// LoraNode::nodeMessageFromString() over arbitrary radio input.
+//
+// libFuzzer:  make fuzz-libfuzzer   (needs clang)
+//             ./fuzz_packet_parser_lf corpus/packet_parser
+// AFL:        make fuzz_packet_parser CXX=afl-g++
+//             afl-fuzz -i corpus/packet_parser -o findings -- ./fuzz_packet_parser @@
+// Built-in:   make fuzz   (ASan/UBSan, replays the corpus, then mutates it)
+//             ./fuzz_packet_parser -runs=N -seed=S corpus/packet_parser
+#include <dirent.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "LoraNode.h"
+#include "NodeState.h"
+
+static void initNode()
+{
+    static bool initialized = false;
+    if (!initialized)
+    {
+        initialized = true;
+        NodeState::begin();
+        LoraNode::setup();
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    initNode();
+    // Radio frames are at most RX_BUFFER_SIZE bytes and arrive NUL-terminated
+    if (size > RX_BUFFER_SIZE)
+    {
+        size = RX_BUFFER_SIZE;
+    }
+    char frame[RX_BUFFER_SIZE + 1];
+    if (size > 0)
+    {
+        memcpy(frame, data, size);
+    }
+    frame[size] = '\0';
+
+    LoraNode::handlePacket(frame, size);
+
+    String text;
+    text.concat(frame, size);
+    NodeMessage message;
+    LoraNode::nodeMessageFromString(text, message);
+    // Touch the last byte of every part so ASan sees one that runs past the buffer
+    const StrView parts[] = {message.user(), message.objectName(), message.functionName(), message.parameters()};
+    for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++)
+    {
+        volatile char last = parts[i].len > 0 ? parts[i].data[parts[i].len - 1] : 0;
+        (void)last;
+    }
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+// =======================
+// Standalone driver
+// =======================
+typedef std::vector<uint8_t> Input;
+
+static uint64_t rngState = 0x9E3779B97F4A7C15ull;
+
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return (uint32_t)rngState;
+}
+
+static uint32_t randomBelow(uint32_t bound)
+{
+    return bound == 0 ? 0 : nextRandom() % bound;
+}
+
+static bool readFile(const std::string &path, Input &out)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    out.clear();
+    uint8_t buf[512];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+    {
+        out.insert(out.end(), buf, buf + n);
+    }
+    fclose(file);
+    return true;
+}
+
+static void loadInputs(const std::string &path, std::vector<Input> &inputs)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+    {
+        fprintf(stderr, "cannot read %s\n", path.c_str());
+        exit(2);
+    }
+    if (!S_ISDIR(info.st_mode))
+    {
+        Input input;
+        if (readFile(path, input))
+        {
+            inputs.push_back(input);
+        }
+        return;
+    }
+    DIR *dir = opendir(path.c_str());
+    std::vector<std::string> names;
+    while (struct dirent *entry = readdir(dir))
+    {
+        if (entry->d_name[0] != '.')
+        {
+            names.push_back(path + "/" + entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        loadInputs(names[i], inputs);
+    }
+}
+
+// Tokens that steer mutations towards the parser's interesting paths
+static const char *const dictionary[] = {
+    ";", "|", "%", "%2", "%zz", "+", ":", ",", "0", "-1", "1", "40", "41", "60", "61",
+    "2147483647", "2147483648", "-2147483649", "99999999999999999999", " ",
+    "PART;", "RESP;PAGE;", "RESP;PAGES;PART;", "RESP;USERS;PART;", "MSG;", "BCAST;",
+    "node:", "target:", "nodeid:", "name:", "USER", "ADD",
+};
+
+static void mutate(Input &input, const std::vector<Input> &corpus)
+{
+    const int steps = 1 + randomBelow(4);
+    for (int step = 0; step < steps; step++)
+    {
+        const size_t size = input.size();
+        switch (randomBelow(7))
+        {
+        case 0: // flip a bit
+            if (size > 0)
+            {
+                input[randomBelow(size)] ^= (uint8_t)(1u << randomBelow(8));
+            }
+            break;
+        case 1: // random byte
+            input.insert(input.begin() + randomBelow(size + 1), (uint8_t)nextRandom());
+            break;
+        case 2: // erase a range
+            if (size > 0)
+            {
+                size_t start = randomBelow(size);
+                size_t count = 1 + randomBelow(std::min<size_t>(size - start, 16));
+                input.erase(input.begin() + start, input.begin() + start + count);
+            }
+            break;
+        case 3: // duplicate a range
+            if (size > 0)
+            {
+                size_t start = randomBelow(size);
+                size_t count = 1 + randomBelow(std::min<size_t>(size - start, 32));
+                Input copy(input.begin() + start, input.begin() + start + count);
+                input.insert(input.begin() + randomBelow(size + 1), copy.begin(), copy.end());
+            }
+            break;
+        case 4: // dictionary token
+        {
+            const char *token = dictionary[randomBelow(sizeof(dictionary) / sizeof(dictionary[0]))];
+            input.insert(input.begin() + randomBelow(size + 1), token, token + strlen(token));
+            break;
+        }
+        case 5: // replace a number field with a token
+        {
+            size_t pos = randomBelow(size + 1);
+            while (pos < size && !isdigit(input[pos]))
+            {
+                pos++;
+            }
+            size_t end = pos;
+            while (end < size && isdigit(input[end]))
+            {
+                end++;
+            }
+            const char *token = dictionary[9 + randomBelow(10)];
+            input.erase(input.begin() + pos, input.begin() + end);
+            input.insert(input.begin() + pos, token, token + strlen(token));
+            break;
+        }
+        default: // splice with another input
+        {
+            const Input &other = corpus[randomBelow(corpus.size())];
+            size_t cut = randomBelow(size + 1);
+            size_t from = randomBelow(other.size() + 1);
+            input.resize(cut);
+            input.insert(input.end(), other.begin() + from, other.end());
+            break;
+        }
+        }
+    }
+    if (input.size() > RX_BUFFER_SIZE)
+    {
+        input.resize(RX_BUFFER_SIZE);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long runs = 0;
+    std::vector<Input> corpus;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "-runs=", 6) == 0)
+        {
+            runs = strtoul(argv[i] + 6, NULL, 10);
+        }
+        else if (strncmp(argv[i], "-seed=", 6) == 0)
+        {
+            rngState = strtoull(argv[i] + 6, NULL, 10) | 1;
+        }
+        else
+        {
+            loadInputs(argv[i], corpus);
+        }
+    }
+    if (corpus.empty())
+    {
+        fprintf(stderr, "usage: %s [-runs=N] [-seed=S] <corpus file or dir>...\n", argv[0]);
+        return 2;
+    }
+
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        LLVMFuzzerTestOneInput(corpus[i].data(), corpus[i].size());
+    }
+    for (unsigned long run = 0; run < runs; run++)
+    {
+        Input input = corpus[randomBelow(corpus.size())];
+        mutate(input, corpus);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    printf("fuzz_packet_parser: %zu corpus inputs, %lu mutations, no crashes\n", corpus.size(), runs);
+    return 0;
+}
+#endif
@@ -0,0 +1,435 @@
+#pragma once
+// Host stand-in for the parts of the Arduino ESP32 core that lora_node uses,
+// so its sources can be built and run on Linux (fuzzing, benchmarks).
+// String follows the ESP32 core's WString semantics; hardware calls are
+// no-ops and the FreeRTOS calls never start a task.
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define IRAM_ATTR
+#define PROGMEM
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 3
+#define DEC 10
+#define HEX 16
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+uint32_t esp_random();
+inline bool psramFound() { return false; }
+inline long random(long low, long high) { return high > low ? low + (long)(esp_random() % (uint32_t)(high - low)) : low; }
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return HIGH; }
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterruptArg(int, void (*)(void *), void *, int) {}
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// =======================
+// String
+// =======================
+class String
+{
+public:
+    String() {}
+    String(const char *text) : s(text ? text : "") {}
+    String(const String &other) : s(other.s) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(int value, unsigned char base = 10) { fromLong(value, base); }
+    explicit String(unsigned int value, unsigned char base = 10) { fromUnsigned(value, base); }
+    explicit String(long value, unsigned char base = 10) { fromLong(value, base); }
+    explicit String(unsigned long value, unsigned char base = 10) { fromUnsigned(value, base); }
+    explicit String(long long value, unsigned char base = 10) { fromLong(value, base); }
+    explicit String(unsigned long long value, unsigned char base = 10) { fromUnsigned(value, base); }
+    explicit String(float value, unsigned int decimals = 2) { fromDouble(value, decimals); }
+    explicit String(double value, unsigned int decimals = 2) { fromDouble(value, decimals); }
+
+    String &operator=(const String &other)
+    {
+        s = other.s;
+        return *this;
+    }
+    String &operator=(const char *text)
+    {
+        s = text ? text : "";
+        return *this;
+    }
+
+    unsigned int length() const { return (unsigned int)s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    const char *c_str() const { return s.c_str(); }
+    bool reserve(unsigned int size)
+    {
+        s.reserve(size);
+        return true;
+    }
+
+    bool concat(const String &other)
+    {
+        s += other.s;
+        return true;
+    }
+    bool concat(const char *text)
+    {
+        if (text == NULL)
+        {
+            return false;
+        }
+        s += text;
+        return true;
+    }
+    bool concat(const char *text, unsigned int length)
+    {
+        if (text == NULL)
+        {
+            return false;
+        }
+        s.append(text, length);
+        return true;
+    }
+    bool concat(char c)
+    {
+        s += c;
+        return true;
+    }
+    bool concat(int value) { return concat(String(value)); }
+    bool concat(unsigned int value) { return concat(String(value)); }
+    bool concat(long value) { return concat(String(value)); }
+    bool concat(unsigned long value) { return concat(String(value)); }
+    bool concat(long long value) { return concat(String(value)); }
+    bool concat(unsigned long long value) { return concat(String(value)); }
+    bool concat(float value) { return concat(String(value)); }
+    bool concat(double value) { return concat(String(value)); }
+
+    template <typename T>
+    String &operator+=(const T &value)
+    {
+        concat(value);
+        return *this;
+    }
+
+    char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index)
+    {
+        static char dummy;
+        if (index >= s.size())
+        {
+            dummy = 0;
+            return dummy;
+        }
+        return s[index];
+    }
+
+    int indexOf(char c, unsigned int from = 0) const
+    {
+        if (from >= s.size())
+        {
+            return -1;
+        }
+        size_t pos = s.find(c, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    int indexOf(const String &needle, unsigned int from = 0) const
+    {
+        if (from >= s.size())
+        {
+            return -1;
+        }
+        size_t pos = s.find(needle.s, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    int lastIndexOf(char c) const
+    {
+        size_t pos = s.rfind(c);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    int lastIndexOf(const String &needle) const
+    {
+        size_t pos = s.rfind(needle.s);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    String substring(unsigned int left) const { return substring(left, length()); }
+    String substring(unsigned int left, unsigned int right) const
+    {
+        if (left > right)
+        {
+            std::swap(left, right);
+        }
+        if (left >= s.size())
+        {
+            return String();
+        }
+        if (right > s.size())
+        {
+            right = (unsigned int)s.size();
+        }
+        String out;
+        out.s.assign(s, left, right - left);
+        return out;
+    }
+
+    bool startsWith(const String &prefix) const
+    {
+        return s.size() >= prefix.s.size() && s.compare(0, prefix.s.size(), prefix.s) == 0;
+    }
+    bool endsWith(const String &suffix) const
+    {
+        return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+    }
+    bool equals(const String &other) const { return s == other.s; }
+    bool equalsIgnoreCase(const String &other) const
+    {
+        if (s.size() != other.s.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < s.size(); i++)
+        {
+            if (tolower((unsigned char)s[i]) != tolower((unsigned char)other.s[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator==(const String &other) const { return s == other.s; }
+    bool operator==(const char *text) const { return s == (text ? text : ""); }
+    bool operator!=(const String &other) const { return s != other.s; }
+    bool operator!=(const char *text) const { return !(*this == text); }
+    bool operator<(const String &other) const { return s < other.s; }
+
+    void trim()
+    {
+        size_t begin = 0;
+        size_t end = s.size();
+        while (begin < end && isspace((unsigned char)s[begin]))
+        {
+            begin++;
+        }
+        while (end > begin && isspace((unsigned char)s[end - 1]))
+        {
+            end--;
+        }
+        s = s.substr(begin, end - begin);
+    }
+    void toUpperCase()
+    {
+        for (size_t i = 0; i < s.size(); i++)
+        {
+            s[i] = (char)toupper((unsigned char)s[i]);
+        }
+    }
+    void toLowerCase()
+    {
+        for (size_t i = 0; i < s.size(); i++)
+        {
+            s[i] = (char)tolower((unsigned char)s[i]);
+        }
+    }
+    void replace(const String &find, const String &replacement)
+    {
+        if (find.s.empty())
+        {
+            return;
+        }
+        size_t pos = 0;
+        while ((pos = s.find(find.s, pos)) != std::string::npos)
+        {
+            s.replace(pos, find.s.size(), replacement.s);
+            pos += replacement.s.size();
+        }
+    }
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1)
+    {
+        if (index < s.size())
+        {
+            s.erase(index, count);
+        }
+    }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return (float)atof(s.c_str()); }
+
+private:
+    void fromLong(long long value, unsigned char base)
+    {
+        if (base == 10)
+        {
+            char buf[24];
+            snprintf(buf, sizeof(buf), "%lld", value);
+            s = buf;
+        }
+        else
+        {
+            fromUnsigned((unsigned long long)value, base);
+        }
+    }
+    void fromUnsigned(unsigned long long value, unsigned char base)
+    {
+        char buf[72];
+        size_t pos = sizeof(buf) - 1;
+        buf[pos] = '\0';
+        do
+        {
+            unsigned digit = (unsigned)(value % base);
+            buf[--pos] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+            value /= base;
+        } while (value != 0);
+        s = buf + pos;
+    }
+    void fromDouble(double value, unsigned int decimals)
+    {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+        s = buf;
+    }
+
+    std::string s;
+};
+
+inline String operator+(const String &a, const String &b)
+{
+    String out(a);
+    out.concat(b);
+    return out;
+}
+inline String operator+(const String &a, const char *b)
+{
+    String out(a);
+    out.concat(b);
+    return out;
+}
+inline String operator+(const char *a, const String &b)
+{
+    String out(a);
+    out.concat(b);
+    return out;
+}
+inline String operator+(const String &a, char b)
+{
+    String out(a);
+    out.concat(b);
+    return out;
+}
+inline String operator+(const String &a, int b) { return a + String(b); }
+inline String operator+(const String &a, unsigned int b) { return a + String(b); }
+inline String operator+(const String &a, long b) { return a + String(b); }
+inline String operator+(const String &a, unsigned long b) { return a + String(b); }
+inline String operator+(const String &a, float b) { return a + String(b); }
+inline String operator+(const String &a, double b) { return a + String(b); }
+
+// =======================
+// Print
+// =======================
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *data, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            write(data[i]);
+        }
+        return length;
+    }
+    size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+    size_t print(const String &text) { return write((const uint8_t *)text.c_str(), text.length()); }
+    size_t println(const char *text) { return print(text) + print("\r\n"); }
+    size_t println(const String &text) { return print(text) + print("\r\n"); }
+    size_t println() { return print("\r\n"); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buf[512];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (len < 0)
+        {
+            return 0;
+        }
+        return write((const uint8_t *)buf, std::min((size_t)len, sizeof(buf) - 1));
+    }
+};
+
+// =======================
+// ESP
+// =======================
+class EspClass
+{
+public:
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 150000; }
+    uint32_t getMaxAllocHeap() { return 100000; }
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount() { return (uint32_t)(micros() * 240); }
+    uint64_t getEfuseMac() { return 0xFFEEDDCCBBAAull; }
+    void restart() { abort(); }
+};
+extern EspClass ESP;
+
+// =======================
+// FreeRTOS
+// =======================
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+
+// Tasks are never started on the host
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t,
+                                          TaskHandle_t *handle, BaseType_t)
+{
+    if (handle != NULL)
+    {
+        *handle = NULL;
+    }
+    return pdPASS;
+}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t *) {}
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t timeout);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex);
+
+struct portMUX_TYPE
+{
+    int unused;
+};
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
@@ -0,0 +1,7 @@
+#pragma once
+#include <Arduino.h>
+
+// Host stand-in; only needed so NodeWebServer.h parses
+class DNSServer
+{
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <Arduino.h>
+
+// Host stand-ins; only needed so NodeWebServer.h parses
+class AsyncWebServer
+{
+public:
+    explicit AsyncWebServer(uint16_t) {}
+};
+
+class AsyncEventSource
+{
+public:
+    explicit AsyncEventSource(const String &) {}
+};
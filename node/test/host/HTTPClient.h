@@ -0,0 +1,14 @@
+#pragma once
+#include <Arduino.h>
+
+// Host stand-in: there is no network, every request fails
+#define HTTP_CODE_OK 200
+
+class HTTPClient
+{
+public:
+    bool begin(const String &) { return true; }
+    int GET() { return -1; }
+    String getString() { return String(); }
+    void end() {}
+};
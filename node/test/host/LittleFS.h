@@ -0,0 +1,110 @@
+#pragma once
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Host stand-in for the ESP32 LittleFS. Files live in memory, so they
+// survive MessageStore::end()/begin() the way they survive a reboot.
+class File
+{
+public:
+    File() : pos(0) {}
+    explicit operator bool() const { return data != nullptr; }
+    size_t size() const { return data ? data->size() : 0; }
+    bool seek(uint32_t position)
+    {
+        if (!data || position > data->size())
+        {
+            return false;
+        }
+        pos = position;
+        return true;
+    }
+    size_t read(uint8_t *buf, size_t size)
+    {
+        if (!data || pos >= data->size())
+        {
+            return 0;
+        }
+        size_t count = std::min(size, data->size() - pos);
+        memcpy(buf, data->data() + pos, count);
+        pos += count;
+        return count;
+    }
+    size_t write(const uint8_t *buf, size_t size)
+    {
+        if (!data)
+        {
+            return 0;
+        }
+        if (pos + size > data->size())
+        {
+            data->resize(pos + size);
+        }
+        memcpy(data->data() + pos, buf, size);
+        pos += size;
+        return size;
+    }
+    void flush() {}
+    void close() { data.reset(); }
+
+private:
+    friend class LittleFSFS;
+    std::shared_ptr<std::vector<uint8_t>> data;
+    size_t pos;
+};
+
+class LittleFSFS
+{
+public:
+    LittleFSFS() : mountFails(false) {}
+    bool begin(bool = false) { return !mountFails; }
+    bool exists(const String &path) { return files.count(path.c_str()) > 0 || dirs.count(path.c_str()) > 0; }
+    bool mkdir(const String &path)
+    {
+        dirs[path.c_str()] = true;
+        return true;
+    }
+    bool remove(const String &path) { return files.erase(path.c_str()) > 0; }
+    File open(const String &path, const char *mode = "r")
+    {
+        File file;
+        std::map<std::string, std::shared_ptr<std::vector<uint8_t> > >::iterator it = files.find(path.c_str());
+        if (mode[0] == 'r')
+        {
+            if (it != files.end())
+            {
+                file.data = it->second;
+            }
+            return file;
+        }
+        if (it == files.end())
+        {
+            it = files.insert(std::make_pair(std::string(path.c_str()),
+                                             std::make_shared<std::vector<uint8_t> >())).first;
+        }
+        file.data = it->second;
+        if (mode[0] == 'w')
+        {
+            file.data->clear();
+        }
+        file.pos = file.data->size();
+        return file;
+    }
+
+    // Host only
+    void format()
+    {
+        files.clear();
+        dirs.clear();
+    }
+    bool mountFails;
+
+private:
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t> > > files;
+    std::map<std::string, bool> dirs;
+};
+
+extern LittleFSFS LittleFS;
@@ -0,0 +1,109 @@
+#pragma once
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// Host stand-in: an in-memory NVS shared by every Preferences object, so a
+// value written under a namespace reads back after end()/begin() like on the
+// board. Nothing survives the process.
+class Preferences
+{
+public:
+    bool begin(const char *name, bool = false)
+    {
+        space = &storage()[name];
+        return true;
+    }
+    void end() { space = NULL; }
+    bool clear()
+    {
+        if (space != NULL)
+        {
+            space->clear();
+        }
+        return true;
+    }
+    bool remove(const char *key) { return space != NULL && space->erase(key) > 0; }
+    bool isKey(const char *key) { return find(key) != NULL; }
+
+    size_t putBool(const char *key, bool value) { return putValue(key, (uint8_t)value); }
+    bool getBool(const char *key, bool value = false) { return getValue(key, (uint8_t)value) != 0; }
+    size_t putUChar(const char *key, uint8_t value) { return putValue(key, value); }
+    uint8_t getUChar(const char *key, uint8_t value = 0) { return getValue(key, value); }
+    size_t putInt(const char *key, int32_t value) { return putValue(key, value); }
+    int32_t getInt(const char *key, int32_t value = 0) { return getValue(key, value); }
+    size_t putUInt(const char *key, uint32_t value) { return putValue(key, value); }
+    uint32_t getUInt(const char *key, uint32_t value = 0) { return getValue(key, value); }
+    size_t putString(const char *key, const String &value) { return putBytes(key, value.c_str(), value.length()); }
+    String getString(const char *key, const String &value = String())
+    {
+        const std::vector<uint8_t> *stored = find(key);
+        if (stored == NULL)
+        {
+            return value;
+        }
+        String out;
+        out.concat((const char *)stored->data(), stored->size());
+        return out;
+    }
+    size_t putBytes(const char *key, const void *data, size_t length)
+    {
+        if (space == NULL)
+        {
+            return 0;
+        }
+        (*space)[key].assign((const uint8_t *)data, (const uint8_t *)data + length);
+        return length;
+    }
+    size_t getBytes(const char *key, void *data, size_t length)
+    {
+        const std::vector<uint8_t> *stored = find(key);
+        if (stored == NULL || stored->size() > length)
+        {
+            return 0;
+        }
+        memcpy(data, stored->data(), stored->size());
+        return stored->size();
+    }
+    size_t getBytesLength(const char *key)
+    {
+        const std::vector<uint8_t> *stored = find(key);
+        return stored != NULL ? stored->size() : 0;
+    }
+
+    // Test hook: forgets every namespace
+    static void wipeAll() { storage().clear(); }
+
+private:
+    typedef std::map<std::string, std::vector<uint8_t>> Space;
+
+    static std::map<std::string, Space> &storage()
+    {
+        static std::map<std::string, Space> spaces;
+        return spaces;
+    }
+    const std::vector<uint8_t> *find(const char *key) const
+    {
+        if (space == NULL)
+        {
+            return NULL;
+        }
+        Space::const_iterator it = space->find(key);
+        return it != space->end() ? &it->second : NULL;
+    }
+    template <typename T>
+    size_t putValue(const char *key, T value) { return putBytes(key, &value, sizeof(value)); }
+    template <typename T>
+    T getValue(const char *key, T value)
+    {
+        const std::vector<uint8_t> *stored = find(key);
+        if (stored != NULL && stored->size() == sizeof(T))
+        {
+            memcpy(&value, stored->data(), sizeof(T));
+        }
+        return value;
+    }
+
+    Space *space = NULL;
+};
@@ -0,0 +1,11 @@
+#pragma once
+#include <Arduino.h>
+
+// Host stand-in: a fixed MAC so node names are stable between runs
+class WiFiClass
+{
+public:
+    String softAPmacAddress() { return "AA:BB:CC:DD:EE:FF"; }
+    String macAddress() { return "AA:BB:CC:DD:EE:FF"; }
+};
+extern WiFiClass WiFi;
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdlib.h>
+
+// Host stand-in: every capability is plain heap
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_8BIT (1 << 2)
+
+inline void *heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+inline void *heap_caps_calloc(size_t count, size_t size, uint32_t) { return calloc(count, size); }
+inline void heap_caps_free(void *ptr) { free(ptr); }
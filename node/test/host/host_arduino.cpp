@@ -0,0 +1,56 @@
+// Host implementations behind host/Arduino.h and friends
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_timer.h>
+#include <LittleFS.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+EspClass ESP;
+WiFiClass WiFi;
+LittleFSFS LittleFS;
+
+static const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+
+int64_t esp_timer_get_time()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - processStart).count();
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)esp_timer_get_time();
+}
+
+uint32_t esp_random()
+{
+    return (uint32_t)rand();
+}
+
+void delay(unsigned long ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()
+{
+    return new std::recursive_mutex();
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t)
+{
+    static_cast<std::recursive_mutex *>(mutex)->lock();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex)
+{
+    static_cast<std::recursive_mutex *>(mutex)->unlock();
+    return pdTRUE;
+}
@@ -0,0 +1,75 @@
+// Link-time fakes for the lora_node modules the packet path calls into but
+// that need the web server, NVS or the UART. They only keep enough state for
+// the packet handlers to take their normal paths.
+#include "NodeWebServer.h"
+#include "NodeLog.h"
+#include "SerialLink.h"
+#include "User.h"
+
+#if FEATURE_ENABLE_WEBSERVER
+// =======================
+// NodeWebServer
+// =======================
+static int fakeStoredPages = 0;
+
+void NodeWebServer::storeTeamPage(const String &, const String &, const String &) { fakeStoredPages++; }
+void NodeWebServer::setUsersSynced(bool) {}
+void NodeWebServer::setPagesSynced(bool) {}
+int NodeWebServer::getStoredPagesCount() { return fakeStoredPages; }
+void NodeWebServer::publishMessage(uint32_t) {}
+void NodeWebServer::publishOnlineNodesChanged() {}
+#endif
+
+// =======================
+// User
+// =======================
+static int fakeUserCount = 0;
+
+int User::getUserCount() { return fakeUserCount; }
+void User::setRuntimeCacheOnly(bool) {}
+
+bool User::registerUserWithToken(const String &name, const String &, const String &, String)
+{
+    if (name.length() == 0)
+    {
+        return false;
+    }
+    fakeUserCount++;
+    return true;
+}
+
+bool User::setUsersFromSyncPayload(const String &payload)
+{
+    fakeUserCount = 0;
+    for (unsigned int i = 0; i < payload.length(); i++)
+    {
+        fakeUserCount += payload[i] == ';';
+    }
+    return payload.length() > 0;
+}
+
+// =======================
+// SerialLink
+// =======================
+uint32_t SerialLink::crcErrors = 0;
+uint32_t SerialLink::droppedFrames = 0;
+
+void SerialLink::sendProto(const char *, size_t) {}
+void SerialLink::sendLog(const char *, size_t) {}
+
+// =======================
+// NodeLog
+// =======================
+// Records are dropped; set LORA_HOST_LOG=1 to print them instead
+void NodeLog::submit(const LogRecord &record)
+{
+    static const bool enabled = getenv("LORA_HOST_LOG") != NULL;
+    if (enabled)
+    {
+        char line[LOG_LINE_MAX];
+        logFormat(record, line, sizeof(line));
+        fprintf(stderr, "%s\n", line);
+    }
+}
+
+uint32_t NodeLog::getDroppedRecords() { return 0; }
@@ -0,0 +1,83 @@
+#include "DutyPolicy.h"
+#include "test_util.h"
+
+static int relayedOutOf100()
+{
+    int relayed = 0;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        relayed += DutyPolicy::shouldRelay(i);
+    }
+    return relayed;
+}
+
+static void testFullBatteryRunsNormally()
+{
+    DutyPolicy::update(100);
+    CHECK_EQ(DutyPolicy::getMode(), DUTY_NORMAL);
+    CHECK(!DutyPolicy::isLowPower());
+    CHECK_EQ(DutyPolicy::beaconInterval(30000), 30000u);
+    CHECK_EQ(relayedOutOf100(), 100);
+}
+
+static void testNoBatteryRunsNormally()
+{
+    DutyPolicy::update(5);
+    CHECK(DutyPolicy::update(-1));
+    CHECK_EQ(DutyPolicy::getMode(), DUTY_NORMAL);
+    CHECK_EQ(relayedOutOf100(), 100);
+}
+
+static void testLowBandScales()
+{
+    DutyPolicy::update(100);
+    CHECK(DutyPolicy::update(DUTY_LOW_LEVEL - 1));
+    CHECK_EQ(DutyPolicy::getMode(), DUTY_LOW_POWER);
+    CHECK(DutyPolicy::isLowPower());
+    const uint32_t early = DutyPolicy::beaconInterval(30000);
+    const int earlyRelays = relayedOutOf100();
+    CHECK(early > 30000u);
+    CHECK(earlyRelays < 100 && earlyRelays > DUTY_RELAY_MIN_PERCENT);
+
+    CHECK(!DutyPolicy::update(DUTY_CRITICAL_LEVEL));
+    CHECK_EQ(DutyPolicy::beaconInterval(30000), 30000u * DUTY_BEACON_MAX_PERCENT / 100);
+    CHECK_EQ(relayedOutOf100(), DUTY_RELAY_MIN_PERCENT);
+    CHECK(DutyPolicy::beaconInterval(30000) > early);
+}
+
+static void testCriticalBecomesLeaf()
+{
+    DutyPolicy::update(100);
+    CHECK(DutyPolicy::update(DUTY_CRITICAL_LEVEL - 1));
+    CHECK_EQ(DutyPolicy::getMode(), DUTY_LEAF);
+    CHECK_EQ(relayedOutOf100(), 0);
+    CHECK(!DutyPolicy::shouldRelay(0));
+    CHECK_EQ(DutyPolicy::beaconInterval(30000), 30000u * DUTY_BEACON_MAX_PERCENT / 100);
+}
+
+static void testHysteresis()
+{
+    DutyPolicy::update(DUTY_CRITICAL_LEVEL - 1);
+    // Back at the critical level is not enough to relay again
+    CHECK(!DutyPolicy::update(DUTY_CRITICAL_LEVEL));
+    CHECK_EQ(DutyPolicy::getMode(), DUTY_LEAF);
+    CHECK(DutyPolicy::update(DUTY_CRITICAL_LEVEL + DUTY_HYSTERESIS));
+    CHECK_EQ(DutyPolicy::getMode(), DUTY_LOW_POWER);
+
+    CHECK(!DutyPolicy::update(DUTY_LOW_LEVEL));
+    CHECK_EQ(DutyPolicy::getMode(), DUTY_LOW_POWER);
+    // Within the hysteresis the node stays flagged but relays everything
+    CHECK_EQ(relayedOutOf100(), 100);
+    CHECK(DutyPolicy::update(DUTY_LOW_LEVEL + DUTY_HYSTERESIS));
+    CHECK_EQ(DutyPolicy::getMode(), DUTY_NORMAL);
+}
+
+int main()
+{
+    RUN_TEST(testFullBatteryRunsNormally);
+    RUN_TEST(testNoBatteryRunsNormally);
+    RUN_TEST(testLowBandScales);
+    RUN_TEST(testCriticalBecomesLeaf);
+    RUN_TEST(testHysteresis);
+    return testResult();
+}
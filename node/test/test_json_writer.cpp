@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "JsonWriter.h"
+#include "test_util.h"
+
+static std::string text(const char *buf, const JsonWriter &json)
+{
+    return std::string(buf, json.length());
+}
+
+static void testWritesValues()
+{
+    char buf[128];
+    JsonWriter json(buf, sizeof(buf));
+    json.raw("{");
+    json.key("n");
+    json.string("node-1");
+    json.raw(",");
+    json.key("r");
+    json.number(-97L);
+    json.raw(",");
+    json.key("s");
+    json.number(4000000000ul);
+    json.raw(",");
+    json.key("ok");
+    json.boolean(true);
+    json.raw("}");
+    CHECK(!json.overflowed());
+    CHECK(text(buf, json) == "{\"n\":\"node-1\",\"r\":-97,\"s\":4000000000,\"ok\":true}");
+}
+
+static void testEscapes()
+{
+    char buf[64];
+    JsonWriter json(buf, sizeof(buf));
+    json.string("a\"b\\c\nd\x01");
+    CHECK(text(buf, json) == "\"a\\\"b\\\\c\\u000ad\\u0001\"");
+    CHECK_EQ(JsonWriter::escapedLength("a\"b\\c\nd\x01", 8), json.length());
+
+    // UTF-8 passes through unchanged
+    JsonWriter utf8(buf, sizeof(buf));
+    utf8.string("\xe2\x9c\x85 ok");
+    CHECK(text(buf, utf8) == "\"\xe2\x9c\x85 ok\"");
+}
+
+static void testEmbeddedNul()
+{
+    char buf[32];
+    JsonWriter json(buf, sizeof(buf));
+    const char value[] = {'a', '\0', 'b'};
+    json.string(value, sizeof(value));
+    CHECK(text(buf, json) == "\"a\\u0000b\"");
+}
+
+static void testOverflowStopsAndRollbackRecovers()
+{
+    char buf[16];
+    memset(buf, '#', sizeof(buf));
+    JsonWriter json(buf, 12);
+    json.raw("[");
+    size_t mark = json.mark();
+    json.string("fits");
+    CHECK(!json.overflowed());
+    json.raw(",");
+    size_t second = json.mark();
+    json.string("does not fit");
+    CHECK(json.overflowed());
+    CHECK_EQ(json.length(), second);
+    // Nothing after an overflow is written, even if it would fit
+    json.raw("]");
+    CHECK_EQ(json.length(), second);
+    CHECK_EQ(buf[12], '#');
+
+    json.rollback(second - 1);
+    CHECK(!json.overflowed());
+    json.raw("]");
+    CHECK(text(buf, json) == "[\"fits\"]");
+    CHECK(mark == 1);
+}
+
+static void testExactFit()
+{
+    char buf[6];
+    JsonWriter json(buf, sizeof(buf));
+    json.string("abcd");
+    CHECK(!json.overflowed());
+    CHECK_EQ(json.length(), 6u);
+    json.raw("x");
+    CHECK(json.overflowed());
+}
+
+int main()
+{
+    RUN_TEST(testWritesValues);
+    RUN_TEST(testEscapes);
+    RUN_TEST(testEmbeddedNul);
+    RUN_TEST(testOverflowStopsAndRollbackRecovers);
+    RUN_TEST(testExactFit);
+    return testResult();
+}
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <string.h>
+#include "LogRecord.h"
+#include "test_util.h"
+
+template <typename... Args>
+static const char *packAndFormat(const char *format, Args... args)
+{
+    static char line[256];
+    LogRecord record;
+    LogPacker packer(record, format);
+    logPack(packer, args...);
+    logFormat(record, line, sizeof(line));
+    return line;
+}
+
+template <typename... Args>
+static bool sameAsPrintf(const char *format, Args... args)
+{
+    char expected[256];
+    snprintf(expected, sizeof(expected), format, args...);
+    const char *actual = packAndFormat(format, args...);
+    if (strcmp(expected, actual) != 0)
+    {
+        fprintf(stderr, "  expected '%s'\n  got      '%s'\n", expected, actual);
+        return false;
+    }
+    return true;
+}
+
+static void testMatchesPrintf()
+{
+    CHECK(sameAsPrintf("[LoRa] init failed, code: %d", -2));
+    CHECK(sameAsPrintf("[USER] capacity=%d (%s)", 200, "PSRAM"));
+    CHECK(sameAsPrintf("[LoRa TX RAW] packet too long (%u bytes)", 300u));
+    CHECK(sameAsPrintf("%lu;%lu;%u", 4000000000ul, 7ul, 16u));
+    CHECK(sameAsPrintf("%5d|%-5d|%05d|%x|%X|%#o", 42, 42, 42, 255, 255, 8));
+    CHECK(sameAsPrintf("%.2f dBm, %.1f dB", -97.25, 9.5));
+    CHECK(sameAsPrintf("100%% done, %c", 'x'));
+    CHECK(sameAsPrintf("%lld / %llu", -5000000000ll, 18000000000000000000ull));
+    CHECK(sameAsPrintf("no args"));
+    CHECK(sameAsPrintf("[%8s][%-4s]", "ab", "cd"));
+}
+
+static void testStarPrecisionCopiesOnlyPrintedBytes()
+{
+    // Not NUL-terminated: only the first 5 bytes may be read
+    const char frame[] = {'P', 'I', 'N', 'G', ';', '#'};
+    CHECK(strcmp(packAndFormat("[PING] Received: %.*s", 5, frame), "[PING] Received: PING;") == 0);
+    CHECK(strcmp(packAndFormat("%.3s|%*d", "abcdef", 4, 7), "abc|   7") == 0);
+    CHECK(strcmp(packAndFormat("%*.*s|", 6, 2, "xyz"), "    xy|") == 0);
+}
+
+static void testStringsAreCopied()
+{
+    char buffer[16];
+    strcpy(buffer, "alice");
+    LogRecord record;
+    LogPacker packer(record, "user=%s team=%s");
+    logPack(packer, (const char *)buffer, "red");
+    strcpy(buffer, "mallory");
+    char line[64];
+    logFormat(record, line, sizeof(line));
+    CHECK(strcmp(line, "user=alice team=red") == 0);
+}
+
+static void testLimitsTruncate()
+{
+    char longText[200];
+    memset(longText, 'a', sizeof(longText) - 1);
+    longText[sizeof(longText) - 1] = '\0';
+    LogRecord record;
+    LogPacker packer(record, "%s|%s");
+    logPack(packer, (const char *)longText, "b");
+    CHECK_EQ(record.textUsed, LOG_RECORD_TEXT);
+    char line[256];
+    size_t len = logFormat(record, line, sizeof(line));
+    CHECK_EQ(len, (size_t)LOG_RECORD_TEXT + 1);
+    CHECK(line[LOG_RECORD_TEXT] == '|');
+
+    // Extra arguments are dropped, missing ones print '?'
+    CHECK(strcmp(packAndFormat("%d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7), "1 2 3 4 5 6 ?") == 0);
+
+    // Output is truncated to the buffer
+    LogRecord small;
+    LogPacker smallPacker(small, "hello %s");
+    logPack(smallPacker, "world");
+    char tiny[8];
+    CHECK_EQ(logFormat(small, tiny, sizeof(tiny)), 7u);
+    CHECK(strcmp(tiny, "hello w") == 0);
+}
+
+static void testMismatchedTypesAreSafe()
+{
+    // A string where an integer is expected must not be dereferenced as one
+    CHECK(strcmp(packAndFormat("%d", "text"), "0") == 0);
+    CHECK(strcmp(packAndFormat("%s", 12), "") == 0);
+    CHECK(strcmp(packAndFormat("%d", 2.9), "2") == 0);
+}
+
+int main()
+{
+    RUN_TEST(testMatchesPrintf);
+    RUN_TEST(testStarPrecisionCopiesOnlyPrintedBytes);
+    RUN_TEST(testStringsAreCopied);
+    RUN_TEST(testLimitsTruncate);
+    RUN_TEST(testMismatchedTypesAreSafe);
+    return testResult();
+}
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <string.h>
+#include <LittleFS.h>
+#include "LoraNode.h"
+#include "MessageStore.h"
+#include "test_util.h"
+
+static NodeMessage makeMessage(uint32_t n, const String &parameters = "text:hello", const char *user = "alice")
+{
+    const String text = parameters + "," + String((unsigned long)n);
+    NodeMessage message;
+    message.set(1700000000000ull + n, StrView(user, strlen(user)), 3, 1000 + n, MSG_OBJECT_MSG, MSG_FUNCTION_SEND,
+                StrView(text.c_str(), text.length()));
+    return message;
+}
+
+// Formats the file system and starts an empty log
+static void freshStore()
+{
+    MessageStore::end();
+    LittleFS.format();
+    MessageStore::begin();
+}
+
+static void reboot()
+{
+    MessageStore::end();
+    MessageStore::begin();
+}
+
+static bool holds(uint32_t seq, uint32_t n)
+{
+    NodeMessage expected = makeMessage(n);
+    NodeMessage message;
+    return MessageStore::read(seq, message) && message.msgId == expected.msgId &&
+           message.user().equals(expected.user()) && message.ttl == expected.ttl &&
+           message.timestamp == expected.timestamp && message.object == expected.object &&
+           message.function == expected.function && message.parameters().equals(expected.parameters());
+}
+
+static void testAppendAndRead()
+{
+    freshStore();
+    CHECK(MessageStore::isPersistent());
+    CHECK_EQ(MessageStore::getNextSeq(), 0u);
+    for (uint32_t n = 0; n < 5; n++)
+    {
+        CHECK_EQ(MessageStore::append(makeMessage(n)), n);
+    }
+    CHECK_EQ(MessageStore::getNextSeq(), 5u);
+    CHECK_EQ(MessageStore::getOldestSeq(), 0u);
+    for (uint32_t n = 0; n < 5; n++)
+    {
+        CHECK(holds(n, n));
+    }
+    MessageRecord record;
+    CHECK(!MessageStore::read(5, record));
+}
+
+static void testLongFieldsAreTruncated()
+{
+    freshStore();
+    String longText;
+    for (int i = 0; i < 400; i++)
+    {
+        longText += (char)('a' + i % 26);
+    }
+    MessageStore::append(makeMessage(0, longText, longText.c_str()));
+
+    MessageRecord record;
+    CHECK(MessageStore::read(0, record));
+    CHECK(record.flags & MESSAGE_FLAG_TRUNCATED);
+    CHECK_EQ(record.field(MESSAGE_FIELD_USER).len, 48u);
+    size_t total = 0;
+    for (int i = 0; i < MESSAGE_FIELD_COUNT; i++)
+    {
+        total += record.field((MessageField)i).len;
+    }
+    CHECK_EQ(total, (size_t)MESSAGE_RECORD_TEXT);
+    CHECK(record.field(MESSAGE_FIELD_PARAMETERS).len > 100);
+    CHECK(memcmp(record.field(MESSAGE_FIELD_PARAMETERS).data, longText.c_str(), 26) == 0);
+}
+
+static void testHistorySurvivesReboot()
+{
+    freshStore();
+    for (uint32_t n = 0; n < 40; n++)
+    {
+        MessageStore::append(makeMessage(n));
+    }
+    reboot();
+    CHECK_EQ(MessageStore::getNextSeq(), 40u);
+    CHECK(holds(0, 0));
+    CHECK(holds(39, 39));
+
+    // Appending carries on in the half-full segment
+    CHECK_EQ(MessageStore::append(makeMessage(40)), 40u);
+    reboot();
+    CHECK_EQ(MessageStore::getNextSeq(), 41u);
+    CHECK(holds(33, 33));
+    CHECK(holds(40, 40));
+}
+
+static void testWrapKeepsTheNewest()
+{
+    freshStore();
+    const uint32_t total = MESSAGE_LOG_CAPACITY + 50;
+    for (uint32_t n = 0; n < total; n++)
+    {
+        MessageStore::append(makeMessage(n));
+    }
+    const uint32_t oldest = MessageStore::getOldestSeq();
+    // The segment being written has dropped what it held one lap ago
+    CHECK_EQ(oldest, (uint32_t)(total - total % MESSAGE_SEGMENT_RECORDS + MESSAGE_SEGMENT_RECORDS - MESSAGE_LOG_CAPACITY));
+    MessageRecord record;
+    CHECK(!MessageStore::read(oldest - 1, record));
+    CHECK(holds(oldest, oldest));
+    CHECK(holds(total - 1, total - 1));
+
+    reboot();
+    CHECK_EQ(MessageStore::getNextSeq(), total);
+    CHECK_EQ(MessageStore::getOldestSeq(), oldest);
+    bool allThere = true;
+    for (uint32_t seq = oldest; seq < total; seq++)
+    {
+        allThere = allThere && holds(seq, seq);
+    }
+    CHECK(allThere);
+}
+
+static void testTornRecordEndsTheSegment()
+{
+    freshStore();
+    for (uint32_t n = 0; n < 10; n++)
+    {
+        MessageStore::append(makeMessage(n));
+    }
+    MessageStore::end();
+    // A reset in the middle of writing record 10
+    File file = LittleFS.open("/msglog/000.bin", "a");
+    const uint8_t partial[100] = {0};
+    file.write(partial, sizeof(partial));
+    file.close();
+
+    MessageStore::begin();
+    CHECK_EQ(MessageStore::getNextSeq(), (uint32_t)MESSAGE_SEGMENT_RECORDS);
+    CHECK(holds(9, 9));
+    MessageRecord record;
+    CHECK(!MessageStore::read(10, record));
+    CHECK_EQ(MessageStore::append(makeMessage(32)), (uint32_t)MESSAGE_SEGMENT_RECORDS);
+    reboot();
+    CHECK(holds(32, 32));
+    CHECK(holds(0, 0));
+}
+
+static void testRamOnlyWithoutFileSystem()
+{
+    freshStore();
+    MessageStore::end();
+    LittleFS.mountFails = true;
+    MessageStore::begin();
+    CHECK(!MessageStore::isPersistent());
+    const uint32_t first = MessageStore::getNextSeq();
+    for (uint32_t n = 0; n < MESSAGE_CACHE_DEPTH + 5; n++)
+    {
+        MessageStore::append(makeMessage(first + n));
+    }
+    const uint32_t next = MessageStore::getNextSeq();
+    CHECK_EQ(MessageStore::getOldestSeq(), next - MESSAGE_CACHE_DEPTH);
+    CHECK(holds(next - 1, next - 1));
+    CHECK(holds(next - MESSAGE_CACHE_DEPTH, next - MESSAGE_CACHE_DEPTH));
+    MessageRecord record;
+    CHECK(!MessageStore::read(next - MESSAGE_CACHE_DEPTH - 1, record));
+    LittleFS.mountFails = false;
+}
+
+static void testUserCredentialsAreNotStored()
+{
+    freshStore();
+    const char *frame = "MSG;1700000000123;alice;0;1000;USER;ADD;name:bob,pwdHash:abc123,token:t0k3n,team:Red";
+    LoraNode::handlePacket(frame, strlen(frame));
+    CHECK_EQ(MessageStore::getNextSeq(), 1u);
+    NodeMessage message;
+    CHECK(MessageStore::read(0, message));
+    CHECK(message.object == MSG_OBJECT_USER);
+    CHECK(message.parameters().equals("name:bob,team:Red"));
+}
+
+static void testRelayedBroadcastIsStoredOnce()
+{
+    freshStore();
+    const char *frame = "BCAST;1700000000456;alice;0;hello";
+    LoraNode::handlePacket(frame, strlen(frame));
+    LoraNode::handlePacket(frame, strlen(frame));
+    CHECK_EQ(MessageStore::getNextSeq(), 1u);
+}
+
+int main()
+{
+    RUN_TEST(testAppendAndRead);
+    RUN_TEST(testLongFieldsAreTruncated);
+    RUN_TEST(testHistorySurvivesReboot);
+    RUN_TEST(testWrapKeepsTheNewest);
+    RUN_TEST(testTornRecordEndsTheSegment);
+    RUN_TEST(testRamOnlyWithoutFileSystem);
+    RUN_TEST(testUserCredentialsAreNotStored);
+    RUN_TEST(testRelayedBroadcastIsStoredOnce);
+    return testResult();
+}
@@ -0,0 +1,106 @@
+#include <string>
+#include "NodeButton.h"
+#include "test_util.h"
+
+// Edges go in through injectEdge(), as the interrupt would queue them; the
+// host pin always reads released
+static std::string drain(NodeButton &button)
+{
+    static const char *const names[] = {"press", "click", "double", "long"};
+    std::string out;
+    ButtonEvent event;
+    while (button.nextEvent(event))
+    {
+        out += out.empty() ? "" : " ";
+        out += names[event];
+    }
+    return out;
+}
+
+static void testClickWaitsForTheDoubleClickWindow()
+{
+    NodeButton button(0);
+    button.injectEdge(true, 1000);
+    button.injectEdge(false, 1100);
+    button.update(1200);
+    CHECK(drain(button) == "press");
+    button.update(1100 + BUTTON_DOUBLE_CLICK_MS + 1);
+    CHECK(drain(button) == "click");
+}
+
+static void testBouncesAreIgnored()
+{
+    NodeButton button(0);
+    button.injectEdge(true, 1000);
+    button.injectEdge(false, 1005);
+    button.injectEdge(true, 1010);
+    button.injectEdge(false, 1300);
+    button.injectEdge(true, 1302);
+    button.injectEdge(false, 1305);
+    button.update(1400);
+    CHECK(drain(button) == "press");
+    CHECK(!button.isPressed());
+    button.update(2000);
+    CHECK(drain(button) == "click");
+}
+
+static void testDoubleClick()
+{
+    NodeButton button(0);
+    button.injectEdge(true, 1000);
+    button.injectEdge(false, 1100);
+    button.injectEdge(true, 1300);
+    button.injectEdge(false, 1400);
+    button.update(1500);
+    button.update(3000);
+    CHECK(drain(button) == "press press double");
+}
+
+static void testLateEventsKeepTheirTiming()
+{
+    // The consumer only looks long after both clicks: they were too far
+    // apart for a double click, which the timestamps still tell
+    NodeButton button(0);
+    button.injectEdge(true, 1000);
+    button.injectEdge(false, 1100);
+    button.injectEdge(true, 2000);
+    button.injectEdge(false, 2100);
+    button.update(5000);
+    CHECK(drain(button) == "press click press click");
+}
+
+static void testLongPress()
+{
+    NodeButton button(0);
+    button.injectEdge(true, 1000);
+    button.injectEdge(false, 1000 + BUTTON_LONG_PRESS_MS + 100);
+    button.update(3000);
+    CHECK(drain(button) == "press long");
+    button.update(5000);
+    CHECK(drain(button).empty());
+}
+
+static void testLostReleaseIsRecovered()
+{
+    NodeButton button(0);
+    button.injectEdge(true, 1000);
+    button.update(1010);
+    CHECK(drain(button).empty());
+    // Settled as pressed, but the pin reads released and no edge came
+    button.update(1100);
+    CHECK(drain(button) == "press");
+    CHECK(!button.isPressed());
+    button.update(2000);
+    CHECK(drain(button) == "click");
+}
+
+int main()
+{
+    RUN_TEST(testClickWaitsForTheDoubleClickWindow);
+    RUN_TEST(testBouncesAreIgnored);
+    RUN_TEST(testDoubleClick);
+    RUN_TEST(testLateEventsKeepTheirTiming);
+    RUN_TEST(testLongPress);
+    RUN_TEST(testLostReleaseIsRecovered);
+    return testResult();
+}
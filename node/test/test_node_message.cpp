@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "NodeMessage.h"
+#include "test_util.h"
+
+static StrView view(const char *text)
+{
+    return StrView(text, strlen(text));
+}
+
+static std::string str(StrView value)
+{
+    return std::string(value.data, value.len);
+}
+
+static void testKnownNamesAreInterned()
+{
+    NodeMessage message;
+    message.set(1700000000123ull, view("alice"), 3, 42, view("USER"), view("ADD"), view("name:bob,team:red"));
+    CHECK_EQ(message.object, MSG_OBJECT_USER);
+    CHECK_EQ(message.function, MSG_FUNCTION_ADD);
+    CHECK(str(message.objectName()) == "USER");
+    CHECK(str(message.functionName()) == "ADD");
+    CHECK(str(message.user()) == "alice");
+    CHECK(str(message.parameters()) == "name:bob,team:red");
+    CHECK_EQ(message.msgId, 1700000000123ull);
+    CHECK_EQ(message.ttl, 3);
+    CHECK_EQ(message.timestamp, 42u);
+    CHECK(!message.truncated);
+}
+
+static void testUnknownNamesKeepTheirText()
+{
+    NodeMessage message;
+    message.set(7, view("carol"), 1, 0, view("PING"), view(""), view("x:1"));
+    CHECK_EQ(message.object, MSG_OBJECT_OTHER);
+    CHECK_EQ(message.function, MSG_FUNCTION_OTHER);
+    CHECK(str(message.objectName()) == "PING");
+    CHECK(message.functionName().empty());
+    CHECK(str(message.user()) == "carol");
+    CHECK(str(message.parameters()) == "x:1");
+}
+
+static void testCopiesAreSelfContained()
+{
+    char user[] = "dave";
+    NodeMessage original;
+    original.set(1, view(user), 2, 0, MSG_OBJECT_BCAST, MSG_FUNCTION_RX, view("hello"));
+    NodeMessage copy = original;
+    user[0] = 'X';
+    original.set(2, view("erin"), 2, 0, MSG_OBJECT_MSG, MSG_FUNCTION_SEND, view("bye"));
+    CHECK(str(copy.user()) == "dave");
+    CHECK(str(copy.parameters()) == "hello");
+    CHECK(str(copy.objectName()) == "BCAST");
+}
+
+static void testLongTextIsTruncated()
+{
+    std::string longText(400, 'p');
+    NodeMessage message;
+    message.set(1, StrView(longText.data(), longText.size()), 300, 0, view("OBJ"), view("FN"),
+                StrView(longText.data(), longText.size()));
+    CHECK(message.truncated);
+    CHECK_EQ(message.ttl, 255);
+    CHECK_EQ(message.user().len, (size_t)NODE_MESSAGE_NAME_MAX);
+    CHECK_EQ(message.user().len + message.objectName().len + message.functionName().len + message.parameters().len,
+             (size_t)NODE_MESSAGE_TEXT);
+
+    message.set(1, view("a"), -4, 0, MSG_OBJECT_MSG, MSG_FUNCTION_SEND, view(""));
+    CHECK(!message.truncated);
+    CHECK_EQ(message.ttl, 0);
+}
+
+static void testIds()
+{
+    char text[24];
+    CHECK_EQ(NodeMessage::parseId(view("1700000000123")), 1700000000123ull);
+    CHECK_EQ(NodeMessage::formatId(1700000000123ull, text, sizeof(text)), 13u);
+    CHECK(strcmp(text, "1700000000123") == 0);
+    CHECK_EQ(NodeMessage::formatId(0, text, sizeof(text)), 1u);
+    CHECK(strcmp(text, "0") == 0);
+    CHECK_EQ(NodeMessage::parseId(view("")), 0ull);
+
+    // Anything that is not a plain decimal id still dedups by value
+    const uint64_t hashed = NodeMessage::parseId(view("M1"));
+    CHECK(hashed >= (1ull << 63));
+    CHECK_EQ(NodeMessage::parseId(view("M1")), hashed);
+    CHECK(NodeMessage::parseId(view("M2")) != hashed);
+    CHECK(NodeMessage::parseId(view("99999999999999999999")) >= (1ull << 63));
+}
+
+int main()
+{
+    RUN_TEST(testKnownNamesAreInterned);
+    RUN_TEST(testUnknownNamesKeepTheirText);
+    RUN_TEST(testCopiesAreSelfContained);
+    RUN_TEST(testLongTextIsTruncated);
+    RUN_TEST(testIds);
+    return testResult();
+}
@@ -0,0 +1,216 @@
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "RingBuffer.h"
+#include "test_util.h"
+
+struct Frame
+{
+    uint32_t producer;
+    uint32_t seq;
+    char payload[24];
+};
+
+static void testSpscFifoOrder()
+{
+    SpscRing<int, 8> ring;
+    CHECK(ring.empty());
+    for (int i = 0; i < 8; i++)
+    {
+        CHECK(ring.push(i));
+    }
+    CHECK(!ring.push(99));
+    CHECK_EQ(ring.size(), 8u);
+    for (int i = 0; i < 8; i++)
+    {
+        int v = -1;
+        CHECK(ring.pop(v));
+        CHECK_EQ(v, i);
+    }
+    int v;
+    CHECK(!ring.pop(v));
+    CHECK(ring.empty());
+}
+
+static void testSpscWrapAround()
+{
+    SpscRing<uint32_t, 4> ring;
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    for (int round = 0; round < 1000; round++)
+    {
+        int n = 1 + round % 4;
+        for (int i = 0; i < n; i++)
+        {
+            CHECK(ring.push(next++));
+        }
+        for (int i = 0; i < n; i++)
+        {
+            uint32_t v = 0;
+            CHECK(ring.pop(v));
+            CHECK_EQ(v, expected++);
+        }
+    }
+    CHECK(ring.empty());
+}
+
+static void testSpscClaimAndFront()
+{
+    SpscRing<Frame, 2> ring;
+    Frame *slot = ring.claim();
+    CHECK(slot != NULL);
+    slot->seq = 7;
+    strcpy(slot->payload, "BEACON;x");
+    CHECK(ring.front() == NULL); // not visible before publish()
+    ring.publish();
+
+    const Frame *head = ring.front();
+    CHECK(head != NULL);
+    CHECK_EQ(head->seq, 7u);
+    CHECK(strcmp(head->payload, "BEACON;x") == 0);
+    // front() does not consume
+    CHECK(ring.front() == head);
+    ring.release();
+    CHECK(ring.front() == NULL);
+
+    CHECK(ring.claim() != NULL);
+    ring.publish();
+    CHECK(ring.claim() != NULL);
+    ring.publish();
+    CHECK(ring.claim() == NULL);
+}
+
+static void testSpscThreaded()
+{
+    static SpscRing<uint32_t, 64> ring;
+    const uint32_t count = 200000;
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            while (!ring.push(i))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t expected = 0;
+    bool ordered = true;
+    while (expected < count)
+    {
+        uint32_t v;
+        if (ring.pop(v))
+        {
+            ordered = ordered && (v == expected);
+            expected++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(ring.empty());
+}
+
+static void testMpscFifoAndFull()
+{
+    MpscRing<int, 4> ring;
+    for (int i = 0; i < 4; i++)
+    {
+        CHECK(ring.push(i));
+    }
+    CHECK(!ring.push(4));
+    CHECK_EQ(ring.size(), 4u);
+    const int *head = ring.front();
+    CHECK(head != NULL && *head == 0);
+    ring.release();
+    CHECK(ring.push(4));
+    for (int i = 1; i <= 4; i++)
+    {
+        int v = -1;
+        CHECK(ring.pop(v));
+        CHECK_EQ(v, i);
+    }
+    int v;
+    CHECK(!ring.pop(v));
+}
+
+static void testMpscThreaded()
+{
+    static MpscRing<Frame, 32> ring;
+    const uint32_t producers = 4;
+    const uint32_t perProducer = 50000;
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        threads.push_back(std::thread([p, perProducer]() {
+            Frame f;
+            memset(&f, 0, sizeof(f));
+            f.producer = p;
+            for (uint32_t i = 0; i < perProducer; i++)
+            {
+                f.seq = i;
+                f.payload[0] = (char)('a' + p);
+                while (!ring.push(f))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+
+    // Every producer's items must arrive complete and in that producer's order
+    std::vector<uint32_t> nextSeq(producers, 0);
+    bool ok = true;
+    uint32_t received = 0;
+    while (received < producers * perProducer)
+    {
+        Frame f;
+        if (!ring.pop(f))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if (f.producer >= producers || f.seq != nextSeq[f.producer] || f.payload[0] != (char)('a' + f.producer))
+        {
+            ok = false;
+        }
+        else
+        {
+            nextSeq[f.producer]++;
+        }
+        received++;
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    CHECK(ok);
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        CHECK_EQ(nextSeq[p], perProducer);
+    }
+    CHECK(ring.empty());
+}
+
+static void testLayout()
+{
+    // Producer and consumer indices must not share a cache line
+    CHECK(alignof(SpscRing<uint8_t, 2>) >= RING_CACHE_LINE);
+    CHECK(sizeof(SpscRing<uint8_t, 2>) >= 3 * RING_CACHE_LINE);
+    CHECK(alignof(MpscRing<uint8_t, 2>) >= RING_CACHE_LINE);
+}
+
+int main()
+{
+    RUN_TEST(testSpscFifoOrder);
+    RUN_TEST(testSpscWrapAround);
+    RUN_TEST(testSpscClaimAndFront);
+    RUN_TEST(testSpscThreaded);
+    RUN_TEST(testMpscFifoAndFull);
+    RUN_TEST(testMpscThreaded);
+    RUN_TEST(testLayout);
+    return testResult();
+}
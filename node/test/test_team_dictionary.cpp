@@ -0,0 +1,85 @@
+#include <string>
+#include "TeamDictionary.h"
+#include "test_util.h"
+
+static std::string teamName(int i)
+{
+    return "Team " + std::to_string(i);
+}
+
+static uint16_t internTeam(const std::string &name)
+{
+    return TeamDictionary::intern(name.c_str(), name.size());
+}
+
+static uint16_t findTeam(const std::string &name)
+{
+    return TeamDictionary::find(name.c_str(), name.size());
+}
+
+// The dictionary is static, so the tests run in order against one instance
+static void testFullDictionaryRejectsNewTeams()
+{
+    for (int i = 0; i < MAX_TEAMS; i++)
+    {
+        CHECK_EQ(internTeam(teamName(i)), (uint16_t)i);
+    }
+    CHECK_EQ(TeamDictionary::getCount(), MAX_TEAMS);
+    CHECK_EQ(internTeam("Late Team"), (uint16_t)TEAM_NONE);
+    // Known teams still resolve
+    CHECK_EQ(internTeam(" team 7 "), (uint16_t)7);
+}
+
+static void testCollectFreesUnreferencedTeams()
+{
+    bool referenced[MAX_TEAMS] = {false};
+    for (int i = 0; i < MAX_TEAMS; i += 2)
+    {
+        referenced[i] = true;
+    }
+    referenced[MAX_TEAMS - 1] = true;
+    CHECK_EQ(TeamDictionary::collect(referenced), MAX_TEAMS / 2 - 1);
+    CHECK_EQ(TeamDictionary::getCount(), MAX_TEAMS);
+
+    // Kept teams keep their ID, name and slug
+    CHECK_EQ(findTeam("team 10"), (uint16_t)10);
+    CHECK(std::string(TeamDictionary::name(10)) == "Team 10");
+    CHECK_EQ(TeamDictionary::findBySlug("team-10"), (uint16_t)10);
+    CHECK_EQ(findTeam(teamName(MAX_TEAMS - 1)), (uint16_t)(MAX_TEAMS - 1));
+
+    // Freed teams are gone from both indexes
+    CHECK_EQ(findTeam("Team 11"), (uint16_t)TEAM_NONE);
+    CHECK_EQ(TeamDictionary::findBySlug("team-11"), (uint16_t)TEAM_NONE);
+    CHECK(std::string(TeamDictionary::name(11)).empty());
+}
+
+static void testFreedIdsAreReused()
+{
+    CHECK_EQ(internTeam("Late Team"), (uint16_t)1);
+    CHECK_EQ(TeamDictionary::findBySlug("late_team"), (uint16_t)1);
+    CHECK_EQ(internTeam("Other Team"), (uint16_t)3);
+    CHECK_EQ(TeamDictionary::getCount(), MAX_TEAMS);
+}
+
+static void testCollectShrinksTheIdRange()
+{
+    bool referenced[MAX_TEAMS] = {false};
+    referenced[0] = true;
+    referenced[3] = true;
+    TeamDictionary::collect(referenced);
+    CHECK_EQ(TeamDictionary::getCount(), 4);
+    CHECK_EQ(findTeam("Other Team"), (uint16_t)3);
+    CHECK_EQ(internTeam("New Team"), (uint16_t)1);
+    CHECK_EQ(internTeam("Newer Team"), (uint16_t)2);
+    CHECK_EQ(internTeam("Newest Team"), (uint16_t)4);
+    CHECK_EQ(TeamDictionary::getCount(), 5);
+}
+
+int main()
+{
+    RUN_TEST(testFullDictionaryRejectsNewTeams);
+    RUN_TEST(testCollectFreesUnreferencedTeams);
+    RUN_TEST(testFreedIdsAreReused);
+    RUN_TEST(testCollectShrinksTheIdRange);
+    return testResult();
+}
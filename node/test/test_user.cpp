@@ -0,0 +1,182 @@
+#include <string>
+#include "TeamDictionary.h"
+#include "User.h"
+#include "test_util.h"
+
+// The user table is static: every test starts from an empty table and NVS
+static void freshUsers()
+{
+    Preferences::wipeAll();
+    User::clearUsers();
+}
+
+static std::string entry(const std::string &name, const char *password, const char *team)
+{
+    return name + "|" + User::hashPassword(password).c_str() + "|" + team + ";";
+}
+
+static String payloadOf(const std::string &text)
+{
+    return String(text.c_str());
+}
+
+static std::string tokenOf(const char *name)
+{
+    return User::getUserByName(name).token();
+}
+
+static void testLookupByNameAndToken()
+{
+    freshUsers();
+    CHECK(User::setUsersFromSyncPayload(payloadOf(entry("Alice", "pw1", "Red") + entry("bob", "pw2", "Blue"))));
+    CHECK_EQ(User::getUserCount(), 2);
+
+    const NodeUser &alice = User::getUserByName("alice");
+    CHECK(User::exists(alice));
+    CHECK(std::string(alice.username()) == "Alice");
+    CHECK(std::string(alice.team()) == "Red");
+    CHECK(User::exists(User::getUserByName("ALICE")));
+    CHECK(!User::exists(User::getUserByName("alic")));
+
+    const std::string token = alice.token();
+    CHECK(!token.empty());
+    CHECK(&User::getUserBySession(String(token.c_str())) == &alice);
+    // Tokens are not case-folded
+    std::string upper = token;
+    for (size_t i = 0; i < upper.size(); i++)
+    {
+        upper[i] = (char)toupper((unsigned char)upper[i]);
+    }
+    if (upper != token)
+    {
+        CHECK(!User::exists(User::getUserBySession(String(upper.c_str()))));
+    }
+    CHECK(!User::exists(User::getUserBySession("")));
+
+    CHECK(User::isValidLogin("ALICE", User::hashPassword("pw1")));
+    CHECK(!User::isValidLogin("alice", User::hashPassword("pw2")));
+}
+
+static void testDuplicateNames()
+{
+    freshUsers();
+    CHECK(User::setUsersFromSyncPayload(payloadOf(entry("carol", "first", "Red") + entry("Carol", "second", "Blue"))));
+    // The first entry wins the lookups
+    CHECK(std::string(User::getUserByName("CAROL").team()) == "Red");
+    CHECK(User::isValidLogin("carol", User::hashPassword("first")));
+    CHECK(!User::isValidLogin("carol", User::hashPassword("second")));
+
+    // Registering a known name, in any case, adds nobody
+    const int count = User::getUserCount();
+    CHECK(User::registerUser("CAROL", User::hashPassword("third"), "Green"));
+    CHECK_EQ(User::getUserCount(), count);
+    CHECK(!User::isValidLogin("carol", User::hashPassword("third")));
+}
+
+static void testSyncKeepsTokens()
+{
+    freshUsers();
+    CHECK(User::setUsersFromSyncPayload(payloadOf(entry("dave", "pw", "Red") + entry("erin", "pw", "Red"))));
+    const std::string dave = tokenOf("dave");
+    const std::string erin = tokenOf("erin");
+
+    CHECK(User::setUsersFromSyncPayload(payloadOf(entry("DAVE", "new", "Blue") + entry("frank", "pw", "Blue"))));
+    CHECK_EQ(User::getUserCount(), 2);
+    // dave keeps his session across the swap, with the synced hash and team
+    const NodeUser &kept = User::getUserBySession(String(dave.c_str()));
+    CHECK(User::exists(kept));
+    CHECK(std::string(kept.username()) == "DAVE");
+    CHECK(std::string(kept.team()) == "Blue");
+    CHECK(User::isValidLogin("dave", User::hashPassword("new")));
+    // erin is gone, and so is her session
+    CHECK(!User::exists(User::getUserBySession(String(erin.c_str()))));
+    CHECK(!User::exists(User::getUserByName("erin")));
+    CHECK(!tokenOf("frank").empty());
+}
+
+static void testUnparsableHashIsRejected()
+{
+    freshUsers();
+    CHECK(User::setUsersFromSyncPayload("admin|null|Red;blank||Red;" + payloadOf(entry("gina", "pw", "Red"))));
+    CHECK_EQ(User::getUserCount(), 1);
+    CHECK(!User::exists(User::getUserByName("admin")));
+    CHECK(!User::isValidLogin("admin", User::hashPassword("null")));
+    CHECK(!User::isValidLogin("blank", User::hashPassword("")));
+    CHECK(!User::registerUserWithToken("hank", "plaintext", "Red", "tok"));
+    CHECK(!User::exists(User::getUserByName("hank")));
+}
+
+static void testNvsRoundTripAcrossBlobs()
+{
+    freshUsers();
+    const int users = USERS_PER_NVS_BLOB + 8;
+    std::string payload;
+    for (int i = 0; i < users; i++)
+    {
+        payload += entry("user" + std::to_string(i), ("pw" + std::to_string(i)).c_str(), i % 2 ? "Odd" : "Even");
+    }
+    CHECK(User::setUsersFromSyncPayload(payloadOf(payload)));
+    CHECK_EQ(User::getUserCount(), users);
+    std::string tokens[USERS_PER_NVS_BLOB + 8];
+    for (int i = 0; i < users; i++)
+    {
+        tokens[i] = tokenOf(("user" + std::to_string(i)).c_str());
+    }
+
+    // The sync saved to NVS; a cleared table loads back from it
+    User::clearUsers();
+    CHECK_EQ(User::getUserCount(), 0);
+    User::loadUsersNVS();
+    CHECK_EQ(User::getUserCount(), users);
+    for (int i = 0; i < users; i++)
+    {
+        const std::string name = "user" + std::to_string(i);
+        const NodeUser &user = User::getUserBySession(String(tokens[i].c_str()));
+        CHECK(User::exists(user));
+        CHECK(std::string(user.username()) == name);
+        CHECK(std::string(user.team()) == (i % 2 ? "Odd" : "Even"));
+        CHECK(User::isValidLogin(name.c_str(), User::hashPassword(("pw" + std::to_string(i)).c_str())));
+    }
+}
+
+static std::string teamPayload(const char *prefix, int teams)
+{
+    std::string payload;
+    for (int i = 0; i < teams; i++)
+    {
+        const std::string id = std::to_string(i);
+        payload += entry(prefix + id, "pw", (std::string(prefix) + "team" + id).c_str());
+    }
+    return payload;
+}
+
+static void testTeamLimit()
+{
+    freshUsers();
+    // A full dictionary of teams, then a sync replacing every one of them
+    CHECK(User::setUsersFromSyncPayload(payloadOf(teamPayload("a", MAX_TEAMS))));
+    CHECK(std::string(User::getUserByName("a0").team()) == "ateam0");
+    CHECK(User::setUsersFromSyncPayload(payloadOf(teamPayload("b", MAX_TEAMS))));
+    CHECK_EQ(User::getUserCount(), MAX_TEAMS);
+    const std::string last = "b" + std::to_string(MAX_TEAMS - 1);
+    CHECK(std::string(User::getUserByName(last.c_str()).team()) == "bteam" + std::to_string(MAX_TEAMS - 1));
+
+    // Past the limit users are still added, without a team
+    CHECK(User::setUsersFromSyncPayload(payloadOf(teamPayload("c", MAX_TEAMS + 1))));
+    CHECK_EQ(User::getUserCount(), MAX_TEAMS + 1);
+    CHECK(std::string(User::getUserByName("c0").team()) == "cteam0");
+    const std::string extra = "c" + std::to_string(MAX_TEAMS);
+    CHECK(User::exists(User::getUserByName(extra.c_str())));
+    CHECK_EQ(User::getUserByName(extra.c_str()).teamId, TEAM_NONE);
+}
+
+int main()
+{
+    RUN_TEST(testLookupByNameAndToken);
+    RUN_TEST(testDuplicateNames);
+    RUN_TEST(testSyncKeepsTokens);
+    RUN_TEST(testUnparsableHashIsRejected);
+    RUN_TEST(testNvsRoundTripAcrossBlobs);
+    RUN_TEST(testTeamLimit);
+    return testResult();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+
+// Minimal assertion helpers for the host tests; no framework needed
+static int testFailures = 0;
+
+#define CHECK(cond)                                                        \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            testFailures++;                                                \
+        }                                                                  \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+
+#define RUN_TEST(fn)                        \
+    do                                      \
+    {                                       \
+        int before = testFailures;          \
+        fn();                               \
+        printf("%s %s\n", testFailures == before ? "[ OK ]" : "[FAIL]", #fn); \
+    } while (0)
+
+static inline int testResult()
+{
+    if (testFailures != 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", testFailures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Writes the node's streamed capture (CAPTURE;ON) to a PCAP file that
+// Wireshark opens with the LoRaTap dissector, like the node's /debug/pcap.
+//
+// Line format: CAP;<seq>;<RX|TX>;<time us since boot>;<rssi>;<snr>;<airtime us>;<hex payload>
+const fs = require('fs');
+
+const LINKTYPE_LORATAP = 270;
+const LORATAP_HEADER_SIZE = 15;
+// Must match LORA_* in node/lora_node/LoraNode.h
+const RADIO = { frequencyHz: 868000000, bandwidthKhz: 125, spreadingFactor: 9, syncWord: 0x12 };
+
+function parseCaptureLine(line) {
+  const parts = line.trim().split(';');
+  if (parts[0] !== 'CAP' || parts.length !== 8) return null;
+  const [seq, timestampUs, rssi, airtimeUs] = [parts[1], parts[3], parts[4], parts[6]].map(Number);
+  const snr = Number(parts[5]);
+  const hex = parts[7];
+  if (parts[2] !== 'RX' && parts[2] !== 'TX') return null;
+  if (![seq, timestampUs, rssi, airtimeUs].every(Number.isInteger) || Number.isNaN(snr)) return null;
+  if (hex.length % 2 !== 0 || !/^[0-9a-f]*$/i.test(hex)) return null;
+  return { seq, direction: parts[2], timestampUs, rssi, snr, airtimeUs, payload: Buffer.from(hex, 'hex') };
+}
+
+function pcapHeader() {
+  const header = Buffer.alloc(24);
+  header.writeUInt32LE(0xa1b2c3d4, 0);
+  header.writeUInt16LE(2, 4);
+  header.writeUInt16LE(4, 6);
+  header.writeUInt32LE(LORATAP_HEADER_SIZE + 255, 16);
+  header.writeUInt32LE(LINKTYPE_LORATAP, 20);
+  return header;
+}
+
+// Same fields PacketCapture.cpp writes; TX frames get packet RSSI 0
+function loraTapHeader(entry) {
+  const header = Buffer.alloc(LORATAP_HEADER_SIZE);
+  const packetRssi = entry.direction === 'RX' ? Math.min(255, Math.max(0, entry.rssi + 139)) : 0;
+  header.writeUInt16BE(LORATAP_HEADER_SIZE, 2);
+  header.writeUInt32BE(RADIO.frequencyHz, 4);
+  header.writeUInt8(RADIO.bandwidthKhz / 125, 8);
+  header.writeUInt8(RADIO.spreadingFactor, 9);
+  header.writeUInt8(packetRssi, 10);
+  header.writeUInt8(packetRssi, 11);
+  header.writeInt8(Math.max(-128, Math.min(127, Math.round(entry.snr * 4))), 13);
+  header.writeUInt8(RADIO.syncWord, 14);
+  return header;
+}
+
+// timeUs is the record timestamp in microseconds since the epoch
+function pcapRecord(entry, timeUs) {
+  const record = Buffer.alloc(16);
+  const length = LORATAP_HEADER_SIZE + entry.payload.length;
+  record.writeUInt32LE(Math.floor(timeUs / 1e6), 0);
+  record.writeUInt32LE(timeUs % 1e6, 4);
+  record.writeUInt32LE(length, 8);
+  record.writeUInt32LE(length, 12);
+  return Buffer.concat([record, loraTapHeader(entry), entry.payload]);
+}
+
+class CaptureWriter {
+  // Node timestamps count from boot; they are anchored to the wall clock at
+  // the first line after construction or reset()
+  constructor(path, { now = () => Date.now() } = {}) {
+    this.path = path;
+    this.now = now;
+    this.anchorUs = null;
+    this.lastUs = 0;
+    this.written = 0;
+  }
+
+  reset() {
+    this.anchorUs = null;
+  }
+
+  handleLine(line) {
+    const entry = parseCaptureLine(line);
+    if (!entry) return false;
+    if (this.anchorUs === null || entry.timestampUs + this.anchorUs < this.lastUs) {
+      this.anchorUs = this.now() * 1000 - entry.timestampUs;
+    }
+    this.lastUs = entry.timestampUs + this.anchorUs;
+    if (!fs.existsSync(this.path) || fs.statSync(this.path).size === 0) {
+      fs.writeFileSync(this.path, pcapHeader());
+    }
+    fs.appendFileSync(this.path, pcapRecord(entry, this.lastUs));
+    this.written++;
+    return true;
+  }
+}
+
+module.exports = { CaptureWriter, parseCaptureLine, pcapHeader, pcapRecord };
@@ -8,14 +8,22 @@ const axios = require('axios');
 const bodyParser = require('body-parser');
 const os = require('os');
 const { selectSerialPort } = require('./serialConfig');
+const { SerialLink } = require('./serialLink');
+const { TxFlowController } = require('./txFlow');
+const { parseMetricsResponse } = require('./metrics');
+const { CaptureWriter } = require('./capture');
 
 const app = express();
 const PORT = process.env.PORT || 3002;
 const BACKEND_URL = process.env.BACKEND_URL || 'http://backend:3001';
 const SERIAL_PORT = process.env.SERIAL_PORT || '';
-const SERIAL_BAUD = Number(process.env.SERIAL_BAUD || '115200');
+const SERIAL_BAUD = Number(process.env.SERIAL_BAUD || '921600');
+// 'slip' for the framed link (node built with SERIAL_LINK_FRAMED=1), 'text' for plain lines
+const SERIAL_FRAMING = (process.env.SERIAL_FRAMING || 'slip').toLowerCase();
 
 let serialPort = null;
+let serialLink = null;
+let txFlow = null;
 let isConnected = false;
 const connectedNodes = new Map();
 const lastSent = new Map();
@@ -24,21 +32,23 @@ const PING_INTERVAL_MS = 60 * 1000;
 const RESPONSE_RETRY_COUNT = 1;
 const PAGES_RESPONSE_RETRY_COUNT = 6;
 const USERS_RESPONSE_RETRY_COUNT = 1; // Reduced from 5 to 1 (was sending 790 packets!)
-const RESPONSE_RETRY_DELAY_MS = 1500;
-const PAGES_RESPONSE_DELAY_MS = 4000;
-const USERS_RESPONSE_DELAY_MS = 6000;
-const RESPONSE_INITIAL_DELAY_MS = 800;
 const PAGES_RESPONSE_INITIAL_DELAY_MS = 5000;
 const USERS_RESPONSE_INITIAL_DELAY_MS = 6000;
 const USERS_RESPONSE_RETRY_DELAY_MS = 10000;
 const USERS_PART_REPEAT = 1; // Reduced from 2 to 1 (was sending 790 packets!)
-const USERS_PART_REPEAT_DELAY_MS = 1500;
 const PAGES_RESPONSE_RETRY_DELAY_MS = 12000;
 const PAGES_PART_REPEAT = 2;
-const PAGES_PART_REPEAT_DELAY_MS = 1200;
 const USERS_SYNC_MAX_CHUNK = 60;
 const PAGES_SYNC_MAX_CHUNK = 40;
-let pagesSendingUntil = 0;
+// Sync parts are paced by the node's TXDONE reports; these only apply to
+// firmware that does not send them
+const TX_MAX_IN_FLIGHT = Number(process.env.TX_MAX_IN_FLIGHT || '2');
+const TX_FALLBACK_DELAY_MS = 1500;
+const TX_COMPLETION_TIMEOUT_MS = 10000;
+// Frames the node streams after CAPTURE;ON are appended here as PCAP
+const CAPTURE_PCAP = process.env.CAPTURE_PCAP || '';
+const captureWriter = CAPTURE_PCAP ? new CaptureWriter(CAPTURE_PCAP) : null;
+let pagesSending = false;
 
 const sleep = (ms) => new Promise(resolve => setTimeout(resolve, ms));
 
@@ -116,16 +126,37 @@ async function initializeGateway() {
       parity: 'none'
     });
     
-    const parser = serialPort.pipe(new ReadlineParser({ delimiter: '\n' }));
+    if (SERIAL_FRAMING === 'slip') {
+      // Protocol frames and node logs arrive on separate channels
+      serialLink = new SerialLink({ write: (buf) => serialPort.write(buf) });
+      serialPort.on('data', (chunk) => serialLink.handleData(chunk));
+      serialLink.on('proto', (line) => handleLoRaMessage(line));
+      serialLink.on('log', (line) => console.log(`[NODE LOG] ${line}`));
+      serialLink.on('reset', () => {
+        console.log('[LoraGateway] Node restarted, serial link resynced');
+        txFlow.reset();
+        if (captureWriter) captureWriter.reset();
+      });
+    } else {
+      const parser = serialPort.pipe(new ReadlineParser({ delimiter: '\n' }));
+
+      // Handle incoming LoRa messages from device
+      parser.on('data', async (data) => {
+        handleLoRaMessage(data);
+      });
+    }
     
-    // Handle incoming LoRa messages from device
-    parser.on('data', async (data) => {
-      handleLoRaMessage(data);
+    txFlow = new TxFlowController({
+      send: sendSerialRaw,
+      maxInFlight: TX_MAX_IN_FLIGHT,
+      completionTimeoutMs: TX_COMPLETION_TIMEOUT_MS,
+      fallbackDelayMs: TX_FALLBACK_DELAY_MS
     });
-    
+
     serialPort.on('open', () => {
-      console.log('[LoraGateway] ✅ Serial connection opened');
+      console.log(`[LoraGateway] ✅ Serial connection opened (${SERIAL_FRAMING}, ${SERIAL_BAUD} baud)`);
       isConnected = true;
+      if (serialLink) serialLink.start();
     });
     
     serialPort.on('error', (err) => {
@@ -141,7 +172,7 @@ async function initializeGateway() {
 
 async function schedulePings() {
   try {
-    if (Date.now() < pagesSendingUntil) {
+    if (pagesSending) {
       return;
     }
     const res = await axios.get(`${BACKEND_URL}/api/nodes`);
@@ -166,6 +197,20 @@ async function handleLoRaMessage(data) {
   try {
     const message = data.trim();
     if (!message) return;
+
+    // Radio progress reports; too frequent to log
+    if (message.startsWith('TXDONE;')) {
+      if (txFlow) txFlow.handleTxDone(message);
+      return;
+    }
+
+    // Streamed packet capture
+    if (message.startsWith('CAP;')) {
+      if (captureWriter && !captureWriter.handleLine(message)) {
+        console.warn('[CAPTURE] Unreadable capture line');
+      }
+      return;
+    }
     
     console.log(`[LoRa RX] ${message}`);
 
@@ -174,6 +219,20 @@ async function handleLoRaMessage(data) {
       return;
     }
 
+    // Frames the attached node transmitted itself; only its beacon matters here
+    if (message.startsWith('LORA_TX;')) {
+      const frame = message.substring('LORA_TX;'.length);
+      if (frame.startsWith('BEACON;')) {
+        await handleBeacon(frame);
+      }
+      return;
+    }
+
+    if (message.startsWith('OFFLINE;')) {
+      handleOffline(message);
+      return;
+    }
+
     if (message.startsWith('REQ;USERS;')) {
       const nodeId = message.split(';')[2] || '';
       await handleUsersRequest(nodeId);
@@ -186,6 +245,11 @@ async function handleLoRaMessage(data) {
       return;
     }
 
+    if (message.startsWith('RESP;METRICS;')) {
+      handleMetricsResponse(message);
+      return;
+    }
+
     if (message.startsWith('RESP;STATS;')) {
       await handleStatsResponse(message);
       return;
@@ -231,6 +295,12 @@ async function sendSerialRaw(packet) {
     console.log('[LoraGateway] Serial not connected, skipping transmission');
     return false;
   }
+  if (serialLink) {
+    // Resolves once the node has handled the frame
+    const ok = await serialLink.send(packet);
+    console.log(ok ? `[LoRa TX] ${packet}` : `[LoRa TX ERROR] Node did not ack: ${packet}`);
+    return ok;
+  }
   return new Promise((resolve) => {
     serialPort.write(packet + '\n', (err) => {
       if (err) {
@@ -244,6 +314,12 @@ async function sendSerialRaw(packet) {
   });
 }
 
+// Queues a sync frame as soon as the node's radio has room for it
+async function sendSyncFrame(packet) {
+  if (!txFlow) return sendSerialRaw(packet);
+  return txFlow.send(packet);
+}
+
 async function handleUsersRequest(nodeId) {
   try {
     const res = await axios.get(`${BACKEND_URL}/api/sync/users`);
@@ -254,16 +330,15 @@ async function handleUsersRequest(nodeId) {
     await sleep(USERS_RESPONSE_INITIAL_DELAY_MS);
     for (let attempt = 0; attempt < USERS_RESPONSE_RETRY_COUNT; attempt++) {
       if (chunks.length === 0) {
-        await sendSerialRaw('LORA_TX;RESP;USERS;');
+        await sendSyncFrame('LORA_TX;RESP;USERS;');
       } else {
         for (let i = 0; i < chunks.length; i += 1) {
           for (let r = 0; r < USERS_PART_REPEAT; r += 1) {
-            await sendSerialRaw(`LORA_TX;RESP;USERS;PART;${i + 1};${total};${chunks[i]}`);
-            await sleep(USERS_PART_REPEAT_DELAY_MS);
+            await sendSyncFrame(`LORA_TX;RESP;USERS;PART;${i + 1};${total};${chunks[i]}`);
           }
-          await sleep(USERS_RESPONSE_DELAY_MS);
         }
       }
+      if (txFlow) await txFlow.drain();
       if (attempt < USERS_RESPONSE_RETRY_COUNT - 1) {
         await sleep(USERS_RESPONSE_RETRY_DELAY_MS);
       }
@@ -280,18 +355,11 @@ async function handlePagesRequest(nodeId) {
   try {
     const res = await axios.get(`${BACKEND_URL}/api/sync/pages`, { params: { nodeId } });
     const pages = res.data.pages || [];
-    let totalParts = 0;
-    for (const page of pages) {
-      const htmlEncoded = encodeURIComponent(page.html || '');
-      const parts = chunkPayloadByLength(htmlEncoded, PAGES_SYNC_MAX_CHUNK);
-      totalParts += (parts.length || 1);
-    }
-    const estimatedDurationMs = PAGES_RESPONSE_INITIAL_DELAY_MS + (totalParts * PAGES_RESPONSE_RETRY_COUNT * PAGES_RESPONSE_DELAY_MS) + 2000;
-    pagesSendingUntil = Date.now() + estimatedDurationMs;
+    pagesSending = true;
     await sleep(PAGES_RESPONSE_INITIAL_DELAY_MS);
     for (let attempt = 0; attempt < PAGES_RESPONSE_RETRY_COUNT; attempt++) {
       if (pages.length === 0) {
-        await sendSerialRaw('LORA_TX;RESP;PAGE;');
+        await sendSyncFrame('LORA_TX;RESP;PAGE;');
         continue;
       }
       for (const page of pages) {
@@ -303,12 +371,11 @@ async function handlePagesRequest(nodeId) {
         const sendParts = parts.length ? parts : [''];
         for (let i = 0; i < sendParts.length; i += 1) {
           for (let r = 0; r < PAGES_PART_REPEAT; r += 1) {
-            await sendSerialRaw(`LORA_TX;RESP;PAGE;${teamEncoded};${i + 1};${total};${updatedEncoded};${sendParts[i]}`);
-            await sleep(PAGES_PART_REPEAT_DELAY_MS);
+            await sendSyncFrame(`LORA_TX;RESP;PAGE;${teamEncoded};${i + 1};${total};${updatedEncoded};${sendParts[i]}`);
           }
-          await sleep(PAGES_RESPONSE_DELAY_MS);
         }
       }
+      if (txFlow) await txFlow.drain();
       if (attempt < PAGES_RESPONSE_RETRY_COUNT - 1) {
         await sleep(PAGES_RESPONSE_RETRY_DELAY_MS);
       }
@@ -317,6 +384,8 @@ async function handlePagesRequest(nodeId) {
     await axios.post(`${BACKEND_URL}/api/nodes/register`, { nodeId });
   } catch (error) {
     console.error('[Pages Sync] Error:', error.message);
+  } finally {
+    pagesSending = false;
   }
 }
 
@@ -446,8 +515,22 @@ async function handleBeacon(message) {
   }
 }
 
+function handleMetricsResponse(message) {
+  const parsed = parseMetricsResponse(message);
+  if (!parsed) {
+    console.warn('[METRICS] Unreadable metrics response');
+    return;
+  }
+  const existing = connectedNodes.get(parsed.nodeId) || { nodeId: parsed.nodeId };
+  connectedNodes.set(parsed.nodeId, {
+    ...existing,
+    metrics: parsed.metrics,
+    metricsAt: new Date()
+  });
+}
+
 function handleOffline(message) {
-  const match = message.match(/Offline:\s*(\S+)/);
+  const match = message.match(/(?:Offline:\s*|^OFFLINE;)(\S+)/);
   const nodeId = match?.[1];
   if (!nodeId) return;
 
@@ -467,6 +550,9 @@ async function sendToLoRa(packet) {
   }
   
   try {
+    if (serialLink) {
+      return await sendSerialRaw(packet);
+    }
     serialPort.write(packet + '\n', (err) => {
       if (err) {
         console.error('[LoRa TX ERROR]', err.message);
@@ -522,6 +608,8 @@ app.get('/health', (req, res) => {
     status: 'ok',
     service: 'LoraGateway',
     serialConnected: isConnected,
+    serialLink: serialLink ? serialLink.stats : null,
+    txFlow: txFlow ? txFlow.stats : null,
     connectedNodes: connectedNodes.size,
     hostname: os.hostname()
   });
@@ -586,6 +674,12 @@ app.get('/nodes', (req, res) => {
 // ============ ERROR HANDLING ============
 process.on('SIGINT', () => {
   console.log('\n[LoraGateway] Shutting down...');
+  if (txFlow) {
+    txFlow.close();
+  }
+  if (serialLink) {
+    serialLink.close();
+  }
   if (serialPort && serialPort.isOpen) {
     serialPort.close();
   }
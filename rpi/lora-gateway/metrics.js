@@ -0,0 +1,80 @@
+// Decodes the compact RESP;METRICS;<node>;<base64> reply (see node Metrics.h).
+//
+// The payload is a version byte followed by (id, LEB128 varint) pairs; metrics
+// that are zero are left out. Ids must stay in step with the node's enums.
+const COMPACT_VERSION = 1;
+
+const COUNTERS = [
+  'rxDropped', 'rxErrors', 'txFailed', 'txQueueFull', 'airtimeMs',
+  'dedupHits', 'relayed', 'syncPartsReceived', 'syncPartsLost', 'httpRequests',
+  'sleepMs', 'displayFrames', 'relaySkipped'
+];
+const GAUGES = ['heapFree', 'heapMinFree', 'heapLargestBlock', 'onlineNodes', 'uptimeS', 'cpuMhz', 'batteryMv', 'dutyMode'];
+const HISTOGRAMS = ['httpMs', 'loopUs'];
+const PACKET_TYPES = [
+  'unknown', 'req_stats', 'resp_users_part', 'resp_users', 'resp_pages_part',
+  'resp_page', 'resp_pages', 'ping', 'pong', 'ack', 'bcast', 'beacon', 'msg',
+  'req_metrics', 'resp_metrics'
+];
+
+const ID_GAUGE = 64;
+const ID_RX_TYPE = 128;
+const ID_TX_TYPE = 160;
+const ID_HIST_COUNT = 200;
+const ID_HIST_SUM = 216;
+
+function emptyMetrics() {
+  const metrics = { counters: {}, gauges: {}, histograms: {}, rxByType: {}, txByType: {} };
+  COUNTERS.forEach((name) => { metrics.counters[name] = 0; });
+  GAUGES.forEach((name) => { metrics.gauges[name] = 0; });
+  HISTOGRAMS.forEach((name) => { metrics.histograms[name] = { count: 0, sum: 0 }; });
+  return metrics;
+}
+
+function assign(metrics, id, value) {
+  if (id < ID_GAUGE) {
+    if (id < COUNTERS.length) metrics.counters[COUNTERS[id]] = value;
+  } else if (id < ID_RX_TYPE) {
+    const name = GAUGES[id - ID_GAUGE];
+    if (name) metrics.gauges[name] = value;
+  } else if (id < ID_TX_TYPE) {
+    metrics.rxByType[PACKET_TYPES[id - ID_RX_TYPE] || `type${id - ID_RX_TYPE}`] = value;
+  } else if (id < ID_HIST_COUNT) {
+    metrics.txByType[PACKET_TYPES[id - ID_TX_TYPE] || `type${id - ID_TX_TYPE}`] = value;
+  } else {
+    const sum = id >= ID_HIST_SUM;
+    const name = HISTOGRAMS[id - (sum ? ID_HIST_SUM : ID_HIST_COUNT)];
+    if (name) metrics.histograms[name][sum ? 'sum' : 'count'] = value;
+  }
+}
+
+// Returns null if the payload is not a compact metrics blob we understand
+function decodeCompact(bytes) {
+  if (!bytes.length || bytes[0] !== COMPACT_VERSION) return null;
+  const metrics = emptyMetrics();
+  let offset = 1;
+  while (offset < bytes.length) {
+    const id = bytes[offset++];
+    let value = 0;
+    let shift = 0;
+    let byte;
+    do {
+      if (offset >= bytes.length || shift > 28) return null;
+      byte = bytes[offset++];
+      value += (byte & 0x7f) * 2 ** shift;
+      shift += 7;
+    } while (byte & 0x80);
+    assign(metrics, id, value);
+  }
+  return metrics;
+}
+
+// "RESP;METRICS;<node>;<base64>" -> { nodeId, metrics } or null
+function parseMetricsResponse(line) {
+  const match = /^RESP;METRICS;([^;]*);([A-Za-z0-9+/=]*)$/.exec(line.trim());
+  if (!match) return null;
+  const metrics = decodeCompact(Buffer.from(match[2], 'base64'));
+  return metrics ? { nodeId: match[1], metrics } : null;
+}
+
+module.exports = { decodeCompact, parseMetricsResponse };
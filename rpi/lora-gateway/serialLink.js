@@ -0,0 +1,279 @@
+// Framed serial link to the attached node (node/lora_node/SerialLink.h).
+//
+// Frame (before SLIP escaping, delimited by 0xC0):
+//   [channel][seq][ack][payload ...][crc16 hi][crc16 lo]
+// CRC-16/CCITT-FALSE over everything before it. seq 0 = unsequenced.
+// Gateway -> node protocol frames are go-back-N with a send window; the node
+// acks the last frame it handled. Node -> gateway frames are numbered so we
+// can count what got lost, but they are not retransmitted.
+const { EventEmitter } = require('events');
+
+const SLIP_END = 0xc0;
+const SLIP_ESC = 0xdb;
+const SLIP_ESC_END = 0xdc;
+const SLIP_ESC_ESC = 0xdd;
+
+const CHANNEL = { CONTROL: 0, PROTO: 1, LOG: 2 };
+const CTRL_HELLO = 0x48; // 'H'
+const CTRL_ACK = 0x41; // 'A'
+
+const HEADER_LEN = 3;
+const CRC_LEN = 2;
+
+function crc16(buf) {
+  let crc = 0xffff;
+  for (const byte of buf) {
+    crc ^= byte << 8;
+    for (let bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) & 0xffff : (crc << 1) & 0xffff;
+    }
+  }
+  return crc;
+}
+
+function nextSeq(seq) {
+  return seq === 255 ? 1 : seq + 1;
+}
+
+function encodeFrame({ channel, seq = 0, ack = 0, payload = Buffer.alloc(0) }) {
+  const body = Buffer.concat([Buffer.from([channel, seq, ack]), Buffer.from(payload)]);
+  const crc = crc16(body);
+  return Buffer.concat([body, Buffer.from([crc >> 8, crc & 0xff])]);
+}
+
+// Returns null when the frame is too short or the CRC does not match
+function decodeFrame(frame) {
+  if (frame.length < HEADER_LEN + CRC_LEN) return null;
+  const bodyLen = frame.length - CRC_LEN;
+  const expected = (frame[bodyLen] << 8) | frame[bodyLen + 1];
+  if (crc16(frame.subarray(0, bodyLen)) !== expected) return null;
+  return {
+    channel: frame[0],
+    seq: frame[1],
+    ack: frame[2],
+    payload: frame.subarray(HEADER_LEN, bodyLen)
+  };
+}
+
+function slipEncode(frame) {
+  const out = [SLIP_END];
+  for (const byte of frame) {
+    if (byte === SLIP_END) out.push(SLIP_ESC, SLIP_ESC_END);
+    else if (byte === SLIP_ESC) out.push(SLIP_ESC, SLIP_ESC_ESC);
+    else out.push(byte);
+  }
+  out.push(SLIP_END);
+  return Buffer.from(out);
+}
+
+// Reassembles SLIP frames from arbitrary chunks
+class SlipDecoder {
+  constructor(maxFrame = 2048) {
+    this.maxFrame = maxFrame;
+    this.buf = Buffer.alloc(maxFrame);
+    this.len = 0;
+    this.escaped = false;
+    this.overflow = false;
+    this.oversized = 0;
+  }
+
+  push(chunk) {
+    const frames = [];
+    for (let byte of chunk) {
+      if (byte === SLIP_END) {
+        if (this.overflow) this.oversized++;
+        else if (this.len > 0) frames.push(Buffer.from(this.buf.subarray(0, this.len)));
+        this.len = 0;
+        this.escaped = false;
+        this.overflow = false;
+        continue;
+      }
+      if (byte === SLIP_ESC) {
+        this.escaped = true;
+        continue;
+      }
+      if (this.escaped) {
+        byte = byte === SLIP_ESC_END ? SLIP_END : byte === SLIP_ESC_ESC ? SLIP_ESC : byte;
+        this.escaped = false;
+      }
+      if (this.len < this.maxFrame) this.buf[this.len++] = byte;
+      else this.overflow = true;
+    }
+    return frames;
+  }
+}
+
+// Events: 'proto' (line), 'log' (line), 'reset' (node restarted)
+class SerialLink extends EventEmitter {
+  constructor({ write, window = 4, retransmitMs = 250, maxRetries = 8, maxFrame = 600 } = {}) {
+    super();
+    this.write = write;
+    // Our own limit; the node's advertised window can only shrink it
+    this.maxWindow = window;
+    this.window = window;
+    this.retransmitMs = retransmitMs;
+    this.maxRetries = maxRetries;
+    this.decoder = new SlipDecoder(maxFrame);
+    this.txSeq = 0;
+    this.queue = [];
+    this.inFlight = [];
+    this.timer = null;
+    this.rxExpected = null;
+    // Acks sent before the node saw our HELLO refer to the old numbering
+    this.awaitingHelloAck = false;
+    this.stats = {
+      txFrames: 0,
+      retransmits: 0,
+      dropped: 0,
+      rxFrames: 0,
+      crcErrors: 0,
+      lostFrames: 0
+    };
+  }
+
+  start() {
+    this.resync();
+  }
+
+  close() {
+    clearTimeout(this.timer);
+    this.timer = null;
+    for (const entry of [...this.inFlight, ...this.queue]) entry.resolve(false);
+    this.inFlight = [];
+    this.queue = [];
+  }
+
+  // Resolves true once the node acked the frame, false if it was given up on
+  send(line) {
+    return new Promise((resolve) => {
+      this.queue.push({ payload: Buffer.from(line), resolve, retries: 0, seq: 0 });
+      this.pump();
+    });
+  }
+
+  handleData(chunk) {
+    for (const raw of this.decoder.push(chunk)) {
+      const frame = decodeFrame(raw);
+      if (!frame) {
+        this.stats.crcErrors++;
+        continue;
+      }
+      this.stats.rxFrames++;
+      this.handleFrame(frame);
+    }
+  }
+
+  handleFrame(frame) {
+    if (frame.seq !== 0) {
+      if (this.rxExpected !== null && frame.seq !== this.rxExpected) {
+        this.stats.lostFrames += (frame.seq - this.rxExpected + 255) % 255;
+      }
+      this.rxExpected = nextSeq(frame.seq);
+    }
+
+    if (frame.channel === CHANNEL.CONTROL) {
+      const type = frame.payload[0];
+      if (type === CTRL_HELLO) {
+        // Node rebooted: it expects seq 1 again and its own numbering restarted
+        this.rxExpected = null;
+        this.emit('reset');
+        this.resync(false);
+        return;
+      }
+      if (type === CTRL_ACK && frame.payload.length > 1) {
+        this.window = Math.max(1, Math.min(this.maxWindow, frame.payload[1]));
+        if (this.awaitingHelloAck && frame.ack === 0) this.awaitingHelloAck = false;
+      }
+    }
+
+    if (!this.awaitingHelloAck) this.handleAck(frame.ack);
+
+    if (frame.channel === CHANNEL.PROTO) {
+      this.emit('proto', frame.payload.toString('utf8'));
+    } else if (frame.channel === CHANNEL.LOG) {
+      this.emit('log', frame.payload.toString('utf8'));
+    }
+  }
+
+  // Cumulative: everything up to and including ackSeq has been handled
+  handleAck(ackSeq) {
+    const idx = this.inFlight.findIndex(entry => entry.seq === ackSeq);
+    if (idx < 0) return;
+    const done = this.inFlight.splice(0, idx + 1);
+    for (const entry of done) entry.resolve(true);
+    this.restartTimer();
+    this.pump();
+  }
+
+  pump() {
+    while (this.inFlight.length < this.window && this.queue.length) {
+      const entry = this.queue.shift();
+      this.txSeq = nextSeq(this.txSeq);
+      entry.seq = this.txSeq;
+      this.inFlight.push(entry);
+      this.transmit(entry);
+    }
+    if (this.inFlight.length && !this.timer) this.restartTimer();
+  }
+
+  transmit(entry) {
+    this.stats.txFrames++;
+    this.write(slipEncode(encodeFrame({ channel: CHANNEL.PROTO, seq: entry.seq, payload: entry.payload })));
+  }
+
+  restartTimer() {
+    clearTimeout(this.timer);
+    this.timer = null;
+    if (this.inFlight.length) {
+      this.timer = setTimeout(() => this.onTimeout(), this.retransmitMs);
+    }
+  }
+
+  onTimeout() {
+    this.timer = null;
+    if (!this.inFlight.length) return;
+    const oldest = this.inFlight[0];
+    oldest.retries++;
+    if (oldest.retries > this.maxRetries) {
+      // The node will never get past this seq; drop it and renumber the rest
+      this.inFlight.shift();
+      this.stats.dropped++;
+      oldest.resolve(false);
+      this.resync();
+      return;
+    }
+    // Go-back-N: the node discards everything after a gap
+    for (const entry of this.inFlight) {
+      this.stats.retransmits++;
+      this.transmit(entry);
+    }
+    this.restartTimer();
+  }
+
+  // Restarts sequence numbering at 1, resending whatever was unacked
+  resync(sendHello = true) {
+    clearTimeout(this.timer);
+    this.timer = null;
+    this.queue = [...this.inFlight, ...this.queue];
+    this.inFlight = [];
+    this.txSeq = 0;
+    this.awaitingHelloAck = sendHello;
+    if (sendHello) {
+      this.write(slipEncode(encodeFrame({ channel: CHANNEL.CONTROL, payload: Buffer.from([CTRL_HELLO]) })));
+    }
+    this.pump();
+  }
+}
+
+module.exports = {
+  CHANNEL,
+  CTRL_ACK,
+  CTRL_HELLO,
+  SerialLink,
+  SlipDecoder,
+  crc16,
+  decodeFrame,
+  encodeFrame,
+  nextSeq,
+  slipEncode
+};
@@ -0,0 +1,55 @@
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { CaptureWriter, parseCaptureLine } = require('../capture');
+
+const line = 'CAP;7;RX;2500000;-97;6.25;185344;4d53473b31';
+const entry = parseCaptureLine(line);
+assert.strictEqual(entry.seq, 7);
+assert.strictEqual(entry.direction, 'RX');
+assert.strictEqual(entry.timestampUs, 2500000);
+assert.strictEqual(entry.rssi, -97);
+assert.strictEqual(entry.snr, 6.25);
+assert.strictEqual(entry.airtimeUs, 185344);
+assert.strictEqual(entry.payload.toString(), 'MSG;1');
+
+assert.strictEqual(parseCaptureLine('CAP;7;XX;1;0;0;0;00'), null);
+assert.strictEqual(parseCaptureLine('CAP;7;RX;1;0;0;0;0'), null);
+assert.strictEqual(parseCaptureLine('LORA_RX;MSG;1'), null);
+
+const file = path.join(os.tmpdir(), `capture-test-${process.pid}.pcap`);
+try {
+  const writer = new CaptureWriter(file, { now: () => 1700000000000 });
+  assert.strictEqual(writer.handleLine(line), true);
+  assert.strictEqual(writer.handleLine('CAP;8;TX;3000000;0;0.00;200000;4142'), true);
+  assert.strictEqual(writer.handleLine('not a capture line'), false);
+
+  const pcap = fs.readFileSync(file);
+  assert.strictEqual(pcap.readUInt32LE(0), 0xa1b2c3d4);
+  assert.strictEqual(pcap.readUInt32LE(20), 270);
+
+  // First record: anchored at the fake wall clock
+  let offset = 24;
+  assert.strictEqual(pcap.readUInt32LE(offset), 1700000000);
+  assert.strictEqual(pcap.readUInt32LE(offset + 4), 0);
+  assert.strictEqual(pcap.readUInt32LE(offset + 8), 15 + 5);
+  const tap = offset + 16;
+  assert.strictEqual(pcap.readUInt16BE(tap + 2), 15);
+  assert.strictEqual(pcap.readUInt32BE(tap + 4), 868000000);
+  assert.strictEqual(pcap[tap + 9], 9);
+  assert.strictEqual(pcap[tap + 10], 42);     // -97 dBm
+  assert.strictEqual(pcap.readInt8(tap + 13), 25); // 6.25 dB in quarter dB
+  assert.strictEqual(pcap.toString('utf8', tap + 15, tap + 20), 'MSG;1');
+
+  // Second record: half a second later on the node's clock, TX marked by RSSI 0
+  offset = tap + 20;
+  assert.strictEqual(pcap.readUInt32LE(offset), 1700000000);
+  assert.strictEqual(pcap.readUInt32LE(offset + 4), 500000);
+  assert.strictEqual(pcap[offset + 16 + 10], 0);
+  assert.strictEqual(pcap.length, offset + 16 + 15 + 2);
+} finally {
+  fs.rmSync(file, { force: true });
+}
+
+console.log('capture tests passed');
@@ -0,0 +1,45 @@
+const assert = require('assert');
+const { decodeCompact, parseMetricsResponse } = require('../metrics');
+
+// Same layout Metrics::encodeCompact writes
+function varint(value) {
+  const out = [];
+  do {
+    let byte = value & 0x7f;
+    value = Math.floor(value / 128);
+    if (value) byte |= 0x80;
+    out.push(byte);
+  } while (value);
+  return out;
+}
+
+const blob = Buffer.from([
+  1,
+  64, ...varint(123456),    // heapFree
+  68, ...varint(3600),      // uptimeS
+  4, ...varint(98765),      // airtimeMs
+  201, ...varint(10),       // loopUs count
+  217, ...varint(4000000),  // loopUs sum
+  128 + 12, ...varint(7),   // rx msg
+  160 + 11, ...varint(3)    // tx beacon
+]);
+
+const decoded = decodeCompact(blob);
+assert.strictEqual(decoded.gauges.heapFree, 123456);
+assert.strictEqual(decoded.gauges.uptimeS, 3600);
+assert.strictEqual(decoded.gauges.onlineNodes, 0);
+assert.strictEqual(decoded.counters.airtimeMs, 98765);
+assert.deepStrictEqual(decoded.histograms.loopUs, { count: 10, sum: 4000000 });
+assert.strictEqual(decoded.rxByType.msg, 7);
+assert.strictEqual(decoded.txByType.beacon, 3);
+
+// Wrong version and a truncated varint are rejected
+assert.strictEqual(decodeCompact(Buffer.from([2, 64, 1])), null);
+assert.strictEqual(decodeCompact(Buffer.from([1, 64, 0x80])), null);
+
+const parsed = parseMetricsResponse(`RESP;METRICS;node-7;${blob.toString('base64')}\r\n`);
+assert.strictEqual(parsed.nodeId, 'node-7');
+assert.strictEqual(parsed.metrics.counters.airtimeMs, 98765);
+assert.strictEqual(parseMetricsResponse('RESP;STATS;node-7;1'), null);
+
+console.log('metrics tests passed');
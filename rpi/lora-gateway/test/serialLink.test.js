@@ -0,0 +1,191 @@
+const assert = require('assert');
+const {
+  CHANNEL,
+  CTRL_ACK,
+  CTRL_HELLO,
+  SerialLink,
+  SlipDecoder,
+  crc16,
+  decodeFrame,
+  encodeFrame,
+  nextSeq,
+  slipEncode
+} = require('../serialLink');
+
+// CRC-16/CCITT-FALSE check value
+assert.strictEqual(crc16(Buffer.from('123456789')), 0x29b1);
+
+// SLIP round trip with bytes that need escaping, split over chunks
+{
+  const payload = Buffer.from([0x41, 0xc0, 0xdb, 0x42, 0xdc, 0xdd]);
+  const wire = slipEncode(encodeFrame({ channel: CHANNEL.PROTO, seq: 7, ack: 3, payload }));
+  assert.ok(!wire.subarray(1, -1).includes(0xc0));
+  const decoder = new SlipDecoder();
+  const frames = [
+    ...decoder.push(wire.subarray(0, 4)),
+    ...decoder.push(wire.subarray(4))
+  ];
+  assert.strictEqual(frames.length, 1);
+  const frame = decodeFrame(frames[0]);
+  assert.strictEqual(frame.channel, CHANNEL.PROTO);
+  assert.strictEqual(frame.seq, 7);
+  assert.strictEqual(frame.ack, 3);
+  assert.deepStrictEqual(Buffer.from(frame.payload), payload);
+}
+
+// Corruption is detected
+{
+  const raw = encodeFrame({ channel: CHANNEL.LOG, seq: 1, payload: Buffer.from('hello') });
+  raw[4] ^= 0x01;
+  assert.strictEqual(decodeFrame(raw), null);
+  assert.strictEqual(decodeFrame(Buffer.from([1, 2])), null);
+}
+
+assert.strictEqual(nextSeq(1), 2);
+assert.strictEqual(nextSeq(255), 1);
+
+// Minimal node: same rules as SerialLink.cpp
+class FakeNode {
+  constructor() {
+    this.decoder = new SlipDecoder();
+    this.lastDelivered = 0;
+    this.txSeq = 0;
+    this.delivered = [];
+    this.dropNext = 0;
+    this.toGateway = null;
+  }
+  send(channel, seq, payload) {
+    this.toGateway(slipEncode(encodeFrame({ channel, seq, ack: this.lastDelivered, payload })));
+  }
+  sendAck() {
+    this.send(CHANNEL.CONTROL, 0, Buffer.from([CTRL_ACK, 4]));
+  }
+  sendLine(channel, text) {
+    this.txSeq = nextSeq(this.txSeq);
+    this.send(channel, this.txSeq, Buffer.from(text));
+  }
+  receive(chunk) {
+    for (const raw of this.decoder.push(chunk)) {
+      if (this.dropNext > 0) {
+        this.dropNext--;
+        continue;
+      }
+      const frame = decodeFrame(raw);
+      if (!frame) continue;
+      if (frame.channel === CHANNEL.CONTROL) {
+        if (frame.payload[0] === CTRL_HELLO) {
+          this.lastDelivered = 0;
+          this.sendAck();
+        }
+        continue;
+      }
+      if (frame.seq !== nextSeq(this.lastDelivered)) {
+        this.sendAck();
+        continue;
+      }
+      this.delivered.push(frame.payload.toString());
+      this.lastDelivered = frame.seq;
+      this.sendAck();
+    }
+  }
+}
+
+function connect(options) {
+  const node = new FakeNode();
+  const link = new SerialLink({
+    write: (buf) => setImmediate(() => node.receive(buf)),
+    retransmitMs: 20,
+    ...options
+  });
+  node.toGateway = (buf) => setImmediate(() => link.handleData(buf));
+  return { node, link };
+}
+
+async function testInOrderDelivery() {
+  const { node, link } = connect();
+  link.start();
+  const lines = Array.from({ length: 300 }, (_, i) => `LORA_TX;RESP;USERS;PART;${i + 1};300;x`);
+  const results = await Promise.all(lines.map(line => link.send(line)));
+  assert.ok(results.every(Boolean));
+  assert.deepStrictEqual(node.delivered, lines);
+  assert.strictEqual(link.stats.retransmits, 0);
+  link.close();
+}
+
+async function testRetransmitAfterLoss() {
+  const { node, link } = connect();
+  link.start();
+  await link.send('first');
+  node.dropNext = 1; // lose the next frame on the wire
+  const results = await Promise.all(['a', 'b', 'c'].map(line => link.send(line)));
+  assert.ok(results.every(Boolean));
+  assert.deepStrictEqual(node.delivered, ['first', 'a', 'b', 'c']);
+  assert.ok(link.stats.retransmits > 0);
+  link.close();
+}
+
+async function testWindowLimitsInFlight() {
+  let maxInFlight = 0;
+  const { link } = connect({ window: 2 });
+  const write = link.write;
+  link.write = (buf) => {
+    maxInFlight = Math.max(maxInFlight, link.inFlight.length);
+    write(buf);
+  };
+  link.start();
+  await Promise.all(Array.from({ length: 20 }, (_, i) => link.send(`m${i}`)));
+  assert.ok(maxInFlight <= 2);
+  link.close();
+}
+
+async function testNodeRebootResyncs() {
+  const { node, link } = connect();
+  link.start();
+  await link.send('before');
+  // Node restarts: sequence state gone, announces itself
+  node.lastDelivered = 0;
+  node.txSeq = 0;
+  node.send(CHANNEL.CONTROL, 0, Buffer.from([CTRL_HELLO]));
+  await new Promise(resolve => setTimeout(resolve, 5));
+  assert.strictEqual(await link.send('after'), true);
+  assert.deepStrictEqual(node.delivered, ['before', 'after']);
+  link.close();
+}
+
+async function testChannelsAndLossCounting() {
+  const { node, link } = connect();
+  const proto = [];
+  const logs = [];
+  link.on('proto', line => proto.push(line));
+  link.on('log', line => logs.push(line));
+  node.sendLine(CHANNEL.LOG, '[LoRa RX] BEACON;LoRA_1');
+  node.sendLine(CHANNEL.PROTO, 'LORA_RX;BEACON;LoRA_1');
+  node.txSeq = nextSeq(node.txSeq); // one frame lost on the wire
+  node.sendLine(CHANNEL.PROTO, 'OFFLINE;LoRA_2');
+  await new Promise(resolve => setTimeout(resolve, 10));
+  assert.deepStrictEqual(logs, ['[LoRa RX] BEACON;LoRA_1']);
+  assert.deepStrictEqual(proto, ['LORA_RX;BEACON;LoRA_1', 'OFFLINE;LoRA_2']);
+  assert.strictEqual(link.stats.lostFrames, 1);
+  link.close();
+}
+
+async function testGivesUpWithoutNode() {
+  const link = new SerialLink({ write: () => {}, retransmitMs: 5, maxRetries: 2 });
+  link.start();
+  assert.strictEqual(await link.send('nobody home'), false);
+  assert.strictEqual(link.stats.dropped, 1);
+  link.close();
+}
+
+(async () => {
+  await testInOrderDelivery();
+  await testRetransmitAfterLoss();
+  await testWindowLimitsInFlight();
+  await testNodeRebootResyncs();
+  await testChannelsAndLossCounting();
+  await testGivesUpWithoutNode();
+  console.log('serialLink tests passed');
+})().catch((err) => {
+  console.error(err);
+  process.exit(1);
+});
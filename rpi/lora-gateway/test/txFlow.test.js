@@ -0,0 +1,140 @@
+const assert = require('assert');
+const { TxFlowController, parseTxDone } = require('../txFlow');
+
+assert.deepStrictEqual(parseTxDone('TXDONE;3;1;14'), { done: 3, failed: 1, credits: 14 });
+assert.strictEqual(parseTxDone('TXDONE;3;x;14'), null);
+assert.strictEqual(parseTxDone('LORA_TX;TXDONE;1;0;1'), null);
+
+// Node with a radio that sends one frame per tick; reports like LoraNode.cpp
+class FakeRadioNode {
+  constructor(flow, depth = 16) {
+    this.flow = flow;
+    this.depth = depth;
+    this.queue = [];
+    this.sent = [];
+    this.done = 0;
+    this.maxQueued = 0;
+  }
+  receive(packet) {
+    this.queue.push(packet);
+    this.maxQueued = Math.max(this.maxQueued, this.queue.length);
+    return Promise.resolve(true);
+  }
+  tick() {
+    if (!this.queue.length) return;
+    this.sent.push(this.queue.shift());
+    this.done++;
+    this.flow.handleTxDone(`TXDONE;${this.done};0;${this.depth - this.queue.length}`);
+  }
+}
+
+async function testStreamsAtRadioPace() {
+  let node = null;
+  const flow = new TxFlowController({ send: (p) => node.receive(p), maxInFlight: 2, fallbackDelayMs: 0 });
+  node = new FakeRadioNode(flow);
+  flow.handleTxDone('TXDONE;0;0;16');
+
+  const radio = setInterval(() => node.tick(), 2);
+  const frames = Array.from({ length: 20 }, (_, i) => `LORA_TX;PART;${i}`);
+  const started = Date.now();
+  for (const frame of frames) {
+    assert.strictEqual(await flow.send(frame), true);
+  }
+  await flow.drain();
+  clearInterval(radio);
+  flow.close();
+
+  assert.deepStrictEqual(node.sent, frames);
+  assert.ok(node.maxQueued <= 2, `queued ${node.maxQueued}`);
+  assert.strictEqual(flow.stats.completed, 20);
+  // Nothing like the old 1.5 s per part
+  assert.ok(Date.now() - started < 1000);
+}
+
+async function testLostReportsAreCaughtUp() {
+  let queued = 0;
+  const flow = new TxFlowController({ send: () => { queued++; return Promise.resolve(true); }, maxInFlight: 3, fallbackDelayMs: 0 });
+  flow.handleTxDone('TXDONE;0;0;16');
+  await flow.send('a');
+  await flow.send('b');
+  await flow.send('c');
+  assert.strictEqual(flow.inFlight, 3);
+
+  let fourthQueued = false;
+  const fourth = flow.send('d').then(() => { fourthQueued = true; });
+  await new Promise(resolve => setImmediate(resolve));
+  assert.strictEqual(fourthQueued, false);
+
+  // Reports for frames 1 and 2 got lost; the totals in 3 cover them
+  flow.handleTxDone('TXDONE;3;1;16');
+  await fourth;
+  assert.strictEqual(queued, 4);
+  assert.strictEqual(flow.inFlight, 1);
+  assert.strictEqual(flow.stats.failed, 1);
+  flow.close();
+}
+
+async function testZeroCreditsWaitsForRoom() {
+  const flow = new TxFlowController({ send: () => Promise.resolve(true), maxInFlight: 4, fallbackDelayMs: 0 });
+  // The node's own beacons hold all but one slot
+  flow.handleTxDone('TXDONE;0;0;1');
+  await flow.send('a');
+  let secondQueued = false;
+  const second = flow.send('b').then(() => { secondQueued = true; });
+  await new Promise(resolve => setImmediate(resolve));
+  assert.strictEqual(secondQueued, false);
+  flow.handleTxDone('TXDONE;1;0;3');
+  await second;
+  flow.close();
+}
+
+async function testTimeoutReleasesSlots() {
+  const flow = new TxFlowController({ send: () => Promise.resolve(true), maxInFlight: 1, completionTimeoutMs: 20, fallbackDelayMs: 0 });
+  flow.handleTxDone('TXDONE;0;0;16');
+  await flow.send('a');
+  // No TXDONE ever comes for 'a'
+  await flow.send('b');
+  assert.strictEqual(flow.stats.timeouts, 1);
+  flow.close();
+}
+
+async function testResetAndReboot() {
+  const flow = new TxFlowController({ send: () => Promise.resolve(true), maxInFlight: 2, fallbackDelayMs: 0 });
+  flow.handleTxDone('TXDONE;0;0;16');
+  await flow.send('a');
+  flow.handleTxDone('TXDONE;7;0;16');
+  await flow.send('b');
+  flow.reset();
+  assert.strictEqual(flow.inFlight, 0);
+
+  // Text mode has no reset event: totals going backwards mean a reboot
+  await flow.send('c');
+  flow.handleTxDone('TXDONE;1;0;16');
+  assert.strictEqual(flow.inFlight, 0);
+  flow.close();
+}
+
+async function testFallbackWithoutFeedback() {
+  const sent = [];
+  const flow = new TxFlowController({ send: (p) => { sent.push(p); return Promise.resolve(true); }, fallbackDelayMs: 10 });
+  const started = Date.now();
+  await flow.send('a');
+  await flow.send('b');
+  assert.deepStrictEqual(sent, ['a', 'b']);
+  assert.ok(Date.now() - started >= 18);
+  assert.strictEqual(flow.inFlight, 0);
+  await flow.drain();
+}
+
+(async () => {
+  await testStreamsAtRadioPace();
+  await testLostReportsAreCaughtUp();
+  await testZeroCreditsWaitsForRoom();
+  await testTimeoutReleasesSlots();
+  await testResetAndReboot();
+  await testFallbackWithoutFeedback();
+  console.log('txFlow tests passed');
+})().catch((err) => {
+  console.error(err);
+  process.exit(1);
+});
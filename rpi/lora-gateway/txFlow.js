@@ -0,0 +1,167 @@
+// Paces LORA_TX lines by the attached node's radio instead of fixed sleeps.
+//
+// For every LORA_TX frame it has finished (sent, failed or refused), the node
+// reports "TXDONE;<done>;<failed>;<credits>". done and failed are running
+// totals since the node booted, credits is the number of free slots in its TX
+// queue. We keep at most maxInFlight of our frames queued on the node, so the
+// radio always has the next frame ready but the queue never overflows.
+const DEFAULT_MAX_IN_FLIGHT = 2;
+
+function parseTxDone(line) {
+  const parts = line.split(';');
+  if (parts[0] !== 'TXDONE' || parts.length < 4) return null;
+  const [done, failed, credits] = parts.slice(1, 4).map(Number);
+  if (![done, failed, credits].every(Number.isInteger)) return null;
+  return { done, failed, credits };
+}
+
+class TxFlowController {
+  // send(packet) writes one LORA_TX line and resolves true once the node has it.
+  // Until the first TXDONE arrives (older firmware) every frame is followed by
+  // fallbackDelayMs, like the old fixed pacing.
+  constructor({ send, maxInFlight = DEFAULT_MAX_IN_FLIGHT, completionTimeoutMs = 10000, fallbackDelayMs = 1500 } = {}) {
+    this.sendFn = send;
+    this.maxInFlight = maxInFlight;
+    this.completionTimeoutMs = completionTimeoutMs;
+    this.fallbackDelayMs = fallbackDelayMs;
+    this.feedback = false;
+    this.inFlight = 0;
+    this.credits = maxInFlight;
+    this.lastDone = 0;
+    this.lastFailed = 0;
+    this.slotWaiters = [];
+    this.drainWaiters = [];
+    this.timer = null;
+    this.stats = {
+      sent: 0,
+      completed: 0,
+      failed: 0,
+      timeouts: 0
+    };
+  }
+
+  // Resolves once the frame is queued on the node (not once it is on air)
+  async send(packet) {
+    if (!this.feedback) {
+      const ok = await this.sendFn(packet);
+      if (ok) this.stats.sent++;
+      await new Promise(resolve => setTimeout(resolve, this.fallbackDelayMs));
+      return ok;
+    }
+
+    await this.acquire();
+    const ok = await this.sendFn(packet);
+    if (ok) {
+      this.stats.sent++;
+    } else {
+      // The node never got it, so no TXDONE will come for it
+      this.release(1);
+    }
+    return ok;
+  }
+
+  // Resolves when every frame handed to the node has left the radio
+  drain() {
+    if (this.inFlight === 0) return Promise.resolve();
+    return new Promise(resolve => this.drainWaiters.push(resolve));
+  }
+
+  handleTxDone(line) {
+    const report = parseTxDone(line);
+    if (!report) return false;
+    this.feedback = true;
+
+    if (report.done < this.lastDone) {
+      // Node rebooted and its totals restarted
+      this.lastDone = 0;
+      this.lastFailed = 0;
+    }
+    const finished = report.done - this.lastDone;
+    const failed = Math.max(0, report.failed - this.lastFailed);
+    this.lastDone = report.done;
+    this.lastFailed = Math.max(this.lastFailed, report.failed);
+    this.stats.completed += finished;
+    this.stats.failed += failed;
+
+    this.credits = report.credits;
+    this.release(finished);
+    return true;
+  }
+
+  // The node restarted: nothing we queued before will be reported
+  reset() {
+    this.lastDone = 0;
+    this.lastFailed = 0;
+    this.credits = this.maxInFlight;
+    this.release(this.inFlight);
+  }
+
+  close() {
+    clearTimeout(this.timer);
+    this.timer = null;
+    this.inFlight = 0;
+    this.credits = this.maxInFlight;
+    this.wake();
+  }
+
+  release(count) {
+    this.inFlight = Math.max(0, this.inFlight - count);
+    if (this.inFlight === 0) {
+      clearTimeout(this.timer);
+      this.timer = null;
+    } else if (count > 0) {
+      this.armTimer();
+    }
+    this.wake();
+  }
+
+  // A TXDONE that never comes (lost line, radio stuck) must not stall a sync
+  armTimer() {
+    clearTimeout(this.timer);
+    this.timer = setTimeout(() => {
+      this.timer = null;
+      if (!this.inFlight) return;
+      this.stats.timeouts++;
+      this.credits = Math.max(this.credits, this.maxInFlight);
+      this.release(this.inFlight);
+    }, this.completionTimeoutMs);
+  }
+
+  // The node reporting zero credits with nothing of ours queued (its own
+  // beacons and relays filled the queue) must not stop us for good
+  canSend() {
+    return this.inFlight < this.maxInFlight && (this.credits > 0 || this.inFlight === 0);
+  }
+
+  take() {
+    this.inFlight++;
+    this.credits = Math.max(0, this.credits - 1);
+    this.armTimer();
+  }
+
+  // Slots are handed out in order so frames keep their sequence
+  acquire() {
+    if (!this.slotWaiters.length && this.canSend()) {
+      this.take();
+      return Promise.resolve();
+    }
+    return new Promise(resolve => this.slotWaiters.push(resolve));
+  }
+
+  wake() {
+    while (this.slotWaiters.length && this.canSend()) {
+      this.take();
+      this.slotWaiters.shift()();
+    }
+    if (this.inFlight === 0) {
+      const waiters = this.drainWaiters;
+      this.drainWaiters = [];
+      for (const resolve of waiters) resolve();
+    }
+  }
+}
+
+module.exports = {
+  TxFlowController,
+  parseTxDone
+};